@@ -43,7 +43,7 @@ const int kMaxRetry = 5;
 
 class ServerInteraction {
  public:
-  ServerInteraction() : leader_index_(0){};
+  ServerInteraction() : leader_index_(0), replica_index_(0){};
   ~ServerInteraction() = default;
 
   ServerInteraction(const ServerInteraction&) = delete;
@@ -62,6 +62,13 @@ class ServerInteraction {
   butil::Status SendRequest(const std::string& service_name, const std::string& api_name, const Request& request,
                             Response& response);
 
+  // Send read request to replicas in turn for follower read, fall back to leader when failed.
+  // replica_index < 0 means choose next replica, and output the replica which served the request,
+  // scan continue must send to the same replica.
+  template <typename Request, typename Response>
+  butil::Status ReplicaSendRequest(const std::string& service_name, const std::string& api_name,
+                                   const Request& request, Response& response, int& replica_index);
+
   template <typename Request, typename Response>
   butil::Status AllSendRequest(const std::string& service_name, const std::string& api_name, const Request& request,
                                Response& response);
@@ -70,6 +77,7 @@ class ServerInteraction {
 
  private:
   std::atomic<int> leader_index_;
+  std::atomic<uint32_t> replica_index_;
   std::vector<butil::EndPoint> endpoints_;
   std::vector<std::unique_ptr<brpc::Channel> > channels_;
   uint64_t latency_;
@@ -138,6 +146,39 @@ butil::Status ServerInteraction::SendRequest(const std::string& service_name, co
   return butil::Status(dingodb::pb::error::ERAFT_NOTLEADER, "Not raft leader");
 }
 
+template <typename Request, typename Response>
+butil::Status ServerInteraction::ReplicaSendRequest(const std::string& service_name, const std::string& api_name,
+                                                    const Request& request, Response& response,
+                                                    int& replica_index) {
+  const auto* method = dingodb::pb::store::StoreService::descriptor()->FindMethodByName(api_name);
+  if (service_name != "StoreService" || method == nullptr) {
+    return SendRequest(service_name, api_name, request, response);
+  }
+
+  brpc::Controller cntl;
+  cntl.set_timeout_ms(FLAGS_timeout_ms);
+  cntl.set_log_id(butil::fast_rand());
+  if (replica_index < 0 || replica_index >= channels_.size()) {
+    replica_index = replica_index_.fetch_add(1) % channels_.size();
+  }
+  channels_[replica_index]->CallMethod(method, &cntl, &request, &response, nullptr);
+  if (FLAGS_log_each_request) {
+    DINGO_LOG(INFO) << "send replica request api " << api_name << " request: " << request.ShortDebugString()
+                    << " response: " << response.ShortDebugString();
+  }
+  if (cntl.Failed() || response.error().errcode() != dingodb::pb::error::OK) {
+    DINGO_LOG(WARNING) << fmt::format("{} replica response failed, {} {}, retry on leader", api_name,
+                                      cntl.ErrorText(), response.error().errmsg());
+    response.Clear();
+    auto status = SendRequest(service_name, api_name, request, response);
+    replica_index = GetLeader();
+    return status;
+  }
+
+  latency_ = cntl.latency_us();
+  return butil::Status();
+}
+
 template <typename Request, typename Response>
 butil::Status ServerInteraction::AllSendRequest(const std::string& service_name, const std::string& api_name,
                                                 const Request& request, Response& response) {
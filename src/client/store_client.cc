@@ -35,6 +35,8 @@ DEFINE_string(key, "", "Request key");
 DEFINE_string(value, "", "Request values");
 DEFINE_string(prefix, "", "key prefix");
 DEFINE_int32(region_id, 111111, "region id");
+DEFINE_bool(follower_read, false, "Read from follower replicas by read index");
+DEFINE_int32(max_staleness_ms, 0, "Read from any replica with bounded staleness, 0 means disable");
 DEFINE_int32(region_count, 1, "region count");
 DEFINE_int32(table_id, 0, "table id");
 DEFINE_string(table_name, "", "table name");
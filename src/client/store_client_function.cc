@@ -24,6 +24,7 @@
 #include <vector>
 
 #include "bthread/bthread.h"
+#include "bvar/bvar.h"
 #include "client/client_helper.h"
 #include "common/helper.h"
 #include "common/logging.h"
@@ -33,8 +34,32 @@
 
 const int kBatchSize = 1000;
 
+DECLARE_bool(follower_read);
+DECLARE_int32(max_staleness_ms);
+
 namespace client {
 
+// Follower read metrics of client
+bvar::Adder<uint64_t> g_follower_read_count("dingo_client_follower_read_count");
+bvar::LatencyRecorder g_follower_read_latency("dingo_client_follower_read_latency");
+
+// Send read request, spread to all replicas when follower read.
+template <typename Request, typename Response>
+butil::Status SendReadRequest(ServerInteractionPtr interaction, const std::string& api_name, Request& request,
+                              Response& response, int& replica_index) {
+  if (!FLAGS_follower_read && FLAGS_max_staleness_ms <= 0) {
+    return interaction->SendRequest("StoreService", api_name, request, response);
+  }
+
+  request.set_follower_read(FLAGS_follower_read);
+  request.set_max_staleness_ms(std::max(FLAGS_max_staleness_ms, 0));
+  auto status = interaction->ReplicaSendRequest("StoreService", api_name, request, response, replica_index);
+  g_follower_read_count << 1;
+  g_follower_read_latency << interaction->GetLatency();
+
+  return status;
+}
+
 void SendKvGet(ServerInteractionPtr interaction, uint64_t region_id, const std::string& key, std::string& value) {
   dingodb::pb::store::KvGetRequest request;
   dingodb::pb::store::KvGetResponse response;
@@ -42,7 +67,8 @@ void SendKvGet(ServerInteractionPtr interaction, uint64_t region_id, const std::
   request.set_region_id(region_id);
   request.set_key(key);
 
-  interaction->SendRequest("StoreService", "KvGet", request, response);
+  int replica_index = -1;
+  SendReadRequest(interaction, "KvGet", request, response, replica_index);
 
   value = response.value();
 }
@@ -57,7 +83,8 @@ void SendKvBatchGet(ServerInteractionPtr interaction, uint64_t region_id, const
     request.add_keys(key);
   }
 
-  interaction->SendRequest("StoreService", "KvBatchGet", request, response);
+  int replica_index = -1;
+  SendReadRequest(interaction, "KvBatchGet", request, response, replica_index);
 }
 
 void SendKvPut(ServerInteractionPtr interaction, uint64_t region_id, const std::string& key, std::string value) {
@@ -149,7 +176,8 @@ void SendKvScan(ServerInteractionPtr interaction, uint64_t region_id, const std:
   request.mutable_range()->set_with_start(true);
   request.mutable_range()->set_with_end(false);
 
-  interaction->SendRequest("StoreService", "KvScanBegin", request, response);
+  int replica_index = -1;
+  SendReadRequest(interaction, "KvScanBegin", request, response, replica_index);
   if (response.error().errcode() != 0) {
     return;
   }
@@ -163,7 +191,13 @@ void SendKvScan(ServerInteractionPtr interaction, uint64_t region_id, const std:
 
   int count = 0;
   for (;;) {
-    interaction->SendRequest("StoreService", "KvScanContinue", continue_request, continue_response);
+    // Scan context is on the replica which served scan begin.
+    if (FLAGS_follower_read || FLAGS_max_staleness_ms > 0) {
+      interaction->ReplicaSendRequest("StoreService", "KvScanContinue", continue_request, continue_response,
+                                      replica_index);
+    } else {
+      interaction->SendRequest("StoreService", "KvScanContinue", continue_request, continue_response);
+    }
     if (continue_response.error().errcode() != 0) {
       return;
     }
@@ -182,7 +216,11 @@ void SendKvScan(ServerInteractionPtr interaction, uint64_t region_id, const std:
   release_request.set_region_id(region_id);
   release_request.set_scan_id(response.scan_id());
 
-  interaction->SendRequest("StoreService", "KvScanRelease", release_request, release_response);
+  if (FLAGS_follower_read || FLAGS_max_staleness_ms > 0) {
+    interaction->ReplicaSendRequest("StoreService", "KvScanRelease", release_request, release_response, replica_index);
+  } else {
+    interaction->SendRequest("StoreService", "KvScanRelease", release_request, release_response);
+  }
 }
 
 void SendKvCompareAndSet(ServerInteractionPtr interaction, uint64_t region_id, const std::string& key) {
@@ -58,11 +58,14 @@ class Constant {
 
   // rocksdb config
   inline static const std::string kDbPath = "store.path";
+  // Directory of coprocessor aggregation spill files, empty means spill directory beside store.path.
+  inline static const std::string kSpillPath = "store.spill_path";
   inline static const std::string kColumnFamilies = "store.column_families";
   inline static const std::string kBaseColumnFamily = "store.base";
 
   inline static const std::string kBlockSize = "block_size";
-  inline static const std::string kBlockCache = "block_cache";
+  // Ratio of the memory budget for the dedicated block cache of column family, 0 means the shared one.
+  inline static const std::string kBlockCacheRatio = "block_cache_ratio";
   inline static const std::string kArenaBlockSize = "arena_block_size";
   inline static const std::string kMinWriteBufferNumberToMerge = "min_write_buffer_number_to_merge";
   inline static const std::string kMaxWriteBufferNumber = "max_write_buffer_number";
@@ -73,6 +76,22 @@ class Constant {
   inline static const std::string kTargetFileSizeBase = "target_file_size_base";
   inline static const std::string kMaxBytesForLevelMultiplier = "max_bytes_for_level_multiplier";
 
+  // Write data column family without wal, the raft log is the wal.
+  inline static const std::string kDisableDataWal = "store.disable_data_wal";
+
+  // Store wide memory budget of rocksdb, block cache and memtables are all charged to it.
+  inline static const std::string kMemoryBudgetMb = "store.memory_budget_mb";
+  inline static const std::string kMemoryBudgetRatio = "store.memory_budget_ratio";
+  inline static const std::string kWriteBufferRatio = "store.write_buffer_ratio";
+  inline static const std::string kBlockCacheType = "store.block_cache_type";
+  static constexpr double kMemoryBudgetRatioDefault = 0.4;
+  static constexpr double kWriteBufferRatioDefault = 0.25;
+  // Row cache of data column family in front of point reads, 0 means disabled.
+  inline static const std::string kRowCacheMb = "store.row_cache_mb";
+  // Compaction drop the data out of all regions, and compact the gaps between regions periodically.
+  inline static const std::string kDropOrphanData = "store.drop_orphan_data";
+  inline static const std::string kOrphanCompactIntervalS = "store.orphan_compact_interval_s";
+
   static const int kRocksdbBackgroundThreadNumDefault = 16;
   static const int kStatsDumpPeriodSecDefault = 600;
 
@@ -83,6 +102,23 @@ class Constant {
   inline static const std::string kStoreScanMaxFetchCntByServer = "max_fetch_cnt_by_server";
   inline static const std::string kStoreScanScanIntervalMs = "scan_interval_ms";
 
+  // raft group commit default config
+  static const int kRaftGroupCommitMaxCount = 256;
+  static const int kRaftGroupCommitMaxBytes = 4 * 1024 * 1024;
+
+  // braft default 10, heartbeat interval is election timeout / factor, lower factor less heartbeat rpc per store pair
+  static const int kRaftElectionHeartbeatFactor = 4;
+  // braft default 1024, max log entries of one append entries rpc
+  static const int kRaftMaxAppendEntriesSize = 2048;
+
+  // follower read wait leader read index and apply timeout
+  static const int kFollowerReadTimeoutMs = 3000;
+
+  // hibernated election timeout = election timeout * factor, heartbeat interval is stretched too
+  static const int kRaftHibernateTimeoutFactor = 60;
+  // store liveness check of hibernated followers rpc timeout
+  static const int kRaftHibernateCheckTimeoutMs = 1000;
+
   inline static const std::string kMetaRegionName = "COORDINATOR";
   inline static const std::string kAutoIncrementRegionName = "AUTO_INCREMENT";
 };
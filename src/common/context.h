@@ -40,6 +40,9 @@ class Context {
         delete_files_in_range_(false),
         flush_(false),
         role_(pb::common::ClusterRole::STORE),
+        follower_read_(false),
+        max_staleness_ms_(0),
+        blind_write_(false),
         enable_sync_(false) {}
   Context(brpc::Controller* cntl, google::protobuf::Closure* done)
       : cntl_(cntl),
@@ -50,6 +53,9 @@ class Context {
         delete_files_in_range_(false),
         flush_(false),
         role_(pb::common::ClusterRole::STORE),
+        follower_read_(false),
+        max_staleness_ms_(0),
+        blind_write_(false),
         enable_sync_(false) {}
   Context(brpc::Controller* cntl, google::protobuf::Closure* done, google::protobuf::Message* response)
       : cntl_(cntl),
@@ -60,6 +66,9 @@ class Context {
         delete_files_in_range_(false),
         flush_(false),
         role_(pb::common::ClusterRole::STORE),
+        follower_read_(false),
+        max_staleness_ms_(0),
+        blind_write_(false),
         enable_sync_(false) {}
   Context(brpc::Controller* cntl, google::protobuf::Closure* done, const google::protobuf::Message* request,
           google::protobuf::Message* response)
@@ -71,6 +80,9 @@ class Context {
         delete_files_in_range_(false),
         flush_(false),
         role_(pb::common::ClusterRole::STORE),
+        follower_read_(false),
+        max_staleness_ms_(0),
+        blind_write_(false),
         enable_sync_(false) {}
   ~Context() = default;
 
@@ -112,6 +124,15 @@ class Context {
   pb::common::ClusterRole ClusterRole() { return role_; }
   void SetClusterRole(pb::common::ClusterRole role) { role_ = role; }
 
+  bool FollowerRead() const { return follower_read_; }
+  void SetFollowerRead(bool follower_read) { follower_read_ = follower_read; }
+
+  uint64_t MaxStalenessMs() const { return max_staleness_ms_; }
+  void SetMaxStalenessMs(uint64_t max_staleness_ms) { max_staleness_ms_ = max_staleness_ms; }
+
+  bool BlindWrite() const { return blind_write_; }
+  void SetBlindWrite(bool blind_write) { blind_write_ = blind_write; }
+
   void EnableSyncMode() {
     enable_sync_ = true;
     cond_ = std::make_shared<BthreadCond>();
@@ -143,6 +164,12 @@ class Context {
   bool flush_;
   // role
   pb::common::ClusterRole role_;
+  // Read on follower by read index
+  bool follower_read_;
+  // Bounded staleness read on any replica
+  uint64_t max_staleness_ms_;
+  // Write result is determined once committed, can be responded before applied
+  bool blind_write_;
 
   // For sync mode
   bool enable_sync_;
@@ -23,6 +23,7 @@
 #include <cstdio>
 #include <cstring>
 #include <filesystem>
+#include <fstream>
 #include <iomanip>
 #include <random>
 #include <ratio>
@@ -48,6 +49,22 @@ using PbError = pb::error::Error;
 
 int Helper::GetCoreNum() { return sysconf(_SC_NPROCESSORS_ONLN); }
 
+int64_t Helper::GetTotalMemorySize() {
+  int64_t total = static_cast<int64_t>(sysconf(_SC_PHYS_PAGES)) * sysconf(_SC_PAGESIZE);
+
+  // cgroup v2 and v1, "max" or a huge value means no limit
+  for (const auto* path : {"/sys/fs/cgroup/memory.max", "/sys/fs/cgroup/memory/memory.limit_in_bytes"}) {
+    std::ifstream file(path);
+    int64_t limit = 0;
+    if (file >> limit && limit > 0 && limit < total) {
+      total = limit;
+      break;
+    }
+  }
+
+  return total;
+}
+
 bool Helper::IsIp(const std::string& s) {
   std::regex const reg(
       "(?=(\\b|\\D))(((\\d{1,2})|(1\\d{1,2})|(2[0-4]\\d)|(25[0-5]))\\.){3}(("
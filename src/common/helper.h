@@ -36,6 +36,8 @@ class Helper {
 
  public:
   static int GetCoreNum();
+  // Physical memory, or the cgroup memory limit if it is smaller.
+  static int64_t GetTotalMemorySize();
   static bool IsIp(const std::string& s);
 
   static butil::EndPoint GetEndPoint(const std::string& host, int port);
@@ -2308,6 +2308,25 @@ void CoordinatorControl::UpdateRegionMapAndStoreOperation(const pb::common::Stor
   for (const auto& it : store_metrics.region_metrics_map()) {
     const auto& region_metrics = it.second;
 
+    // hibernated region only report id and epoch, the leader store keep it alive
+    if (region_metrics.is_hibernated()) {
+      pb::common::Region region_to_update;
+      if (region_map_.Get(region_metrics.id(), region_to_update) < 0 ||
+          region_to_update.leader_store_id() != store_metrics.id() ||
+          region_to_update.definition().epoch() != region_metrics.region_definition().epoch()) {
+        continue;
+      }
+
+      if (region_to_update.last_update_timestamp() + FLAGS_region_update_timeout * 1000 < butil::gettimeofday_ms()) {
+        auto* region_increment = meta_increment.add_regions();
+        region_increment->set_id(region_metrics.id());
+        region_increment->set_op_type(::dingodb::pb::coordinator_internal::MetaIncrementOpType::UPDATE);
+        region_increment->mutable_region()->CopyFrom(region_to_update);
+        region_increment->mutable_region()->set_last_update_timestamp(butil::gettimeofday_ms());
+      }
+      continue;
+    }
+
     // when region leader change or region state change, we need to update region_map_
     // or when region last_update_timestamp is too old, we need to update region_map_
     bool need_update_region = false;
@@ -2510,7 +2529,24 @@ uint64_t CoordinatorControl::UpdateStoreMetrics(const pb::common::StoreMetrics&
 
   {
     BAIDU_SCOPED_LOCK(store_metrics_map_mutex_);
-    store_metrics_map_.insert(store_metrics.id(), store_metrics);
+    auto* old_store_metrics = store_metrics_map_.seek(store_metrics.id());
+    if (old_store_metrics == nullptr) {
+      store_metrics_map_.insert(store_metrics.id(), store_metrics);
+    } else {
+      // hibernated region only report id and epoch, keep its last metrics
+      pb::common::StoreMetrics new_store_metrics = store_metrics;
+      for (auto& [region_id, region_metrics] : *new_store_metrics.mutable_region_metrics_map()) {
+        if (!region_metrics.is_hibernated()) {
+          continue;
+        }
+        auto old_region_metrics = old_store_metrics->region_metrics_map().find(region_id);
+        if (old_region_metrics != old_store_metrics->region_metrics_map().end()) {
+          region_metrics.CopyFrom(old_region_metrics->second);
+          region_metrics.set_is_hibernated(true);
+        }
+      }
+      store_metrics_map_.insert(store_metrics.id(), new_store_metrics);
+    }
     // if (store_metrics_map_.seek(store_metrics.id()) != nullptr) {
     //   DINGO_LOG(DEBUG) << "STORE METIRCS UPDATE store_metrics.id = " << store_metrics.id();
 
@@ -15,115 +15,119 @@
 #include "coprocessor/aggregation.h"
 
 #include <cstdint>
-#include <exception>
+#include <cstring>
 #include <memory>
 #include <optional>
 #include <string>
-#include <type_traits>
 
 #include "common/logging.h"
 #include "fmt/core.h"
-#include "proto/store.pb.h"
+#include "proto/error.pb.h"
 
 namespace dingodb {
 
-Aggregation::Aggregation() = default;
-Aggregation::~Aggregation() { Close(); }
+void Aggregation::InitState(const AggregationFunction& function, AggregationState* state,
+                            std::vector<std::string>* strings) {
+  state->has_value = function.init_zero;
+  state->value.i64 = 0;
+  switch (function.result_type) {
+    case BaseSchema::Type::kBool:
+      state->value.b = false;
+      break;
+    case BaseSchema::Type::kInteger:
+      state->value.i32 = 0;
+      break;
+    case BaseSchema::Type::kFloat:
+      state->value.f = 0.0f;
+      break;
+    case BaseSchema::Type::kDouble:
+      state->value.d = 0.0;
+      break;
+    case BaseSchema::Type::kString:
+      if (function.init_zero) {
+        state->value.s = strings->size();
+        strings->emplace_back();
+      }
+      break;
+    default:
+      break;
+  }
+}
 
-butil::Status Aggregation::Open(
-    size_t start_aggregation_operators_index,
-    const std::shared_ptr<std::vector<std::shared_ptr<BaseSchema>>>& result_serial_schemas,
-    const ::google::protobuf::RepeatedPtrField<pb::store::AggregationOperator>& aggregation_operators) {
-  butil::Status status;
+std::any Aggregation::GetResult(const AggregationFunction& function, const AggregationState& state,
+                                const std::vector<std::string>& strings) {
+  switch (function.result_type) {
+    case BaseSchema::Type::kBool:
+      return state.has_value ? std::optional<bool>(state.value.b) : std::optional<bool>(std::nullopt);
+    case BaseSchema::Type::kInteger:
+      return state.has_value ? std::optional<int32_t>(state.value.i32) : std::optional<int32_t>(std::nullopt);
+    case BaseSchema::Type::kFloat:
+      return state.has_value ? std::optional<float>(state.value.f) : std::optional<float>(std::nullopt);
+    case BaseSchema::Type::kLong:
+      return state.has_value ? std::optional<int64_t>(state.value.i64) : std::optional<int64_t>(std::nullopt);
+    case BaseSchema::Type::kDouble:
+      return state.has_value ? std::optional<double>(state.value.d) : std::optional<double>(std::nullopt);
+    case BaseSchema::Type::kString:
+      return state.has_value ? std::optional<std::shared_ptr<std::string>>(
+                                   std::make_shared<std::string>(strings[state.value.s]))
+                             : std::optional<std::shared_ptr<std::string>>(std::nullopt);
+    default:
+      return std::any();
+  }
+}
 
-  result_record_ = std::make_shared<std::vector<std::any>>();
+// has_value(1 byte) + value(8 bytes), string value is length(4 bytes) + data
+void Aggregation::EncodeState(const AggregationFunction& function, const AggregationState& state,
+                              const std::vector<std::string>& strings, std::string* output) {
+  output->push_back(state.has_value ? 1 : 0);
+  if (!state.has_value) {
+    return;
+  }
 
-  result_record_->reserve((*result_serial_schemas).size() - start_aggregation_operators_index);
-  size_t j = 0;
-  for (size_t i = start_aggregation_operators_index;
-       i < result_serial_schemas->size() && j < aggregation_operators.size(); i++, j++) {
-    auto type = (*result_serial_schemas)[i]->GetType();
-    auto oper = aggregation_operators[j].oper();
+  if (function.result_type == BaseSchema::Type::kString) {
+    const auto& str = strings[state.value.s];
+    uint32_t size = str.size();
+    output->append(reinterpret_cast<const char*>(&size), sizeof(size));
+    output->append(str);
+  } else {
+    output->append(reinterpret_cast<const char*>(&state.value), sizeof(state.value));
+  }
+}
 
-    switch (type) {
-      case BaseSchema::Type::kBool: {
-        if (pb::store::COUNT == oper || pb::store::COUNTWITHNULL == oper || pb::store::SUM0 == oper) {
-          result_record_->emplace_back(std::optional<bool>(false));
-        } else {
-          result_record_->emplace_back(std::optional<bool>(std::nullopt));
-        }
-        break;
-      }
-      case BaseSchema::Type::kInteger: {
-        if (pb::store::COUNT == oper || pb::store::COUNTWITHNULL == oper || pb::store::SUM0 == oper) {
-          result_record_->emplace_back(std::optional<int32_t>(0));
-        } else {
-          result_record_->emplace_back(std::optional<int32_t>(std::nullopt));
-        }
-        break;
-      }
-      case BaseSchema::Type::kFloat: {
-        if (pb::store::COUNT == oper || pb::store::COUNTWITHNULL == oper || pb::store::SUM0 == oper) {
-          result_record_->emplace_back(std::optional<float>(0.0f));
-        } else {
-          result_record_->emplace_back(std::optional<float>(std::nullopt));
-        }
-        break;
-      }
-      case BaseSchema::Type::kLong: {
-        if (pb::store::COUNT == oper || pb::store::COUNTWITHNULL == oper || pb::store::SUM0 == oper) {
-          result_record_->emplace_back(std::optional<int64_t>(0));
-        } else {
-          result_record_->emplace_back(std::optional<int64_t>(std::nullopt));
-        }
-        break;
-      }
-      case BaseSchema::Type::kDouble: {
-        if (pb::store::COUNT == oper || pb::store::COUNTWITHNULL == oper || pb::store::SUM0 == oper) {
-          result_record_->emplace_back(std::optional<double>(0.0));
-        } else {
-          result_record_->emplace_back(std::optional<double>(std::nullopt));
-        }
-        break;
+butil::Status Aggregation::DecodeState(const AggregationFunction& function, const char** data, const char* end,
+                                       AggregationState* state, std::vector<std::string>* strings) {
+  const char* p = *data;
+  if (p >= end) {
+    return butil::Status(pb::error::EINTERNAL, "aggregation state truncated");
+  }
+
+  state->has_value = (*p++ != 0);
+  state->value.i64 = 0;
+  if (state->has_value) {
+    if (function.result_type == BaseSchema::Type::kString) {
+      uint32_t size = 0;
+      if (end - p < static_cast<int64_t>(sizeof(size))) {
+        return butil::Status(pb::error::EINTERNAL, "aggregation state truncated");
       }
-      case BaseSchema::Type::kString: {
-        if (pb::store::COUNT == oper || pb::store::COUNTWITHNULL == oper || pb::store::SUM0 == oper) {
-          result_record_->emplace_back(std::optional<std::shared_ptr<std::string>>(std::make_shared<std::string>()));
-        } else {
-          result_record_->emplace_back(std::optional<std::shared_ptr<std::string>>(std::nullopt));
-        }
-        break;
+      memcpy(&size, p, sizeof(size));
+      p += sizeof(size);
+      if (end - p < static_cast<int64_t>(size)) {
+        return butil::Status(pb::error::EINTERNAL, "aggregation state truncated");
       }
-      default: {
-        std::string error_message = fmt::format("unsupported serial_schema1 type: {}", static_cast<int>(type));
-        DINGO_LOG(ERROR) << error_message;
-        return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
+      state->value.s = strings->size();
+      strings->emplace_back(p, size);
+      p += size;
+    } else {
+      if (end - p < static_cast<int64_t>(sizeof(state->value))) {
+        return butil::Status(pb::error::EINTERNAL, "aggregation state truncated");
       }
+      memcpy(&state->value, p, sizeof(state->value));
+      p += sizeof(state->value);
     }
   }
 
+  *data = p;
   return butil::Status();
 }
 
-butil::Status Aggregation::Execute(
-    const std::vector<std::function<bool(const std::any&, std::any*)>>& aggregation_functions,
-    const std::vector<std::any>& group_by_operator_record) {
-  bool ret = false;
-  for (size_t i = 0; i < group_by_operator_record.size(); i++) {
-    ret = aggregation_functions[i](group_by_operator_record[i], &(*result_record_)[i]);
-    if (!ret) {
-      std::string error_message = fmt::format("Execute failed index :  {}", i);
-      DINGO_LOG(ERROR) << error_message;
-      return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
-    }
-  }
-  return butil::Status();
-}
-
-void Aggregation::Close() {
-  if (result_record_) {
-    result_record_.reset();
-  }
-}
-
 }  // namespace dingodb
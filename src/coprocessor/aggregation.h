@@ -18,8 +18,9 @@
 #include <serial/schema/base_schema.h>
 
 #include <any>
-#include <functional>
-#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <string>
 #include <vector>
 
 #include "butil/status.h"
@@ -27,30 +28,55 @@
 
 namespace dingodb {
 
-class Aggregation {
- public:
-  Aggregation();
-  ~Aggregation();
+namespace expr {
+class ColumnVector;
+}  // namespace expr
 
-  Aggregation(const Aggregation& rhs) = delete;
-  Aggregation& operator=(const Aggregation& rhs) = delete;
-  Aggregation(Aggregation&& rhs) = delete;
-  Aggregation& operator=(Aggregation&& rhs) = delete;
+// State of one aggregation operator in a group, the states of all groups are laid out contiguously.
+// String value is kept out of the state, s is the index of the strings.
+struct AggregationState {
+  bool has_value;
+  union {
+    bool b;
+    int32_t i32;
+    int64_t i64;
+    float f;
+    double d;
+    size_t s;
+  } value;
+};
 
-  butil::Status Open(
-      size_t start_aggregation_operators_index,
-      const std::shared_ptr<std::vector<std::shared_ptr<BaseSchema>>>& result_serial_schemas,
-      const ::google::protobuf::RepeatedPtrField<pb::store::AggregationOperator>& aggregation_operators);
+// Update is called for every row, merge is for the groups spilled to disk.
+struct AggregationFunction {
+  bool (*update)(const std::any& param, AggregationState* state, std::vector<std::string>* strings);
+  // Column-wise update of a batch, the state of row rows[k] is states[groups[k] * stride].
+  // string_bytes is increased by the grown capacity of strings.
+  bool (*update_batch)(const expr::ColumnVector& param, const uint32_t* rows, const uint32_t* groups, size_t size,
+                       AggregationState* states, size_t stride, std::vector<std::string>* strings,
+                       size_t* string_bytes);
+  void (*merge)(const AggregationState& from, const std::vector<std::string>& from_strings, AggregationState* to,
+                std::vector<std::string>* to_strings);
+  BaseSchema::Type result_type;
+  // COUNT, COUNTWITHNULL and SUM0 start from zero, others start from null.
+  bool init_zero;
+};
+
+class Aggregation {
+ public:
+  Aggregation() = delete;
 
-  butil::Status Execute(const std::vector<std::function<bool(const std::any&, std::any*)>>& aggregation_functions,
-                        const std::vector<std::any>& group_by_operator_record);
+  static void InitState(const AggregationFunction& function, AggregationState* state,
+                        std::vector<std::string>* strings);
 
-  const std::shared_ptr<std::vector<std::any>>& GetResult() const { return result_record_; }
+  // std::optional<T> of the result type.
+  static std::any GetResult(const AggregationFunction& function, const AggregationState& state,
+                            const std::vector<std::string>& strings);
 
-  void Close();
+  static void EncodeState(const AggregationFunction& function, const AggregationState& state,
+                          const std::vector<std::string>& strings, std::string* output);
 
- private:
-  std::shared_ptr<std::vector<std::any>> result_record_;
+  static butil::Status DecodeState(const AggregationFunction& function, const char** data, const char* end,
+                                   AggregationState* state, std::vector<std::string>* strings);
 };
 
 }  // namespace dingodb
@@ -14,8 +14,14 @@
 
 #include "coprocessor/aggregation_manager.h"
 
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
 #include <cstdint>
-#include <exception>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
@@ -24,201 +30,530 @@
 
 #include "common/logging.h"
 #include "fmt/core.h"
+#include "gflags/gflags.h"
+#include "proto/error.pb.h"
 #include "proto/store.pb.h"
 
+// Must be after proto, otherwise it will cause naming collision. such as TYPE_STRING
+#include "expr/vector_runner.h"
+
 namespace dingodb {
 
+DEFINE_int64(coprocessor_aggregation_memory_limit, 256 * 1024 * 1024,
+             "coprocessor aggregation memory limit of groups, spill to disk when exceed, 0 is unlimited");
+
+static const size_t kAggregationInitSlots = 1024;
+
+template <typename T>
+T& StateValue(AggregationState* state) {
+  if constexpr (std::is_same_v<T, bool>) {
+    return state->value.b;
+  } else if constexpr (std::is_same_v<T, int32_t>) {
+    return state->value.i32;
+  } else if constexpr (std::is_same_v<T, int64_t>) {
+    return state->value.i64;
+  } else if constexpr (std::is_same_v<T, float>) {
+    return state->value.f;
+  } else {
+    static_assert(std::is_same_v<T, double>, "StateValue : unsupported type");
+    return state->value.d;
+  }
+}
+
+template <typename T>
+T StateValue(const AggregationState& state) {
+  return StateValue<T>(const_cast<AggregationState*>(&state));
+}
+
+// Merge of SUM and COUNT, add the states.
+template <typename RESULT>
+void MergeAdd(const AggregationState& from, [[maybe_unused]] const std::vector<std::string>& from_strings,
+              AggregationState* to, [[maybe_unused]] std::vector<std::string>* to_strings) {
+  if (!from.has_value) {
+    return;
+  }
+
+  if (!to->has_value) {
+    *to = from;
+  } else {
+    StateValue<RESULT>(to) += StateValue<RESULT>(from);
+  }
+}
+
+// The param column of the batch should be the type of the function.
+template <typename PARAM>
+bool CheckParamColumn(const expr::ColumnVector& param, const char* name) {
+  if (param.Type() != expr::ColumnVector::TypeOf<PARAM>()) {
+    DINGO_LOG(ERROR) << fmt::format("{}<{}> bad param column type : {}", name, typeid(PARAM).name(),
+                                    static_cast<int>(param.Type()));
+    return false;
+  }
+  return true;
+}
+
 template <typename PARAM, typename RESULT>
 struct SUM {
-  bool operator()(const std::any& param, std::any* result) {
-    static_assert(
-        !(std::is_same_v<std::string, PARAM> || std::is_same_v<std::string, RESULT> ||
-          std::is_same_v<std::shared_ptr<std::string>, PARAM> || std::is_same_v<std::shared_ptr<std::string>, RESULT>),
-        "SUM : unsupported shared_ptr<std::string> or std::string");
-
-    try {
-      const std::optional<PARAM>& param_value = std::any_cast<const std::optional<PARAM>&>(param);
-      std::optional<RESULT>& result_value = std::any_cast<std::optional<RESULT>&>(*result);
-
-      if (param_value.has_value() && !result_value.has_value()) {
-        result_value = param_value;
-      } else if (!param_value.has_value() && !result_value.has_value()) {
-        return true;
-      } else if (!param_value.has_value() && result_value.has_value()) {
-        return true;
-      } else {
-        result_value.value() += param_value.value();
-      }
-    } catch (const std::exception& my_exception) {
-      DINGO_LOG(ERROR) << fmt::format("SUM<{},{}> exception : {}", typeid(PARAM).name(), typeid(RESULT).name(),
-                                      my_exception.what());
+  static_assert(
+      !(std::is_same_v<std::string, PARAM> || std::is_same_v<std::string, RESULT> ||
+        std::is_same_v<std::shared_ptr<std::string>, PARAM> || std::is_same_v<std::shared_ptr<std::string>, RESULT>),
+      "SUM : unsupported shared_ptr<std::string> or std::string");
+
+  static void Add(const PARAM& value, AggregationState* state) {
+    if (!state->has_value) {
+      state->has_value = true;
+      StateValue<RESULT>(state) = value;
+    } else {
+      StateValue<RESULT>(state) += value;
+    }
+  }
+
+  static bool Update(const std::any& param, AggregationState* state,
+                     [[maybe_unused]] std::vector<std::string>* strings) {
+    const auto* param_value = std::any_cast<std::optional<PARAM>>(&param);
+    if (param_value == nullptr) {
+      DINGO_LOG(ERROR) << fmt::format("SUM<{},{}> bad param type : {}", typeid(PARAM).name(), typeid(RESULT).name(),
+                                      param.type().name());
       return false;
     }
 
+    if (param_value->has_value()) {
+      Add(param_value->value(), state);
+    }
+
     return true;
   }
+
+  static bool UpdateBatch(const expr::ColumnVector& param, const uint32_t* rows, const uint32_t* groups, size_t size,
+                          AggregationState* states, size_t stride, [[maybe_unused]] std::vector<std::string>* strings,
+                          [[maybe_unused]] size_t* string_bytes) {
+    if (!CheckParamColumn<PARAM>(param, "SUM")) {
+      return false;
+    }
+
+    const auto* values = param.Values<expr::ColumnVector::Storage<PARAM>>();
+    const auto* nulls = param.Nulls();
+    for (size_t k = 0; k < size; k++) {
+      uint32_t row = rows[k];
+      if (nulls[row] == 0) {
+        Add(static_cast<PARAM>(values[row]), states + groups[k] * stride);
+      }
+    }
+
+    return true;
+  }
+
+  static void Merge(const AggregationState& from, const std::vector<std::string>& from_strings, AggregationState* to,
+                    std::vector<std::string>* to_strings) {
+    MergeAdd<RESULT>(from, from_strings, to, to_strings);
+  }
 };
 
+template <typename RESULT>
+void AddOne(AggregationState* state) {
+  if (!state->has_value) {
+    state->has_value = true;
+    StateValue<RESULT>(state) = 1;
+  } else {
+    StateValue<RESULT>(state) += 1;
+  }
+}
+
 template <typename PARAM, typename RESULT>
 struct COUNT {
-  bool operator()(const std::any& param, std::any* result) {
-    try {
-      const std::optional<PARAM>& param_value = std::any_cast<const std::optional<PARAM>&>(param);
-      std::optional<RESULT>& result_value = std::any_cast<std::optional<RESULT>&>(*result);
-
-      if (param_value.has_value() && !result_value.has_value()) {
-        result_value = 1;
-      } else if (!param_value.has_value() && !result_value.has_value()) {
-        return true;
-      } else if (!param_value.has_value() && result_value.has_value()) {
-        return true;
-      } else {
-        result_value.value() += 1;
-      }
-    } catch (const std::exception& my_exception) {
-      DINGO_LOG(ERROR) << fmt::format("COUNT<{},{}> exception : {}", typeid(PARAM).name(), typeid(RESULT).name(),
-                                      my_exception.what());
+  static bool Update(const std::any& param, AggregationState* state,
+                     [[maybe_unused]] std::vector<std::string>* strings) {
+    const auto* param_value = std::any_cast<std::optional<PARAM>>(&param);
+    if (param_value == nullptr) {
+      DINGO_LOG(ERROR) << fmt::format("COUNT<{},{}> bad param type : {}", typeid(PARAM).name(), typeid(RESULT).name(),
+                                      param.type().name());
       return false;
     }
 
+    if (param_value->has_value()) {
+      AddOne<RESULT>(state);
+    }
+
     return true;
   }
+
+  static bool UpdateBatch(const expr::ColumnVector& param, const uint32_t* rows, const uint32_t* groups, size_t size,
+                          AggregationState* states, size_t stride, [[maybe_unused]] std::vector<std::string>* strings,
+                          [[maybe_unused]] size_t* string_bytes) {
+    if (!CheckParamColumn<PARAM>(param, "COUNT")) {
+      return false;
+    }
+
+    const auto* nulls = param.Nulls();
+    for (size_t k = 0; k < size; k++) {
+      if (nulls[rows[k]] == 0) {
+        AddOne<RESULT>(states + groups[k] * stride);
+      }
+    }
+
+    return true;
+  }
+
+  static void Merge(const AggregationState& from, const std::vector<std::string>& from_strings, AggregationState* to,
+                    std::vector<std::string>* to_strings) {
+    MergeAdd<RESULT>(from, from_strings, to, to_strings);
+  }
 };
 
 template <typename PARAM, typename RESULT>
 struct COUNTWITHNULL {
-  bool operator()([[maybe_unused]] const std::any& param, std::any* result) {
-    try {
-      std::optional<RESULT>& result_value = std::any_cast<std::optional<RESULT>&>(*result);
-
-      if (!result_value.has_value()) {
-        result_value = 1;
-      } else {
-        result_value.value() += 1;
-      }
-    } catch (const std::exception& my_exception) {
-      DINGO_LOG(ERROR) << fmt::format("COUNTWITHNULL<{},{}> exception : {}", typeid(PARAM).name(),
-                                      typeid(RESULT).name(), my_exception.what());
+  static bool Update([[maybe_unused]] const std::any& param, AggregationState* state,
+                     [[maybe_unused]] std::vector<std::string>* strings) {
+    AddOne<RESULT>(state);
+    return true;
+  }
+
+  static bool UpdateBatch([[maybe_unused]] const expr::ColumnVector& param, [[maybe_unused]] const uint32_t* rows,
+                          const uint32_t* groups, size_t size, AggregationState* states, size_t stride,
+                          [[maybe_unused]] std::vector<std::string>* strings, [[maybe_unused]] size_t* string_bytes) {
+    for (size_t k = 0; k < size; k++) {
+      AddOne<RESULT>(states + groups[k] * stride);
+    }
+    return true;
+  }
+
+  static void Merge(const AggregationState& from, const std::vector<std::string>& from_strings, AggregationState* to,
+                    std::vector<std::string>* to_strings) {
+    MergeAdd<RESULT>(from, from_strings, to, to_strings);
+  }
+};
+
+// MAX if IS_MAX, otherwise MIN. String value is kept in strings.
+template <typename T, bool IS_MAX>
+struct EXTREMUM {
+  static constexpr bool kIsString = std::is_same_v<std::shared_ptr<std::string>, T>;
+
+  template <typename V>
+  static bool Better(const V& value, const V& current) {
+    if constexpr (IS_MAX) {
+      return current < value;
+    } else {
+      return current > value;
+    }
+  }
+
+  static void UpdateString(const std::string& value, AggregationState* state, std::vector<std::string>* strings) {
+    if (!state->has_value) {
+      state->has_value = true;
+      state->value.s = strings->size();
+      strings->emplace_back(value);
+    } else if (Better(value, (*strings)[state->value.s])) {
+      (*strings)[state->value.s] = value;
+    }
+  }
+
+  template <typename V>
+  static void UpdateValue(const V& value, AggregationState* state) {
+    if (!state->has_value) {
+      state->has_value = true;
+      StateValue<V>(state) = value;
+    } else if (Better(value, StateValue<V>(*state))) {
+      StateValue<V>(state) = value;
+    }
+  }
+
+  static bool Update(const std::any& param, AggregationState* state, std::vector<std::string>* strings) {
+    const auto* param_value = std::any_cast<std::optional<T>>(&param);
+    if (param_value == nullptr) {
+      DINGO_LOG(ERROR) << fmt::format("{}<{}> bad param type : {}", IS_MAX ? "MAX" : "MIN", typeid(T).name(),
+                                      param.type().name());
       return false;
     }
 
+    if (!param_value->has_value()) {
+      return true;
+    }
+
+    if constexpr (kIsString) {
+      if (param_value->value() != nullptr) {
+        UpdateString(*(param_value->value()), state, strings);
+      }
+    } else {
+      UpdateValue(param_value->value(), state);
+    }
+
     return true;
   }
-};
 
-template <typename PARAM, typename RESULT>
-struct MAX {
-  bool operator()(const std::any& param, std::any* result) {
-    try {
-      const std::optional<PARAM>& param_value = std::any_cast<const std::optional<PARAM>&>(param);
-      std::optional<RESULT>& result_value = std::any_cast<std::optional<RESULT>&>(*result);
-
-      if (param_value.has_value() && !result_value.has_value()) {
-        if constexpr (std::is_same_v<std::shared_ptr<std::string>, PARAM> &&
-                      !std::is_same_v<std::shared_ptr<std::string>, RESULT>) {
-          result_value = *(param_value.value());
-
-        } else if constexpr (!std::is_same_v<std::shared_ptr<std::string>, PARAM> &&  // NOLINT
-                             std::is_same_v<std::shared_ptr<std::string>, RESULT>) {
-          result_value.value() = std::make_shared<std::string>(param_value);
-
-        } else {
-          result_value = param_value;
-        }
+  static bool UpdateBatch(const expr::ColumnVector& param, const uint32_t* rows, const uint32_t* groups, size_t size,
+                          AggregationState* states, size_t stride, std::vector<std::string>* strings,
+                          size_t* string_bytes) {
+    if (!CheckParamColumn<T>(param, IS_MAX ? "MAX" : "MIN")) {
+      return false;
+    }
 
-      } else if (!param_value.has_value() && !result_value.has_value()) {
-        return true;
-      } else if (!param_value.has_value() && result_value.has_value()) {
-        return true;
-      } else {
-        if constexpr (std::is_same_v<std::shared_ptr<std::string>, PARAM> &&
-                      !std::is_same_v<std::shared_ptr<std::string>, RESULT>) {
-          if (result_value.value() < *(param_value.value())) {
-            result_value = *(param_value.value());
-          }
-        } else if constexpr (std::is_same_v<std::shared_ptr<std::string>, PARAM> &&  // NOLINT
-                             std::is_same_v<std::shared_ptr<std::string>, RESULT>) {
-          if (*(result_value.value()) < *(param_value.value())) {
-            result_value = param_value;
-          }
-        } else if constexpr (!std::is_same_v<std::shared_ptr<std::string>, PARAM> &&  // NOLINT
-                             std::is_same_v<std::shared_ptr<std::string>, RESULT>) {
-          if (*(result_value.value()) < param_value.value()) {
-            *(result_value.value()) = param_value;
-          }
-        } else {
-          if (result_value.value() < param_value.value()) {
-            result_value = param_value;
-          }
+    const auto* nulls = param.Nulls();
+    if constexpr (kIsString) {
+      const auto* values = param.Strings();
+      for (size_t k = 0; k < size; k++) {
+        uint32_t row = rows[k];
+        if (nulls[row] != 0 || values[row] == nullptr) {
+          continue;
+        }
+        AggregationState* state = states + groups[k] * stride;
+        size_t const old_bytes = state->has_value ? (*strings)[state->value.s].capacity() : 0;
+        UpdateString(*values[row], state, strings);
+        *string_bytes += (*strings)[state->value.s].capacity() - old_bytes;
+      }
+    } else {
+      const auto* values = param.Values<expr::ColumnVector::Storage<T>>();
+      for (size_t k = 0; k < size; k++) {
+        uint32_t row = rows[k];
+        if (nulls[row] == 0) {
+          UpdateValue(static_cast<T>(values[row]), states + groups[k] * stride);
         }
       }
-    } catch (const std::exception& my_exception) {
-      DINGO_LOG(ERROR) << fmt::format("MAX<{},{}> exception : {}", typeid(PARAM).name(), typeid(RESULT).name(),
-                                      my_exception.what());
-      return false;
     }
 
     return true;
   }
+
+  static void Merge(const AggregationState& from, const std::vector<std::string>& from_strings, AggregationState* to,
+                    std::vector<std::string>* to_strings) {
+    if (!from.has_value) {
+      return;
+    }
+
+    if constexpr (kIsString) {
+      UpdateString(from_strings[from.value.s], to, to_strings);
+    } else {
+      if (!to->has_value || Better(StateValue<T>(from), StateValue<T>(*to))) {
+        *to = from;
+      }
+    }
+  }
 };
 
 template <typename PARAM, typename RESULT>
-struct MIN {
-  bool operator()(const std::any& param, std::any* result) {
-    try {
-      const std::optional<PARAM>& param_value = std::any_cast<const std::optional<PARAM>&>(param);
-      std::optional<RESULT>& result_value = std::any_cast<std::optional<RESULT>&>(*result);
-
-      if (param_value.has_value() && !result_value.has_value()) {
-        if constexpr (std::is_same_v<std::shared_ptr<std::string>, PARAM> &&
-                      !std::is_same_v<std::shared_ptr<std::string>, RESULT>) {
-          result_value = *(param_value.value());
-
-        } else if constexpr (!std::is_same_v<std::shared_ptr<std::string>, PARAM> &&  // NOLINT
-                             std::is_same_v<std::shared_ptr<std::string>, RESULT>) {
-          result_value.value() = std::make_shared<std::string>(param_value);
-
-        } else {
-          result_value = param_value;
-        }
+using MAX = EXTREMUM<PARAM, true>;
 
-      } else if (!param_value.has_value() && !result_value.has_value()) {
-        return true;
-      } else if (!param_value.has_value() && result_value.has_value()) {
-        return true;
-      } else {
-        if constexpr (std::is_same_v<std::shared_ptr<std::string>, PARAM> &&
-                      !std::is_same_v<std::shared_ptr<std::string>, RESULT>) {
-          if (result_value.value() > *(param_value.value())) {
-            result_value = *(param_value.value());
-          }
-        } else if constexpr (std::is_same_v<std::shared_ptr<std::string>, PARAM> &&  // NOLINT
-                             std::is_same_v<std::shared_ptr<std::string>, RESULT>) {
-          if (*(result_value.value()) > *(param_value.value())) {
-            result_value = param_value;
-          }
-        } else if constexpr (!std::is_same_v<std::shared_ptr<std::string>, PARAM> &&  // NOLINT
-                             std::is_same_v<std::shared_ptr<std::string>, RESULT>) {
-          if (*(result_value.value()) > param_value.value()) {
-            *(result_value.value()) = param_value;
-          }
-        } else {
-          if (result_value.value() > param_value.value()) {
-            result_value = param_value;
-          }
-        }
+template <typename PARAM, typename RESULT>
+using MIN = EXTREMUM<PARAM, false>;
+
+template <typename F>
+AggregationFunction MakeAggregationFunction(BaseSchema::Type result_type, bool init_zero) {
+  return AggregationFunction{&F::Update, &F::UpdateBatch, &F::Merge, result_type, init_zero};
+}
+
+AggregationSpillFile::~AggregationSpillFile() {
+  if (file_ != nullptr) {
+    std::fclose(file_);
+    file_ = nullptr;
+  }
+}
+
+static std::string spill_directory;
+
+void AggregationSpillFile::SetDirectory(const std::string& directory) { spill_directory = directory; }
+
+const std::string& AggregationSpillFile::GetDirectory() { return spill_directory; }
+
+butil::Status AggregationSpillFile::Open() {
+  if (spill_directory.empty()) {
+    // Removed automatically when closed.
+    file_ = std::tmpfile();
+  } else {
+    std::string path = fmt::format("{}/aggregation_XXXXXX", spill_directory);
+    int fd = mkstemp(path.data());
+    if (fd >= 0) {
+      // Unlink at once, the file is removed when closed, even if the process crash.
+      unlink(path.c_str());
+      file_ = fdopen(fd, "w+");
+      if (file_ == nullptr) {
+        close(fd);
       }
-    } catch (const std::exception& my_exception) {
-      DINGO_LOG(ERROR) << fmt::format("MIN<{},{}> exception : {}", typeid(PARAM).name(), typeid(RESULT).name(),
-                                      my_exception.what());
-      return false;
     }
+  }
+  if (file_ == nullptr) {
+    std::string error_message =
+        fmt::format("create aggregation spill file in {} failed, errno : {}", spill_directory, errno);
+    DINGO_LOG(ERROR) << error_message;
+    return butil::Status(pb::error::EINTERNAL, error_message);
+  }
+  return butil::Status();
+}
 
-    return true;
+butil::Status AggregationSpillFile::Write(std::string_view key, const std::string& states) {
+  uint32_t key_size = key.size();
+  uint32_t states_size = states.size();
+  if (std::fwrite(&key_size, sizeof(key_size), 1, file_) != 1 ||
+      std::fwrite(key.data(), 1, key_size, file_) != key_size ||
+      std::fwrite(&states_size, sizeof(states_size), 1, file_) != 1 ||
+      std::fwrite(states.data(), 1, states_size, file_) != states_size) {
+    std::string error_message = fmt::format("write aggregation spill file failed, errno : {}", errno);
+    DINGO_LOG(ERROR) << error_message;
+    return butil::Status(pb::error::EINTERNAL, error_message);
+  }
+  size_ += sizeof(key_size) + key_size + sizeof(states_size) + states_size;
+  return butil::Status();
+}
+
+butil::Status AggregationSpillFile::Rewind() {
+  if (std::fflush(file_) != 0 || std::fseek(file_, 0, SEEK_SET) != 0) {
+    std::string error_message = fmt::format("rewind aggregation spill file failed, errno : {}", errno);
+    DINGO_LOG(ERROR) << error_message;
+    return butil::Status(pb::error::EINTERNAL, error_message);
+  }
+  return butil::Status();
+}
+
+butil::Status AggregationSpillFile::Read(std::string* key, std::string* states, bool* eof) {
+  *eof = false;
+  uint32_t size = 0;
+  if (std::fread(&size, sizeof(size), 1, file_) != 1) {
+    if (std::feof(file_) != 0 && std::ferror(file_) == 0) {
+      *eof = true;
+      return butil::Status();
+    }
+    std::string error_message = fmt::format("read aggregation spill file failed, errno : {}", errno);
+    DINGO_LOG(ERROR) << error_message;
+    return butil::Status(pb::error::EINTERNAL, error_message);
   }
-};
 
-AggregationManager::AggregationManager() = default;
+  key->resize(size);
+  bool is_ok = std::fread(key->data(), 1, size, file_) == size;
+  if (is_ok) {
+    is_ok = std::fread(&size, sizeof(size), 1, file_) == 1;
+  }
+  if (is_ok) {
+    states->resize(size);
+    is_ok = std::fread(states->data(), 1, size, file_) == size;
+  }
+  if (!is_ok) {
+    std::string error_message =
+        fmt::format("read aggregation spill file failed, truncated : {} errno : {}", std::feof(file_) != 0, errno);
+    DINGO_LOG(ERROR) << error_message;
+    return butil::Status(pb::error::EINTERNAL, error_message);
+  }
+  return butil::Status();
+}
+
+AggregationIterator::AggregationIterator(AggregationManager* aggregation_manager)
+    : aggregation_manager_(aggregation_manager), has_next_(false), position_(0) {
+  order_ = aggregation_manager_->GetSortedGroups();
+
+  if (aggregation_manager_->spill_files_.empty()) {
+    LoadFromMemory();
+    return;
+  }
+
+  for (size_t i = 0; i < aggregation_manager_->spill_files_.size(); i++) {
+    status_ = aggregation_manager_->spill_files_[i]->Rewind();
+    if (!status_.ok()) {
+      return;
+    }
+  }
+  for (size_t i = 0; i <= aggregation_manager_->spill_files_.size(); i++) {
+    status_ = ReadSource(i);
+    if (!status_.ok()) {
+      return;
+    }
+  }
+  status_ = LoadFromMerge();
+}
+
+butil::Status AggregationIterator::Next() {
+  if (!status_.ok()) {
+    return status_;
+  }
+
+  if (aggregation_manager_->spill_files_.empty()) {
+    position_++;
+    LoadFromMemory();
+  } else {
+    status_ = LoadFromMerge();
+  }
+  return status_;
+}
+
+void AggregationIterator::LoadFromMemory() {
+  has_next_ = position_ < order_.size();
+  if (!has_next_) {
+    return;
+  }
+
+  uint32_t group = order_[position_];
+  key_ = aggregation_manager_->GetGroupKey(group);
+  value_ = aggregation_manager_->GetResult(aggregation_manager_->GetGroupStates(group), aggregation_manager_->strings_);
+}
+
+butil::Status AggregationIterator::LoadFromMerge() {
+  has_next_ = false;
+  if (heap_.empty()) {
+    return butil::Status();
+  }
+
+  MergeEntry entry = heap_.top();
+  heap_.pop();
+  auto status = ReadSource(entry.source);
+  if (!status.ok()) {
+    return status;
+  }
+
+  key_ = std::move(entry.key);
+  merge_strings_.clear();
+  status = aggregation_manager_->DecodeStates(entry.states, &merge_states_, &merge_strings_);
+  if (!status.ok()) {
+    DINGO_LOG(ERROR) << fmt::format("decode aggregation states failed, {}", status.error_cstr());
+    return status;
+  }
+
+  // The same group may be in every source.
+  const auto& functions = aggregation_manager_->functions_;
+  while (!heap_.empty() && heap_.top().key == key_) {
+    entry = heap_.top();
+    heap_.pop();
+    status = ReadSource(entry.source);
+    if (!status.ok()) {
+      return status;
+    }
+
+    temp_strings_.clear();
+    status = aggregation_manager_->DecodeStates(entry.states, &temp_states_, &temp_strings_);
+    if (!status.ok()) {
+      DINGO_LOG(ERROR) << fmt::format("decode aggregation states failed, {}", status.error_cstr());
+      return status;
+    }
+    for (size_t i = 0; i < functions.size(); i++) {
+      functions[i].merge(temp_states_[i], temp_strings_, &merge_states_[i], &merge_strings_);
+    }
+  }
+
+  value_ = aggregation_manager_->GetResult(merge_states_.data(), merge_strings_);
+  has_next_ = true;
+  return butil::Status();
+}
+
+butil::Status AggregationIterator::ReadSource(size_t source) {
+  MergeEntry entry;
+  entry.source = source;
+
+  const auto& spill_files = aggregation_manager_->spill_files_;
+  if (source < spill_files.size()) {
+    bool eof = false;
+    auto status = spill_files[source]->Read(&entry.key, &entry.states, &eof);
+    if (!status.ok() || eof) {
+      return status;
+    }
+  } else {
+    // Groups in memory.
+    if (position_ >= order_.size()) {
+      return butil::Status();
+    }
+    uint32_t group = order_[position_++];
+    entry.key = aggregation_manager_->GetGroupKey(group);
+    aggregation_manager_->EncodeGroupStates(group, &entry.states);
+  }
+
+  heap_.push(std::move(entry));
+  return butil::Status();
+}
+
+AggregationManager::AggregationManager() : string_bytes_(0) {}
 AggregationManager::~AggregationManager() { Close(); }
 
 butil::Status AggregationManager::Open(
@@ -233,7 +568,7 @@ butil::Status AggregationManager::Open(
   size_t start_aggregation_operators_index = result_serial_schemas->size() - aggregation_operators.size();
 
   size_t i = 0;
-  aggregation_functions_.reserve(aggregation_operators.size());
+  functions_.reserve(aggregation_operators.size());
   for (const auto& aggregation_operator : aggregation_operators) {
     int32_t index = aggregation_operator.index_of_column();
     const auto& oper = aggregation_operator.oper();
@@ -243,7 +578,7 @@ butil::Status AggregationManager::Open(
       case pb::store::AggregationType::SUM0:
         [[fallthrough]];
       case pb::store::AggregationType::SUM: {
-        status = AddSumFunction(serial_schema_type, result_schema_type);
+        status = AddSumFunction(serial_schema_type, result_schema_type, oper == pb::store::AggregationType::SUM0);
         if (!status.ok()) {
           DINGO_LOG(ERROR) << fmt::format(
               "AddSumFunction failed index : {} serial_schema_type : {} result_schema_type : {}", index,
@@ -319,33 +654,79 @@ butil::Status AggregationManager::Open(
 
 butil::Status AggregationManager::Execute(const std::string& group_by_key,
                                           const std::vector<std::any>& group_by_operator_record) {
-  butil::Status status;
-  std::shared_ptr<Aggregation> aggregation;
+  if (group_by_operator_record.size() > functions_.size()) {
+    std::string error_message = fmt::format("record size : {} exceed aggregation functions size : {}",
+                                            group_by_operator_record.size(), functions_.size());
+    DINGO_LOG(ERROR) << error_message;
+    return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
+  }
 
-  if (!aggregations_) {
-    using MapType = std::map<std::string, std::shared_ptr<Aggregation>>;
-    aggregations_ = std::make_shared<MapType>();
+  bool is_new = false;
+  uint32_t group = FindOrInsertGroup(group_by_key, &is_new);
+  AggregationState* states = GetGroupStates(group);
+
+  for (size_t i = 0; i < group_by_operator_record.size(); i++) {
+    // MAX and MIN of string append the first value, then replace it with a better one.
+    bool const is_string = functions_[i].result_type == BaseSchema::Type::kString;
+    size_t const old_bytes = is_string && states[i].has_value ? strings_[states[i].value.s].capacity() : 0;
+    if (!functions_[i].update(group_by_operator_record[i], &states[i], &strings_)) {
+      std::string error_message = fmt::format("Execute failed index :  {}", i);
+      DINGO_LOG(ERROR) << error_message;
+      return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
+    }
+    if (is_string && states[i].has_value) {
+      string_bytes_ += strings_[states[i].value.s].capacity() - old_bytes;
+    }
   }
 
-  const auto& iter = aggregations_->find(group_by_key);
-  if (iter == aggregations_->end()) {
-    const auto& [iter_new, _] = aggregations_->emplace(group_by_key, std::make_shared<Aggregation>());
-    aggregation = iter_new->second;
+  if (is_new && FLAGS_coprocessor_aggregation_memory_limit > 0 &&
+      MemoryUsage() > static_cast<size_t>(FLAGS_coprocessor_aggregation_memory_limit)) {
+    return Spill();
+  }
 
-    status = aggregation->Open(result_serial_schemas_->size() - group_by_operator_serial_schemas_->size(),
-                               result_serial_schemas_, aggregation_operators_);
-    if (!status.ok()) {
-      DINGO_LOG(ERROR) << fmt::format("Aggregation::Open failed");
-      return status;
-    }
-  } else {
-    aggregation = iter->second;
+  return butil::Status();
+}
+
+butil::Status AggregationManager::ExecuteBatch(const std::string* keys, const uint32_t* rows, size_t size,
+                                               const std::vector<const expr::ColumnVector*>& params) {
+  if (params.size() != functions_.size()) {
+    std::string error_message = fmt::format("param columns size : {} not equal aggregation functions size : {}",
+                                            params.size(), functions_.size());
+    DINGO_LOG(ERROR) << error_message;
+    return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
   }
 
-  status = aggregation->Execute(aggregation_functions_, group_by_operator_record);
-  if (!status.ok()) {
-    DINGO_LOG(ERROR) << fmt::format("Aggregation::Execute failed");
-    return status;
+  size_t begin = 0;
+  while (begin < size) {
+    // Find the groups of rows first, the states may be moved when insert a group.
+    // Stop at the new group exceed the memory limit, spill after update.
+    batch_groups_.clear();
+    bool is_spill = false;
+    size_t end = begin;
+    while (end < size && !is_spill) {
+      bool is_new = false;
+      batch_groups_.push_back(FindOrInsertGroup(keys[end], &is_new));
+      end++;
+      is_spill = is_new && FLAGS_coprocessor_aggregation_memory_limit > 0 &&
+                 MemoryUsage() > static_cast<size_t>(FLAGS_coprocessor_aggregation_memory_limit);
+    }
+
+    for (size_t i = 0; i < functions_.size(); i++) {
+      if (!functions_[i].update_batch(*params[i], rows + begin, batch_groups_.data(), end - begin, states_.data() + i,
+                                      functions_.size(), &strings_, &string_bytes_)) {
+        std::string error_message = fmt::format("ExecuteBatch failed index :  {}", i);
+        DINGO_LOG(ERROR) << error_message;
+        return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
+      }
+    }
+
+    if (is_spill) {
+      auto status = Spill();
+      if (!status.ok()) {
+        return status;
+      }
+    }
+    begin = end;
   }
 
   return butil::Status();
@@ -362,34 +743,169 @@ void AggregationManager::Close() {
     result_serial_schemas_.reset();
   }
 
-  aggregation_functions_.clear();
+  ClearGroups();
+  functions_.clear();
+  spill_files_.clear();
+}
 
-  if (aggregations_) {
-    aggregations_.reset();
-  }
+void AggregationManager::Reset() {
+  ClearGroups();
+  spill_files_.clear();
 }
 
 std::shared_ptr<AggregationIterator> AggregationManager::CreateIterator() {
-  if (!aggregations_) {
-    using MapType = std::map<std::string, std::shared_ptr<Aggregation>>;
-    aggregations_ = std::make_shared<MapType>();
+  DINGO_LOG(DEBUG) << "aggregations  size : " << groups_.size() << " spill files : " << spill_files_.size();
+  return std::make_shared<AggregationIterator>(this);
+}
+
+size_t AggregationManager::MemoryUsage() const {
+  return keys_.size() + groups_.size() * sizeof(Group) + states_.size() * sizeof(AggregationState) +
+         slots_.size() * sizeof(uint32_t) + strings_.size() * sizeof(std::string) + string_bytes_;
+}
+
+uint32_t AggregationManager::FindOrInsertGroup(const std::string& key, bool* is_new) {
+  if (slots_.empty()) {
+    slots_.resize(kAggregationInitSlots, 0);
+  }
+
+  uint64_t hash = std::hash<std::string_view>()(key);
+  size_t mask = slots_.size() - 1;
+  size_t pos = hash & mask;
+  // Linear probing.
+  while (slots_[pos] != 0) {
+    uint32_t group = slots_[pos] - 1;
+    if (groups_[group].hash == hash && GetGroupKey(group) == key) {
+      *is_new = false;
+      return group;
+    }
+    pos = (pos + 1) & mask;
+  }
+
+  uint32_t group = groups_.size();
+  groups_.push_back(Group{hash, keys_.size(), key.size()});
+  keys_.append(key);
+  states_.resize(states_.size() + functions_.size());
+  AggregationState* states = GetGroupStates(group);
+  for (size_t i = 0; i < functions_.size(); i++) {
+    Aggregation::InitState(functions_[i], &states[i], &strings_);
   }
-  DINGO_LOG(DEBUG) << "aggregations  size : " << aggregations_->size();
-  return std::make_shared<AggregationIterator>(aggregations_);
+  slots_[pos] = group + 1;
+  *is_new = true;
+
+  // Keep load factor under 0.5.
+  if (groups_.size() * 2 > slots_.size()) {
+    Rehash();
+  }
+
+  return group;
+}
+
+void AggregationManager::Rehash() {
+  std::vector<uint32_t> slots(slots_.size() * 2, 0);
+  size_t mask = slots.size() - 1;
+  for (uint32_t group = 0; group < groups_.size(); group++) {
+    size_t pos = groups_[group].hash & mask;
+    while (slots[pos] != 0) {
+      pos = (pos + 1) & mask;
+    }
+    slots[pos] = group + 1;
+  }
+  slots_.swap(slots);
+}
+
+void AggregationManager::ClearGroups() {
+  groups_.clear();
+  keys_.clear();
+  states_.clear();
+  strings_.clear();
+  string_bytes_ = 0;
+  // Keep the initial slots, release the grown ones.
+  if (slots_.size() > kAggregationInitSlots) {
+    slots_.clear();
+  } else {
+    std::fill(slots_.begin(), slots_.end(), 0);
+  }
+}
+
+butil::Status AggregationManager::Spill() {
+  auto spill_file = std::make_shared<AggregationSpillFile>();
+  auto status = spill_file->Open();
+  if (!status.ok()) {
+    return status;
+  }
+
+  std::string states;
+  auto order = GetSortedGroups();
+  for (auto group : order) {
+    states.clear();
+    EncodeGroupStates(group, &states);
+    status = spill_file->Write(GetGroupKey(group), states);
+    if (!status.ok()) {
+      return status;
+    }
+  }
+
+  DINGO_LOG(INFO) << fmt::format("aggregation spill groups : {} bytes : {} spill files : {}", order.size(),
+                                 spill_file->Size(), spill_files_.size() + 1);
+  spill_files_.push_back(spill_file);
+  ClearGroups();
+
+  return butil::Status();
+}
+
+std::vector<uint32_t> AggregationManager::GetSortedGroups() const {
+  std::vector<uint32_t> order(groups_.size());
+  for (uint32_t i = 0; i < order.size(); i++) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(),
+            [this](uint32_t lhs, uint32_t rhs) { return GetGroupKey(lhs) < GetGroupKey(rhs); });
+  return order;
+}
+
+void AggregationManager::EncodeGroupStates(uint32_t group, std::string* output) const {
+  const AggregationState* states = states_.data() + group * functions_.size();
+  for (size_t i = 0; i < functions_.size(); i++) {
+    Aggregation::EncodeState(functions_[i], states[i], strings_, output);
+  }
+}
+
+butil::Status AggregationManager::DecodeStates(const std::string& input, std::vector<AggregationState>* states,
+                                               std::vector<std::string>* strings) const {
+  states->resize(functions_.size());
+  const char* data = input.data();
+  const char* end = input.data() + input.size();
+  for (size_t i = 0; i < functions_.size(); i++) {
+    auto status = Aggregation::DecodeState(functions_[i], &data, end, &(*states)[i], strings);
+    if (!status.ok()) {
+      return status;
+    }
+  }
+  return butil::Status();
+}
+
+std::shared_ptr<std::vector<std::any>> AggregationManager::GetResult(const AggregationState* states,
+                                                                     const std::vector<std::string>& strings) const {
+  auto result = std::make_shared<std::vector<std::any>>();
+  result->reserve(functions_.size());
+  for (size_t i = 0; i < functions_.size(); i++) {
+    result->emplace_back(Aggregation::GetResult(functions_[i], states[i], strings));
+  }
+  return result;
 }
 
 butil::Status AggregationManager::AddSumFunction(BaseSchema::Type serial_schema_type,
-                                                 BaseSchema::Type result_schema_type) {
+                                                 BaseSchema::Type result_schema_type, bool init_zero) {
   if (serial_schema_type == BaseSchema::kBool && result_schema_type == BaseSchema::kBool) {
-    aggregation_functions_.emplace_back(SUM<bool, bool>());
+    functions_.emplace_back(MakeAggregationFunction<SUM<bool, bool>>(result_schema_type, init_zero));
   } else if (serial_schema_type == BaseSchema::kInteger && result_schema_type == BaseSchema::kInteger) {
-    aggregation_functions_.emplace_back(SUM<int32_t, int32_t>());
+    functions_.emplace_back(MakeAggregationFunction<SUM<int32_t, int32_t>>(result_schema_type, init_zero));
   } else if (serial_schema_type == BaseSchema::kFloat && result_schema_type == BaseSchema::kFloat) {
-    aggregation_functions_.emplace_back(SUM<float, float>());
+    functions_.emplace_back(MakeAggregationFunction<SUM<float, float>>(result_schema_type, init_zero));
   } else if (serial_schema_type == BaseSchema::kLong && result_schema_type == BaseSchema::kLong) {
-    aggregation_functions_.emplace_back(SUM<int64_t, int64_t>());
+    functions_.emplace_back(MakeAggregationFunction<SUM<int64_t, int64_t>>(result_schema_type, init_zero));
   } else if (serial_schema_type == BaseSchema::kDouble && result_schema_type == BaseSchema::kDouble) {
-    aggregation_functions_.emplace_back(SUM<double, double>());
+    functions_.emplace_back(MakeAggregationFunction<SUM<double, double>>(result_schema_type, init_zero));
   } else {
     std::string error_message =
         fmt::format("SUM<{},{}>  not support yet", BaseSchema::GetTypeString(serial_schema_type),
@@ -404,17 +920,18 @@ butil::Status AggregationManager::AddSumFunction(BaseSchema::Type serial_schema_
 butil::Status AggregationManager::AddCountFunction(BaseSchema::Type serial_schema_type,
                                                    BaseSchema::Type result_schema_type) {
   if (serial_schema_type == BaseSchema::kBool && result_schema_type == BaseSchema::kLong) {
-    aggregation_functions_.emplace_back(COUNT<bool, int64_t>());
+    functions_.emplace_back(MakeAggregationFunction<COUNT<bool, int64_t>>(result_schema_type, true));
   } else if (serial_schema_type == BaseSchema::kInteger && result_schema_type == BaseSchema::kLong) {
-    aggregation_functions_.emplace_back(COUNT<int32_t, int64_t>());
+    functions_.emplace_back(MakeAggregationFunction<COUNT<int32_t, int64_t>>(result_schema_type, true));
   } else if (serial_schema_type == BaseSchema::kFloat && result_schema_type == BaseSchema::kLong) {
-    aggregation_functions_.emplace_back(COUNT<float, int64_t>());
+    functions_.emplace_back(MakeAggregationFunction<COUNT<float, int64_t>>(result_schema_type, true));
   } else if (serial_schema_type == BaseSchema::kLong && result_schema_type == BaseSchema::kLong) {
-    aggregation_functions_.emplace_back(COUNT<int64_t, int64_t>());
+    functions_.emplace_back(MakeAggregationFunction<COUNT<int64_t, int64_t>>(result_schema_type, true));
   } else if (serial_schema_type == BaseSchema::kDouble && result_schema_type == BaseSchema::kLong) {
-    aggregation_functions_.emplace_back(COUNT<double, int64_t>());
+    functions_.emplace_back(MakeAggregationFunction<COUNT<double, int64_t>>(result_schema_type, true));
   } else if (serial_schema_type == BaseSchema::kString && result_schema_type == BaseSchema::kLong) {
-    aggregation_functions_.emplace_back(COUNT<std::shared_ptr<std::string>, int64_t>());
+    functions_.emplace_back(
+        MakeAggregationFunction<COUNT<std::shared_ptr<std::string>, int64_t>>(result_schema_type, true));
   } else {
     std::string error_message =
         fmt::format("COUNT<{},{}>  not support yet", BaseSchema::GetTypeString(serial_schema_type),
@@ -427,17 +944,18 @@ butil::Status AggregationManager::AddCountFunction(BaseSchema::Type serial_schem
 butil::Status AggregationManager::AddCountWithNullFunction(BaseSchema::Type serial_schema_type,
                                                            BaseSchema::Type result_schema_type) {
   if (serial_schema_type == BaseSchema::kBool && result_schema_type == BaseSchema::kLong) {
-    aggregation_functions_.emplace_back(COUNTWITHNULL<bool, int64_t>());
+    functions_.emplace_back(MakeAggregationFunction<COUNTWITHNULL<bool, int64_t>>(result_schema_type, true));
   } else if (serial_schema_type == BaseSchema::kInteger && result_schema_type == BaseSchema::kLong) {
-    aggregation_functions_.emplace_back(COUNTWITHNULL<int32_t, int64_t>());
+    functions_.emplace_back(MakeAggregationFunction<COUNTWITHNULL<int32_t, int64_t>>(result_schema_type, true));
   } else if (serial_schema_type == BaseSchema::kFloat && result_schema_type == BaseSchema::kLong) {
-    aggregation_functions_.emplace_back(COUNTWITHNULL<float, int64_t>());
+    functions_.emplace_back(MakeAggregationFunction<COUNTWITHNULL<float, int64_t>>(result_schema_type, true));
   } else if (serial_schema_type == BaseSchema::kLong && result_schema_type == BaseSchema::kLong) {
-    aggregation_functions_.emplace_back(COUNTWITHNULL<int64_t, int64_t>());
+    functions_.emplace_back(MakeAggregationFunction<COUNTWITHNULL<int64_t, int64_t>>(result_schema_type, true));
   } else if (serial_schema_type == BaseSchema::kDouble && result_schema_type == BaseSchema::kLong) {
-    aggregation_functions_.emplace_back(COUNTWITHNULL<double, int64_t>());
+    functions_.emplace_back(MakeAggregationFunction<COUNTWITHNULL<double, int64_t>>(result_schema_type, true));
   } else if (serial_schema_type == BaseSchema::kString && result_schema_type == BaseSchema::kLong) {
-    aggregation_functions_.emplace_back(COUNTWITHNULL<std::shared_ptr<std::string>, int64_t>());
+    functions_.emplace_back(
+        MakeAggregationFunction<COUNTWITHNULL<std::shared_ptr<std::string>, int64_t>>(result_schema_type, true));
   } else {
     std::string error_message =
         fmt::format("COUNTWITHNULL<{},{}>  not support yet", BaseSchema::GetTypeString(serial_schema_type),
@@ -450,17 +968,19 @@ butil::Status AggregationManager::AddCountWithNullFunction(BaseSchema::Type seri
 butil::Status AggregationManager::AddMaxFunction(BaseSchema::Type serial_schema_type,
                                                  BaseSchema::Type result_schema_type) {
   if (serial_schema_type == BaseSchema::kBool && result_schema_type == BaseSchema::kBool) {
-    aggregation_functions_.emplace_back(MAX<bool, bool>());
+    functions_.emplace_back(MakeAggregationFunction<MAX<bool, bool>>(result_schema_type, false));
   } else if (serial_schema_type == BaseSchema::kInteger && result_schema_type == BaseSchema::kInteger) {
-    aggregation_functions_.emplace_back(MAX<int32_t, int32_t>());
+    functions_.emplace_back(MakeAggregationFunction<MAX<int32_t, int32_t>>(result_schema_type, false));
   } else if (serial_schema_type == BaseSchema::kFloat && result_schema_type == BaseSchema::kFloat) {
-    aggregation_functions_.emplace_back(MAX<float, float>());
+    functions_.emplace_back(MakeAggregationFunction<MAX<float, float>>(result_schema_type, false));
   } else if (serial_schema_type == BaseSchema::kLong && result_schema_type == BaseSchema::kLong) {
-    aggregation_functions_.emplace_back(MAX<int64_t, int64_t>());
+    functions_.emplace_back(MakeAggregationFunction<MAX<int64_t, int64_t>>(result_schema_type, false));
   } else if (serial_schema_type == BaseSchema::kDouble && result_schema_type == BaseSchema::kDouble) {
-    aggregation_functions_.emplace_back(MAX<double, double>());
+    functions_.emplace_back(MakeAggregationFunction<MAX<double, double>>(result_schema_type, false));
   } else if (serial_schema_type == BaseSchema::kString && result_schema_type == BaseSchema::kString) {
-    aggregation_functions_.emplace_back(MAX<std::shared_ptr<std::string>, std::shared_ptr<std::string>>());
+    functions_.emplace_back(
+        MakeAggregationFunction<MAX<std::shared_ptr<std::string>, std::shared_ptr<std::string>>>(
+            result_schema_type, false));
   } else {
     std::string error_message =
         fmt::format("COUNTWITHNULL<{},{}>  not support yet", BaseSchema::GetTypeString(serial_schema_type),
@@ -473,17 +993,19 @@ butil::Status AggregationManager::AddMaxFunction(BaseSchema::Type serial_schema_
 butil::Status AggregationManager::AddMinFunction(BaseSchema::Type serial_schema_type,
                                                  BaseSchema::Type result_schema_type) {
   if (serial_schema_type == BaseSchema::kBool && result_schema_type == BaseSchema::kBool) {
-    aggregation_functions_.emplace_back(MIN<bool, bool>());
+    functions_.emplace_back(MakeAggregationFunction<MIN<bool, bool>>(result_schema_type, false));
   } else if (serial_schema_type == BaseSchema::kInteger && result_schema_type == BaseSchema::kInteger) {
-    aggregation_functions_.emplace_back(MIN<int32_t, int32_t>());
+    functions_.emplace_back(MakeAggregationFunction<MIN<int32_t, int32_t>>(result_schema_type, false));
   } else if (serial_schema_type == BaseSchema::kFloat && result_schema_type == BaseSchema::kFloat) {
-    aggregation_functions_.emplace_back(MIN<float, float>());
+    functions_.emplace_back(MakeAggregationFunction<MIN<float, float>>(result_schema_type, false));
   } else if (serial_schema_type == BaseSchema::kLong && result_schema_type == BaseSchema::kLong) {
-    aggregation_functions_.emplace_back(MIN<int64_t, int64_t>());
+    functions_.emplace_back(MakeAggregationFunction<MIN<int64_t, int64_t>>(result_schema_type, false));
   } else if (serial_schema_type == BaseSchema::kDouble && result_schema_type == BaseSchema::kDouble) {
-    aggregation_functions_.emplace_back(MIN<double, double>());
+    functions_.emplace_back(MakeAggregationFunction<MIN<double, double>>(result_schema_type, false));
   } else if (serial_schema_type == BaseSchema::kString && result_schema_type == BaseSchema::kString) {
-    aggregation_functions_.emplace_back(MIN<std::shared_ptr<std::string>, std::shared_ptr<std::string>>());
+    functions_.emplace_back(
+        MakeAggregationFunction<MIN<std::shared_ptr<std::string>, std::shared_ptr<std::string>>>(
+            result_schema_type, false));
   } else {
     std::string error_message =
         fmt::format("COUNTWITHNULL<{},{}>  not support yet", BaseSchema::GetTypeString(serial_schema_type),
@@ -18,10 +18,12 @@
 #include <serial/schema/base_schema.h>
 
 #include <any>
-#include <functional>
-#include <map>
+#include <cstdint>
+#include <cstdio>
 #include <memory>
+#include <queue>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "butil/status.h"
@@ -30,25 +32,85 @@
 
 namespace dingodb {
 
-class AggregationIterator {
+class AggregationManager;
+
+// Groups sorted by key in a temp file, deleted when closed.
+class AggregationSpillFile {
  public:
-  explicit AggregationIterator(const std::shared_ptr<std::map<std::string, std::shared_ptr<Aggregation>>>& aggregations)
-      : aggregations_(aggregations) {
-    iter_ = aggregations_->begin();
-  }
+  AggregationSpillFile() = default;
+  ~AggregationSpillFile();
+
+  // Spill files are created in the directory, it should be on the data disk, not a memory backed /tmp.
+  // Empty means the system temp directory.
+  static void SetDirectory(const std::string& directory);
+  static const std::string& GetDirectory();
+
+  AggregationSpillFile(const AggregationSpillFile& rhs) = delete;
+  AggregationSpillFile& operator=(const AggregationSpillFile& rhs) = delete;
+
+  butil::Status Open();
+  butil::Status Write(std::string_view key, const std::string& states);
+  // Flush and read from the beginning.
+  butil::Status Rewind();
+  // eof is set at the end, a truncated group is an error.
+  butil::Status Read(std::string* key, std::string* states, bool* eof);
+
+  size_t Size() const { return size_; }
+
+ private:
+  FILE* file_{nullptr};
+  size_t size_{0};
+};
 
-  ~AggregationIterator() { aggregations_.reset(); }
+// Iterate groups ordered by key, the spilled groups are merged with the groups in memory.
+class AggregationIterator {
+ public:
+  explicit AggregationIterator(AggregationManager* aggregation_manager);
+  ~AggregationIterator() = default;
 
-  bool HasNext() { return (iter_ != aggregations_->end()); }
-  void Next() { ++iter_; }
-  const std::string& GetKey() const { return iter_->first; }
-  const std::shared_ptr<std::vector<std::any>>& GetValue() const { return iter_->second->GetResult(); }
+  // Stop at the first error of reading spill files, check Status() after create and Next().
+  bool HasNext() { return has_next_; }
+  butil::Status Next();
+  const std::string& GetKey() const { return key_; }
+  const std::shared_ptr<std::vector<std::any>>& GetValue() const { return value_; }
+  const butil::Status& Status() const { return status_; }
 
  private:
-  std::shared_ptr<std::map<std::string, std::shared_ptr<Aggregation>>> aggregations_;
-  std::map<std::string, std::shared_ptr<Aggregation>>::iterator iter_;
+  struct MergeEntry {
+    std::string key;
+    std::string states;
+    size_t source;
+  };
+
+  struct MergeEntryGreater {
+    bool operator()(const MergeEntry& lhs, const MergeEntry& rhs) const { return lhs.key > rhs.key; }
+  };
+
+  void LoadFromMemory();
+  butil::Status LoadFromMerge();
+  // Read the next group of source into the heap.
+  butil::Status ReadSource(size_t source);
+
+  AggregationManager* aggregation_manager_;
+  butil::Status status_;
+  bool has_next_;
+  std::string key_;
+  std::shared_ptr<std::vector<std::any>> value_;
+
+  // Groups in memory ordered by key.
+  std::vector<uint32_t> order_;
+  size_t position_;
+
+  // Spill files and groups in memory as the last source.
+  std::priority_queue<MergeEntry, std::vector<MergeEntry>, MergeEntryGreater> heap_;
+  std::vector<AggregationState> merge_states_;
+  std::vector<std::string> merge_strings_;
+  std::vector<AggregationState> temp_states_;
+  std::vector<std::string> temp_strings_;
 };
 
+// Hash aggregation, open addressing table keyed by group key, states of groups are contiguous.
+// When memory exceed the limit, the groups are spilled to a temp file sorted by key.
 class AggregationManager {
  public:
   AggregationManager();
@@ -65,22 +127,73 @@ class AggregationManager {
 
   butil::Status Execute(const std::string& group_by_key, const std::vector<std::any>& group_by_operator_record);
 
+  // Column-wise execute of the selected rows of a batch, keys[k] is the group key of row rows[k],
+  // params[i] is the input column of the i-th aggregation operator.
+  butil::Status ExecuteBatch(const std::string* keys, const uint32_t* rows, size_t size,
+                             const std::vector<const expr::ColumnVector*>& params);
+
   std::shared_ptr<AggregationIterator> CreateIterator();
 
+  // Drop all groups, keep the functions.
+  void Reset();
+
   void Close();
 
+  size_t GroupCount() const { return groups_.size(); }
+  size_t SpillFileCount() const { return spill_files_.size(); }
+  size_t MemoryUsage() const;
+
  private:
-  butil::Status AddSumFunction(BaseSchema::Type serial_schema_type, BaseSchema::Type result_schema_type);
+  friend class AggregationIterator;
+
+  struct Group {
+    uint64_t hash;
+    size_t key_offset;
+    size_t key_size;
+  };
+
+  butil::Status AddSumFunction(BaseSchema::Type serial_schema_type, BaseSchema::Type result_schema_type,
+                               bool init_zero);
   butil::Status AddCountFunction(BaseSchema::Type serial_schema_type, BaseSchema::Type result_schema_type);
   butil::Status AddCountWithNullFunction(BaseSchema::Type serial_schema_type, BaseSchema::Type result_schema_type);
   butil::Status AddMaxFunction(BaseSchema::Type serial_schema_type, BaseSchema::Type result_schema_type);
   butil::Status AddMinFunction(BaseSchema::Type serial_schema_type, BaseSchema::Type result_schema_type);
 
+  uint32_t FindOrInsertGroup(const std::string& key, bool* is_new);
+  void Rehash();
+  void ClearGroups();
+  butil::Status Spill();
+
+  std::string_view GetGroupKey(uint32_t group) const {
+    return std::string_view(keys_.data() + groups_[group].key_offset, groups_[group].key_size);
+  }
+  AggregationState* GetGroupStates(uint32_t group) { return states_.data() + group * functions_.size(); }
+  std::vector<uint32_t> GetSortedGroups() const;
+  void EncodeGroupStates(uint32_t group, std::string* output) const;
+  butil::Status DecodeStates(const std::string& input, std::vector<AggregationState>* states,
+                             std::vector<std::string>* strings) const;
+  std::shared_ptr<std::vector<std::any>> GetResult(const AggregationState* states,
+                                                   const std::vector<std::string>& strings) const;
+
   std::shared_ptr<std::vector<std::shared_ptr<BaseSchema>>> group_by_operator_serial_schemas_;
   ::google::protobuf::RepeatedPtrField<pb::store::AggregationOperator> aggregation_operators_;
   std::shared_ptr<std::vector<std::shared_ptr<BaseSchema>>> result_serial_schemas_;
-  std::vector<std::function<bool(const std::any&, std::any*)>> aggregation_functions_;
-  std::shared_ptr<std::map<std::string, std::shared_ptr<Aggregation>>> aggregations_;
+  std::vector<AggregationFunction> functions_;
+
+  std::vector<Group> groups_;
+  // Arena of group keys.
+  std::string keys_;
+  // functions_.size() states for each group.
+  std::vector<AggregationState> states_;
+  std::vector<std::string> strings_;
+  // Capacity of strings_, MAX and MIN of string grow it when replace the value.
+  size_t string_bytes_;
+  // group index + 1, 0 is empty.
+  std::vector<uint32_t> slots_;
+  // Groups of the rows of a batch, reused by ExecuteBatch.
+  std::vector<uint32_t> batch_groups_;
+
+  std::vector<std::shared_ptr<AggregationSpillFile>> spill_files_;
 };
 
 }  // namespace dingodb
@@ -18,25 +18,61 @@
 #include <cstddef>
 #include <cstdint>
 #include <exception>
+#include <limits>
 #include <memory>
 #include <optional>
+#include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "common/helper.h"
 #include "common/logging.h"
+#include "coprocessor/coprocessor_plan.h"
 #include "coprocessor/utils.h"
 #include "fmt/core.h"
+#include "gflags/gflags.h"
 #include "proto/error.pb.h"
 #include "proto/store.pb.h"
 #include "serial/record_decoder.h"
 #include "serial/record_encoder.h"
 
 // Must be after proto, otherwise it will cause naming collision. such as TYPE_STRING
+#include "expr/range_analyzer.h"
 #include "expr/runner.h"
+#include "expr/vector_runner.h"
 
 namespace dingodb {
 
-Coprocessor::Coprocessor() : enable_expression_(true), end_of_group_by_(true) {}
+DEFINE_int32(coprocessor_batch_size, 1024, "rows of coprocessor vectorized execution batch, 0 means disable");
+DEFINE_int64(coprocessor_top_n_max_limit, 100000, "max limit of coprocessor order by limit");
+
+// Column type of the batch, the same as the value type of decoded record.
+static expr::byte ToColumnType(BaseSchema::Type type) {
+  switch (type) {
+    case BaseSchema::kBool:
+      return TYPE_BOOL;
+    case BaseSchema::kInteger:
+      return TYPE_INT32;
+    case BaseSchema::kFloat:
+      return TYPE_FLOAT;
+    case BaseSchema::kLong:
+      return TYPE_INT64;
+    case BaseSchema::kDouble:
+      return TYPE_DOUBLE;
+    case BaseSchema::kString:
+    default:
+      return TYPE_STRING;
+  }
+}
+
+Coprocessor::Coprocessor()
+    : enable_expression_(true),
+      end_of_group_by_(true),
+      stream_aggregation_(false),
+      has_key_range_(false),
+      end_of_top_n_(false),
+      top_n_position_(0) {}
 Coprocessor::~Coprocessor() { Close(); }
 
 butil::Status Coprocessor::Open(const pb::store::Coprocessor& coprocessor) {
@@ -44,6 +80,39 @@ butil::Status Coprocessor::Open(const pb::store::Coprocessor& coprocessor) {
 
   DINGO_LOG(DEBUG) << fmt::format("Coprocessor::Open Enter");
 
+  // The same coprocessor skip the setup
+  std::string plan_key = CoprocessorPlanCache::GenKey(coprocessor);
+  auto plan = CoprocessorPlanCache::GetInstance()->Get(plan_key);
+  if (plan == nullptr) {
+    plan = std::make_shared<CoprocessorPlan>();
+    status = BuildPlan(coprocessor, plan);
+    if (!status.ok()) {
+      DINGO_LOG(ERROR) << fmt::format("Coprocessor::BuildPlan failed");
+      return status;
+    }
+
+    CoprocessorPlanCache::GetInstance()->Put(plan_key, plan);
+  }
+
+  LoadPlan(plan);
+
+  DINGO_LOG(DEBUG) << fmt::format("Coprocessor::Open vectorized : {}", vector_runner_ != nullptr);
+
+  DINGO_LOG(DEBUG) << fmt::format("Coprocessor::Open Leave");
+
+  return butil::Status();
+}
+
+butil::Status Coprocessor::BuildPlan(const pb::store::Coprocessor& coprocessor,
+                                     std::shared_ptr<CoprocessorPlan>& plan) {
+  butil::Status status;
+
+  // Built from scratch, the plan is shared by other scans
+  group_by_key_serial_schemas_.reset();
+  group_by_operator_serial_schemas_.reset();
+  group_by_serial_schemas_.reset();
+  end_of_group_by_ = false;
+
   coprocessor_ = coprocessor;
 
   Utils::DebugCoprocessor(coprocessor_);
@@ -139,11 +208,63 @@ butil::Status Coprocessor::Open(const pb::store::Coprocessor& coprocessor) {
     return status;
   }
 
+  status = InitTopN(coprocessor_, &plan->sort_keys);
+  if (!status.ok()) {
+    DINGO_LOG(ERROR) << fmt::format("InitTopN failed");
+    return status;
+  }
+
   enable_expression_ = !coprocessor_.expression().empty();
 
   DINGO_LOG(DEBUG) << fmt::format("Coprocessor::Open enable_expression_ : {}", enable_expression_);
 
-  DINGO_LOG(DEBUG) << fmt::format("Coprocessor::Open Leave");
+  if (enable_expression_) {
+    // Decode once, every scan run on a copy
+    plan->runner = std::make_shared<expr::Runner>();
+    try {
+      plan->runner->Decode(reinterpret_cast<const expr::byte*>(coprocessor_.expression().c_str()),
+                           coprocessor_.expression().length());
+    } catch (const std::exception& my_exception) {
+      std::string error_message = fmt::format("expr::Runner Decode failed. exception : {}", my_exception.what());
+      DINGO_LOG(ERROR) << error_message;
+      return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
+    }
+
+    auto vector_runner = std::make_shared<expr::VectorRunner>();
+    bool is_vectorized = false;
+    try {
+      is_vectorized = vector_runner->Decode(reinterpret_cast<const expr::byte*>(coprocessor_.expression().c_str()),
+                                            coprocessor_.expression().length());
+    } catch (const std::exception& my_exception) {
+      DINGO_LOG(WARNING) << fmt::format("expr::VectorRunner Decode failed. exception : {}", my_exception.what());
+      is_vectorized = false;
+    }
+
+    if (is_vectorized && vector_runner->ResultType() == TYPE_BOOL) {
+      for (const auto& [index, type] : vector_runner->Columns()) {
+        if (index >= original_serial_schemas_sorted_->size() ||
+            ToColumnType((*original_serial_schemas_sorted_)[index]->GetType()) != type) {
+          is_vectorized = false;
+          break;
+        }
+      }
+    } else {
+      is_vectorized = false;
+    }
+
+    // Not support expression fallback to row by row
+    if (is_vectorized) {
+      plan->vector_runner = vector_runner;
+    }
+
+    plan->has_key_range = InitKeyRange(&plan->key_range);
+  }
+
+  GetOriginalColumnIndexes();
+
+  stream_aggregation_ = end_of_group_by_ && IsGroupByKeyPrefix();
+
+  DINGO_LOG(DEBUG) << fmt::format("Coprocessor::Open stream_aggregation_ : {}", stream_aggregation_);
 
   Utils::DebugSerialSchema(original_serial_schemas_, "original_serial_schemas");
   Utils::DebugSerialSchema(selection_serial_schemas_, "selection_serial_schemas");
@@ -152,67 +273,398 @@ butil::Status Coprocessor::Open(const pb::store::Coprocessor& coprocessor) {
   Utils::DebugSerialSchema(group_by_serial_schemas_, "group_by_serial_schemas");
   Utils::DebugSerialSchema(result_serial_schemas_, "result_serial_schemas");
 
+  plan->coprocessor = coprocessor_;
+  plan->original_serial_schemas = original_serial_schemas_;
+  plan->selection_serial_schemas = selection_serial_schemas_;
+  plan->group_by_key_serial_schemas = group_by_key_serial_schemas_;
+  plan->group_by_operator_serial_schemas = group_by_operator_serial_schemas_;
+  plan->group_by_serial_schemas = group_by_serial_schemas_;
+  plan->result_serial_schemas = result_serial_schemas_;
+  plan->original_serial_schemas_sorted = original_serial_schemas_sorted_;
+  plan->selection_serial_schemas_sorted = selection_serial_schemas_sorted_;
+  plan->result_serial_schemas_sorted = result_serial_schemas_sorted_;
+  plan->enable_expression = enable_expression_;
+  plan->end_of_group_by = end_of_group_by_;
+  plan->stream_aggregation = stream_aggregation_;
+  plan->original_column_indexes = original_column_indexes_;
+
   return butil::Status();
 }
 
+void Coprocessor::LoadPlan(const std::shared_ptr<CoprocessorPlan>& plan) {
+  // The schemas are shared by scans, never modify them
+  coprocessor_ = plan->coprocessor;
+  original_serial_schemas_ = plan->original_serial_schemas;
+  selection_serial_schemas_ = plan->selection_serial_schemas;
+  group_by_key_serial_schemas_ = plan->group_by_key_serial_schemas;
+  group_by_operator_serial_schemas_ = plan->group_by_operator_serial_schemas;
+  group_by_serial_schemas_ = plan->group_by_serial_schemas;
+  result_serial_schemas_ = plan->result_serial_schemas;
+  original_serial_schemas_sorted_ = plan->original_serial_schemas_sorted;
+  selection_serial_schemas_sorted_ = plan->selection_serial_schemas_sorted;
+  result_serial_schemas_sorted_ = plan->result_serial_schemas_sorted;
+  enable_expression_ = plan->enable_expression;
+  end_of_group_by_ = plan->end_of_group_by;
+  stream_aggregation_ = plan->stream_aggregation;
+  has_key_range_ = plan->has_key_range;
+  key_range_ = plan->key_range;
+  original_column_indexes_ = plan->original_column_indexes;
+
+  original_record_decoder_ = std::make_shared<RecordDecoder>(coprocessor_.schema_version(), original_serial_schemas_,
+                                                             coprocessor_.original_schema().common_id());
+
+  runner_.reset();
+  if (plan->runner) {
+    runner_ = std::make_shared<expr::Runner>(*plan->runner);
+  }
+
+  vector_runner_.reset();
+  batch_columns_.clear();
+  batch_aggregation_params_.clear();
+  if (plan->vector_runner && FLAGS_coprocessor_batch_size > 0) {
+    vector_runner_ = std::make_shared<expr::VectorRunner>(*plan->vector_runner);
+    batch_columns_.resize(original_serial_schemas_->size());
+    for (const auto& schema : *original_serial_schemas_) {
+      batch_columns_[schema->GetIndex()].Reset(ToColumnType(schema->GetType()), 0);
+    }
+    for (const auto& aggregation : coprocessor_.aggregation_operators()) {
+      int32_t index_of_column = (aggregation.index_of_column() < 0 ||
+                                 aggregation.index_of_column() >= coprocessor_.selection_columns().size())
+                                    ? 0
+                                    : aggregation.index_of_column();
+      batch_aggregation_params_.push_back(&batch_columns_[index_of_column]);
+    }
+  }
+
+  top_n_.reset();
+  end_of_top_n_ = false;
+  top_n_kvs_.clear();
+  top_n_position_ = 0;
+  if (!plan->sort_keys.empty()) {
+    top_n_ = std::make_shared<TopN>(plan->sort_keys, coprocessor_.limit());
+  }
+}
+
 butil::Status Coprocessor::Execute(const std::shared_ptr<EngineIterator>& iter, bool key_only, size_t max_fetch_cnt,
                                    uint64_t max_bytes_rpc, std::vector<pb::common::KeyValue>* kvs) {
   DINGO_LOG(DEBUG) << fmt::format("Coprocessor::Execute Enter");
+  if (vector_runner_) {
+    return ExecuteBatch(iter, key_only, max_fetch_cnt, max_bytes_rpc, kvs);
+  }
+
   ScanFilter scan_filter = ScanFilter(key_only, max_fetch_cnt, max_bytes_rpc);
   butil::Status status;
-  while (iter->HasNext()) {
-    pb::common::KeyValue key_value;
-    iter->GetKV(*key_value.mutable_key(), *key_value.mutable_value());
+  bool is_upto_limit = false;
+  // Rows discarded by the filter are never copied out of the iterator.
+  iter->Visit([&](std::string_view key, std::string_view value) -> bool {
     bool has_result_kv = false;
     pb::common::KeyValue result_key_value;
     DINGO_LOG(DEBUG) << fmt::format("Coprocessor::DoExecute Call");
-    status = DoExecute(key_value, &has_result_kv, &result_key_value);
+    status = DoExecute(key, value, &has_result_kv, &result_key_value);
     if (!status.ok()) {
       DINGO_LOG(ERROR) << fmt::format("Coprocessor::Execute failed");
-      return status;
+      return false;
     }
 
     if (!has_result_kv) {
-      iter->Next();
-      continue;
+      return true;
     }
 
     if (key_only) {
       result_key_value.set_value("");
     }
 
-    kvs->emplace_back(result_key_value);
+    kvs->emplace_back(std::move(result_key_value));
 
-    if (scan_filter.UptoLimit(result_key_value)) {
-      iter->Next();
-      return butil::Status();
-    }
-    iter->Next();
+    is_upto_limit = scan_filter.UptoLimit(kvs->back());
+    return !is_upto_limit;
+  });
+
+  if (!status.ok() || is_upto_limit) {
+    return status;
   }
 
   status = GetKeyValueFromAggregation(key_only, max_fetch_cnt, max_bytes_rpc, kvs);
+  if (!status.ok()) {
+    return status;
+  }
+
+  status = GetKeyValueFromTopN(key_only, max_fetch_cnt, max_bytes_rpc, kvs);
 
   DINGO_LOG(DEBUG) << fmt::format("Coprocessor::Execute Leave");
 
   return status;
 }
-butil::Status Coprocessor::DoExecute(const pb::common::KeyValue& kv, bool* has_result_kv,
-                                     pb::common::KeyValue* result_kv) {
+butil::Status Coprocessor::ExecuteBatch(const std::shared_ptr<EngineIterator>& iter, bool key_only,
+                                        size_t max_fetch_cnt, uint64_t max_bytes_rpc,
+                                        std::vector<pb::common::KeyValue>* kvs) {
+  ScanFilter scan_filter = ScanFilter(key_only, max_fetch_cnt, max_bytes_rpc);
+
+  // Results left by the last call
+  while (!pending_kvs_.empty()) {
+    kvs->emplace_back(std::move(pending_kvs_.front()));
+    pending_kvs_.pop_front();
+    if (scan_filter.UptoLimit(kvs->back())) {
+      return butil::Status();
+    }
+  }
+
+  size_t batch_size = FLAGS_coprocessor_batch_size > 0 ? FLAGS_coprocessor_batch_size : 1;
+  ResetBatchColumns(batch_size);
+
   butil::Status status;
+  bool is_upto_limit = false;
+  size_t count = 0;
+  iter->Visit([&](std::string_view key, std::string_view value) -> bool {
+    int ret = 0;
+    try {
+      // decode to the typed columns directly, throw std::bad_any_cast if the type of column mismatch
+      ret = original_record_decoder_->DecodeColumns(
+          key, value, original_column_indexes_,
+          [this, count](int index, auto&& column) { batch_columns_[index].SetValue(count, column); });
+    } catch (const std::exception& my_exception) {
+      std::string error_message = fmt::format("serial::Decode failed exception : {}", my_exception.what());
+      DINGO_LOG(ERROR) << error_message;
+      status = butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
+      return false;
+    }
 
-  RecordDecoder original_record_decoder(coprocessor_.schema_version(), original_serial_schemas_,
-                                        coprocessor_.original_schema().common_id());
+    if (ret < 0) {
+      std::string error_message = fmt::format("serial::Decode failed");
+      DINGO_LOG(ERROR) << error_message;
+      status = butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
+      return false;
+    }
+
+    if (++count < batch_size) {
+      return true;
+    }
+
+    status = DoExecuteBatch(count, key_only, scan_filter, kvs, &is_upto_limit);
+    count = 0;
+    return status.ok() && !is_upto_limit;
+  });
+
+  if (status.ok() && count > 0) {
+    status = DoExecuteBatch(count, key_only, scan_filter, kvs, &is_upto_limit);
+  }
+
+  if (!status.ok()) {
+    DINGO_LOG(ERROR) << fmt::format("Coprocessor::ExecuteBatch failed");
+    return status;
+  }
+
+  if (is_upto_limit) {
+    return status;
+  }
 
-  std::vector<std::any> original_record;
+  status = GetKeyValueFromAggregation(key_only, max_fetch_cnt, max_bytes_rpc, kvs);
+  if (!status.ok()) {
+    return status;
+  }
+
+  return GetKeyValueFromTopN(key_only, max_fetch_cnt, max_bytes_rpc, kvs);
+}
+
+void Coprocessor::ResetBatchColumns(size_t batch_size) {
+  for (auto& column : batch_columns_) {
+    column.Reset(column.Type(), batch_size);
+  }
+}
+
+butil::Status Coprocessor::DoExecuteBatch(size_t batch_size, bool key_only, ScanFilter& scan_filter,
+                                          std::vector<pb::common::KeyValue>* kvs, bool* is_upto_limit) {
+  butil::Status status;
+
+  batch_selection_.clear();
+  try {
+    vector_runner_->Select(batch_columns_, batch_size, batch_selection_);
+  } catch (const std::exception& my_exception) {
+    std::string error_message = fmt::format("expr::VectorRunner Run failed. exception : {}", my_exception.what());
+    DINGO_LOG(ERROR) << error_message;
+    return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
+  }
+
+  std::vector<pb::common::KeyValue> result_kvs;
+  if (end_of_group_by_) {  // group by
+    status = DoExecuteBatchForAggregation(&result_kvs);
+    if (!status.ok()) {
+      DINGO_LOG(ERROR) << fmt::format("Coprocessor::DoExecuteBatchForAggregation failed");
+      return status;
+    }
+  } else {  // selection
+    status = DoExecuteBatchForSelection(&result_kvs);
+    if (!status.ok()) {
+      DINGO_LOG(ERROR) << fmt::format("Coprocessor::DoExecuteBatchForSelection failed");
+      return status;
+    }
+  }
+
+  for (auto& result_key_value : result_kvs) {
+    if (key_only) {
+      result_key_value.set_value("");
+    }
+
+    // The rows of this batch are consumed from iterator, keep them for the next call.
+    if (*is_upto_limit) {
+      pending_kvs_.emplace_back(std::move(result_key_value));
+      continue;
+    }
+
+    kvs->emplace_back(std::move(result_key_value));
+    *is_upto_limit = scan_filter.UptoLimit(kvs->back());
+  }
+
+  return butil::Status();
+}
+
+butil::Status Coprocessor::DoExecuteBatchForSelection(std::vector<pb::common::KeyValue>* result_kvs) {
+  butil::Status status;
+
+  if (top_n_) {
+    original_record_.resize(batch_columns_.size());
+    for (auto row : batch_selection_) {
+      for (size_t i = 0; i < batch_columns_.size(); i++) {
+        original_record_[i] = batch_columns_[i].Get(row);
+      }
+
+      bool has_result_kv = false;
+      pb::common::KeyValue result_key_value;
+      status = DoExecuteForSelection(original_record_, &has_result_kv, &result_key_value);
+      if (!status.ok()) {
+        DINGO_LOG(ERROR) << fmt::format("Coprocessor::DoExecuteForSelection failed");
+        return status;
+      }
+      if (has_result_kv) {
+        result_kvs->emplace_back(std::move(result_key_value));
+      }
+    }
+    return butil::Status();
+  }
+
+  RecordEncoder result_record_encoder(coprocessor_.schema_version(), result_serial_schemas_,
+                                      coprocessor_.result_schema().common_id());
+  result_kvs->reserve(batch_selection_.size());
+  for (auto row : batch_selection_) {
+    pb::common::KeyValue result_key_value;
+    int ret = 0;
+    try {
+      ret = result_record_encoder.EncodeColumns(
+          [this, row](int index, auto& column) {
+            using T = typename std::decay_t<decltype(column)>::value_type;
+            column = batch_columns_.at(index).GetValue<T>(row);
+          },
+          result_key_value);
+    } catch (const std::exception& my_exception) {
+      std::string error_message = fmt::format("serial::Encode failed exception : {}", my_exception.what());
+      DINGO_LOG(ERROR) << error_message;
+      return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
+    }
+    if (ret < 0) {
+      std::string error_message = fmt::format("serial::Encode failed");
+      DINGO_LOG(ERROR) << error_message;
+      return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
+    }
+    result_kvs->emplace_back(std::move(result_key_value));
+  }
+
+  return butil::Status();
+}
+
+butil::Status Coprocessor::DoExecuteBatchForAggregation(std::vector<pb::common::KeyValue>* result_kvs) {
+  butil::Status status = OpenAggregationManager();
+  if (!status.ok()) {
+    return status;
+  }
+
+  size_t size = batch_selection_.size();
+  batch_group_keys_.resize(size);
+  if (group_by_key_serial_schemas_ && !group_by_key_serial_schemas_->empty()) {
+    RecordEncoder group_by_key_encoder(coprocessor_.schema_version(), group_by_key_serial_schemas_,
+                                       coprocessor_.result_schema().common_id());
+    for (size_t k = 0; k < size; k++) {
+      uint32_t row = batch_selection_[k];
+      batch_group_keys_[k].clear();
+      int ret = 0;
+      try {
+        // index of group by key schema is the position of group by columns
+        ret = group_by_key_encoder.EncodeKeyColumns(
+            [this, row](int index, auto& column) {
+              using T = typename std::decay_t<decltype(column)>::value_type;
+              column = batch_columns_.at(coprocessor_.group_by_columns(index)).GetValue<T>(row);
+            },
+            batch_group_keys_[k]);
+      } catch (const std::exception& my_exception) {
+        std::string error_message = fmt::format("serial::EncodeKey failed exception : {}", my_exception.what());
+        DINGO_LOG(ERROR) << error_message;
+        return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
+      }
+      if (ret < 0) {
+        std::string error_message = fmt::format("serial::EncodeKey failed");
+        DINGO_LOG(ERROR) << error_message;
+        return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
+      }
+    }
+  } else {
+    for (auto& group_by_key : batch_group_keys_) {
+      group_by_key.clear();
+    }
+  }
+
+  if (!stream_aggregation_) {
+    status = aggregation_manager_->ExecuteBatch(batch_group_keys_.data(), batch_selection_.data(), size,
+                                                batch_aggregation_params_);
+    if (!status.ok()) {
+      DINGO_LOG(ERROR) << fmt::format("AggregationManager::ExecuteBatch failed");
+    }
+    return status;
+  }
+
+  // Rows are in key order, execute the rows of a group together.
+  size_t begin = 0;
+  while (begin < size) {
+    size_t end = begin + 1;
+    while (end < size && batch_group_keys_[end] == batch_group_keys_[begin]) {
+      end++;
+    }
+
+    // The current group is finished when the key changed
+    if (batch_group_keys_[begin] != stream_group_key_) {
+      bool has_result_kv = false;
+      pb::common::KeyValue result_key_value;
+      status = FinishStreamGroup(&has_result_kv, &result_key_value);
+      if (!status.ok()) {
+        return status;
+      }
+      if (has_result_kv) {
+        result_kvs->emplace_back(std::move(result_key_value));
+      }
+      stream_group_key_ = batch_group_keys_[begin];
+    }
 
-  if (original_column_indexes_.empty()) {
-    GetOriginalColumnIndexes();
+    status = aggregation_manager_->ExecuteBatch(batch_group_keys_.data() + begin, batch_selection_.data() + begin,
+                                                end - begin, batch_aggregation_params_);
+    if (!status.ok()) {
+      DINGO_LOG(ERROR) << fmt::format("AggregationManager::ExecuteBatch failed");
+      return status;
+    }
+    begin = end;
   }
 
+  return butil::Status();
+}
+
+butil::Status Coprocessor::DoExecute(std::string_view key, std::string_view value, bool* has_result_kv,
+                                     pb::common::KeyValue* result_kv) {
+  butil::Status status;
+
+  // reused by every row, decode overwrite all columns
+  auto& original_record = original_record_;
+
   int ret = 0;
   try {
     // decode some column. not decode all
-    ret = original_record_decoder.Decode(kv, original_column_indexes_, original_record);
+    ret = original_record_decoder_->Decode(key, value, original_column_indexes_, original_record);
   } catch (const std::exception& my_exception) {
     std::string error_message = fmt::format("serial::Decode failed exception : {}", my_exception.what());
     DINGO_LOG(ERROR) << error_message;
@@ -245,16 +697,11 @@ butil::Status Coprocessor::DoExecute(const pb::common::KeyValue& kv, bool* has_r
 
   bool is_key_value_reserve = true;
   if (enable_expression_) {
-    expr::Runner runner;
-
     try {
-      runner.Decode(reinterpret_cast<const expr::byte*>(coprocessor_.expression().c_str()),
-                    coprocessor_.expression().length());
-
-      expr::wrap<bool> ok = runner.Run<bool>(reinterpret_cast<const expr::Tuple*>(&original_record));
+      expr::wrap<bool> ok = runner_->Run<bool>(reinterpret_cast<const expr::Tuple*>(&original_record));
       is_key_value_reserve = ok.has_value() && ok.value();
     } catch (const std::exception& my_exception) {
-      std::string error_message = fmt::format("expr::Runner Decode or Run failed. exception : {}", my_exception.what());
+      std::string error_message = fmt::format("expr::Runner Run failed. exception : {}", my_exception.what());
       DINGO_LOG(ERROR) << error_message;
       return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
     }
@@ -266,15 +713,14 @@ butil::Status Coprocessor::DoExecute(const pb::common::KeyValue& kv, bool* has_r
   }
 
   if (end_of_group_by_) {  // group by
-    status = DoExecuteForAggregation(original_record);
+    *has_result_kv = false;
+    status = DoExecuteForAggregation(original_record, has_result_kv, result_kv);
     if (!status.ok()) {
       std::string error_message = fmt::format("Coprocessor::DoExecuteForAggregation failed");
       DINGO_LOG(ERROR) << error_message;
       return status;
     }
 
-    *has_result_kv = false;
-
   } else {  // selection
     status = DoExecuteForSelection(original_record, has_result_kv, result_kv);
     if (!status.ok()) {
@@ -287,7 +733,8 @@ butil::Status Coprocessor::DoExecute(const pb::common::KeyValue& kv, bool* has_r
   return butil::Status();
 }
 
-butil::Status Coprocessor::DoExecuteForAggregation(const std::vector<std::any>& selection_record) {
+butil::Status Coprocessor::DoExecuteForAggregation(const std::vector<std::any>& selection_record,
+                                                   bool* has_result_kv, pb::common::KeyValue* result_kv) {
   butil::Status status;
   // group by
   std::vector<std::any> group_by_key_record;
@@ -362,14 +809,18 @@ butil::Status Coprocessor::DoExecuteForAggregation(const std::vector<std::any>&
 
   Utils::DebugGroupByKey(group_by_key, "group_by_key");
 
-  if (!aggregation_manager_) {
-    aggregation_manager_ = std::make_shared<AggregationManager>();
-    status = aggregation_manager_->Open(group_by_operator_serial_schemas_, coprocessor_.aggregation_operators(),
-                                        result_serial_schemas_sorted_);
+  status = OpenAggregationManager();
+  if (!status.ok()) {
+    return status;
+  }
+
+  // The current group is finished when the key changed
+  if (stream_aggregation_ && group_by_key != stream_group_key_) {
+    status = FinishStreamGroup(has_result_kv, result_kv);
     if (!status.ok()) {
-      DINGO_LOG(ERROR) << fmt::format("AggregationManager::Open failed");
       return status;
     }
+    stream_group_key_ = group_by_key;
   }
 
   status = aggregation_manager_->Execute(group_by_key, group_by_operator_record);
@@ -380,9 +831,63 @@ butil::Status Coprocessor::DoExecuteForAggregation(const std::vector<std::any>&
   return butil::Status();
 }
 
+butil::Status Coprocessor::OpenAggregationManager() {
+  if (aggregation_manager_) {
+    return butil::Status();
+  }
+
+  aggregation_manager_ = std::make_shared<AggregationManager>();
+  auto status = aggregation_manager_->Open(group_by_operator_serial_schemas_, coprocessor_.aggregation_operators(),
+                                           result_serial_schemas_sorted_);
+  if (!status.ok()) {
+    DINGO_LOG(ERROR) << fmt::format("AggregationManager::Open failed");
+    return status;
+  }
+  return butil::Status();
+}
+
+butil::Status Coprocessor::FinishStreamGroup(bool* has_result_kv, pb::common::KeyValue* result_kv) {
+  *has_result_kv = false;
+  if (aggregation_manager_->GroupCount() == 0) {
+    return butil::Status();
+  }
+
+  auto iter = aggregation_manager_->CreateIterator();
+  if (!iter->Status().ok()) {
+    DINGO_LOG(ERROR) << fmt::format("AggregationManager::CreateIterator failed");
+    return iter->Status();
+  }
+  auto status = EncodeAggregationResult(iter->GetKey(), *iter->GetValue(), result_kv);
+  if (!status.ok()) {
+    DINGO_LOG(ERROR) << fmt::format("Coprocessor::EncodeAggregationResult failed");
+    return status;
+  }
+  *has_result_kv = true;
+  aggregation_manager_->Reset();
+  return butil::Status();
+}
+
 butil::Status Coprocessor::DoExecuteForSelection(const std::vector<std::any>& selection_record, bool* has_result_kv,
                                                  pb::common::KeyValue* result_kv) {
   butil::Status status;
+
+  // Only encode the rows in the top n so far
+  if (top_n_) {
+    bool is_accepted = false;
+    try {
+      is_accepted = top_n_->Accept(selection_record);
+    } catch (const std::exception& my_exception) {
+      std::string error_message = fmt::format("TopN::Accept failed exception : {}", my_exception.what());
+      DINGO_LOG(ERROR) << error_message;
+      return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
+    }
+
+    if (!is_accepted) {
+      *has_result_kv = false;
+      return butil::Status();
+    }
+  }
+
   // selection
   RecordEncoder result_record_encoder(coprocessor_.schema_version(), result_serial_schemas_,
                                       coprocessor_.result_schema().common_id());
@@ -401,6 +906,13 @@ butil::Status Coprocessor::DoExecuteForSelection(const std::vector<std::any>& se
     return status;
   }
 
+  // Returned at the end of scan
+  if (top_n_) {
+    top_n_->Push(selection_record, std::move(result_key_value));
+    *has_result_kv = false;
+    return butil::Status();
+  }
+
   *has_result_kv = true;
   *result_kv = std::move(result_key_value);
 
@@ -415,83 +927,20 @@ butil::Status Coprocessor::GetKeyValueFromAggregation(bool key_only, size_t max_
     if (!aggregation_iterator_) {
       aggregation_iterator_ = aggregation_manager_->CreateIterator();
     }
+    // Read spill files failed, the result is incomplete.
+    if (!aggregation_iterator_->Status().ok()) {
+      DINGO_LOG(ERROR) << fmt::format("aggregation iterator failed, {}", aggregation_iterator_->Status().error_cstr());
+      return aggregation_iterator_->Status();
+    }
     ScanFilter scan_filter = ScanFilter(key_only, max_fetch_cnt, max_bytes_rpc);
 
-    RecordEncoder result_record_encoder(coprocessor_.schema_version(), result_serial_schemas_,
-                                        coprocessor_.result_schema().common_id());
-
     while (aggregation_iterator_->HasNext()) {
       Utils::DebugGroupByKey("", "Key Value pair");
-      const std::string& key = aggregation_iterator_->GetKey();
-      const std::shared_ptr<std::vector<std::any>>& value = aggregation_iterator_->GetValue();
-
-      std::vector<std::any> result_key_record;
-      int ret = 0;
-      if (group_by_key_serial_schemas_ && !group_by_key_serial_schemas_->empty()) {
-        RecordDecoder result_record_decoder(coprocessor_.schema_version(), group_by_key_serial_schemas_,
-                                            coprocessor_.result_schema().common_id());
-
-        try {
-          ret = result_record_decoder.DecodeKey(key, result_key_record);
-        } catch (const std::exception& my_exception) {
-          std::string error_message = fmt::format("serial::DecodeKey failed exception : {}", my_exception.what());
-          DINGO_LOG(ERROR) << error_message;
-          return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
-        }
-        if (ret < 0) {
-          std::string error_message = fmt::format("serial::DecodeKey failed");
-          DINGO_LOG(ERROR) << error_message;
-          return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
-        }
-      }
-
-      std::vector<std::any> result_record;
-      result_record.reserve(result_key_record.size() + value->size());
-      size_t i = 0;
-      for (const auto& column : result_key_record) {
-        std::any column_clone = Utils::CloneColumn(column, (*result_serial_schemas_sorted_)[i]->GetType());
-        if (!column_clone.has_value()) {
-          std::string error_message = fmt::format(
-              "CloneColumn failed result_key_record index : {} result_serial_schemas_sorted_ i : {} "
-              "result_serial_schemas_ "
-              "type : {}",
-              i, i, BaseSchema::GetTypeString((*result_serial_schemas_)[i]->GetType()));
-          DINGO_LOG(ERROR) << error_message;
-          return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
-        }
-        Utils::DebugColumn(column, (*result_serial_schemas_sorted_)[i]->GetType(), "Key");
-        result_record.emplace_back(std::move(column_clone));
-        i++;
-      }
-
-      for (const auto& column : *value) {
-        std::any column_clone = Utils::CloneColumn(column, (*result_serial_schemas_sorted_)[i]->GetType());
-        if (!column_clone.has_value()) {
-          std::string error_message = fmt::format(
-              "CloneColumn failed result_aggregation_record  index : {} result_serial_schemas_sorted_ i : {} "
-              "result_serial_schemas_ type : {}",
-              (i - result_key_record.size()), i, BaseSchema::GetTypeString((*result_serial_schemas_)[i]->GetType()));
-          DINGO_LOG(ERROR) << error_message;
-          return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
-        }
-        Utils::DebugColumn(column, (*result_serial_schemas_sorted_)[i]->GetType(), "Value");
-        result_record.emplace_back(std::move(column_clone));
-        i++;
-      }
-
       pb::common::KeyValue result_key_value;
-      ret = 0;
-      try {
-        ret = result_record_encoder.Encode(result_record, result_key_value);
-      } catch (const std::exception& my_exception) {
-        std::string error_message = fmt::format("serial::Encode failed exception : {}", my_exception.what());
-        DINGO_LOG(ERROR) << error_message;
-        return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
-      }
-      if (ret < 0) {
-        std::string error_message = fmt::format("serial::Encode failed");
-        DINGO_LOG(ERROR) << error_message;
-        return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
+      status = EncodeAggregationResult(aggregation_iterator_->GetKey(), *aggregation_iterator_->GetValue(),
+                                       &result_key_value);
+      if (!status.ok()) {
+        return status;
       }
 
       if (key_only) {
@@ -500,46 +949,157 @@ butil::Status Coprocessor::GetKeyValueFromAggregation(bool key_only, size_t max_
 
       kvs->emplace_back(result_key_value);
 
+      status = aggregation_iterator_->Next();
+      if (!status.ok()) {
+        DINGO_LOG(ERROR) << fmt::format("aggregation iterator failed, {}", status.error_cstr());
+        return status;
+      }
+
       if (scan_filter.UptoLimit(result_key_value)) {
-        aggregation_iterator_->Next();
         return butil::Status();
       }
+    }
+  }
+
+  return butil::Status();
+}
+
+butil::Status Coprocessor::GetKeyValueFromTopN(bool key_only, size_t max_fetch_cnt, uint64_t max_bytes_rpc,
+                                               std::vector<pb::common::KeyValue>* kvs) {
+  if (!top_n_) {
+    return butil::Status();
+  }
 
-      aggregation_iterator_->Next();
+  if (!end_of_top_n_) {
+    top_n_kvs_ = top_n_->Finish();
+    top_n_position_ = 0;
+    end_of_top_n_ = true;
+  }
+
+  ScanFilter scan_filter = ScanFilter(key_only, max_fetch_cnt, max_bytes_rpc);
+  while (top_n_position_ < top_n_kvs_.size()) {
+    auto& result_key_value = top_n_kvs_[top_n_position_++];
+    if (key_only) {
+      result_key_value.set_value("");
+    }
+
+    kvs->emplace_back(std::move(result_key_value));
+    if (scan_filter.UptoLimit(kvs->back())) {
+      break;
     }
   }
 
   return butil::Status();
 }
 
+butil::Status Coprocessor::EncodeAggregationResult(const std::string& group_by_key,
+                                                   const std::vector<std::any>& value,
+                                                   pb::common::KeyValue* result_kv) {
+  std::vector<std::any> result_key_record;
+  int ret = 0;
+  if (group_by_key_serial_schemas_ && !group_by_key_serial_schemas_->empty()) {
+    RecordDecoder result_record_decoder(coprocessor_.schema_version(), group_by_key_serial_schemas_,
+                                        coprocessor_.result_schema().common_id());
+
+    try {
+      ret = result_record_decoder.DecodeKey(group_by_key, result_key_record);
+    } catch (const std::exception& my_exception) {
+      std::string error_message = fmt::format("serial::DecodeKey failed exception : {}", my_exception.what());
+      DINGO_LOG(ERROR) << error_message;
+      return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
+    }
+    if (ret < 0) {
+      std::string error_message = fmt::format("serial::DecodeKey failed");
+      DINGO_LOG(ERROR) << error_message;
+      return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
+    }
+  }
+
+  std::vector<std::any> result_record;
+  result_record.reserve(result_key_record.size() + value.size());
+  size_t i = 0;
+  for (const auto& column : result_key_record) {
+    std::any column_clone = Utils::CloneColumn(column, (*result_serial_schemas_sorted_)[i]->GetType());
+    if (!column_clone.has_value()) {
+      std::string error_message = fmt::format(
+          "CloneColumn failed result_key_record index : {} result_serial_schemas_sorted_ i : {} "
+          "result_serial_schemas_ "
+          "type : {}",
+          i, i, BaseSchema::GetTypeString((*result_serial_schemas_)[i]->GetType()));
+      DINGO_LOG(ERROR) << error_message;
+      return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
+    }
+    Utils::DebugColumn(column, (*result_serial_schemas_sorted_)[i]->GetType(), "Key");
+    result_record.emplace_back(std::move(column_clone));
+    i++;
+  }
+
+  for (const auto& column : value) {
+    std::any column_clone = Utils::CloneColumn(column, (*result_serial_schemas_sorted_)[i]->GetType());
+    if (!column_clone.has_value()) {
+      std::string error_message = fmt::format(
+          "CloneColumn failed result_aggregation_record  index : {} result_serial_schemas_sorted_ i : {} "
+          "result_serial_schemas_ type : {}",
+          (i - result_key_record.size()), i, BaseSchema::GetTypeString((*result_serial_schemas_)[i]->GetType()));
+      DINGO_LOG(ERROR) << error_message;
+      return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
+    }
+    Utils::DebugColumn(column, (*result_serial_schemas_sorted_)[i]->GetType(), "Value");
+    result_record.emplace_back(std::move(column_clone));
+    i++;
+  }
+
+  RecordEncoder result_record_encoder(coprocessor_.schema_version(), result_serial_schemas_,
+                                      coprocessor_.result_schema().common_id());
+  ret = 0;
+  try {
+    ret = result_record_encoder.Encode(result_record, *result_kv);
+  } catch (const std::exception& my_exception) {
+    std::string error_message = fmt::format("serial::Encode failed exception : {}", my_exception.what());
+    DINGO_LOG(ERROR) << error_message;
+    return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
+  }
+  if (ret < 0) {
+    std::string error_message = fmt::format("serial::Encode failed");
+    DINGO_LOG(ERROR) << error_message;
+    return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
+  }
+
+  return butil::Status();
+}
+
 void Coprocessor::Close() {
   coprocessor_.Clear();
   if (original_serial_schemas_) {
-    original_serial_schemas_->clear();
+    original_serial_schemas_.reset();
   }
 
   if (selection_serial_schemas_) {
-    selection_serial_schemas_->clear();
+    selection_serial_schemas_.reset();
   }
 
   if (group_by_key_serial_schemas_) {
-    group_by_key_serial_schemas_->clear();
+    group_by_key_serial_schemas_.reset();
   }
 
   if (group_by_operator_serial_schemas_) {
-    group_by_operator_serial_schemas_->clear();
+    group_by_operator_serial_schemas_.reset();
   }
 
   if (group_by_serial_schemas_) {
-    group_by_serial_schemas_->clear();
+    group_by_serial_schemas_.reset();
   }
 
   if (result_serial_schemas_) {
-    result_serial_schemas_->clear();
+    result_serial_schemas_.reset();
   }
 
   enable_expression_ = false;
   end_of_group_by_ = false;
+  stream_aggregation_ = false;
+  stream_group_key_.clear();
+  has_key_range_ = false;
+  key_range_.Clear();
 
   if (aggregation_manager_) {
     aggregation_manager_.reset();
@@ -550,6 +1110,21 @@ void Coprocessor::Close() {
   }
 
   original_column_indexes_.clear();
+  original_record_.clear();
+  original_record_decoder_.reset();
+  runner_.reset();
+
+  vector_runner_.reset();
+  batch_columns_.clear();
+  batch_selection_.clear();
+  batch_group_keys_.clear();
+  batch_aggregation_params_.clear();
+  pending_kvs_.clear();
+
+  top_n_.reset();
+  end_of_top_n_ = false;
+  top_n_kvs_.clear();
+  top_n_position_ = 0;
 
   if (original_serial_schemas_sorted_) {
     original_serial_schemas_sorted_.reset();
@@ -676,6 +1251,7 @@ butil::Status Coprocessor::InitGroupBySerialSchema(const pb::store::Coprocessor&
 }
 
 void Coprocessor::GetOriginalColumnIndexes() {
+  original_column_indexes_.clear();
   original_column_indexes_.reserve(original_serial_schemas_->size());
   for (const auto& schema : *original_serial_schemas_) {
     original_column_indexes_.push_back(schema->GetIndex());
@@ -688,4 +1264,148 @@ void Coprocessor::GetOriginalColumnIndexes() {
                                  original_column_indexes_.end());
 }
 
+butil::Status Coprocessor::InitTopN(const pb::store::Coprocessor& coprocessor, std::vector<SortKey>* sort_keys) {
+  sort_keys->clear();
+  if (coprocessor.sort_columns().empty() || coprocessor.limit() <= 0) {
+    return butil::Status();
+  }
+
+  if (end_of_group_by_) {
+    std::string error_message = fmt::format("top n with group by not support");
+    DINGO_LOG(ERROR) << error_message;
+    return butil::Status(pb::error::ENOT_SUPPORT, error_message);
+  }
+
+  // All rows of top n are held in memory until the end of scan
+  if (coprocessor.limit() > FLAGS_coprocessor_top_n_max_limit) {
+    std::string error_message =
+        fmt::format("top n limit : {} exceed max : {}", coprocessor.limit(), FLAGS_coprocessor_top_n_max_limit);
+    DINGO_LOG(ERROR) << error_message;
+    return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
+  }
+
+  for (const auto& sort_column : coprocessor.sort_columns()) {
+    int index = sort_column.index_of_column();
+    if (index < 0 || index >= static_cast<int>(original_serial_schemas_sorted_->size())) {
+      std::string error_message = fmt::format("sort column index : {} out of range : {}", index,
+                                              original_serial_schemas_sorted_->size());
+      DINGO_LOG(ERROR) << error_message;
+      return butil::Status(pb::error::EILLEGAL_PARAMTETERS, error_message);
+    }
+    sort_keys->push_back(SortKey{index, (*original_serial_schemas_sorted_)[index]->GetType(), sort_column.is_desc()});
+  }
+
+  DINGO_LOG(DEBUG) << fmt::format("Coprocessor::Open top n limit : {} sort keys : {}", coprocessor.limit(),
+                                  sort_keys->size());
+
+  return butil::Status();
+}
+
+bool Coprocessor::IsGroupByKeyPrefix() {
+  if (coprocessor_.group_by_columns().empty()) {
+    return false;
+  }
+
+  // The key columns in the order of encoding
+  std::vector<int> key_indexes;
+  for (const auto& schema : *original_serial_schemas_) {
+    if (schema && schema->IsKey()) {
+      key_indexes.push_back(schema->GetIndex());
+    }
+  }
+
+  if (coprocessor_.group_by_columns().size() > key_indexes.size()) {
+    return false;
+  }
+
+  for (int i = 0; i < coprocessor_.group_by_columns().size(); i++) {
+    if (coprocessor_.group_by_columns(i) != key_indexes[i]) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool Coprocessor::InitKeyRange(pb::common::Range* key_range) {
+  // The first key column in the order of encoding
+  std::shared_ptr<BaseSchema> key_schema;
+  for (const auto& schema : *original_serial_schemas_) {
+    if (schema && schema->IsKey()) {
+      key_schema = schema;
+      break;
+    }
+  }
+
+  if (!key_schema ||
+      (key_schema->GetType() != BaseSchema::kInteger && key_schema->GetType() != BaseSchema::kLong)) {
+    return false;
+  }
+
+  expr::VarRange range;
+  try {
+    if (!expr::RangeAnalyzer::Analyze(reinterpret_cast<const expr::byte*>(coprocessor_.expression().c_str()),
+                                      coprocessor_.expression().length(), key_schema->GetIndex(), range)) {
+      return false;
+    }
+  } catch (const std::exception& my_exception) {
+    DINGO_LOG(WARNING) << fmt::format("expr::RangeAnalyzer Analyze failed. exception : {}", my_exception.what());
+    return false;
+  }
+
+  if (key_schema->GetType() == BaseSchema::kInteger) {
+    range.min = std::max(range.min, static_cast<int64_t>(std::numeric_limits<int32_t>::min()));
+    range.max = std::min(range.max, static_cast<int64_t>(std::numeric_limits<int32_t>::max()));
+  }
+
+  // Encode the bounds as key prefix, common_id + first key column
+  auto schemas = std::make_shared<std::vector<std::shared_ptr<BaseSchema>>>();
+  schemas->push_back(key_schema);
+  RecordEncoder encoder(coprocessor_.schema_version(), schemas, coprocessor_.original_schema().common_id());
+  std::vector<std::any> record(original_serial_schemas_->size());
+  auto encode_prefix = [&](int64_t value) {
+    if (key_schema->GetType() == BaseSchema::kInteger) {
+      record[key_schema->GetIndex()] = std::optional<int32_t>(static_cast<int32_t>(value));
+    } else {
+      record[key_schema->GetIndex()] = std::optional<int64_t>(value);
+    }
+    std::string prefix;
+    encoder.EncodeKeyPrefix(record, 1, prefix);
+    return prefix;
+  };
+
+  if (range.IsEmpty()) {
+    std::string prefix = encode_prefix(0);
+    key_range->set_start_key(prefix);
+    key_range->set_end_key(prefix);
+  } else {
+    key_range->set_start_key(encode_prefix(range.min));
+    key_range->set_end_key(Helper::PrefixNext(encode_prefix(range.max)));
+  }
+
+  DINGO_LOG(DEBUG) << fmt::format("Coprocessor::InitKeyRange column : {} range : [{}, {}]", key_schema->GetIndex(),
+                                  range.min, range.max);
+
+  return true;
+}
+
+void Coprocessor::NarrowRange(pb::common::Range* range) const {
+  if (!has_key_range_) {
+    return;
+  }
+
+  if (key_range_.start_key() > range->start_key()) {
+    range->set_start_key(key_range_.start_key());
+  }
+
+  if (range->end_key().empty() || key_range_.end_key() < range->end_key()) {
+    range->set_end_key(key_range_.end_key());
+  }
+
+  // Empty range, nothing to scan
+  if (range->start_key() > range->end_key()) {
+    range->set_end_key(range->start_key());
+  }
+}
+
 }  // namespace dingodb
@@ -18,18 +18,30 @@
 #include <serial/schema/base_schema.h>
 
 #include <any>
+#include <deque>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "butil/status.h"
 #include "coprocessor/aggregation_manager.h"
+#include "coprocessor/coprocessor_plan.h"
+#include "coprocessor/top_n.h"
 #include "engine/raw_engine.h"
 #include "proto/store.pb.h"
 #include "scan/scan_filter.h"
 
 namespace dingodb {
 
+namespace expr {
+class Runner;
+class VectorRunner;
+class ColumnVector;
+}  // namespace expr
+
+class RecordDecoder;
+
 class Coprocessor {
  public:
   Coprocessor();
@@ -46,22 +58,66 @@ class Coprocessor {
                         uint64_t max_bytes_rpc, std::vector<pb::common::KeyValue>* kvs);
   void Close();
 
+  // Intersect the scan range with the key range derived from expression, do nothing if not derived.
+  void NarrowRange(pb::common::Range* range) const;
+
  private:
-  butil::Status DoExecute(const pb::common::KeyValue& kv, bool* has_result_kv, pb::common::KeyValue* result_kv);
+  butil::Status DoExecute(std::string_view key, std::string_view value, bool* has_result_kv,
+                          pb::common::KeyValue* result_kv);
+
+  // Vectorized path, decode a batch of rows to typed columns and filter them together.
+  // Projection and aggregation read the selected rows from the columns.
+  butil::Status ExecuteBatch(const std::shared_ptr<EngineIterator>& iter, bool key_only, size_t max_fetch_cnt,
+                             uint64_t max_bytes_rpc, std::vector<pb::common::KeyValue>* kvs);
+
+  butil::Status DoExecuteBatch(size_t batch_size, bool key_only, ScanFilter& scan_filter,
+                               std::vector<pb::common::KeyValue>* kvs, bool* is_upto_limit);
+
+  // Encode the selected rows, top n still accept row by row.
+  butil::Status DoExecuteBatchForSelection(std::vector<pb::common::KeyValue>* result_kvs);
+
+  // Update the aggregation functions column by column, the finished groups of stream aggregation are returned.
+  butil::Status DoExecuteBatchForAggregation(std::vector<pb::common::KeyValue>* result_kvs);
 
-  butil::Status DoExecuteForAggregation(const std::vector<std::any>& selection_record);
+  void ResetBatchColumns(size_t batch_size);
+
+  // has_result_kv is set when a group is finished by stream aggregation.
+  butil::Status DoExecuteForAggregation(const std::vector<std::any>& selection_record, bool* has_result_kv,
+                                        pb::common::KeyValue* result_kv);
 
   butil::Status DoExecuteForSelection(const std::vector<std::any>& selection_record, bool* has_result_kv,
                                       pb::common::KeyValue* result_kv);
+
+  butil::Status OpenAggregationManager();
+
+  // Encode the current group of stream aggregation and drop it, has_result_kv is false if no group.
+  butil::Status FinishStreamGroup(bool* has_result_kv, pb::common::KeyValue* result_kv);
   butil::Status GetKeyValueFromAggregation(bool key_only, size_t max_fetch_cnt, uint64_t max_bytes_rpc,
                                            std::vector<pb::common::KeyValue>* kvs);
+  // Sorted rows of top n, return at the end of scan.
+  butil::Status GetKeyValueFromTopN(bool key_only, size_t max_fetch_cnt, uint64_t max_bytes_rpc,
+                                    std::vector<pb::common::KeyValue>* kvs);
+  butil::Status EncodeAggregationResult(const std::string& group_by_key, const std::vector<std::any>& value,
+                                        pb::common::KeyValue* result_kv);
+
+  // Setup of the coprocessor, cached and shared by scans
+  butil::Status BuildPlan(const pb::store::Coprocessor& coprocessor, std::shared_ptr<CoprocessorPlan>& plan);
+  void LoadPlan(const std::shared_ptr<CoprocessorPlan>& plan);
 
   butil::Status CompareSerialSchema(const pb::store::Coprocessor& coprocessor);
 
   butil::Status InitGroupBySerialSchema(const pb::store::Coprocessor& coprocessor);
 
+  butil::Status InitTopN(const pb::store::Coprocessor& coprocessor, std::vector<SortKey>* sort_keys);
+
   void GetOriginalColumnIndexes();
 
+  // Only int32/int64 first key column compared with constants is supported.
+  bool InitKeyRange(pb::common::Range* key_range);
+
+  // Rows are scanned in key order, so the groups come one by one when group by a prefix of the key.
+  bool IsGroupByKeyPrefix();
+
   pb::store::Coprocessor coprocessor_;
   std::shared_ptr<std::vector<std::shared_ptr<BaseSchema>>> original_serial_schemas_;
   std::shared_ptr<std::vector<std::shared_ptr<BaseSchema>>> selection_serial_schemas_;
@@ -76,7 +132,33 @@ class Coprocessor {
   bool end_of_group_by_;
   std::shared_ptr<AggregationManager> aggregation_manager_;
   std::shared_ptr<AggregationIterator> aggregation_iterator_;
+  // Stream aggregation only hold the current group, emit it when the next group begin.
+  bool stream_aggregation_;
+  std::string stream_group_key_;
+  bool has_key_range_;
+  pb::common::Range key_range_;
   std::vector<int> original_column_indexes_;
+  std::shared_ptr<RecordDecoder> original_record_decoder_;
+  std::vector<std::any> original_record_;
+  std::shared_ptr<expr::Runner> runner_;
+
+  // Only set when the expression can be vectorized.
+  std::shared_ptr<expr::VectorRunner> vector_runner_;
+  // Indexed by column index, the rows of a batch are decoded to them.
+  std::vector<expr::ColumnVector> batch_columns_;
+  std::vector<uint32_t> batch_selection_;
+  // Group keys of the selected rows.
+  std::vector<std::string> batch_group_keys_;
+  // Input columns of the aggregation operators.
+  std::vector<const expr::ColumnVector*> batch_aggregation_params_;
+  // Selected rows of the last batch which exceed the limit.
+  std::deque<pb::common::KeyValue> pending_kvs_;
+
+  // Only set when order by limit.
+  std::shared_ptr<TopN> top_n_;
+  bool end_of_top_n_;
+  std::vector<pb::common::KeyValue> top_n_kvs_;
+  size_t top_n_position_;
 
   std::shared_ptr<std::vector<std::shared_ptr<BaseSchema>>> original_serial_schemas_sorted_;
   std::shared_ptr<std::vector<std::shared_ptr<BaseSchema>>> selection_serial_schemas_sorted_;
@@ -0,0 +1,93 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "coprocessor/coprocessor_plan.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "butil/memory/singleton.h"
+#include "butil/scoped_lock.h"
+#include "gflags/gflags.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+
+namespace dingodb {
+
+DEFINE_int32(coprocessor_plan_cache_capacity, 1024, "max number of cached coprocessor plan, 0 means disable");
+
+CoprocessorPlanCache::CoprocessorPlanCache() { bthread_mutex_init(&mutex_, nullptr); }
+CoprocessorPlanCache::~CoprocessorPlanCache() { bthread_mutex_destroy(&mutex_); }
+
+CoprocessorPlanCache* CoprocessorPlanCache::GetInstance() { return Singleton<CoprocessorPlanCache>::get(); }
+
+std::string CoprocessorPlanCache::GenKey(const pb::store::Coprocessor& coprocessor) {
+  std::string key;
+  {
+    google::protobuf::io::StringOutputStream string_stream(&key);
+    google::protobuf::io::CodedOutputStream coded_stream(&string_stream);
+    // Same definition always get same bytes.
+    coded_stream.SetSerializationDeterministic(true);
+    coprocessor.SerializeToCodedStream(&coded_stream);
+  }
+
+  return key;
+}
+
+std::shared_ptr<CoprocessorPlan> CoprocessorPlanCache::Get(const std::string& key) {
+  BAIDU_SCOPED_LOCK(mutex_);
+  auto it = plan_index_.find(key);
+  if (it == plan_index_.end()) {
+    return nullptr;
+  }
+
+  plans_.splice(plans_.begin(), plans_, it->second);
+  return it->second->second;
+}
+
+void CoprocessorPlanCache::Put(const std::string& key, std::shared_ptr<CoprocessorPlan> plan) {
+  if (FLAGS_coprocessor_plan_cache_capacity <= 0) {
+    return;
+  }
+
+  BAIDU_SCOPED_LOCK(mutex_);
+  auto it = plan_index_.find(key);
+  if (it != plan_index_.end()) {
+    it->second->second = std::move(plan);
+    plans_.splice(plans_.begin(), plans_, it->second);
+    return;
+  }
+
+  plans_.emplace_front(key, std::move(plan));
+  plan_index_[key] = plans_.begin();
+
+  while (plans_.size() > static_cast<size_t>(FLAGS_coprocessor_plan_cache_capacity)) {
+    plan_index_.erase(plans_.back().first);
+    plans_.pop_back();
+  }
+}
+
+size_t CoprocessorPlanCache::Size() {
+  BAIDU_SCOPED_LOCK(mutex_);
+  return plans_.size();
+}
+
+void CoprocessorPlanCache::Clear() {
+  BAIDU_SCOPED_LOCK(mutex_);
+  plans_.clear();
+  plan_index_.clear();
+}
+
+}  // namespace dingodb
@@ -0,0 +1,106 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DINGODB_COPROCESSOR_COPROCESSOR_PLAN_H_  // NOLINT
+#define DINGODB_COPROCESSOR_COPROCESSOR_PLAN_H_
+
+#include <serial/schema/base_schema.h>
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "bthread/mutex.h"
+#include "coprocessor/top_n.h"
+#include "proto/store.pb.h"
+
+template <typename T>
+struct DefaultSingletonTraits;
+
+namespace dingodb {
+
+namespace expr {
+class Runner;
+class VectorRunner;
+}  // namespace expr
+
+// The setup of coprocessor which only depend on the definition.
+// Immutable after built, shared by all scans with the same definition.
+struct CoprocessorPlan {
+  pb::store::Coprocessor coprocessor;
+  std::shared_ptr<std::vector<std::shared_ptr<BaseSchema>>> original_serial_schemas;
+  std::shared_ptr<std::vector<std::shared_ptr<BaseSchema>>> selection_serial_schemas;
+  std::shared_ptr<std::vector<std::shared_ptr<BaseSchema>>> group_by_key_serial_schemas;
+  std::shared_ptr<std::vector<std::shared_ptr<BaseSchema>>> group_by_operator_serial_schemas;
+  std::shared_ptr<std::vector<std::shared_ptr<BaseSchema>>> group_by_serial_schemas;
+  std::shared_ptr<std::vector<std::shared_ptr<BaseSchema>>> result_serial_schemas;
+  std::shared_ptr<std::vector<std::shared_ptr<BaseSchema>>> original_serial_schemas_sorted;
+  std::shared_ptr<std::vector<std::shared_ptr<BaseSchema>>> selection_serial_schemas_sorted;
+  std::shared_ptr<std::vector<std::shared_ptr<BaseSchema>>> result_serial_schemas_sorted;
+  bool enable_expression = false;
+  bool end_of_group_by = false;
+  // Group by columns are a prefix of the key columns.
+  bool stream_aggregation = false;
+  std::vector<int> original_column_indexes;
+  // Empty if not top n.
+  std::vector<SortKey> sort_keys;
+  // Key range of the first key column derived from expression, rows out of it never match.
+  bool has_key_range = false;
+  pb::common::Range key_range;
+
+  // Decoded expression, runner has stack so every scan run on a copy.
+  std::shared_ptr<expr::Runner> runner;
+  // nullptr if the expression can not be vectorized.
+  std::shared_ptr<expr::VectorRunner> vector_runner;
+};
+
+// LRU cache of coprocessor plan, store wide.
+// The executor issue lots of short scans with same coprocessor, which skip the setup by the cache.
+class CoprocessorPlanCache {
+ public:
+  static CoprocessorPlanCache* GetInstance();
+
+  CoprocessorPlanCache(const CoprocessorPlanCache&) = delete;
+  const CoprocessorPlanCache& operator=(const CoprocessorPlanCache&) = delete;
+
+  // Key contain schema_version, common_id, schemas, expression, selection/group by columns and aggregation.
+  static std::string GenKey(const pb::store::Coprocessor& coprocessor);
+
+  std::shared_ptr<CoprocessorPlan> Get(const std::string& key);
+  void Put(const std::string& key, std::shared_ptr<CoprocessorPlan> plan);
+
+  size_t Size();
+  void Clear();
+
+ private:
+  CoprocessorPlanCache();
+  ~CoprocessorPlanCache();
+
+  friend struct DefaultSingletonTraits<CoprocessorPlanCache>;
+
+  using PlanEntry = std::pair<std::string, std::shared_ptr<CoprocessorPlan>>;
+
+  bthread_mutex_t mutex_;
+  // Front is the most recently used.
+  std::list<PlanEntry> plans_;
+  std::unordered_map<std::string, std::list<PlanEntry>::iterator> plan_index_;
+};
+
+}  // namespace dingodb
+
+#endif  // DINGODB_COPROCESSOR_COPROCESSOR_PLAN_H_  // NOLINT
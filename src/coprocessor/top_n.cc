@@ -0,0 +1,141 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "coprocessor/top_n.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace dingodb {
+
+template <typename T>
+static int CompareOptional(const std::any& lhs, const std::any& rhs) {
+  const auto& lhs_value = std::any_cast<const std::optional<T>&>(lhs);
+  const auto& rhs_value = std::any_cast<const std::optional<T>&>(rhs);
+
+  if (!lhs_value.has_value() || !rhs_value.has_value()) {
+    return static_cast<int>(lhs_value.has_value()) - static_cast<int>(rhs_value.has_value());
+  }
+
+  if constexpr (std::is_same_v<std::shared_ptr<std::string>, T>) {
+    const std::string empty;
+    const std::string& l = lhs_value.value() ? *lhs_value.value() : empty;
+    const std::string& r = rhs_value.value() ? *rhs_value.value() : empty;
+    return l.compare(r);
+  } else {
+    if (lhs_value.value() < rhs_value.value()) {
+      return -1;
+    }
+    return rhs_value.value() < lhs_value.value() ? 1 : 0;
+  }
+}
+
+int TopN::CompareColumn(const std::any& lhs, const std::any& rhs, BaseSchema::Type type) {
+  switch (type) {
+    case BaseSchema::kBool:
+      return CompareOptional<bool>(lhs, rhs);
+    case BaseSchema::kInteger:
+      return CompareOptional<int32_t>(lhs, rhs);
+    case BaseSchema::kFloat:
+      return CompareOptional<float>(lhs, rhs);
+    case BaseSchema::kLong:
+      return CompareOptional<int64_t>(lhs, rhs);
+    case BaseSchema::kDouble:
+      return CompareOptional<double>(lhs, rhs);
+    case BaseSchema::kString:
+      return CompareOptional<std::shared_ptr<std::string>>(lhs, rhs);
+    default:
+      throw std::bad_any_cast();
+  }
+}
+
+TopN::TopN(std::vector<SortKey> sort_keys, size_t limit) : sort_keys_(std::move(sort_keys)), limit_(limit) {}
+
+int TopN::Compare(const std::vector<std::any>& values, const std::vector<std::any>& record) const {
+  for (size_t i = 0; i < sort_keys_.size(); i++) {
+    const auto& sort_key = sort_keys_[i];
+    int ret = CompareColumn(values[i], record[sort_key.index], sort_key.type);
+    if (ret != 0) {
+      return sort_key.is_desc ? -ret : ret;
+    }
+  }
+  return 0;
+}
+
+int TopN::CompareValues(const std::vector<std::any>& lhs, const std::vector<std::any>& rhs) const {
+  for (size_t i = 0; i < sort_keys_.size(); i++) {
+    const auto& sort_key = sort_keys_[i];
+    int ret = CompareColumn(lhs[i], rhs[i], sort_key.type);
+    if (ret != 0) {
+      return sort_key.is_desc ? -ret : ret;
+    }
+  }
+  return 0;
+}
+
+bool TopN::Accept(const std::vector<std::any>& record) const {
+  if (limit_ == 0) {
+    return false;
+  }
+
+  if (heap_.size() < limit_) {
+    // Check the type
+    for (const auto& sort_key : sort_keys_) {
+      CompareColumn(record[sort_key.index], record[sort_key.index], sort_key.type);
+    }
+    return true;
+  }
+
+  return Compare(heap_.front().values, record) > 0;
+}
+
+void TopN::Push(const std::vector<std::any>& record, pb::common::KeyValue key_value) {
+  auto less = [this](const Entry& lhs, const Entry& rhs) { return CompareValues(lhs.values, rhs.values) < 0; };
+
+  if (heap_.size() >= limit_) {
+    std::pop_heap(heap_.begin(), heap_.end(), less);
+    heap_.pop_back();
+  }
+
+  Entry entry;
+  entry.values.reserve(sort_keys_.size());
+  for (const auto& sort_key : sort_keys_) {
+    entry.values.push_back(record[sort_key.index]);
+  }
+  entry.key_value = std::move(key_value);
+
+  heap_.push_back(std::move(entry));
+  std::push_heap(heap_.begin(), heap_.end(), less);
+}
+
+std::vector<pb::common::KeyValue> TopN::Finish() {
+  auto less = [this](const Entry& lhs, const Entry& rhs) { return CompareValues(lhs.values, rhs.values) < 0; };
+  std::sort_heap(heap_.begin(), heap_.end(), less);
+
+  std::vector<pb::common::KeyValue> key_values;
+  key_values.reserve(heap_.size());
+  for (auto& entry : heap_) {
+    key_values.push_back(std::move(entry.key_value));
+  }
+  heap_.clear();
+
+  return key_values;
+}
+
+}  // namespace dingodb
@@ -0,0 +1,76 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DINGODB_COPROCESSOR_TOP_N_H_  // NOLINT
+#define DINGODB_COPROCESSOR_TOP_N_H_
+
+#include <serial/schema/base_schema.h>
+
+#include <any>
+#include <cstddef>
+#include <vector>
+
+#include "proto/common.pb.h"
+
+namespace dingodb {
+
+struct SortKey {
+  // Index of the column in record
+  int index;
+  BaseSchema::Type type;
+  bool is_desc;
+};
+
+// Bounded heap keep the first limit rows by the sort keys, null is the smallest.
+// The heap top is the last row, a new row only replace it when the new row is before it.
+class TopN {
+ public:
+  TopN(std::vector<SortKey> sort_keys, size_t limit);
+  ~TopN() = default;
+
+  TopN(const TopN& rhs) = delete;
+  TopN& operator=(const TopN& rhs) = delete;
+
+  // Whether the record is in the first limit rows so far, throw std::bad_any_cast if type mismatch.
+  bool Accept(const std::vector<std::any>& record) const;
+
+  // The record must be accepted, only the sort columns are kept.
+  void Push(const std::vector<std::any>& record, pb::common::KeyValue key_value);
+
+  // Sorted result, the heap is cleared.
+  std::vector<pb::common::KeyValue> Finish();
+
+  size_t Size() const { return heap_.size(); }
+
+  // <0 if lhs before rhs, 0 if equal, >0 if after.
+  static int CompareColumn(const std::any& lhs, const std::any& rhs, BaseSchema::Type type);
+
+ private:
+  struct Entry {
+    std::vector<std::any> values;
+    pb::common::KeyValue key_value;
+  };
+
+  // Compare values of sort keys with the record.
+  int Compare(const std::vector<std::any>& values, const std::vector<std::any>& record) const;
+  int CompareValues(const std::vector<std::any>& lhs, const std::vector<std::any>& rhs) const;
+
+  std::vector<SortKey> sort_keys_;
+  size_t limit_;
+  std::vector<Entry> heap_;
+};
+
+}  // namespace dingodb
+
+#endif  // DINGODB_COPROCESSOR_TOP_N_H_  // NOLINT
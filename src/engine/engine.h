@@ -59,6 +59,9 @@ class Engine {
 
     virtual butil::Status KvGet(std::shared_ptr<Context> ctx, const std::string& key, std::string& value) = 0;
 
+    virtual butil::Status KvBatchGet(std::shared_ptr<Context> ctx, const std::vector<std::string>& keys,
+                                     std::vector<pb::common::KeyValue>& kvs) = 0;
+
     virtual butil::Status KvScan(std::shared_ptr<Context> ctx, const std::string& start_key, const std::string& end_key,
                                  std::vector<pb::common::KeyValue>& kvs) = 0;
 
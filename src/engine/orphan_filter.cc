@@ -0,0 +1,114 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "engine/orphan_filter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <utility>
+
+namespace dingodb {
+
+static bool InRange(const pb::common::Range& range, const rocksdb::Slice& key) {
+  return key.compare(range.start_key()) >= 0 && (range.end_key().empty() || key.compare(range.end_key()) < 0);
+}
+
+LiveRanges::LiveRanges(std::vector<pb::common::Range> ranges) {
+  std::sort(ranges.begin(), ranges.end(), [](const pb::common::Range& lhs, const pb::common::Range& rhs) {
+    return lhs.start_key() < rhs.start_key();
+  });
+
+  // Ranges overlap while a region is splitting, the child range is set before the parent shrink.
+  for (auto& range : ranges) {
+    if (!ranges_.empty()) {
+      auto& last = ranges_.back();
+      if (last.end_key().empty()) {
+        continue;
+      }
+      if (range.start_key() <= last.end_key()) {
+        if (range.end_key().empty() || range.end_key() > last.end_key()) {
+          last.set_end_key(range.end_key());
+        }
+        continue;
+      }
+    }
+    ranges_.push_back(std::move(range));
+  }
+}
+
+bool LiveRanges::Contains(const rocksdb::Slice& key, size_t& hint) const {
+  if (hint < ranges_.size() && InRange(ranges_[hint], key)) {
+    return true;
+  }
+
+  // The last range start before or at key.
+  auto it = std::upper_bound(
+      ranges_.begin(), ranges_.end(), key,
+      [](const rocksdb::Slice& key, const pb::common::Range& range) { return key.compare(range.start_key()) < 0; });
+  if (it == ranges_.begin()) {
+    return false;
+  }
+  --it;
+  if (!InRange(*it, key)) {
+    return false;
+  }
+
+  hint = it - ranges_.begin();
+  return true;
+}
+
+std::vector<pb::common::Range> LiveRanges::Gaps() const {
+  std::vector<pb::common::Range> gaps;
+  std::string start_key;
+  for (const auto& range : ranges_) {
+    if (start_key < range.start_key()) {
+      pb::common::Range gap;
+      gap.set_start_key(start_key);
+      gap.set_end_key(range.start_key());
+      gaps.push_back(std::move(gap));
+    }
+    start_key = range.end_key();
+    if (start_key.empty()) {
+      return gaps;
+    }
+  }
+
+  pb::common::Range gap;
+  gap.set_start_key(start_key);
+  gaps.push_back(std::move(gap));
+  return gaps;
+}
+
+bool OrphanFilter::Filter(int /*level*/, const rocksdb::Slice& key, const rocksdb::Slice& /*existing_value*/,
+                          std::string* /*new_value*/, bool* /*value_changed*/) const {
+  return !live_ranges_->Contains(key, hint_);
+}
+
+void OrphanFilterFactory::SetLiveRanges(std::shared_ptr<const LiveRanges> live_ranges) {
+  std::atomic_store(&live_ranges_, live_ranges);
+}
+
+std::shared_ptr<const LiveRanges> OrphanFilterFactory::GetLiveRanges() const { return std::atomic_load(&live_ranges_); }
+
+std::unique_ptr<rocksdb::CompactionFilter> OrphanFilterFactory::CreateCompactionFilter(
+    const rocksdb::CompactionFilter::Context& /*context*/) {
+  auto live_ranges = GetLiveRanges();
+  // Not published, or no region on the store, keep all data for safety.
+  if (live_ranges == nullptr || live_ranges->Ranges().empty()) {
+    return nullptr;
+  }
+  return std::make_unique<OrphanFilter>(live_ranges);
+}
+
+}  // namespace dingodb
@@ -0,0 +1,85 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DINGODB_ENGINE_ORPHAN_FILTER_H_
+#define DINGODB_ENGINE_ORPHAN_FILTER_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "proto/common.pb.h"
+#include "rocksdb/compaction_filter.h"
+#include "rocksdb/slice.h"
+
+namespace dingodb {
+
+// Sorted and merged key ranges of the regions on the store, empty end key means unbounded.
+class LiveRanges {
+ public:
+  explicit LiveRanges(std::vector<pb::common::Range> ranges);
+  ~LiveRanges() = default;
+
+  // hint is the index of the last matched range, keys of one compaction are sorted so it mostly hit.
+  bool Contains(const rocksdb::Slice& key, size_t& hint) const;
+
+  // Key ranges out of all regions, empty key means unbounded.
+  std::vector<pb::common::Range> Gaps() const;
+
+  const std::vector<pb::common::Range>& Ranges() const { return ranges_; }
+
+ private:
+  std::vector<pb::common::Range> ranges_;
+};
+
+// Drop the keys which not belong to any region, such as the leftover of dropped table or moved region.
+class OrphanFilter : public rocksdb::CompactionFilter {
+ public:
+  explicit OrphanFilter(std::shared_ptr<const LiveRanges> live_ranges) : live_ranges_(live_ranges) {}
+  ~OrphanFilter() override = default;
+
+  bool Filter(int level, const rocksdb::Slice& key, const rocksdb::Slice& existing_value, std::string* new_value,
+              bool* value_changed) const override;
+
+  const char* Name() const override { return "dingo.OrphanFilter"; }
+
+ private:
+  std::shared_ptr<const LiveRanges> live_ranges_;
+  mutable size_t hint_ = 0;
+};
+
+// Every compaction pin the live ranges published when it start. Regions are added before their data is written,
+// so a compaction never see the data of region newer than its live ranges.
+class OrphanFilterFactory : public rocksdb::CompactionFilterFactory {
+ public:
+  OrphanFilterFactory() = default;
+  ~OrphanFilterFactory() override = default;
+
+  void SetLiveRanges(std::shared_ptr<const LiveRanges> live_ranges);
+  // Return nullptr before the first publish.
+  std::shared_ptr<const LiveRanges> GetLiveRanges() const;
+
+  std::unique_ptr<rocksdb::CompactionFilter> CreateCompactionFilter(
+      const rocksdb::CompactionFilter::Context& context) override;
+
+  const char* Name() const override { return "dingo.OrphanFilterFactory"; }
+
+ private:
+  std::shared_ptr<const LiveRanges> live_ranges_;
+};
+
+}  // namespace dingodb
+
+#endif  // DINGODB_ENGINE_ORPHAN_FILTER_H_
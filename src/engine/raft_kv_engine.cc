@@ -14,15 +14,23 @@
 
 #include "engine/raft_kv_engine.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <map>
 #include <memory>
+#include <set>
+#include <vector>
 
 #include "braft/raft.h"
+#include "brpc/channel.h"
+#include "brpc/controller.h"
 #include "butil/endpoint.h"
+#include "common/constant.h"
 #include "common/helper.h"
 #include "common/logging.h"
 #include "common/synchronization.h"
 #include "config/config_manager.h"
+#include "engine/raw_rocks_engine.h"
 #include "engine/write_data.h"
 #include "event/store_state_machine_event.h"
 #include "fmt/core.h"
@@ -30,18 +38,39 @@
 #include "proto/coordinator_internal.pb.h"
 #include "proto/error.pb.h"
 #include "proto/raft.pb.h"
+#include "proto/store.pb.h"
 #include "raft/meta_state_machine.h"
+#include "raft/raft_log_storage.h"
 #include "raft/store_state_machine.h"
 #include "server/server.h"
 
 namespace dingodb {
 
 RaftKvEngine::RaftKvEngine(std::shared_ptr<RawEngine> engine)
-    : engine_(engine), raft_node_manager_(std::move(std::make_unique<RaftNodeManager>())) {}
+    : engine_(engine),
+      raft_node_manager_(std::move(std::make_unique<RaftNodeManager>())),
+      is_checking_hibernate_(false) {}
 
 RaftKvEngine::~RaftKvEngine() = default;
 
-bool RaftKvEngine::Init(std::shared_ptr<Config> /*config*/) { return true; }
+bool RaftKvEngine::Init(std::shared_ptr<Config> config) {
+  // Shared raft log engine of all regions, empty means one segment log per region.
+  std::string log_storage_path = config->GetString("raft.log_storage_path");
+  // Log engine is within the memory budget of data engine.
+  std::shared_ptr<rocksdb::Cache> block_cache;
+  std::shared_ptr<rocksdb::WriteBufferManager> write_buffer_manager;
+  auto raw_rocks_engine = std::dynamic_pointer_cast<RawRocksEngine>(engine_);
+  if (raw_rocks_engine != nullptr) {
+    block_cache = raw_rocks_engine->GetBlockCache();
+    write_buffer_manager = raw_rocks_engine->GetWriteBufferManager();
+  }
+  if (!log_storage_path.empty() && !RaftLogStorage::Init(log_storage_path, block_cache, write_buffer_manager)) {
+    DINGO_LOG(ERROR) << "Init raft log storage failed, path: " << log_storage_path;
+    return false;
+  }
+
+  return true;
+}
 
 // Recover raft node from region meta data.
 // Invoke when server starting.
@@ -91,16 +120,19 @@ butil::Status RaftKvEngine::AddNode(std::shared_ptr<Context> ctx, store::RegionP
                                     std::shared_ptr<EventListenerCollection> listeners, bool is_restart) {
   DINGO_LOG(INFO) << "RaftkvEngine add region, region_id " << region->Id();
 
+  auto config = ConfigManager::GetInstance()->GetConfig(ctx->ClusterRole());
   auto* state_machine = new StoreStateMachine(engine_, region, raft_meta, region_metrics, listeners, is_restart);
   if (!state_machine->Init()) {
     return butil::Status(pb::error::ERAFT_INIT, "State machine init failed");
   }
+  state_machine->SetApplyBatchMaxBytes(std::max(config->GetInt("raft.apply_batch_max_bytes"), 0));
+  state_machine->SetDisableDataWal(config->GetInt(Constant::kDisableDataWal) > 0);
+  state_machine->SetEarlyAck(config->GetInt("raft.early_ack_blind_write") > 0);
 
   std::shared_ptr<RaftNode> node = std::make_shared<RaftNode>(
       region->Id(), region->Name(), braft::PeerId(Server::GetInstance()->RaftEndpoint()), state_machine);
 
-  if (node->Init(Helper::FormatPeers(Helper::ExtractLocations(region->Peers())),
-                 ConfigManager::GetInstance()->GetConfig(ctx->ClusterRole())) != 0) {
+  if (node->Init(Helper::FormatPeers(Helper::ExtractLocations(region->Peers())), config) != 0) {
     node->Destroy();
     return butil::Status(pb::error::ERAFT_INIT, "Raft init failed");
   }
@@ -160,6 +192,67 @@ butil::Status RaftKvEngine::DoSnapshot(std::shared_ptr<Context> ctx, uint64_t re
   return butil::Status();
 }
 
+// Ask the leader store whether it still lead the regions, wake up the followers lost the leader.
+static void CheckHibernateLeader(const butil::EndPoint& endpoint, const std::vector<std::shared_ptr<RaftNode>>& nodes) {
+  pb::store::CheckHibernateRequest request;
+  pb::store::CheckHibernateResponse response;
+  for (const auto& node : nodes) {
+    request.add_region_ids(node->GetNodeId());
+  }
+
+  brpc::Channel channel;
+  brpc::Controller cntl;
+  cntl.set_timeout_ms(Constant::kRaftHibernateCheckTimeoutMs);
+  if (channel.Init(endpoint, nullptr) == 0) {
+    pb::store::StoreService_Stub stub(&channel);
+    stub.CheckHibernate(&cntl, &request, &response, nullptr);
+  } else {
+    cntl.SetFailed("Init channel failed");
+  }
+  if (cntl.Failed() || response.error().errcode() != pb::error::OK) {
+    DINGO_LOG(WARNING) << fmt::format("Check hibernate leader store {} failed, {} {}",
+                                      butil::endpoint2str(endpoint).c_str(), cntl.ErrorText(),
+                                      response.error().errmsg());
+  }
+
+  std::set<uint64_t> leader_region_ids(response.leader_region_ids().begin(), response.leader_region_ids().end());
+  for (const auto& node : nodes) {
+    if (leader_region_ids.find(node->GetNodeId()) == leader_region_ids.end()) {
+      node->WakeUp();
+    }
+  }
+}
+
+void RaftKvEngine::CheckHibernate() {
+  // The last check is still waiting the leader stores.
+  if (is_checking_hibernate_.exchange(true)) {
+    return;
+  }
+  ScopeGuard guard([this]() { is_checking_hibernate_.store(false); });
+
+  auto stores = Server::GetInstance()->GetStoreMetaManager()->GetStoreServerMeta()->GetAllStore();
+
+  // Hibernated followers never start election, check their leader by one rpc per store pair.
+  std::map<butil::EndPoint, std::vector<std::shared_ptr<RaftNode>>> hibernated_followers;
+  for (auto& node : raft_node_manager_->GetAllNode()) {
+    node->CheckHibernate();
+    if (!node->IsHibernated() || node->IsLeader()) {
+      continue;
+    }
+
+    butil::EndPoint const endpoint = Helper::QueryServerEndpointByRaftEndpoint(stores, node->GetLeaderId().addr);
+    if (endpoint.port == 0) {
+      node->WakeUp();
+      continue;
+    }
+    hibernated_followers[endpoint].push_back(node);
+  }
+
+  for (const auto& [endpoint, nodes] : hibernated_followers) {
+    CheckHibernateLeader(endpoint, nodes);
+  }
+}
+
 butil::Status RaftKvEngine::TransferLeader(uint64_t region_id, const pb::common::Peer& peer) {
   auto node = raft_node_manager_->GetNode(region_id);
   if (node == nullptr) {
@@ -222,7 +315,7 @@ butil::Status RaftKvEngine::AsyncWrite(std::shared_ptr<Context> ctx, const Write
   }
 
   ctx->SetWriteCb(cb);
-  return node->Commit(ctx, GenRaftCmdRequest(ctx, write_data));
+  return node->GroupCommit(ctx, GenRaftCmdRequest(ctx, write_data));
 }
 
 std::shared_ptr<Engine::Reader> RaftKvEngine::NewReader(const std::string& cf_name) {
@@ -234,6 +327,11 @@ butil::Status RaftKvEngine::Reader::KvGet(std::shared_ptr<Context> /*ctx*/, cons
   return reader_->KvGet(key, value);
 }
 
+butil::Status RaftKvEngine::Reader::KvBatchGet(std::shared_ptr<Context> /*ctx*/, const std::vector<std::string>& keys,
+                                               std::vector<pb::common::KeyValue>& kvs) {
+  return reader_->KvBatchGet(keys, kvs);
+}
+
 butil::Status RaftKvEngine::Reader::KvScan(std::shared_ptr<Context> /*ctx*/, const std::string& start_key,
                                            const std::string& end_key, std::vector<pb::common::KeyValue>& kvs) {
   return reader_->KvScan(start_key, end_key, kvs);
@@ -15,6 +15,7 @@
 #ifndef DINGODB_ENGINE_RAFT_KV_ENGINE_H_
 #define DINGODB_ENGINE_RAFT_KV_ENGINE_H_
 
+#include <atomic>
 #include <memory>
 
 #include "engine/engine.h"
@@ -70,6 +71,8 @@ class RaftKvEngine : public Engine, public RaftControlAble {
   butil::Status StopNode(std::shared_ptr<Context> ctx, uint64_t region_id) override;
   butil::Status DestroyNode(std::shared_ptr<Context> ctx, uint64_t region_id) override;
   std::shared_ptr<RaftNode> GetNode(uint64_t region_id) override;
+  // Hibernate idle region, wake up the hibernated followers whose leader store lost the leadership.
+  void CheckHibernate();
 
   butil::Status TransferLeader(uint64_t region_id, const pb::common::Peer& peer) override;
 
@@ -86,6 +89,9 @@ class RaftKvEngine : public Engine, public RaftControlAble {
     Reader(std::shared_ptr<RawEngine::Reader> reader) : reader_(reader) {}
     butil::Status KvGet(std::shared_ptr<Context> ctx, const std::string& key, std::string& value) override;
 
+    butil::Status KvBatchGet(std::shared_ptr<Context> ctx, const std::vector<std::string>& keys,
+                             std::vector<pb::common::KeyValue>& kvs) override;
+
     butil::Status KvScan(std::shared_ptr<Context> ctx, const std::string& start_key, const std::string& end_key,
                          std::vector<pb::common::KeyValue>& kvs) override;
 
@@ -99,6 +105,7 @@ class RaftKvEngine : public Engine, public RaftControlAble {
  protected:
   std::shared_ptr<RawEngine> engine_;                   // NOLINT
   std::unique_ptr<RaftNodeManager> raft_node_manager_;  // NOLINT
+  std::atomic<bool> is_checking_hibernate_;             // NOLINT
 };
 
 }  // namespace dingodb
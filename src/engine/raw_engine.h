@@ -15,13 +15,16 @@
 #ifndef DINGODB_ENGINE_KV_ENGINE_H_  // NOLINT
 #define DINGODB_ENGINE_KV_ENGINE_H_
 
+#include <functional>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "common/context.h"
 #include "config/config.h"
 #include "engine/iterator.h"
+#include "engine/row_cache.h"
 #include "engine/snapshot.h"
 #include "engine/write_data.h"
 #include "proto/common.pb.h"
@@ -45,6 +48,18 @@ enum class EnumEngineReader {
   kColumnar = 4,
 };
 
+// Visit key/value without copy, key and value are only valid during the call.
+// Return false to stop visiting.
+using KvVisitor = std::function<bool(std::string_view key, std::string_view value)>;
+
+// Read pattern of iterator, decide the io options of engine.
+enum class ReadProfile {
+  // Short scan of online requests, read through block cache.
+  kDefault = 0,
+  // Long sequential scan such as analytic queries, prefetch asynchronously and bypass block cache.
+  kBulkScan = 1,
+};
+
 class EngineIterator : public std::enable_shared_from_this<EngineIterator> {
  public:
   EngineIterator() = default;
@@ -56,8 +71,12 @@ class EngineIterator : public std::enable_shared_from_this<EngineIterator> {
   virtual bool GetKV(std::string& key, std::string& value) = 0;  // NOLINT
   virtual bool GetKey(std::string& key) = 0;                     // NOLINT
   virtual bool GetValue(std::string& value) = 0;                 // NOLINT
+  // Visit from current position until the end or visitor return false,
+  // the key/value which visitor return false is also consumed.
+  virtual void Visit(const KvVisitor& visitor) = 0;
   virtual const std::string& GetName() const = 0;
   virtual uint32_t GetID() = 0;
+  virtual ReadProfile GetReadProfile() const { return ReadProfile::kDefault; }
 };
 
 class RawEngine {
@@ -72,16 +91,33 @@ class RawEngine {
     virtual butil::Status KvGet(std::shared_ptr<dingodb::Snapshot> snapshot, const std::string& key,
                                 std::string& value) = 0;
 
+    // Batch point lookup under one snapshot, not found keys are skipped.
+    virtual butil::Status KvBatchGet(const std::vector<std::string>& keys, std::vector<pb::common::KeyValue>& kvs) = 0;
+    virtual butil::Status KvBatchGet(std::shared_ptr<dingodb::Snapshot> snapshot, const std::vector<std::string>& keys,
+                                     std::vector<pb::common::KeyValue>& kvs) = 0;
+
     virtual butil::Status KvScan(const std::string& start_key, const std::string& end_key,
                                  std::vector<pb::common::KeyValue>& kvs) = 0;
     virtual butil::Status KvScan(std::shared_ptr<dingodb::Snapshot> snapshot, const std::string& start_key,
                                  const std::string& end_key, std::vector<pb::common::KeyValue>& kvs) = 0;
 
+    // Zero copy scan, stop when reach max_count rows or max_bytes(key + value), 0 means no limit.
+    virtual butil::Status KvScan(const std::string& start_key, const std::string& end_key, uint64_t max_count,
+                                 uint64_t max_bytes, const KvVisitor& visitor) = 0;
+    virtual butil::Status KvScan(std::shared_ptr<dingodb::Snapshot> snapshot, const std::string& start_key,
+                                 const std::string& end_key, uint64_t max_count, uint64_t max_bytes,
+                                 const KvVisitor& visitor) = 0;
+
     virtual butil::Status KvCount(const std::string& start_key, const std::string& end_key, uint64_t& count) = 0;
     virtual butil::Status KvCount(std::shared_ptr<dingodb::Snapshot> snapshot, const std::string& start_key,
                                   const std::string& end_key, uint64_t& count) = 0;
 
     virtual std::shared_ptr<EngineIterator> NewIterator(const std::string& start_key, const std::string& end_key) = 0;
+    // Engines without io options ignore profile.
+    virtual std::shared_ptr<EngineIterator> NewIterator(const std::string& start_key, const std::string& end_key,
+                                                        ReadProfile /*profile*/) {
+      return NewIterator(start_key, end_key);
+    }
   };
 
   class Writer {
@@ -113,11 +149,35 @@ class RawEngine {
     virtual butil::Status KvBatchDelete(const std::vector<std::string>& keys) = 0;
 
     virtual butil::Status KvDeleteRange(const pb::common::Range& range) = 0;
+    // Drop whole files in range besides the range tombstone, it is not snapshot consistent,
+    // old snapshots may lose the data. Engines without files ignore the flag.
+    virtual butil::Status KvDeleteRange(const pb::common::Range& range, bool /*delete_files_in_range*/) {
+      return KvDeleteRange(range);
+    }
     virtual butil::Status KvBatchDeleteRange(const std::vector<pb::common::Range>& ranges) = 0;
 
     virtual butil::Status KvDeleteIfEqual(const pb::common::KeyValue& kv) = 0;
   };
 
+  // Accumulate mutations of many writes and commit them by one engine write,
+  // readers and writers from the batch see the uncommitted mutations.
+  class WriteBatch {
+   public:
+    WriteBatch() = default;
+    virtual ~WriteBatch() = default;
+
+    virtual std::shared_ptr<Reader> NewReader(const std::string& cf_name) = 0;
+    virtual std::shared_ptr<Writer> NewWriter(const std::string& cf_name) = 0;
+
+    // Uncommitted mutation count and bytes.
+    virtual uint32_t Count() = 0;
+    virtual uint64_t DataSize() = 0;
+
+    virtual butil::Status Commit() = 0;
+    // Not less than the sequence number of the last commit, 0 means unknown.
+    virtual uint64_t CommittedSequence() { return 0; }
+  };
+
   virtual bool Init(std::shared_ptr<Config> config) = 0;
   virtual bool Recover() { return true; }
 
@@ -127,11 +187,17 @@ class RawEngine {
   virtual std::shared_ptr<Snapshot> GetSnapshot() = 0;
 
   virtual void Flush(const std::string& cf_name) = 0;
+  // Largest sequence number of the flushed data, 0 means unknown.
+  virtual uint64_t GetFlushedSequence() { return 0; }
 
   virtual std::shared_ptr<Snapshot> NewSnapshot() = 0;
   virtual std::shared_ptr<Reader> NewReader(const std::string& cf_name) = 0;
   virtual std::shared_ptr<RawEngine::Writer> NewWriter(const std::string& cf_name) = 0;
   virtual std::shared_ptr<Iterator> NewIterator(const std::string& cf_name, IteratorOptions options) = 0;
+  // Return nullptr when engine not support write batch.
+  virtual std::shared_ptr<WriteBatch> NewWriteBatch() { return nullptr; }
+  // Return nullptr when rows of the column family are not cached.
+  virtual std::shared_ptr<RowCache> GetRowCache(const std::string& /*cf_name*/) { return nullptr; }
 
   virtual std::vector<uint64_t> GetApproximateSizes(const std::string& cf_name,
                                                     std::vector<pb::common::Range>& ranges) = 0;
@@ -34,6 +34,7 @@
 #include <utility>
 #include <vector>
 
+#include "bthread/bthread.h"
 #include "butil/compiler_specific.h"
 #include "butil/macros.h"
 #include "common/constant.h"
@@ -44,6 +45,7 @@
 #include "engine/raft_kv_engine.h"
 #include "engine/raw_engine.h"
 #include "fmt/core.h"
+#include "gflags/gflags.h"
 #include "proto/common.pb.h"
 #include "proto/error.pb.h"
 #include "rocksdb/advanced_options.h"
@@ -55,17 +57,26 @@
 
 namespace dingodb {
 
+DEFINE_int64(rocksdb_bulk_scan_readahead_size, 2 * 1024 * 1024,
+             "readahead size of bulk scan, 0 means grow automatically from block size");
+DEFINE_int64(rocksdb_orphan_compact_min_bytes, 8 * 1024 * 1024,
+             "skip compacting the gap between regions when its approximate size is less than it");
+DEFINE_int32(rocksdb_compactor_max_pending, 1024, "max pending tasks of background manual compaction");
+
 class RocksIterator : public EngineIterator {
  public:
   explicit RocksIterator(std::shared_ptr<dingodb::Snapshot> snapshot, std::shared_ptr<rocksdb::DB> db,
                          std::shared_ptr<RawRocksEngine::ColumnFamily> column_family, const std::string& start_key,
-                         const std::string& end_key)
+                         const std::string& end_key, ReadProfile profile,
+                         std::shared_ptr<RawRocksEngine::WriteBatch> write_batch = nullptr)
       : snapshot_(snapshot),
         db_(db),
         column_family_(column_family),
+        write_batch_(write_batch),
         iter_(nullptr),
         start_key_(start_key),
         end_key_(end_key),
+        profile_(profile),
         with_start_(true),
         with_end_(false),
         has_valid_kv_(false) {
@@ -73,8 +84,26 @@ class RocksIterator : public EngineIterator {
     read_option.auto_prefix_mode = true;
     read_option.snapshot = static_cast<const rocksdb::Snapshot*>(
         std::dynamic_pointer_cast<RawRocksEngine::RocksSnapshot>(snapshot)->Inner());
+    // [start_key, end_key), rocksdb skip the files and blocks out of range
+    lower_bound_ = rocksdb::Slice(start_key_);
+    read_option.iterate_lower_bound = &lower_bound_;
+    if (!end_key_.empty()) {
+      upper_bound_ = rocksdb::Slice(end_key_);
+      read_option.iterate_upper_bound = &upper_bound_;
+    }
+    if (profile == ReadProfile::kBulkScan) {
+      // Prefetch the next blocks in background while the current ones are consumed, and keep the working set of
+      // online requests in block cache.
+      read_option.async_io = true;
+      read_option.adaptive_readahead = true;
+      read_option.readahead_size = FLAGS_rocksdb_bulk_scan_readahead_size;
+      read_option.fill_cache = false;
+    }
 
     iter_ = db_->NewIterator(read_option, column_family_->GetHandle());
+    if (write_batch_ != nullptr) {
+      iter_ = write_batch_->Inner()->NewIteratorWithBase(column_family_->GetHandle(), iter_, &read_option);
+    }
   }
   void Start() override {
     iter_->Seek(start_key_);
@@ -93,8 +122,8 @@ class RocksIterator : public EngineIterator {
 
   bool HasNext() override {
     if (iter_->Valid()) {
-      rocksdb::Slice key = iter_->key();
-      if (FilterEndKey(key)) {
+      // The mutations of write batch are not bounded by rocksdb
+      if (write_batch_ == nullptr || FilterEndKey(iter_->key())) {
         has_valid_kv_ = true;
         return true;
       }
@@ -105,6 +134,16 @@ class RocksIterator : public EngineIterator {
 
   void Next() override { iter_->Next(); }
 
+  void Visit(const KvVisitor& visitor) override {
+    while (HasNext()) {
+      bool is_continue = visitor(iter_->key().ToStringView(), iter_->value().ToStringView());
+      iter_->Next();
+      if (!is_continue) {
+        break;
+      }
+    }
+  }
+
   bool GetKV(std::string& key, std::string& value) {  // NOLINT
     if (has_valid_kv_) {
       key.assign(iter_->key().data(), iter_->key().size());
@@ -129,6 +168,7 @@ class RocksIterator : public EngineIterator {
 
   const std::string& GetName() const override { return name_; }
   uint32_t GetID() override { return id_; }
+  ReadProfile GetReadProfile() const override { return profile_; }
 
   ~RocksIterator() override {
     if (iter_) {
@@ -192,17 +232,21 @@ class RocksIterator : public EngineIterator {
   std::shared_ptr<dingodb::Snapshot> snapshot_;
   std::shared_ptr<rocksdb::DB> db_;
   std::shared_ptr<RawRocksEngine::ColumnFamily> column_family_;
+  std::shared_ptr<RawRocksEngine::WriteBatch> write_batch_;
   rocksdb::Iterator* iter_;
   const std::string name_ = "Rocks";
   uint32_t id_ = static_cast<uint32_t>(EnumEngineIterator::kRocks);
   std::string start_key_;
   std::string end_key_;
+  rocksdb::Slice lower_bound_;
+  rocksdb::Slice upper_bound_;
+  ReadProfile profile_;
   bool with_start_;
   bool with_end_;
   bool has_valid_kv_;
 };
 
-RawRocksEngine::RawRocksEngine() : db_(nullptr), column_families_({}) {}
+RawRocksEngine::RawRocksEngine() : db_(nullptr), column_families_({}), disable_data_wal_(false) {}
 
 RawRocksEngine::~RawRocksEngine() {}
 
@@ -235,6 +279,10 @@ bool RawRocksEngine::Init(std::shared_ptr<Config> config) {
 
   SetColumnFamilyFromConfig(config, column_families);
 
+  InitMemoryBudget(config, column_families);
+
+  InitRowCache(config);
+
   std::vector<rocksdb::ColumnFamilyHandle*> family_handles;
   bool ret = RocksdbInit(config, db_path_, column_families, family_handles);
   if (BAIDU_UNLIKELY(!ret)) {
@@ -244,6 +292,9 @@ bool RawRocksEngine::Init(std::shared_ptr<Config> config) {
 
   SetColumnFamilyHandle(column_families, family_handles);
 
+  compactor_ = std::make_shared<Compactor>();
+  compactor_->Start();
+
   DINGO_LOG(INFO) << fmt::format("rocksdb::DB::Open : {} success!", db_path_);
 
   return true;
@@ -281,13 +332,13 @@ butil::Status RawRocksEngine::MergeCheckpointFile(const std::string& path, const
 
   // Create iterator
   IteratorOptions iter_options;
+  iter_options.lower_bound = range.start_key();
   iter_options.upper_bound = range.end_key();
 
   rocksdb::ReadOptions read_options;
   read_options.auto_prefix_mode = true;
 
-  auto iter =
-      std::make_shared<RawRocksEngine::Iterator>(iter_options, snapshot_db->NewIterator(read_options, handles[0]));
+  auto iter = std::make_shared<RawRocksEngine::Iterator>(iter_options, snapshot_db, handles[0], read_options);
   iter->Seek(range.start_key());
 
   // Create sst writer
@@ -309,6 +360,15 @@ butil::Status RawRocksEngine::IngestExternalFile(const std::string& cf_name, con
 void RawRocksEngine::Flush(const std::string& cf_name) {
   if (db_) {
     rocksdb::FlushOptions flush_options;
+    if (disable_data_wal_) {
+      // Data and raft meta must be flushed together.
+      std::vector<rocksdb::ColumnFamilyHandle*> handles;
+      for (const auto& [_, column_family] : column_families_) {
+        handles.push_back(column_family->GetHandle());
+      }
+      db_->Flush(flush_options, handles);
+      return;
+    }
     db_->Flush(flush_options, GetColumnFamily(cf_name)->GetHandle());
   }
 }
@@ -324,6 +384,9 @@ std::shared_ptr<RawEngine::Reader> RawRocksEngine::NewReader(const std::string&
   if (column_family == nullptr) {
     return nullptr;
   }
+  if (row_cache_ != nullptr && cf_name == Constant::kStoreDataCF) {
+    return std::make_shared<Reader>(db_, column_family, row_cache_);
+  }
   return std::make_shared<Reader>(db_, column_family);
 }
 
@@ -332,7 +395,15 @@ std::shared_ptr<RawEngine::Writer> RawRocksEngine::NewWriter(const std::string&
   if (column_family == nullptr) {
     return nullptr;
   }
-  return std::make_shared<Writer>(db_, column_family);
+  return std::make_shared<Writer>(db_, column_family, compactor_);
+}
+
+std::shared_ptr<RawEngine::WriteBatch> RawRocksEngine::NewWriteBatch() {
+  return std::make_shared<RawRocksEngine::WriteBatch>(this, db_, disable_data_wal_);
+}
+
+std::shared_ptr<RowCache> RawRocksEngine::GetRowCache(const std::string& cf_name) {
+  return cf_name == Constant::kStoreDataCF ? row_cache_ : nullptr;
 }
 
 std::shared_ptr<dingodb::Iterator> RawRocksEngine::NewIterator(const std::string& cf_name, IteratorOptions options) {
@@ -347,17 +418,12 @@ std::shared_ptr<dingodb::Iterator> RawRocksEngine::NewIterator(const std::string
     return nullptr;
   }
 
-  // Correct free iterate_upper_bound
-  // auto slice = std::make_unique<rocksdb::Slice>(options.upper_bound);
   rocksdb::ReadOptions read_options;
   if (snapshot != nullptr) {
     read_options.snapshot = static_cast<const rocksdb::Snapshot*>(snapshot->Inner());
   }
   read_options.auto_prefix_mode = true;
-  // if (!options.upper_bound.empty()) {
-  //   read_options.iterate_upper_bound = slice.get();
-  // }
-  return std::make_shared<RawRocksEngine::Iterator>(options, db_->NewIterator(read_options, column_family->GetHandle()),
+  return std::make_shared<RawRocksEngine::Iterator>(options, db_.get(), column_family->GetHandle(), read_options,
                                                     snapshot);
 }
 
@@ -370,6 +436,21 @@ std::shared_ptr<RawRocksEngine::Checkpoint> RawRocksEngine::NewCheckpoint() {
 }
 
 void RawRocksEngine::Close() {
+  block_cache_capacity_metrics_.reset();
+  block_cache_usage_metrics_.reset();
+  block_cache_pinned_usage_metrics_.reset();
+  write_buffer_usage_metrics_.reset();
+  row_cache_usage_metrics_.reset();
+  row_cache_ = nullptr;
+
+  if (compactor_ != nullptr) {
+    // Abort the running manual compaction, not wait it.
+    if (db_) {
+      db_->DisableManualCompaction();
+    }
+    compactor_->Stop();
+  }
+
   if (db_) {
     column_families_.clear();
     db_->Close();
@@ -411,6 +492,134 @@ std::vector<uint64_t> RawRocksEngine::GetApproximateSizes(const std::string& cf_
   return result;
 }
 
+void RawRocksEngine::SetLiveRanges(const std::vector<pb::common::Range>& ranges) {
+  if (orphan_filter_factory_ == nullptr) {
+    return;
+  }
+  orphan_filter_factory_->SetLiveRanges(std::make_shared<LiveRanges>(ranges));
+}
+
+void RawRocksEngine::CompactOrphanRanges() {
+  if (orphan_filter_factory_ == nullptr || compactor_ == nullptr) {
+    return;
+  }
+
+  if (!compactor_->Submit("orphan_ranges", [this]() { DoCompactOrphanRanges(); })) {
+    DINGO_LOG(INFO) << "last orphan ranges compaction is pending";
+  }
+}
+
+void RawRocksEngine::DoCompactOrphanRanges() {
+  auto live_ranges = orphan_filter_factory_->GetLiveRanges();
+  if (live_ranges == nullptr || live_ranges->Ranges().empty()) {
+    return;
+  }
+
+  auto gaps = live_ranges->Gaps();
+  auto sizes = GetApproximateSizes(Constant::kStoreDataCF, gaps);
+  int compact_count = 0;
+  for (size_t i = 0; i < gaps.size(); ++i) {
+    // Most gaps only have the edges of the files across it, compact it rewrite these files.
+    if (sizes[i] < static_cast<uint64_t>(FLAGS_rocksdb_orphan_compact_min_bytes)) {
+      continue;
+    }
+
+    auto status = CompactRange(Constant::kStoreDataCF, gaps[i]);
+    if (!status.ok()) {
+      break;
+    }
+    ++compact_count;
+  }
+
+  DINGO_LOG(INFO) << fmt::format("compact orphan ranges : {}/{} live ranges : {}", compact_count, gaps.size(),
+                                 live_ranges->Ranges().size());
+}
+
+butil::Status RawRocksEngine::CompactRange(const std::string& cf_name, const pb::common::Range& range) {
+  auto column_family = GetColumnFamily(cf_name);
+  if (column_family == nullptr) {
+    return butil::Status(pb::error::EINTERNAL, fmt::format("column family {} not found", cf_name));
+  }
+
+  // Bottommost files are compacted because of the compaction filter, but not the files just compacted.
+  rocksdb::CompactRangeOptions options;
+  options.exclusive_manual_compaction = false;
+  options.max_subcompactions = 1;
+  options.bottommost_level_compaction = rocksdb::BottommostLevelCompaction::kForceOptimized;
+  rocksdb::Slice start(range.start_key());
+  rocksdb::Slice end(range.end_key());
+  auto status = db_->CompactRange(options, column_family->GetHandle(), range.start_key().empty() ? nullptr : &start,
+                                  range.end_key().empty() ? nullptr : &end);
+  if (!status.ok()) {
+    DINGO_LOG(WARNING) << fmt::format("rocksdb::DB::CompactRange [{}, {}) failed : {}",
+                                      Helper::StringToHex(range.start_key()), Helper::StringToHex(range.end_key()),
+                                      status.ToString());
+    return butil::Status(status.code(), status.ToString());
+  }
+
+  return butil::Status();
+}
+
+void RawRocksEngine::Compactor::Start() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!is_stopped_) {
+    return;
+  }
+  is_stopped_ = false;
+  thread_ = std::thread([this]() { Run(); });
+}
+
+void RawRocksEngine::Compactor::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (is_stopped_) {
+      return;
+    }
+    is_stopped_ = true;
+    tasks_.clear();
+    pending_keys_.clear();
+  }
+  cond_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+bool RawRocksEngine::Compactor::Submit(const std::string& key, std::function<void()> func) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (is_stopped_ || pending_keys_.count(key) > 0) {
+      return false;
+    }
+    if (tasks_.size() >= static_cast<size_t>(FLAGS_rocksdb_compactor_max_pending)) {
+      DINGO_LOG(WARNING) << fmt::format("compactor pending tasks exceed {}, drop it", tasks_.size());
+      return false;
+    }
+    pending_keys_.insert(key);
+    tasks_.emplace_back(key, std::move(func));
+  }
+  cond_.notify_one();
+  return true;
+}
+
+void RawRocksEngine::Compactor::Run() {
+  while (true) {
+    std::function<void()> func;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait(lock, [this]() { return is_stopped_ || !tasks_.empty(); });
+      if (is_stopped_) {
+        return;
+      }
+      // Submit the same key again while running is another task.
+      pending_keys_.erase(tasks_.front().first);
+      func = std::move(tasks_.front().second);
+      tasks_.pop_front();
+    }
+    func();
+  }
+}
+
 template <typename T>
 void SetCfConfigurationElement(const std::map<std::string, std::string>& cf_configuration, const char* name,
                                const T& default_value, T& value) {  // NOLINT
@@ -460,12 +669,132 @@ void SetCfConfigurationElementWrapper(const RawRocksEngine::CfDefaultConf& defau
   }
 }
 
+std::shared_ptr<rocksdb::Cache> NewBlockCache(const std::string& type, size_t capacity, size_t block_size) {
+  if (type == "hyper_clock") {
+    // Lock free lookup, scale better than LRU under lots of concurrent reads.
+    rocksdb::HyperClockCacheOptions options(capacity, block_size);
+    return options.MakeSharedCache();
+  }
+
+  return rocksdb::NewLRUCache(capacity);
+}
+
+void RawRocksEngine::InitMemoryBudget(std::shared_ptr<Config> config, const std::vector<std::string>& column_families) {
+  int64_t budget = static_cast<int64_t>(config->GetInt(Constant::kMemoryBudgetMb)) * 1024 * 1024;
+  if (budget <= 0) {
+    double ratio = config->GetDouble(Constant::kMemoryBudgetRatio);
+    if (ratio <= 0 || ratio > 1) {
+      ratio = Constant::kMemoryBudgetRatioDefault;
+    }
+    budget = static_cast<int64_t>(ratio * static_cast<double>(Helper::GetTotalMemorySize()));
+  }
+
+  std::string cache_type = config->GetString(Constant::kBlockCacheType);
+
+  size_t block_size = 0;
+  const auto& default_cf = column_families_[ROCKSDB_NAMESPACE::kDefaultColumnFamilyName];
+  SetCfConfigurationElementWrapper(default_cf->GetDefaultConf(), default_cf->GetConf(), Constant::kBlockSize.c_str(),
+                                   block_size);
+
+  // The dedicated caches are carved out of the budget, the rest is shared
+  std::map<std::string, double> cf_ratios;
+  double total_cf_ratio = 0;
+  for (const auto& cf_name : column_families) {
+    double ratio = 0;
+    SetCfConfigurationElement(column_families_[cf_name]->GetConf(), Constant::kBlockCacheRatio.c_str(), 0.0, ratio);
+    if (ratio > 0) {
+      cf_ratios[cf_name] = ratio;
+      total_cf_ratio += ratio;
+    }
+  }
+
+  if (total_cf_ratio >= 1.0) {
+    DINGO_LOG(ERROR) << fmt::format("sum of {} {} must less than 1, all column families share the block cache",
+                                    Constant::kBlockCacheRatio, total_cf_ratio);
+    cf_ratios.clear();
+    total_cf_ratio = 0;
+  }
+
+  cf_block_caches_.clear();
+  for (const auto& [cf_name, ratio] : cf_ratios) {
+    cf_block_caches_[cf_name] = NewBlockCache(cache_type, static_cast<size_t>(ratio * budget), block_size);
+  }
+
+  size_t shared_capacity = static_cast<size_t>((1.0 - total_cf_ratio) * budget);
+  block_cache_ = NewBlockCache(cache_type, shared_capacity, block_size);
+
+  // Memtables take the space of the shared block cache, so the budget hold both
+  double write_buffer_ratio = config->GetDouble(Constant::kWriteBufferRatio);
+  if (write_buffer_ratio <= 0 || write_buffer_ratio >= 1) {
+    write_buffer_ratio = Constant::kWriteBufferRatioDefault;
+  }
+  write_buffer_manager_ = std::make_shared<rocksdb::WriteBufferManager>(
+      static_cast<size_t>(write_buffer_ratio * shared_capacity), block_cache_);
+
+  block_cache_capacity_metrics_ = std::make_unique<bvar::PassiveStatus<int64_t>>(
+      "dingo_rocksdb", "block_cache_capacity",
+      [](void* arg) -> int64_t {
+        auto* engine = static_cast<RawRocksEngine*>(arg);
+        int64_t capacity = engine->block_cache_->GetCapacity();
+        for (const auto& [_, cache] : engine->cf_block_caches_) {
+          capacity += cache->GetCapacity();
+        }
+        return capacity;
+      },
+      this);
+  block_cache_usage_metrics_ = std::make_unique<bvar::PassiveStatus<int64_t>>(
+      "dingo_rocksdb", "block_cache_usage",
+      [](void* arg) -> int64_t {
+        auto* engine = static_cast<RawRocksEngine*>(arg);
+        int64_t usage = engine->block_cache_->GetUsage();
+        for (const auto& [_, cache] : engine->cf_block_caches_) {
+          usage += cache->GetUsage();
+        }
+        return usage;
+      },
+      this);
+  block_cache_pinned_usage_metrics_ = std::make_unique<bvar::PassiveStatus<int64_t>>(
+      "dingo_rocksdb", "block_cache_pinned_usage",
+      [](void* arg) -> int64_t {
+        auto* engine = static_cast<RawRocksEngine*>(arg);
+        int64_t usage = engine->block_cache_->GetPinnedUsage();
+        for (const auto& [_, cache] : engine->cf_block_caches_) {
+          usage += cache->GetPinnedUsage();
+        }
+        return usage;
+      },
+      this);
+  write_buffer_usage_metrics_ = std::make_unique<bvar::PassiveStatus<int64_t>>(
+      "dingo_rocksdb", "write_buffer_usage",
+      [](void* arg) -> int64_t {
+        return static_cast<RawRocksEngine*>(arg)->write_buffer_manager_->memory_usage();
+      },
+      this);
+
+  DINGO_LOG(INFO) << fmt::format(
+      "rocksdb memory budget : {} block cache type : {} shared block cache : {} write buffer : {} dedicated : {}",
+      budget, cache_type.empty() ? "lru" : cache_type, shared_capacity, write_buffer_manager_->buffer_size(),
+      cf_ratios.size());
+}
+
+void RawRocksEngine::InitRowCache(std::shared_ptr<Config> config) {
+  int64_t capacity = static_cast<int64_t>(config->GetInt(Constant::kRowCacheMb)) * 1024 * 1024;
+  if (capacity <= 0) {
+    return;
+  }
+
+  row_cache_ = std::make_shared<RowCache>(capacity);
+  row_cache_usage_metrics_ = std::make_unique<bvar::PassiveStatus<int64_t>>(
+      "dingo_rocksdb", "row_cache_usage",
+      [](void* arg) -> int64_t { return static_cast<RawRocksEngine*>(arg)->row_cache_->Usage(); }, this);
+
+  DINGO_LOG(INFO) << fmt::format("row cache of {} : {}", Constant::kStoreDataCF, capacity);
+}
+
 bool RawRocksEngine::InitCfConfig(const std::vector<std::string>& column_families) {
   CfDefaultConf dcf_default_conf;
   dcf_default_conf.emplace(Constant::kBlockSize, std::make_optional(static_cast<int64_t>(131072)));
 
-  dcf_default_conf.emplace(Constant::kBlockCache, std::make_optional(static_cast<int64_t>(67108864)));
-
   dcf_default_conf.emplace(Constant::kArenaBlockSize, std::make_optional(static_cast<int64_t>(67108864)));
 
   dcf_default_conf.emplace(Constant::kMinWriteBufferNumberToMerge, std::make_optional(static_cast<int64_t>(4)));
@@ -495,6 +824,7 @@ bool RawRocksEngine::InitCfConfig(const std::vector<std::string>& column_familie
 // set cf config
 bool RawRocksEngine::SetCfConfiguration(const CfDefaultConf& default_conf,
                                         const std::map<std::string, std::string>& cf_configuration,
+                                        std::shared_ptr<rocksdb::Cache> block_cache,
                                         rocksdb::ColumnFamilyOptions* family_options) {
   rocksdb::ColumnFamilyOptions& cf_options = *family_options;
 
@@ -504,15 +834,8 @@ bool RawRocksEngine::SetCfConfiguration(const CfDefaultConf& default_conf,
   SetCfConfigurationElementWrapper(default_conf, cf_configuration, Constant::kBlockSize.c_str(),
                                    table_options.block_size);
 
-  // block_cache
-  {
-    size_t value = 0;
-
-    SetCfConfigurationElementWrapper(default_conf, cf_configuration, Constant::kBlockCache.c_str(), value);
-
-    auto cache = rocksdb::NewLRUCache(value);  // LRUcache
-    table_options.block_cache = cache;
-  }
+  // block_cache, shared by column families
+  table_options.block_cache = block_cache;
 
   // arena_block_size
 
@@ -567,10 +890,6 @@ bool RawRocksEngine::SetCfConfiguration(const CfDefaultConf& default_conf,
 
   cf_options.prefix_extractor.reset(rocksdb::NewCappedPrefixTransform(8));
 
-  auto compressed_block_cache = rocksdb::NewLRUCache(1024 * 1024 * 1024);  // LRUcache
-
-  // table_options.block_cache_compressed.reset(compressed_block_cache);
-
   rocksdb::TableFactory* table_factory = NewBlockBasedTableFactory(table_options);
   cf_options.table_factory.reset(table_factory);
 
@@ -620,6 +939,25 @@ int GetBackgroundThreadNum(std::shared_ptr<dingodb::Config> config) {
   return num > 0 ? num : Constant::kRocksdbBackgroundThreadNumDefault;
 }
 
+// With data wal disabled, flushed data is all that survives a crash. Record the flushed sequence number,
+// the state machine compare it with the sequence of its commits to know which applied index is durable.
+class FlushListener : public rocksdb::EventListener {
+ public:
+  explicit FlushListener(std::atomic<uint64_t>* flushed_sequence) : flushed_sequence_(flushed_sequence) {}
+
+  void OnFlushCompleted(rocksdb::DB* /*db*/, const rocksdb::FlushJobInfo& info) override {
+    uint64_t sequence = flushed_sequence_->load();
+    while (info.largest_seqno > sequence && !flushed_sequence_->compare_exchange_weak(sequence, info.largest_seqno)) {
+    }
+
+    DINGO_LOG(DEBUG) << fmt::format("rocksdb flush completed, cf: {} seqno: [{}-{}] reason: {}", info.cf_name,
+                                    info.smallest_seqno, info.largest_seqno, static_cast<int>(info.flush_reason));
+  }
+
+ private:
+  std::atomic<uint64_t>* flushed_sequence_;
+};
+
 int GetStatsDumpPeriodSec(std::shared_ptr<dingodb::Config> config) {
   int num = config->GetInt("store.stats_dump_period_sec");
   return (num <= 0) ? Constant::kStatsDumpPeriodSecDefault : num;
@@ -628,12 +966,21 @@ int GetStatsDumpPeriodSec(std::shared_ptr<dingodb::Config> config) {
 bool RawRocksEngine::RocksdbInit(std::shared_ptr<Config> config, const std::string& db_path,
                                  const std::vector<std::string>& column_family,
                                  std::vector<rocksdb::ColumnFamilyHandle*>& family_handles) {
+  // The filter keep all data until store region meta publish the live ranges.
+  if (config->GetInt(Constant::kDropOrphanData) > 0) {
+    orphan_filter_factory_ = std::make_shared<OrphanFilterFactory>();
+  }
+
   // cppcheck-suppress variableScope
   std::vector<rocksdb::ColumnFamilyDescriptor> column_families;
   for (const auto& column_family : column_family) {
     rocksdb::ColumnFamilyOptions family_options;
+    auto iter = cf_block_caches_.find(column_family);
     SetCfConfiguration(column_families_[column_family]->GetDefaultConf(), column_families_[column_family]->GetConf(),
-                       &family_options);
+                       iter != cf_block_caches_.end() ? iter->second : block_cache_, &family_options);
+    if (orphan_filter_factory_ != nullptr && column_family == Constant::kStoreDataCF) {
+      family_options.compaction_filter_factory = orphan_filter_factory_;
+    }
 
     column_families.push_back(rocksdb::ColumnFamilyDescriptor(column_family, family_options));
   }
@@ -644,6 +991,15 @@ bool RawRocksEngine::RocksdbInit(std::shared_ptr<Config> config, const std::stri
   db_options.max_background_jobs = GetBackgroundThreadNum(config);
   db_options.max_subcompactions = db_options.max_background_jobs / 4 * 3;
   db_options.stats_dump_period_sec = GetStatsDumpPeriodSec(config);
+  db_options.write_buffer_manager = write_buffer_manager_;
+
+  // Apply write batch carry data and raft applied index without wal, the applied index
+  // recovered from meta column family is the flushed one, the raft log after it will be replayed.
+  disable_data_wal_ = config->GetInt(Constant::kDisableDataWal) > 0;
+  if (disable_data_wal_) {
+    db_options.atomic_flush = true;
+    db_options.listeners.push_back(std::make_shared<FlushListener>(&flushed_sequence_));
+  }
 
   rocksdb::DB* db;
   rocksdb::Status s = rocksdb::DB::Open(db_options, db_path, column_families, &family_handles, &db);
@@ -744,8 +1100,23 @@ RawRocksEngine::ColumnFamily& RawRocksEngine::ColumnFamily::operator=(RawRocksEn
 }
 
 butil::Status RawRocksEngine::Reader::KvGet(const std::string& key, std::string& value) {
+  if (row_cache_ == nullptr) {
+    auto snapshot = std::make_shared<RocksSnapshot>(db_->GetSnapshot(), db_);
+    return KvGet(snapshot, key, value);
+  }
+
+  if (row_cache_->Lookup(key, value)) {
+    return butil::Status();
+  }
+
+  // Take version before snapshot, the fill is dropped if key is written after it.
+  uint64_t version = row_cache_->Version(key);
   auto snapshot = std::make_shared<RocksSnapshot>(db_->GetSnapshot(), db_);
-  return KvGet(snapshot, key, value);
+  auto status = KvGet(snapshot, key, value);
+  if (status.ok()) {
+    row_cache_->Fill(key, value, version);
+  }
+  return status;
 }
 
 butil::Status RawRocksEngine::Reader::KvGet(std::shared_ptr<dingodb::Snapshot> snapshot, const std::string& key,
@@ -757,7 +1128,11 @@ butil::Status RawRocksEngine::Reader::KvGet(std::shared_ptr<dingodb::Snapshot> s
 
   rocksdb::ReadOptions read_option;
   read_option.snapshot = static_cast<const rocksdb::Snapshot*>(snapshot->Inner());
-  rocksdb::Status s = db_->Get(read_option, column_family_->GetHandle(), rocksdb::Slice(key), &value);
+  rocksdb::Status s =
+      write_batch_ != nullptr
+          ? write_batch_->Inner()->GetFromBatchAndDB(db_.get(), read_option, column_family_->GetHandle(),
+                                                     rocksdb::Slice(key), &value)
+          : db_->Get(read_option, column_family_->GetHandle(), rocksdb::Slice(key), &value);
   if (!s.ok()) {
     if (s.IsNotFound()) {
       return butil::Status(pb::error::EKEY_NOT_FOUND, "Not found");
@@ -769,6 +1144,63 @@ butil::Status RawRocksEngine::Reader::KvGet(std::shared_ptr<dingodb::Snapshot> s
   return butil::Status();
 }
 
+butil::Status RawRocksEngine::Reader::KvBatchGet(const std::vector<std::string>& keys,
+                                                 std::vector<pb::common::KeyValue>& kvs) {
+  auto snapshot = std::make_shared<RocksSnapshot>(db_->GetSnapshot(), db_);
+  return KvBatchGet(snapshot, keys, kvs);
+}
+
+butil::Status RawRocksEngine::Reader::KvBatchGet(std::shared_ptr<dingodb::Snapshot> snapshot,
+                                                 const std::vector<std::string>& keys,
+                                                 std::vector<pb::common::KeyValue>& kvs) {
+  if (BAIDU_UNLIKELY(keys.empty())) {
+    DINGO_LOG(ERROR) << fmt::format("keys empty not support");
+    return butil::Status(pb::error::EKEY_EMPTY, "Key is empty");
+  }
+
+  std::vector<rocksdb::Slice> key_slices;
+  key_slices.reserve(keys.size());
+  for (const auto& key : keys) {
+    if (BAIDU_UNLIKELY(key.empty())) {
+      DINGO_LOG(ERROR) << fmt::format("key empty not support");
+      return butil::Status(pb::error::EKEY_EMPTY, "Key is empty");
+    }
+    key_slices.emplace_back(key);
+  }
+
+  rocksdb::ReadOptions read_option;
+  read_option.snapshot = static_cast<const rocksdb::Snapshot*>(snapshot->Inner());
+
+  std::vector<rocksdb::PinnableSlice> values(keys.size());
+  std::vector<rocksdb::Status> statuses(keys.size());
+  if (write_batch_ != nullptr) {
+    write_batch_->Inner()->MultiGetFromBatchAndDB(db_.get(), read_option, column_family_->GetHandle(), keys.size(),
+                                                  key_slices.data(), values.data(), statuses.data(), false);
+  } else {
+    db_->MultiGet(read_option, column_family_->GetHandle(), keys.size(), key_slices.data(), values.data(),
+                  statuses.data());
+  }
+
+  kvs.reserve(kvs.size() + keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (!statuses[i].ok()) {
+      if (statuses[i].IsNotFound()) {
+        continue;
+      }
+      DINGO_LOG(ERROR) << fmt::format("rocksdb::DB::MultiGet failed : {}", statuses[i].ToString());
+      kvs.clear();
+      return butil::Status(pb::error::EINTERNAL, "Internal get error");
+    }
+
+    pb::common::KeyValue kv;
+    kv.set_key(keys[i]);
+    kv.set_value(values[i].data(), values[i].size());
+    kvs.emplace_back(std::move(kv));
+  }
+
+  return butil::Status();
+}
+
 butil::Status RawRocksEngine::Reader::KvScan(const std::string& start_key, const std::string& end_key,
                                              std::vector<pb::common::KeyValue>& kvs) {
   auto snapshot = std::make_shared<RocksSnapshot>(db_->GetSnapshot(), db_);
@@ -777,6 +1209,25 @@ butil::Status RawRocksEngine::Reader::KvScan(const std::string& start_key, const
 
 butil::Status RawRocksEngine::Reader::KvScan(std::shared_ptr<dingodb::Snapshot> snapshot, const std::string& start_key,
                                              const std::string& end_key, std::vector<pb::common::KeyValue>& kvs) {
+  return KvScan(snapshot, start_key, end_key, 0, 0, [&kvs](std::string_view key, std::string_view value) -> bool {
+    pb::common::KeyValue kv;
+    kv.set_key(key.data(), key.size());
+    kv.set_value(value.data(), value.size());
+
+    kvs.emplace_back(std::move(kv));
+    return true;
+  });
+}
+
+butil::Status RawRocksEngine::Reader::KvScan(const std::string& start_key, const std::string& end_key,
+                                             uint64_t max_count, uint64_t max_bytes, const KvVisitor& visitor) {
+  auto snapshot = std::make_shared<RocksSnapshot>(db_->GetSnapshot(), db_);
+  return KvScan(snapshot, start_key, end_key, max_count, max_bytes, visitor);
+}
+
+butil::Status RawRocksEngine::Reader::KvScan(std::shared_ptr<dingodb::Snapshot> snapshot, const std::string& start_key,
+                                             const std::string& end_key, uint64_t max_count, uint64_t max_bytes,
+                                             const KvVisitor& visitor) {
   if (BAIDU_UNLIKELY(start_key.empty())) {
     DINGO_LOG(ERROR) << fmt::format("start_key empty  not support");
     return butil::Status(pb::error::EKEY_EMPTY, "Key is empty");
@@ -790,17 +1241,34 @@ butil::Status RawRocksEngine::Reader::KvScan(std::shared_ptr<dingodb::Snapshot>
   rocksdb::ReadOptions read_option;
   read_option.auto_prefix_mode = true;
   read_option.snapshot = static_cast<const rocksdb::Snapshot*>(snapshot->Inner());
+  rocksdb::Slice lower_bound(start_key);
+  rocksdb::Slice upper_bound(end_key);
+  read_option.iterate_lower_bound = &lower_bound;
+  read_option.iterate_upper_bound = &upper_bound;
 
+  // The end key check is for the mutations of write batch which are not bounded by rocksdb
   std::string_view end_key_view(end_key);
-  rocksdb::Iterator* it = db_->NewIterator(read_option, column_family_->GetHandle());
+  uint64_t count = 0;
+  uint64_t bytes = 0;
+  std::unique_ptr<rocksdb::Iterator> it(NewRocksIterator(read_option));
   for (it->Seek(start_key); it->Valid() && it->key().ToStringView() < end_key_view; it->Next()) {
-    pb::common::KeyValue kv;
-    kv.set_key(it->key().data(), it->key().size());
-    kv.set_value(it->value().data(), it->value().size());
+    std::string_view key = it->key().ToStringView();
+    std::string_view value = it->value().ToStringView();
+    if (!visitor(key, value)) {
+      break;
+    }
 
-    kvs.emplace_back(std::move(kv));
+    ++count;
+    bytes += key.size() + value.size();
+    if ((max_count > 0 && count >= max_count) || (max_bytes > 0 && bytes >= max_bytes)) {
+      break;
+    }
+  }
+
+  if (BAIDU_UNLIKELY(!it->status().ok())) {
+    DINGO_LOG(ERROR) << fmt::format("rocksdb::Iterator failed : {}", it->status().ToString());
+    return butil::Status(pb::error::EINTERNAL, "Internal scan error");
   }
-  delete it;
 
   return butil::Status();
 }
@@ -826,9 +1294,13 @@ butil::Status RawRocksEngine::Reader::KvCount(std::shared_ptr<dingodb::Snapshot>
   rocksdb::ReadOptions read_options;
   read_options.auto_prefix_mode = true;
   read_options.snapshot = static_cast<const rocksdb::Snapshot*>(snapshot->Inner());
+  rocksdb::Slice lower_bound(start_key);
+  rocksdb::Slice upper_bound(end_key);
+  read_options.iterate_lower_bound = &lower_bound;
+  read_options.iterate_upper_bound = &upper_bound;
 
   std::string_view end_key_view(end_key.data(), end_key.size());
-  rocksdb::Iterator* it = db_->NewIterator(read_options, column_family_->GetHandle());
+  rocksdb::Iterator* it = NewRocksIterator(read_options);
   for (it->Seek(start_key), count = 0; it->Valid() && it->key().ToStringView() < end_key_view; it->Next()) {
     ++count;
   }
@@ -839,14 +1311,27 @@ butil::Status RawRocksEngine::Reader::KvCount(std::shared_ptr<dingodb::Snapshot>
 
 std::shared_ptr<EngineIterator> RawRocksEngine::Reader::NewIterator(const std::string& start_key,
                                                                     const std::string& end_key) {
+  return NewIterator(start_key, end_key, ReadProfile::kDefault);
+}
+
+std::shared_ptr<EngineIterator> RawRocksEngine::Reader::NewIterator(const std::string& start_key,
+                                                                    const std::string& end_key, ReadProfile profile) {
   auto snapshot = std::make_shared<RocksSnapshot>(db_->GetSnapshot(), db_);
-  return NewIterator(snapshot, start_key, end_key);
+  return NewIterator(snapshot, start_key, end_key, profile);
 }
 
 std::shared_ptr<EngineIterator> RawRocksEngine::Reader::NewIterator(std::shared_ptr<dingodb::Snapshot> snapshot,
                                                                     const std::string& start_key,
-                                                                    const std::string& end_key) {
-  return std::make_shared<RocksIterator>(snapshot, db_, column_family_, start_key, end_key);
+                                                                    const std::string& end_key, ReadProfile profile) {
+  return std::make_shared<RocksIterator>(snapshot, db_, column_family_, start_key, end_key, profile, write_batch_);
+}
+
+rocksdb::Iterator* RawRocksEngine::Reader::NewRocksIterator(const rocksdb::ReadOptions& read_options) {
+  rocksdb::Iterator* iter = db_->NewIterator(read_options, column_family_->GetHandle());
+  if (write_batch_ != nullptr) {
+    return write_batch_->Inner()->NewIteratorWithBase(column_family_->GetHandle(), iter, &read_options);
+  }
+  return iter;
 }
 
 butil::Status RawRocksEngine::Writer::KvPut(const pb::common::KeyValue& kv) {
@@ -855,9 +1340,7 @@ butil::Status RawRocksEngine::Writer::KvPut(const pb::common::KeyValue& kv) {
     return butil::Status(pb::error::EKEY_EMPTY, "Key is empty");
   }
 
-  rocksdb::WriteOptions write_options;
-  rocksdb::Status s =
-      db_->Put(write_options, column_family_->GetHandle(), rocksdb::Slice(kv.key()), rocksdb::Slice(kv.value()));
+  rocksdb::Status s = Put(rocksdb::Slice(kv.key()), rocksdb::Slice(kv.value()));
   if (!s.ok()) {
     DINGO_LOG(ERROR) << fmt::format("rocksdb::DB::Put failed : {}", s.ToString());
     return butil::Status(pb::error::EINTERNAL, "Internal put error");
@@ -903,8 +1386,7 @@ butil::Status RawRocksEngine::Writer::KvBatchPutAndDelete(const std::vector<pb::
       }
     }
   }
-  rocksdb::WriteOptions write_options;
-  rocksdb::Status s = db_->Write(write_options, &batch);
+  rocksdb::Status s = Write(&batch);
   if (!s.ok()) {
     DINGO_LOG(ERROR) << fmt::format("rocksdb::DB::Write failed : {}", s.ToString());
     return butil::Status(pb::error::EINTERNAL, "Internal write error");
@@ -946,8 +1428,7 @@ butil::Status RawRocksEngine::Writer::KvBatchPutIfAbsent(const std::vector<pb::c
     }
 
     std::string value_old;
-    rocksdb::Status s = db_->Get(rocksdb::ReadOptions(), column_family_->GetHandle(),
-                                 rocksdb::Slice(kv.key().data(), kv.key().size()), &value_old);
+    rocksdb::Status s = Get(rocksdb::Slice(kv.key().data(), kv.key().size()), &value_old);
     if (is_atomic) {
       if (!s.IsNotFound()) {
         key_states.clear();
@@ -977,7 +1458,7 @@ butil::Status RawRocksEngine::Writer::KvBatchPutIfAbsent(const std::vector<pb::c
     key_index++;
   }
 
-  rocksdb::Status s = db_->Write(rocksdb::WriteOptions(), &batch);
+  rocksdb::Status s = Write(&batch);
   if (!s.ok()) {
     key_states.clear();
     key_states.resize(kvs.size(), false);
@@ -999,9 +1480,7 @@ butil::Status RawRocksEngine::Writer::KvDelete(const std::string& key) {
     return butil::Status(pb::error::EKEY_EMPTY, "Key is empty");
   }
 
-  rocksdb::WriteOptions const write_options;
-  rocksdb::Status const s =
-      db_->Delete(write_options, column_family_->GetHandle(), rocksdb::Slice(key.data(), key.size()));
+  rocksdb::Status const s = Delete(rocksdb::Slice(key.data(), key.size()));
   if (!s.ok()) {
     DINGO_LOG(ERROR) << fmt::format("rocksdb::DB::Delete failed : {}", s.ToString());
     return butil::Status(pb::error::EINTERNAL, "Internal delete error");
@@ -1038,8 +1517,7 @@ butil::Status RawRocksEngine::Writer::KvBatchCompareAndSet(const std::vector<pb:
     }
 
     std::string value_old;
-    rocksdb::Status s = db_->Get(rocksdb::ReadOptions(), column_family_->GetHandle(),
-                                 rocksdb::Slice(kv.key().data(), kv.key().size()), &value_old);
+    rocksdb::Status s = Get(rocksdb::Slice(kv.key().data(), kv.key().size()), &value_old);
     if (is_atomic) {
       if (s.ok()) {
         if (value_old != expect_values[key_index]) {
@@ -1109,7 +1587,7 @@ butil::Status RawRocksEngine::Writer::KvBatchCompareAndSet(const std::vector<pb:
     key_index++;
   }
 
-  rocksdb::Status s = db_->Write(rocksdb::WriteOptions(), &batch);
+  rocksdb::Status s = Write(&batch);
   if (!s.ok()) {
     key_states.clear();
     key_states.resize(kvs.size(), false);
@@ -1140,8 +1618,16 @@ butil::Status RawRocksEngine::Writer::KvDeleteRange(const pb::common::Range& ran
     return butil::Status(pb::error::EILLEGAL_PARAMTETERS, "range is wrong");
   }
 
-  auto status =
-      db_->DeleteRange(rocksdb::WriteOptions(), column_family_->GetHandle(), range.start_key(), range.end_key());
+  // WriteBatchWithIndex not support delete range, commit the batch first to keep write order.
+  if (write_batch_ != nullptr) {
+    auto ret = write_batch_->Commit();
+    if (!ret.ok()) {
+      return ret;
+    }
+  }
+
+  auto status = db_->DeleteRange(write_batch_ != nullptr ? write_batch_->GetWriteOptions() : rocksdb::WriteOptions(),
+                                 column_family_->GetHandle(), range.start_key(), range.end_key());
   if (!status.ok()) {
     DINGO_LOG(ERROR) << fmt::format("rocksdb::DB::Write failed : {}", status.ToString());
     return butil::Status(pb::error::EINTERNAL, "Internal delete range error");
@@ -1150,6 +1636,47 @@ butil::Status RawRocksEngine::Writer::KvDeleteRange(const pb::common::Range& ran
   return butil::Status();
 }
 
+butil::Status RawRocksEngine::Writer::KvDeleteRange(const pb::common::Range& range, bool delete_files_in_range) {
+  auto status = KvDeleteRange(range);
+  if (!status.ok() || !delete_files_in_range) {
+    return status;
+  }
+
+  // The tombstone has hidden the range, so dropping the files covered by it only changes old snapshots.
+  rocksdb::Slice start(range.start_key());
+  rocksdb::Slice end(range.end_key());
+  auto s = rocksdb::DeleteFilesInRange(db_.get(), column_family_->GetHandle(), &start, &end, false);
+  if (!s.ok()) {
+    // Compaction still reclaim the space
+    DINGO_LOG(WARNING) << fmt::format("rocksdb::DeleteFilesInRange failed : {}", s.ToString());
+    return butil::Status();
+  }
+
+  // After whole files are dropped, only the files across the edges and the tombstone are left in range,
+  // the compaction is small but may still wait for the compaction threads, so not block the caller.
+  if (compactor_ != nullptr) {
+    auto db = db_;
+    auto column_family = column_family_;
+    compactor_->Submit(
+        fmt::format("{}_{}_{}", column_family->Name(), range.start_key(), range.end_key()),
+        [db, column_family, range]() {
+          rocksdb::CompactRangeOptions options;
+          options.exclusive_manual_compaction = false;
+          options.bottommost_level_compaction = rocksdb::BottommostLevelCompaction::kForceOptimized;
+          rocksdb::Slice start(range.start_key());
+          rocksdb::Slice end(range.end_key());
+          auto status = db->CompactRange(options, column_family->GetHandle(), &start, &end);
+          if (!status.ok()) {
+            DINGO_LOG(WARNING) << fmt::format("rocksdb::DB::CompactRange [{}, {}) failed : {}",
+                                              Helper::StringToHex(range.start_key()),
+                                              Helper::StringToHex(range.end_key()), status.ToString());
+          }
+        });
+  }
+
+  return butil::Status();
+}
+
 butil::Status RawRocksEngine::Writer::KvBatchDeleteRange(const std::vector<pb::common::Range>& ranges) {
   for (const auto& range : ranges) {
     if (range.start_key().empty() || range.end_key().empty()) {
@@ -1162,14 +1689,23 @@ butil::Status RawRocksEngine::Writer::KvBatchDeleteRange(const std::vector<pb::c
 
   rocksdb::WriteBatch batch;
   for (const auto& range : ranges) {
-    rocksdb::Status s = batch.DeleteRange(column_family_->GetHandle(), range.start_key(), range.start_key());
+    rocksdb::Status s = batch.DeleteRange(column_family_->GetHandle(), range.start_key(), range.end_key());
     if (!s.ok()) {
       DINGO_LOG(ERROR) << fmt::format("rocksdb::WriteBatch::DeleteRange failed : {}", s.ToString());
       return butil::Status(pb::error::EINTERNAL, "Internal delete range error");
     }
   }
 
-  rocksdb::Status s = db_->Write(rocksdb::WriteOptions(), &batch);
+  // WriteBatchWithIndex not support delete range, commit the batch first to keep write order.
+  if (write_batch_ != nullptr) {
+    auto ret = write_batch_->Commit();
+    if (!ret.ok()) {
+      return ret;
+    }
+  }
+
+  rocksdb::Status s =
+      db_->Write(write_batch_ != nullptr ? write_batch_->GetWriteOptions() : rocksdb::WriteOptions(), &batch);
   if (!s.ok()) {
     DINGO_LOG(ERROR) << fmt::format("rocksdb::DB::Write failed : {}", s.ToString());
     return butil::Status(pb::error::EINTERNAL, "Internal write error");
@@ -1186,8 +1722,7 @@ butil::Status RawRocksEngine::Writer::KvDeleteIfEqual(const pb::common::KeyValue
 
   // other read will failed
   std::string old_value;
-  rocksdb::Status s = db_->Get(rocksdb::ReadOptions(), column_family_->GetHandle(),
-                               rocksdb::Slice(kv.key().data(), kv.key().size()), &old_value);
+  rocksdb::Status s = Get(rocksdb::Slice(kv.key().data(), kv.key().size()), &old_value);
   if (!s.ok()) {
     if (s.IsNotFound()) {
       DINGO_LOG(ERROR) << fmt::format("rocksdb::DB::GetForUpdate not found key");
@@ -1203,8 +1738,7 @@ butil::Status RawRocksEngine::Writer::KvDeleteIfEqual(const pb::common::KeyValue
   }
 
   // delete a key
-  s = db_->Delete(rocksdb::WriteOptions(), column_family_->GetHandle(),
-                  rocksdb::Slice(kv.key().data(), kv.key().size()));
+  s = Delete(rocksdb::Slice(kv.key().data(), kv.key().size()));
   if (BAIDU_UNLIKELY(!s.ok())) {
     DINGO_LOG(ERROR) << fmt::format("rocksdb::DB::Delete failed : {}", s.ToString());
     return butil::Status(pb::error::EINTERNAL, "Internal delete error");
@@ -1223,8 +1757,7 @@ butil::Status RawRocksEngine::Writer::KvCompareAndSetInternal(const pb::common::
   key_state = false;
 
   std::string old_value;
-  rocksdb::Status s = db_->Get(rocksdb::ReadOptions(), column_family_->GetHandle(),
-                               rocksdb::Slice(kv.key().data(), kv.key().size()), &old_value);
+  rocksdb::Status s = Get(rocksdb::Slice(kv.key().data(), kv.key().size()), &old_value);
   if (s.ok()) {
     if (!is_key_exist) {
       // The key already exists, the client requests not to return an error code and key_state set false
@@ -1247,8 +1780,7 @@ butil::Status RawRocksEngine::Writer::KvCompareAndSetInternal(const pb::common::
   }
 
   // write a key
-  s = db_->Put(rocksdb::WriteOptions(), column_family_->GetHandle(), rocksdb::Slice(kv.key().data(), kv.key().size()),
-               rocksdb::Slice(value.data(), value.size()));
+  s = Put(rocksdb::Slice(kv.key().data(), kv.key().size()), rocksdb::Slice(value.data(), value.size()));
   if (!s.ok()) {
     DINGO_LOG(ERROR) << fmt::format("rocksdb::DB::Put failed : {}", s.ToString());
     return butil::Status(pb::error::EINTERNAL, "Internal put error");
@@ -1259,6 +1791,93 @@ butil::Status RawRocksEngine::Writer::KvCompareAndSetInternal(const pb::common::
   return butil::Status();
 }
 
+rocksdb::Status RawRocksEngine::Writer::Get(const rocksdb::Slice& key, std::string* value) {
+  if (write_batch_ != nullptr) {
+    return write_batch_->Inner()->GetFromBatchAndDB(db_.get(), rocksdb::ReadOptions(), column_family_->GetHandle(), key,
+                                                    value);
+  }
+  return db_->Get(rocksdb::ReadOptions(), column_family_->GetHandle(), key, value);
+}
+
+rocksdb::Status RawRocksEngine::Writer::Put(const rocksdb::Slice& key, const rocksdb::Slice& value) {
+  if (write_batch_ != nullptr) {
+    return write_batch_->Inner()->Put(column_family_->GetHandle(), key, value);
+  }
+  return db_->Put(rocksdb::WriteOptions(), column_family_->GetHandle(), key, value);
+}
+
+rocksdb::Status RawRocksEngine::Writer::Delete(const rocksdb::Slice& key) {
+  if (write_batch_ != nullptr) {
+    return write_batch_->Inner()->Delete(column_family_->GetHandle(), key);
+  }
+  return db_->Delete(rocksdb::WriteOptions(), column_family_->GetHandle(), key);
+}
+
+// Append put/delete of rocksdb::WriteBatch to WriteBatchWithIndex.
+class WriteBatchIndexAppender : public rocksdb::WriteBatch::Handler {
+ public:
+  WriteBatchIndexAppender(rocksdb::WriteBatchWithIndex* batch, rocksdb::ColumnFamilyHandle* handle)
+      : batch_(batch), handle_(handle) {}
+
+  rocksdb::Status PutCF(uint32_t column_family_id, const rocksdb::Slice& key, const rocksdb::Slice& value) override {
+    if (BAIDU_UNLIKELY(column_family_id != handle_->GetID())) {
+      return rocksdb::Status::InvalidArgument("Mismatch column family");
+    }
+    return batch_->Put(handle_, key, value);
+  }
+
+  rocksdb::Status DeleteCF(uint32_t column_family_id, const rocksdb::Slice& key) override {
+    if (BAIDU_UNLIKELY(column_family_id != handle_->GetID())) {
+      return rocksdb::Status::InvalidArgument("Mismatch column family");
+    }
+    return batch_->Delete(handle_, key);
+  }
+
+ private:
+  rocksdb::WriteBatchWithIndex* batch_;
+  rocksdb::ColumnFamilyHandle* handle_;
+};
+
+rocksdb::Status RawRocksEngine::Writer::Write(rocksdb::WriteBatch* batch) {
+  if (write_batch_ != nullptr) {
+    WriteBatchIndexAppender appender(write_batch_->Inner(), column_family_->GetHandle());
+    return batch->Iterate(&appender);
+  }
+  return db_->Write(rocksdb::WriteOptions(), batch);
+}
+
+std::shared_ptr<RawEngine::Reader> RawRocksEngine::WriteBatch::NewReader(const std::string& cf_name) {
+  auto column_family = engine_->GetColumnFamily(cf_name);
+  if (column_family == nullptr) {
+    return nullptr;
+  }
+  return std::make_shared<RawRocksEngine::Reader>(db_, column_family, shared_from_this());
+}
+
+std::shared_ptr<RawEngine::Writer> RawRocksEngine::WriteBatch::NewWriter(const std::string& cf_name) {
+  auto column_family = engine_->GetColumnFamily(cf_name);
+  if (column_family == nullptr) {
+    return nullptr;
+  }
+  return std::make_shared<RawRocksEngine::Writer>(db_, column_family, engine_->compactor_, shared_from_this());
+}
+
+butil::Status RawRocksEngine::WriteBatch::Commit() {
+  if (batch_.GetWriteBatch()->Count() == 0) {
+    return butil::Status();
+  }
+
+  rocksdb::Status s = db_->Write(GetWriteOptions(), batch_.GetWriteBatch());
+  if (!s.ok()) {
+    DINGO_LOG(ERROR) << fmt::format("rocksdb::DB::Write failed : {}", s.ToString());
+    return butil::Status(pb::error::EINTERNAL, "Internal write error");
+  }
+  batch_.Clear();
+  committed_sequence_ = db_->GetLatestSequenceNumber();
+
+  return butil::Status();
+}
+
 butil::Status RawRocksEngine::SstFileWriter::SaveFile(const std::vector<pb::common::KeyValue>& kvs,
                                                       const std::string& filename) {
   auto status = sst_writer_->Open(filename);
@@ -15,22 +15,32 @@
 #ifndef DINGODB_ENGINE_ROCKS_KV_ENGINE_H_  // NOLINT
 #define DINGODB_ENGINE_ROCKS_KV_ENGINE_H_
 
+#include <atomic>
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
+#include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <set>
 #include <string>
+#include <thread>
 #include <utility>
 #include <variant>
 #include <vector>
 
+#include "bvar/passive_status.h"
 #include "config/config.h"
 #include "engine/iterator.h"
+#include "engine/orphan_filter.h"
 #include "engine/raw_engine.h"
 #include "engine/snapshot.h"
 #include "openssl/core_dispatch.h"
 #include "proto/store_internal.pb.h"
 #include "rocksdb/cache.h"
+#include "rocksdb/comparator.h"
 #include "rocksdb/convenience.h"
 #include "rocksdb/db.h"
 #include "rocksdb/listener.h"
@@ -39,6 +49,8 @@
 #include "rocksdb/slice_transform.h"
 #include "rocksdb/status.h"
 #include "rocksdb/utilities/checkpoint.h"
+#include "rocksdb/utilities/write_batch_with_index.h"
+#include "rocksdb/write_buffer_manager.h"
 
 namespace dingodb {
 
@@ -113,29 +125,27 @@ class RawRocksEngine : public RawEngine {
 
   class Iterator : public dingodb::Iterator {
    public:
-    explicit Iterator(IteratorOptions options, rocksdb::Iterator* iter)
-        : options_(options), iter_(iter), snapshot_(nullptr) {}
-    explicit Iterator(IteratorOptions options, rocksdb::Iterator* iter, std::shared_ptr<Snapshot> snapshot)
-        : options_(options), iter_(iter), snapshot_(snapshot) {}
+    // The bounds of options are passed to rocksdb, which skip the files and blocks out of range and use the
+    // prefix bloom filter by auto_prefix_mode. The bounds must live as long as the rocksdb iterator.
+    explicit Iterator(IteratorOptions options, rocksdb::DB* db, rocksdb::ColumnFamilyHandle* handle,
+                      rocksdb::ReadOptions read_options, std::shared_ptr<Snapshot> snapshot = nullptr)
+        : options_(std::move(options)), snapshot_(snapshot) {
+      if (!options_.lower_bound.empty()) {
+        lower_bound_ = rocksdb::Slice(options_.lower_bound);
+        read_options.iterate_lower_bound = &lower_bound_;
+      }
+      if (!options_.upper_bound.empty()) {
+        upper_bound_ = rocksdb::Slice(options_.upper_bound);
+        read_options.iterate_upper_bound = &upper_bound_;
+      }
+      iter_.reset(db->NewIterator(read_options, handle));
+    }
     ~Iterator() override = default;
 
     std::string GetName() override { return "RawRocks"; }
     IteratorType GetID() override { return IteratorType::kRawRocksEngine; }
 
-    bool Valid() const override {
-      if (!iter_->Valid()) {
-        return false;
-      }
-
-      if (!options_.upper_bound.empty()) {
-        auto upper_bound = rocksdb::Slice(options_.upper_bound);
-        if (upper_bound.compare(iter_->key()) <= 0) {
-          return false;
-        }
-      }
-
-      return true;
-    }
+    bool Valid() const override { return iter_->Valid(); }
 
     void SeekToFirst() override { iter_->SeekToFirst(); }
     void SeekToLast() override { iter_->SeekToLast(); }
@@ -153,41 +163,104 @@ class RawRocksEngine : public RawEngine {
 
    private:
     IteratorOptions options_;
-    std::unique_ptr<rocksdb::Iterator> iter_;
+    rocksdb::Slice lower_bound_;
+    rocksdb::Slice upper_bound_;
     std::shared_ptr<Snapshot> snapshot_;
+    std::unique_ptr<rocksdb::Iterator> iter_;
   };
 
+  // Run manual compactions one by one on a dedicated thread. rocksdb::DB::CompactRange block until the
+  // compaction is done, so it must not occupy the bthread workers. The task with the same key is pending
+  // only once, the task is dropped when the queue is full, the normal compaction still reclaim the space.
+  class Compactor {
+   public:
+    Compactor() = default;
+    ~Compactor() { Stop(); }
+
+    Compactor(const Compactor& rhs) = delete;
+    Compactor& operator=(const Compactor& rhs) = delete;
+
+    void Start();
+    // Drop the pending tasks, wait the running one.
+    void Stop();
+
+    // Return false if the key is pending, the queue is full or stopped.
+    bool Submit(const std::string& key, std::function<void()> func);
+
+   private:
+    void Run();
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::deque<std::pair<std::string, std::function<void()>>> tasks_;
+    std::set<std::string> pending_keys_;
+    bool is_stopped_{true};
+    std::thread thread_;
+  };
+
+  class WriteBatch;
+
   class Reader : public RawEngine::Reader {
    public:
     Reader(std::shared_ptr<rocksdb::DB> db, std::shared_ptr<ColumnFamily> column_family)
         : db_(db), column_family_(column_family) {}
+    // Read through write batch, see the uncommitted mutations of the batch.
+    Reader(std::shared_ptr<rocksdb::DB> db, std::shared_ptr<ColumnFamily> column_family,
+           std::shared_ptr<WriteBatch> write_batch)
+        : db_(db), column_family_(column_family), write_batch_(write_batch) {}
+    // Point read without snapshot go through row cache.
+    Reader(std::shared_ptr<rocksdb::DB> db, std::shared_ptr<ColumnFamily> column_family,
+           std::shared_ptr<RowCache> row_cache)
+        : db_(db), column_family_(column_family), row_cache_(row_cache) {}
     ~Reader() override = default;
     butil::Status KvGet(const std::string& key, std::string& value) override;
     butil::Status KvGet(std::shared_ptr<dingodb::Snapshot> snapshot, const std::string& key,
                         std::string& value) override;
 
+    butil::Status KvBatchGet(const std::vector<std::string>& keys, std::vector<pb::common::KeyValue>& kvs) override;
+    butil::Status KvBatchGet(std::shared_ptr<dingodb::Snapshot> snapshot, const std::vector<std::string>& keys,
+                             std::vector<pb::common::KeyValue>& kvs) override;
+
     butil::Status KvScan(const std::string& start_key, const std::string& end_key,
                          std::vector<pb::common::KeyValue>& kvs) override;
     butil::Status KvScan(std::shared_ptr<dingodb::Snapshot> snapshot, const std::string& start_key,
                          const std::string& end_key, std::vector<pb::common::KeyValue>& kvs) override;
 
+    butil::Status KvScan(const std::string& start_key, const std::string& end_key, uint64_t max_count,
+                         uint64_t max_bytes, const KvVisitor& visitor) override;
+    butil::Status KvScan(std::shared_ptr<dingodb::Snapshot> snapshot, const std::string& start_key,
+                         const std::string& end_key, uint64_t max_count, uint64_t max_bytes,
+                         const KvVisitor& visitor) override;
+
     butil::Status KvCount(const std::string& start_key, const std::string& end_key, uint64_t& count) override;
     butil::Status KvCount(std::shared_ptr<dingodb::Snapshot> snapshot, const std::string& start_key,
                           const std::string& end_key, uint64_t& count) override;
 
     std::shared_ptr<EngineIterator> NewIterator(const std::string& start_key, const std::string& end_key) override;
+    std::shared_ptr<EngineIterator> NewIterator(const std::string& start_key, const std::string& end_key,
+                                                ReadProfile profile) override;
 
    private:
     std::shared_ptr<EngineIterator> NewIterator(std::shared_ptr<dingodb::Snapshot> snapshot,
-                                                const std::string& start_key, const std::string& end_key);
+                                                const std::string& start_key, const std::string& end_key,
+                                                ReadProfile profile);
+    rocksdb::Iterator* NewRocksIterator(const rocksdb::ReadOptions& read_options);
+
     std::shared_ptr<rocksdb::DB> db_;
     std::shared_ptr<ColumnFamily> column_family_;
+    std::shared_ptr<WriteBatch> write_batch_;
+    std::shared_ptr<RowCache> row_cache_;
   };
 
   class Writer : public RawEngine::Writer {
    public:
-    Writer(std::shared_ptr<rocksdb::DB> db, std::shared_ptr<ColumnFamily> column_family)
-        : db_(db), column_family_(column_family) {}
+    Writer(std::shared_ptr<rocksdb::DB> db, std::shared_ptr<ColumnFamily> column_family,
+           std::shared_ptr<Compactor> compactor)
+        : db_(db), column_family_(column_family), compactor_(compactor) {}
+    // Write into write batch, committed by WriteBatch::Commit.
+    Writer(std::shared_ptr<rocksdb::DB> db, std::shared_ptr<ColumnFamily> column_family,
+           std::shared_ptr<Compactor> compactor, std::shared_ptr<WriteBatch> write_batch)
+        : db_(db), column_family_(column_family), compactor_(compactor), write_batch_(write_batch) {}
     ~Writer() override = default;
     butil::Status KvPut(const pb::common::KeyValue& kv) override;
     butil::Status KvBatchPut(const std::vector<pb::common::KeyValue>& kvs) override;
@@ -215,6 +288,7 @@ class RawRocksEngine : public RawEngine {
     butil::Status KvBatchDelete(const std::vector<std::string>& keys) override;
 
     butil::Status KvDeleteRange(const pb::common::Range& range) override;
+    butil::Status KvDeleteRange(const pb::common::Range& range, bool delete_files_in_range) override;
     butil::Status KvBatchDeleteRange(const std::vector<pb::common::Range>& ranges) override;
 
     // key must be exist
@@ -224,8 +298,49 @@ class RawRocksEngine : public RawEngine {
     butil::Status KvCompareAndSetInternal(const pb::common::KeyValue& kv, const std::string& value, bool is_key_exist,
                                           bool& key_state);
 
+    // Read/write db directly, or through the write batch if exist.
+    rocksdb::Status Get(const rocksdb::Slice& key, std::string* value);
+    rocksdb::Status Put(const rocksdb::Slice& key, const rocksdb::Slice& value);
+    rocksdb::Status Delete(const rocksdb::Slice& key);
+    rocksdb::Status Write(rocksdb::WriteBatch* batch);
+
     std::shared_ptr<ColumnFamily> column_family_;
     std::shared_ptr<rocksdb::DB> db_;
+    std::shared_ptr<Compactor> compactor_;
+    std::shared_ptr<WriteBatch> write_batch_;
+  };
+
+  // Apply many writes by one rocksdb write, base on WriteBatchWithIndex,
+  // so readers and writers of the batch can see the uncommitted mutations.
+  // Delete range is not supported by WriteBatchWithIndex, it commit the batch first.
+  class WriteBatch : public RawEngine::WriteBatch, public std::enable_shared_from_this<WriteBatch> {
+   public:
+    WriteBatch(RawRocksEngine* engine, std::shared_ptr<rocksdb::DB> db, bool disable_wal)
+        : engine_(engine), db_(db), disable_wal_(disable_wal), batch_(rocksdb::BytewiseComparator(), 0, true) {}
+    ~WriteBatch() override = default;
+
+    std::shared_ptr<RawEngine::Reader> NewReader(const std::string& cf_name) override;
+    std::shared_ptr<RawEngine::Writer> NewWriter(const std::string& cf_name) override;
+
+    uint32_t Count() override { return batch_.GetWriteBatch()->Count(); }
+    uint64_t DataSize() override { return batch_.GetWriteBatch()->GetDataSize(); }
+
+    butil::Status Commit() override;
+    uint64_t CommittedSequence() override { return committed_sequence_; }
+
+    rocksdb::WriteBatchWithIndex* Inner() { return &batch_; }
+    rocksdb::WriteOptions GetWriteOptions() const {
+      rocksdb::WriteOptions write_options;
+      write_options.disableWAL = disable_wal_;
+      return write_options;
+    }
+
+   private:
+    RawRocksEngine* engine_;
+    std::shared_ptr<rocksdb::DB> db_;
+    bool disable_wal_;
+    rocksdb::WriteBatchWithIndex batch_;
+    uint64_t committed_sequence_ = 0;
   };
 
   class SstFileWriter {
@@ -271,6 +386,7 @@ class RawRocksEngine : public RawEngine {
   bool Init(std::shared_ptr<Config> config) override;
 
   std::string DbPath() { return db_path_; }
+  bool IsDataWalDisabled() const { return disable_data_wal_; }
 
   std::shared_ptr<Snapshot> GetSnapshot() override;
 
@@ -279,6 +395,7 @@ class RawRocksEngine : public RawEngine {
   butil::Status IngestExternalFile(const std::string& cf_name, const std::vector<std::string>& files);
 
   void Flush(const std::string& cf_name) override;
+  uint64_t GetFlushedSequence() override { return flushed_sequence_.load(); }
   void Close();
   void Destroy();
 
@@ -288,20 +405,43 @@ class RawRocksEngine : public RawEngine {
   std::shared_ptr<dingodb::Iterator> NewIterator(const std::string& cf_name, IteratorOptions options) override;
   std::shared_ptr<dingodb::Iterator> NewIterator(const std::string& cf_name, std::shared_ptr<Snapshot> snapshot,
                                                  IteratorOptions options);
+  std::shared_ptr<RawEngine::WriteBatch> NewWriteBatch() override;
+  std::shared_ptr<RowCache> GetRowCache(const std::string& cf_name) override;
   static std::shared_ptr<SstFileWriter> NewSstFileWriter();
   std::shared_ptr<Checkpoint> NewCheckpoint();
 
   std::shared_ptr<ColumnFamily> GetColumnFamily(const std::string& cf_name);
 
+  // Memory budget of the store, other rocksdb instances of the store share them.
+  std::shared_ptr<rocksdb::Cache> GetBlockCache() { return block_cache_; }
+  std::shared_ptr<rocksdb::WriteBufferManager> GetWriteBufferManager() { return write_buffer_manager_; }
+
   std::vector<uint64_t> GetApproximateSizes(const std::string& cf_name,
                                             std::vector<pb::common::Range>& ranges) override;
 
+  // Ranges of the regions on the store, data out of them is dropped by compaction of data column family.
+  void SetLiveRanges(const std::vector<pb::common::Range>& ranges);
+  // Compact the gaps between regions on the compactor thread, so the orphan data not touched by normal compaction
+  // is dropped too. The gap with little data is skipped, not rewrite the files across it every time.
+  void CompactOrphanRanges();
+
+  // Compact range synchronously, empty key means unbounded.
+  butil::Status CompactRange(const std::string& cf_name, const pb::common::Range& range);
+
  private:
   bool InitCfConfig(const std::vector<std::string>& column_family);
 
+  // Run on the compactor thread.
+  void DoCompactOrphanRanges();
+
+  // Create the shared block cache and write buffer manager from the store memory budget.
+  void InitMemoryBudget(std::shared_ptr<Config> config, const std::vector<std::string>& column_families);
+  void InitRowCache(std::shared_ptr<Config> config);
+
   // set cf config
   static bool SetCfConfiguration(const CfDefaultConf& default_conf,
                                  const std::map<std::string, std::string>& cf_configuration,
+                                 std::shared_ptr<rocksdb::Cache> block_cache,
                                  rocksdb::ColumnFamilyOptions* family_options);
 
   // set default column family if not exist. rocksdb not allow no default
@@ -326,6 +466,31 @@ class RawRocksEngine : public RawEngine {
   rocksdb::Options db_options_;
   std::shared_ptr<rocksdb::DB> db_;
   std::map<std::string, std::shared_ptr<ColumnFamily>> column_families_;
+  // Apply write batch without wal, column families are flushed atomically.
+  bool disable_data_wal_;
+  // Updated by flush listener when data wal is disabled.
+  std::atomic<uint64_t> flushed_sequence_{0};
+
+  // Shared by all column families, the memtables are charged to it by write_buffer_manager_.
+  std::shared_ptr<rocksdb::Cache> block_cache_;
+  // Column families with block_cache_ratio have their own cache, carved out of the budget.
+  std::map<std::string, std::shared_ptr<rocksdb::Cache>> cf_block_caches_;
+  std::shared_ptr<rocksdb::WriteBufferManager> write_buffer_manager_;
+  // Hot rows of data column family, nullptr when disabled.
+  std::shared_ptr<RowCache> row_cache_;
+
+  // nullptr when drop orphan data is disabled.
+  std::shared_ptr<OrphanFilterFactory> orphan_filter_factory_;
+
+  // Run the background manual compactions.
+  std::shared_ptr<Compactor> compactor_;
+
+  // Must be destroyed before the caches.
+  std::unique_ptr<bvar::PassiveStatus<int64_t>> block_cache_capacity_metrics_;
+  std::unique_ptr<bvar::PassiveStatus<int64_t>> block_cache_usage_metrics_;
+  std::unique_ptr<bvar::PassiveStatus<int64_t>> block_cache_pinned_usage_metrics_;
+  std::unique_ptr<bvar::PassiveStatus<int64_t>> write_buffer_usage_metrics_;
+  std::unique_ptr<bvar::PassiveStatus<int64_t>> row_cache_usage_metrics_;
 };
 
 }  // namespace dingodb
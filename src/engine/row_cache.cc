@@ -0,0 +1,164 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "engine/row_cache.h"
+
+#include <functional>
+#include <iterator>
+
+#include "butil/scoped_lock.h"
+
+namespace dingodb {
+
+// Approximate memory of list node and hash node.
+static const size_t kEntryOverhead = 64;
+
+RowCache::RowCache(size_t capacity, int shard_bits) : capacity_(capacity) {
+  if (shard_bits < 0 || shard_bits > 16) {
+    shard_bits = kDefaultShardBits;
+  }
+  size_t shard_num = static_cast<size_t>(1) << shard_bits;
+  shard_mask_ = shard_num - 1;
+  shards_.reserve(shard_num);
+  for (size_t i = 0; i < shard_num; ++i) {
+    auto shard = std::make_unique<Shard>();
+    shard->capacity = (capacity + shard_num - 1) / shard_num;
+    shards_.push_back(std::move(shard));
+  }
+}
+
+RowCache::~RowCache() = default;
+
+size_t RowCache::Charge(const std::string& key, const std::string& value) {
+  return key.size() + value.size() + kEntryOverhead;
+}
+
+RowCache::Shard& RowCache::GetShard(const std::string& key) {
+  return *shards_[std::hash<std::string>()(key) & shard_mask_];
+}
+
+void RowCache::Insert(Shard& shard, const std::string& key, const std::string& value) {
+  auto it = shard.index.find(key);
+  if (it != shard.index.end()) {
+    Remove(shard, it->second);
+  }
+
+  size_t charge = Charge(key, value);
+  if (charge > shard.capacity) {
+    return;
+  }
+  while (shard.usage + charge > shard.capacity && !shard.lru.empty()) {
+    Remove(shard, std::prev(shard.lru.end()));
+  }
+
+  shard.lru.push_front(Entry{key, value});
+  shard.index.emplace(shard.lru.front().key, shard.lru.begin());
+  shard.usage += charge;
+}
+
+void RowCache::Remove(Shard& shard, std::list<Entry>::iterator it) {
+  shard.usage -= Charge(it->key, it->value);
+  shard.index.erase(it->key);
+  shard.lru.erase(it);
+}
+
+bool RowCache::Lookup(const std::string& key, std::string& value) {
+  auto& shard = GetShard(key);
+  BAIDU_SCOPED_LOCK(shard.mutex);
+  auto it = shard.index.find(key);
+  if (it == shard.index.end()) {
+    return false;
+  }
+  shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+  value = it->second->value;
+  return true;
+}
+
+uint64_t RowCache::Version(const std::string& key) {
+  auto& shard = GetShard(key);
+  BAIDU_SCOPED_LOCK(shard.mutex);
+  return shard.version;
+}
+
+void RowCache::Fill(const std::string& key, const std::string& value, uint64_t version) {
+  auto& shard = GetShard(key);
+  BAIDU_SCOPED_LOCK(shard.mutex);
+  if (shard.version != version) {
+    return;
+  }
+  Insert(shard, key, value);
+}
+
+void RowCache::Update(const std::string& key, const std::string& value) {
+  auto& shard = GetShard(key);
+  BAIDU_SCOPED_LOCK(shard.mutex);
+  ++shard.version;
+  auto it = shard.index.find(key);
+  if (it != shard.index.end()) {
+    Insert(shard, key, value);
+  }
+}
+
+void RowCache::Erase(const std::string& key) {
+  auto& shard = GetShard(key);
+  BAIDU_SCOPED_LOCK(shard.mutex);
+  ++shard.version;
+  auto it = shard.index.find(key);
+  if (it != shard.index.end()) {
+    Remove(shard, it->second);
+  }
+}
+
+void RowCache::EraseRange(const std::string& start_key, const std::string& end_key) {
+  for (auto& shard : shards_) {
+    BAIDU_SCOPED_LOCK(shard->mutex);
+    ++shard->version;
+    for (auto it = shard->lru.begin(); it != shard->lru.end();) {
+      auto cur = it++;
+      if (cur->key >= start_key && (end_key.empty() || cur->key < end_key)) {
+        Remove(*shard, cur);
+      }
+    }
+  }
+}
+
+void RowCache::Clear() {
+  for (auto& shard : shards_) {
+    BAIDU_SCOPED_LOCK(shard->mutex);
+    ++shard->version;
+    shard->index.clear();
+    shard->lru.clear();
+    shard->usage = 0;
+  }
+}
+
+size_t RowCache::Usage() {
+  size_t usage = 0;
+  for (auto& shard : shards_) {
+    BAIDU_SCOPED_LOCK(shard->mutex);
+    usage += shard->usage;
+  }
+  return usage;
+}
+
+size_t RowCache::Size() {
+  size_t size = 0;
+  for (auto& shard : shards_) {
+    BAIDU_SCOPED_LOCK(shard->mutex);
+    size += shard->lru.size();
+  }
+  return size;
+}
+
+}  // namespace dingodb
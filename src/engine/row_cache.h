@@ -0,0 +1,97 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DINGODB_ENGINE_ROW_CACHE_H_
+#define DINGODB_ENGINE_ROW_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "bthread/mutex.h"
+
+namespace dingodb {
+
+// Sharded LRU cache of hot rows in front of engine point reads, bounded by bytes.
+// Reads fill it, raft apply update or erase it after writing the engine, so a hit is never older than the applied
+// index. A fill is dropped if the shard was mutated since Version() was taken, this keeps a slow reader from
+// putting back a value which was overwritten meanwhile.
+class RowCache {
+ public:
+  static const int kDefaultShardBits = 6;
+
+  explicit RowCache(size_t capacity, int shard_bits = kDefaultShardBits);
+  ~RowCache();
+
+  RowCache(const RowCache&) = delete;
+  const RowCache& operator=(const RowCache&) = delete;
+
+  bool Lookup(const std::string& key, std::string& value);
+
+  // Take before reading the engine, pass to Fill.
+  uint64_t Version(const std::string& key);
+  void Fill(const std::string& key, const std::string& value, uint64_t version);
+
+  // Apply the write to a cached key, cold keys are not admitted.
+  void Update(const std::string& key, const std::string& value);
+  void Erase(const std::string& key);
+  // Erase keys in [start_key, end_key), empty end_key means no upper bound.
+  void EraseRange(const std::string& start_key, const std::string& end_key);
+  void Clear();
+
+  size_t Capacity() const { return capacity_; }
+  size_t Usage();
+  size_t Size();
+
+ private:
+  struct Entry {
+    std::string key;
+    std::string value;
+  };
+
+  struct Shard {
+    Shard() { bthread_mutex_init(&mutex, nullptr); }
+    ~Shard() { bthread_mutex_destroy(&mutex); }
+
+    bthread_mutex_t mutex;
+    // Front is the most recently used.
+    std::list<Entry> lru;
+    // Key view point to the entry in lru.
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> index;
+    size_t capacity = 0;
+    size_t usage = 0;
+    // Increase on every mutation.
+    uint64_t version = 0;
+  };
+
+  static size_t Charge(const std::string& key, const std::string& value);
+
+  Shard& GetShard(const std::string& key);
+  // Caller must hold the shard mutex.
+  static void Insert(Shard& shard, const std::string& key, const std::string& value);
+  static void Remove(Shard& shard, std::list<Entry>::iterator it);
+
+  size_t capacity_;
+  uint32_t shard_mask_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+}  // namespace dingodb
+
+#endif  // DINGODB_ENGINE_ROW_CACHE_H_
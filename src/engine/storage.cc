@@ -16,18 +16,24 @@
 
 #include <vector>
 
+#include "brpc/channel.h"
+#include "brpc/controller.h"
 #include "common/constant.h"
 #include "common/helper.h"
 #include "common/logging.h"
 #include "engine/write_data.h"
 #include "fmt/core.h"
+#include "metrics/store_bvar_metrics.h"
 #include "proto/common.pb.h"
 #include "proto/error.pb.h"
+#include "proto/store.pb.h"
 #include "scan/scan.h"
 #include "scan/scan_manager.h"
+#include "server/server.h"
+
 namespace dingodb {
 
-Storage::Storage(std::shared_ptr<Engine> engine) : engine_(engine) {}
+Storage::Storage(std::shared_ptr<Engine> engine) : engine_(engine) { leader_channels_.Init(64); }
 
 Storage::~Storage() = default;
 
@@ -43,39 +49,165 @@ butil::Status Storage::ValidateLeader(uint64_t region_id) {
       return butil::Status(pb::error::ERAFT_NOT_FOUND, "Not found raft node");
     }
 
-    if (!node->IsLeader()) {
-      return butil::Status(pb::error::ERAFT_NOTLEADER, node->GetLeaderId().to_string());
+    // Serve read on leader without raft round trip when the lease is valid, else by read index.
+    return node->ReadIndex();
+  }
+
+  return butil::Status();
+}
+
+butil::Status Storage::GetReadIndexFromLeader(uint64_t region_id, const braft::PeerId& leader_id,
+                                              uint64_t& read_index) {
+  // Leader id is raft endpoint, query its server endpoint.
+  butil::EndPoint server_endpoint = Helper::QueryServerEndpointByRaftEndpoint(
+      Server::GetInstance()->GetStoreMetaManager()->GetStoreServerMeta()->GetAllStore(), leader_id.addr);
+  if (server_endpoint.port == 0) {
+    return butil::Status(pb::error::ERAFT_NOTLEADER, "Not found leader server endpoint");
+  }
+
+  std::shared_ptr<brpc::Channel> channel;
+  if (leader_channels_.Get(server_endpoint, channel) < 0 || channel == nullptr) {
+    channel = std::make_shared<brpc::Channel>();
+    if (channel->Init(server_endpoint, nullptr) != 0) {
+      return butil::Status(pb::error::EINTERNAL,
+                           fmt::format("Init channel failed, {}", butil::endpoint2str(server_endpoint).c_str()));
     }
+    // Concurrent follower reads may create channels of the same leader, the last one is kept.
+    leader_channels_.Put(server_endpoint, channel);
+  }
+
+  pb::store::StoreService_Stub stub(channel.get());
+  brpc::Controller cntl;
+  cntl.set_timeout_ms(Constant::kFollowerReadTimeoutMs);
+
+  pb::store::ReadIndexRequest request;
+  pb::store::ReadIndexResponse response;
+  request.set_region_id(region_id);
+  stub.ReadIndex(&cntl, &request, &response, nullptr);
+  if (cntl.Failed()) {
+    return butil::Status(pb::error::ERAFT_READ_INDEX, cntl.ErrorText());
+  }
+  if (response.error().errcode() != pb::error::OK) {
+    return butil::Status(response.error().errcode(), response.error().errmsg());
+  }
+
+  read_index = response.read_index();
+  return butil::Status();
+}
+
+butil::Status Storage::ValidateFollowerRead(uint64_t region_id) {
+  if (engine_->GetID() != pb::common::ENG_RAFT_STORE) {
+    return butil::Status();
+  }
+
+  auto raft_kv_engine = std::dynamic_pointer_cast<RaftKvEngine>(engine_);
+  auto node = raft_kv_engine->GetNode(region_id);
+  if (node == nullptr) {
+    return butil::Status(pb::error::ERAFT_NOT_FOUND, "Not found raft node");
+  }
+
+  if (node->IsLeader()) {
+    return node->ReadIndex();
+  }
+  if (!node->HasLeader()) {
+    return butil::Status(pb::error::ERAFT_NOTLEADER, "No leader");
+  }
+
+  uint64_t read_index = 0;
+  uint64_t const start_time = Helper::TimestampMs();
+  auto status = GetReadIndexFromLeader(region_id, node->GetLeaderId(), read_index);
+  if (!status.ok()) {
+    return status;
   }
 
+  status = node->WaitApplied(read_index, Constant::kFollowerReadTimeoutMs);
+  if (!status.ok()) {
+    return status;
+  }
+
+  StoreBvarMetrics::GetInstance().IncFollowerReadCount(std::to_string(region_id));
+  StoreBvarMetrics::GetInstance().UpdateFollowerReadLatency(std::to_string(region_id),
+                                                            Helper::TimestampMs() - start_time);
+
   return butil::Status();
 }
 
+butil::Status Storage::ValidateStaleRead(uint64_t region_id, uint64_t max_staleness_ms) {
+  if (engine_->GetID() != pb::common::ENG_RAFT_STORE) {
+    return butil::Status();
+  }
+
+  auto raft_kv_engine = std::dynamic_pointer_cast<RaftKvEngine>(engine_);
+  auto node = raft_kv_engine->GetNode(region_id);
+  if (node == nullptr) {
+    return butil::Status(pb::error::ERAFT_NOT_FOUND, "Not found raft node");
+  }
+
+  // Same as the lease read of ReadIndex.
+  if (node->IsLeaderLeaseValid()) {
+    return node->WaitEarlyAcked();
+  }
+
+  // Applied timestamp is the leader propose time of the last applied log entry,
+  // a idle region has old timestamp, fall back to follower read.
+  int64_t const applied_timestamp = node->GetAppliedTimestamp();
+  int64_t const staleness_ms = static_cast<int64_t>(Helper::TimestampMs()) - applied_timestamp;
+  if (applied_timestamp > 0 && staleness_ms <= static_cast<int64_t>(max_staleness_ms)) {
+    StoreBvarMetrics::GetInstance().IncStaleReadCount(std::to_string(region_id));
+    return butil::Status();
+  }
+
+  return ValidateFollowerRead(region_id);
+}
+
+butil::Status Storage::ValidateRead(std::shared_ptr<Context> ctx) {
+  if (ctx->MaxStalenessMs() > 0) {
+    return ValidateStaleRead(ctx->RegionId(), ctx->MaxStalenessMs());
+  }
+
+  return ctx->FollowerRead() ? ValidateFollowerRead(ctx->RegionId()) : ValidateLeader(ctx->RegionId());
+}
+
+butil::Status Storage::ReadIndex(std::shared_ptr<Context> ctx, uint64_t& read_index) {
+  if (engine_->GetID() != pb::common::ENG_RAFT_STORE) {
+    return butil::Status(pb::error::ENOT_SUPPORT, "Not support read index");
+  }
+
+  auto raft_kv_engine = std::dynamic_pointer_cast<RaftKvEngine>(engine_);
+  auto node = raft_kv_engine->GetNode(ctx->RegionId());
+  if (node == nullptr) {
+    return butil::Status(pb::error::ERAFT_NOT_FOUND, "Not found raft node");
+  }
+
+  return node->GetReadIndex(read_index);
+}
+
 butil::Status Storage::KvGet(std::shared_ptr<Context> ctx, const std::vector<std::string>& keys,
                              std::vector<pb::common::KeyValue>& kvs) {
-  auto status = ValidateLeader(ctx->RegionId());
+  auto status = ValidateRead(ctx);
   if (!status.ok()) {
     return status;
   }
   auto reader = engine_->NewReader(Constant::kStoreDataCF);
-  for (const auto& key : keys) {
+  if (keys.size() == 1) {
     std::string value;
-    auto status = reader->KvGet(ctx, key, value);
+    status = reader->KvGet(ctx, keys[0], value);
     if (!status.ok()) {
       if (pb::error::EKEY_NOT_FOUND == status.error_code()) {
-        continue;
+        return butil::Status();
       }
-      kvs.clear();
       return status;
     }
 
     pb::common::KeyValue kv;
-    kv.set_key(key);
-    kv.set_value(value);
-    kvs.emplace_back(kv);
+    kv.set_key(keys[0]);
+    kv.set_value(std::move(value));
+    kvs.emplace_back(std::move(kv));
+    return butil::Status();
   }
 
-  return butil::Status();
+  // Batch lookup all keys under one snapshot.
+  return reader->KvBatchGet(ctx, keys, kvs);
 }
 
 butil::Status Storage::KvPut(std::shared_ptr<Context> ctx, const std::vector<pb::common::KeyValue>& kvs) {
@@ -139,6 +271,7 @@ butil::Status Storage::KvDeleteRange(std::shared_ptr<Context> ctx, const pb::com
   std::shared_ptr<DeleteRangeDatum> datum = std::make_shared<DeleteRangeDatum>();
   datum->cf_name = ctx->CfName();
   datum->ranges.emplace_back(std::move(const_cast<pb::common::Range&>(range)));
+  datum->delete_files_in_range = ctx->DeleteFilesInRange();
   write_data.AddDatums(std::static_pointer_cast<DatumAble>(datum));
 
   return engine_->AsyncWrite(ctx, write_data, [](std::shared_ptr<Context> ctx, butil::Status status) {
@@ -177,7 +310,7 @@ butil::Status Storage::KvScanBegin(std::shared_ptr<Context> ctx, const std::stri
                                    bool disable_auto_release, bool disable_coprocessor,
                                    const pb::store::Coprocessor& coprocessor, std::string* scan_id,
                                    std::vector<pb::common::KeyValue>* kvs) {
-  auto status = ValidateLeader(ctx->RegionId());
+  auto status = ValidateRead(ctx);
   if (!status.ok()) {
     return status;
   }
@@ -19,7 +19,9 @@
 #include <string>
 #include <vector>
 
+#include "brpc/channel.h"
 #include "common/context.h"
+#include "common/safe_map.h"
 #include "engine/engine.h"
 #include "engine/raft_kv_engine.h"
 #include "memory"
@@ -36,6 +38,9 @@ class Storage {
   Snapshot* GetSnapshot();
   void ReleaseSnapshot();
 
+  // Leader committed index for follower read.
+  butil::Status ReadIndex(std::shared_ptr<Context> ctx, uint64_t& read_index);
+
   butil::Status KvGet(std::shared_ptr<Context> ctx, const std::vector<std::string>& keys,
                       std::vector<pb::common::KeyValue>& kvs);
 
@@ -64,8 +69,18 @@ class Storage {
 
  private:
   butil::Status ValidateLeader(uint64_t region_id);
+  // Follower get read index from leader, and wait applied index catch up it.
+  butil::Status ValidateFollowerRead(uint64_t region_id);
+  // Any replica serve read if its applied data is fresher than max_staleness_ms,
+  // else fall back to follower read.
+  butil::Status ValidateStaleRead(uint64_t region_id, uint64_t max_staleness_ms);
+  butil::Status ValidateRead(std::shared_ptr<Context> ctx);
+  // Get read index from the region leader by rpc.
+  butil::Status GetReadIndexFromLeader(uint64_t region_id, const braft::PeerId& leader_id, uint64_t& read_index);
 
   std::shared_ptr<Engine> engine_;
+  // Channel of leader server endpoint, reused by follower reads.
+  DingoSafeMap<butil::EndPoint, std::shared_ptr<brpc::Channel>> leader_channels_;
 };
 
 }  // namespace dingodb
@@ -152,6 +152,7 @@ struct DeleteRangeDatum : public DatumAble {
     request->set_cmd_type(pb::raft::CmdType::DELETERANGE);
     pb::raft::DeleteRangeRequest* delete_range_request = request->mutable_delete_range();
     delete_range_request->set_cf_name(cf_name);
+    delete_range_request->set_delete_files_in_range(delete_files_in_range);
 
     for (const auto& range : ranges) {
       delete_range_request->add_ranges()->CopyFrom(range);
@@ -164,6 +165,7 @@ struct DeleteRangeDatum : public DatumAble {
 
   std::string cf_name;
   std::vector<pb::common::Range> ranges;
+  bool delete_files_in_range = false;
 };
 
 struct CreateSchemaDatum : public DatumAble {
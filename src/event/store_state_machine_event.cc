@@ -35,8 +35,10 @@ void SmApplyEventListener::OnEvent(std::shared_ptr<Event> event) {
 
   // Dispatch
   auto* done = dynamic_cast<StoreClosure*>(the_event->done);
-  auto ctx = done ? done->GetCtx() : nullptr;
+  int request_index = 0;
   for (const auto& req : the_event->raft_cmd->requests()) {
+    auto ctx = done ? done->GetCtx(request_index) : nullptr;
+    ++request_index;
     auto handler = handler_collection_->GetHandler(static_cast<HandlerType>(req.cmd_type()));
     if (handler) {
       handler->Handle(ctx, the_event->region, the_event->engine, req, the_event->region_metrics);
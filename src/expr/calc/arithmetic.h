@@ -16,6 +16,7 @@
 #define DINGODB_EXPR_OPERATORS_ARITHMETIC_H_
 
 #include <string>
+#include <type_traits>
 
 #include "defs.h"
 
@@ -56,8 +57,16 @@ T CalcMul(T v0, T v1) {
 
 DECLARE_INVALID_BINARY_OP(CalcMul, std::string)
 
+// Divisor of integer must not be zero, see OperatorDiv.
 template <typename T>
 T CalcDiv(T v0, T v1) {
+  if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+    // Avoid overflow of min / -1.
+    if (v1 == -1) {
+      using U = std::make_unsigned_t<T>;
+      return static_cast<T>(U() - static_cast<U>(v0));
+    }
+  }
   return v0 / v1;
 }
 
@@ -65,6 +74,11 @@ DECLARE_INVALID_BINARY_OP(CalcDiv, std::string)
 
 template <typename T>
 T CalcMod(T v0, T v1) {
+  if constexpr (std::is_signed_v<T>) {
+    if (v1 == -1) {
+      return T();
+    }
+  }
   return v0 % v1;
 }
 
@@ -15,69 +15,235 @@
 #ifndef DINGODB_EXPR_OPERANDSTACK_H_
 #define DINGODB_EXPR_OPERANDSTACK_H_
 
-#include <stack>
+#include <any>
+#include <cstdint>
 #include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
 
 #include "calc/operand.h"
+#include "types.h"
 
 namespace dingodb::expr {
 
+// Type tag of the value in the stack, string_view is for TYPE_STRING and TYPE_DECIMAL.
+template <typename T>
+class StackTraits {};
+
+template <>
+class StackTraits<int32_t> {
+ public:
+  static constexpr byte type = TYPE_INT32;
+};
+
+template <>
+class StackTraits<int64_t> {
+ public:
+  static constexpr byte type = TYPE_INT64;
+};
+
+template <>
+class StackTraits<bool> {
+ public:
+  static constexpr byte type = TYPE_BOOL;
+};
+
+template <>
+class StackTraits<float> {
+ public:
+  static constexpr byte type = TYPE_FLOAT;
+};
+
+template <>
+class StackTraits<double> {
+ public:
+  static constexpr byte type = TYPE_DOUBLE;
+};
+
+template <>
+class StackTraits<std::string_view> {
+ public:
+  static constexpr byte type = TYPE_STRING;
+};
+
+// Tagged union, no allocation to push or pop.
+class StackValue {
+ public:
+  StackValue() : m_i64(0), m_type(TYPE_INT64), m_is_null(true) {}
+
+  byte Type() const { return m_type; }
+  bool IsNull() const { return m_is_null; }
+
+  template <typename T>
+  wrap<T> Get() const {
+    if (m_type != StackTraits<T>::type) {
+      throw std::bad_any_cast();
+    }
+    if (m_is_null) {
+      return wrap<T>();
+    }
+    return wrap<T>(Value<T>());
+  }
+
+  template <typename T>
+  void Set(T v) {
+    m_type = StackTraits<T>::type;
+    m_is_null = false;
+    Value<T>() = v;
+  }
+
+  template <typename T>
+  void Set() {
+    m_type = StackTraits<T>::type;
+    m_is_null = true;
+  }
+
+  Operand ToOperand() const;
+
+ private:
+  template <typename T>
+  T &Value();
+
+  template <typename T>
+  const T &Value() const {
+    return const_cast<StackValue *>(this)->Value<T>();
+  }
+
+  union {
+    int32_t m_i32;
+    int64_t m_i64;
+    bool m_bool;
+    float m_float;
+    double m_double;
+    std::string_view m_string;
+  };
+  byte m_type;
+  bool m_is_null;
+};
+
+template <>
+inline int32_t &StackValue::Value<int32_t>() {
+  return m_i32;
+}
+
+template <>
+inline int64_t &StackValue::Value<int64_t>() {
+  return m_i64;
+}
+
+template <>
+inline bool &StackValue::Value<bool>() {
+  return m_bool;
+}
+
+template <>
+inline float &StackValue::Value<float>() {
+  return m_float;
+}
+
+template <>
+inline double &StackValue::Value<double>() {
+  return m_double;
+}
+
+template <>
+inline std::string_view &StackValue::Value<std::string_view>() {
+  return m_string;
+}
+
+// Fixed size stack, the size is decided by the max depth of the expression.
 class OperandStack {
  public:
-  OperandStack() : m_stack(), m_tuple(nullptr) {}
+  OperandStack() : m_stack(), m_top(0), m_tuple(nullptr) {}
   virtual ~OperandStack() {}
 
-  Operand PopAny() {
-    auto v = m_stack.top();
-    m_stack.pop();
-    return v;
-  }
+  void Resize(size_t size) { m_stack.resize(size); }
+
+  void Reset() { m_top = 0; }
+
+  size_t Size() const { return m_top; }
+
+  Operand PopAny() { return m_stack[--m_top].ToOperand(); }
 
   template <typename T>
   wrap<T> Pop() {
-    return std::any_cast<wrap<T>>(PopAny());
+    return m_stack[--m_top].Get<T>();
   }
 
   template <typename T>
-  wrap<T> Get() {
-    return std::any_cast<wrap<T>>(m_stack.top());
+  wrap<T> Get() const {
+    return m_stack[m_top - 1].Get<T>();
   }
 
+  void Push(const StackValue &v) { m_stack[m_top++] = v; }
+
   template <typename T>
   void Push(T v) {
-    m_stack.push(Operand(wrap<T>(v)));
+    m_stack[m_top++].Set<T>(v);
   }
 
   template <typename T>
   void Push() {
-    m_stack.push(Operand(wrap<T>()));
+    m_stack[m_top++].Set<T>();
   }
 
   template <typename T>
   void Set(T v) {
-    m_stack.top().emplace<wrap<T>>(wrap<T>(v));
+    m_stack[m_top - 1].Set<T>(v);
   }
 
   template <typename T>
   void Set() {
-    m_stack.top().emplace<wrap<T>>(wrap<T>());
+    m_stack[m_top - 1].Set<T>();
   }
 
-  void BindTuple(const Tuple* tuple) { m_tuple = tuple; }
+  void BindTuple(const Tuple *tuple) { m_tuple = tuple; }
 
+  template <typename T>
   void PushTuple(uint32_t index) {
-    if (m_tuple != nullptr) {
-      m_stack.push((*m_tuple)[index]);
-    } else {
+    if (m_tuple == nullptr) {
       throw std::runtime_error("No tuple provided.");
     }
+    // Cast by pointer to avoid copy.
+    const auto *v = std::any_cast<wrap<T>>(&(*m_tuple)[index]);
+    if (v == nullptr) {
+      throw std::bad_any_cast();
+    }
+    if (v->has_value()) {
+      Push<T>(**v);
+    } else {
+      Push<T>();
+    }
   }
 
  private:
-  std::stack<Operand> m_stack;
-  const Tuple* m_tuple;
+  std::vector<StackValue> m_stack;
+  size_t m_top;
+  const Tuple *m_tuple;
 };
 
+inline Operand StackValue::ToOperand() const {
+  switch (m_type) {
+    case TYPE_INT32:
+      return Get<int32_t>();
+    case TYPE_INT64:
+      return Get<int64_t>();
+    case TYPE_BOOL:
+      return Get<bool>();
+    case TYPE_FLOAT:
+      return Get<float>();
+    case TYPE_DOUBLE:
+      return Get<double>();
+    case TYPE_STRING: {
+      auto v = Get<std::string_view>();
+      return v.has_value() ? wrap<std::string>(std::string(*v)) : wrap<std::string>();
+    }
+    default:
+      throw std::runtime_error("Unsupported type.");
+  }
+}
+
 }  // namespace dingodb::expr
 
 #endif  // DINGODB_EXPR_OPERANDSTACK_H_
@@ -15,7 +15,8 @@
 #ifndef DINGODB_EXPR_OPERATOR_H_
 #define DINGODB_EXPR_OPERATOR_H_
 
-#include <functional>
+#include <cstdint>
+#include <type_traits>
 
 #include "calc/arithmetic.h"
 #include "calc/relational.h"
@@ -24,38 +25,45 @@
 
 namespace dingodb::expr {
 
-typedef std::function<void(OperandStack &)> Operator;
+struct Operator;
 
+typedef void (*OperatorFunc)(OperandStack &, const Operator &);
+
+// Operators are called by function pointer, the operands of instruction are kept here.
+struct Operator {
+  OperatorFunc func;
+  // Tuple index of var.
+  uint32_t index;
+  // Value of const.
+  StackValue value;
+};
+
+// kDepth is the change of stack depth, Run is specialized at compile time for each type.
 template <typename T>
 class OperatorNull {
  public:
-  void operator()(OperandStack &stack) { stack.Push<T>(); }
+  static constexpr int kDepth = 1;
+  static void Run(OperandStack &stack, const Operator & /*op*/) { stack.Push<T>(); }
 };
 
-template <typename T>
 class OperatorConst {
  public:
-  OperatorConst(T value) : m_value(value) {}
-  void operator()(OperandStack &stack) { stack.Push(m_value); }
-
- private:
-  T m_value;
+  static constexpr int kDepth = 1;
+  static void Run(OperandStack &stack, const Operator &op) { stack.Push(op.value); }
 };
 
 template <typename T>
 class OperatorVarI {
  public:
-  OperatorVarI(uint32_t index) : m_index(index) {}
-  void operator()(OperandStack &stack) { stack.PushTuple(m_index); }
-
- private:
-  uint32_t m_index;
+  static constexpr int kDepth = 1;
+  static void Run(OperandStack &stack, const Operator &op) { stack.PushTuple<T>(op.index); }
 };
 
 template <typename T, typename R, R (*Calc)(T)>
 class UnaryOperator {
  public:
-  void operator()(OperandStack &stack) {
+  static constexpr int kDepth = 0;
+  static void Run(OperandStack &stack, const Operator & /*op*/) {
     auto v = stack.Get<T>();
     if (v.has_value()) {
       stack.Set<R>(Calc(*v));
@@ -68,7 +76,8 @@ class UnaryOperator {
 template <typename T, typename R, R (*Calc)(const wrap<T> &)>
 class UnarySpecialOperator {
  public:
-  void operator()(OperandStack &stack) {
+  static constexpr int kDepth = 0;
+  static void Run(OperandStack &stack, const Operator & /*op*/) {
     auto v = stack.Get<T>();
     stack.Set<R>(Calc(v));
   }
@@ -77,7 +86,8 @@ class UnarySpecialOperator {
 template <typename T, typename R, R (*Calc)(T, T)>
 class BinaryOperator {
  public:
-  void operator()(OperandStack &stack) {
+  static constexpr int kDepth = -1;
+  static void Run(OperandStack &stack, const Operator & /*op*/) {
     auto v1 = stack.Pop<T>();
     auto v0 = stack.Get<T>();
     if (v0.has_value() && v1.has_value()) {
@@ -88,6 +98,30 @@ class BinaryOperator {
   }
 };
 
+// Integer divide by zero is null, instead of crash, same as VectorRunner.
+template <typename T, T (*Calc)(T, T)>
+class DivModOperator {
+ public:
+  static constexpr int kDepth = -1;
+  static void Run(OperandStack &stack, const Operator & /*op*/) {
+    auto v1 = stack.Pop<T>();
+    auto v0 = stack.Get<T>();
+    if (v0.has_value() && v1.has_value() && !IsZeroDivisor(*v1)) {
+      stack.Set<T>(Calc(*v0, *v1));
+    } else {
+      stack.Set<T>();
+    }
+  }
+
+ private:
+  static bool IsZeroDivisor(T v) {
+    if constexpr (std::is_integral_v<T>) {
+      return v == 0;
+    }
+    return false;
+  }
+};
+
 template <typename T>
 using OperatorPos = UnaryOperator<T, T, CalcPos>;
 template <typename T>
@@ -99,9 +133,9 @@ using OperatorSub = BinaryOperator<T, T, CalcSub>;
 template <typename T>
 using OperatorMul = BinaryOperator<T, T, CalcMul>;
 template <typename T>
-using OperatorDiv = BinaryOperator<T, T, CalcDiv>;
+using OperatorDiv = DivModOperator<T, CalcDiv>;
 template <typename T>
-using OperatorMod = BinaryOperator<T, T, CalcMod>;
+using OperatorMod = DivModOperator<T, CalcMod>;
 
 template <typename T>
 using OperatorEq = BinaryOperator<T, bool, CalcEq>;
@@ -118,7 +152,8 @@ using OperatorNe = BinaryOperator<T, bool, CalcNe>;
 
 class OperatorNot {
  public:
-  void operator()(OperandStack &stack) {
+  static constexpr int kDepth = 0;
+  static void Run(OperandStack &stack, const Operator & /*op*/) {
     auto v = stack.Get<bool>();
     if (v.has_value()) {
       stack.Set<bool>(!*v);
@@ -130,7 +165,8 @@ class OperatorNot {
 
 class OperatorAnd {
  public:
-  void operator()(OperandStack &stack) {
+  static constexpr int kDepth = -1;
+  static void Run(OperandStack &stack, const Operator & /*op*/) {
     auto v1 = stack.Pop<bool>();
     auto v0 = stack.Get<bool>();
     if (v0.has_value()) {
@@ -151,7 +187,8 @@ class OperatorAnd {
 
 class OperatorOr {
  public:
-  void operator()(OperandStack &stack) {
+  static constexpr int kDepth = -1;
+  static void Run(OperandStack &stack, const Operator & /*op*/) {
     auto v1 = stack.Pop<bool>();
     auto v0 = stack.Get<bool>();
     if (v0.has_value()) {
@@ -173,7 +210,8 @@ class OperatorOr {
 template <typename D, typename T>
 class OperatorCast {
  public:
-  void operator()(OperandStack &stack) {
+  static constexpr int kDepth = 0;
+  static void Run(OperandStack &stack, const Operator & /*op*/) {
     auto v = stack.Get<T>();
     if (v.has_value()) {
       stack.Set<D>((D)(*v));
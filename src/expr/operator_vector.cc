@@ -14,107 +14,56 @@
 
 #include "operator_vector.h"
 
-#include "codec.h"
-
-#define NULL_PREFIX 0x00
-#define NULL_INT32 (NULL_PREFIX | TYPE_INT32)
-#define NULL_INT64 (NULL_PREFIX | TYPE_INT64)
-#define NULL_BOOL (NULL_PREFIX | TYPE_BOOL)
-#define NULL_FLOAT (NULL_PREFIX | TYPE_FLOAT)
-#define NULL_DOUBLE (NULL_PREFIX | TYPE_DOUBLE)
-#define NULL_DECIMAL (NULL_PREFIX | TYPE_DECIMAL)
-#define NULL_STRING (NULL_PREFIX | TYPE_STRING)
-
-#define CONST 0x10
-#define CONST_INT32 (CONST | TYPE_INT32)
-#define CONST_INT64 (CONST | TYPE_INT64)
-#define CONST_BOOL (CONST | TYPE_BOOL)
-#define CONST_FLOAT (CONST | TYPE_FLOAT)
-#define CONST_DOUBLE (CONST | TYPE_DOUBLE)
-#define CONST_DECIMAL (CONST | TYPE_DECIMAL)
-#define CONST_STRING (CONST | TYPE_STRING)
-
-#define CONST_N 0x20
-#define CONST_N_INT32 (CONST_N | TYPE_INT32)
-#define CONST_N_INT64 (CONST_N | TYPE_INT64)
-#define CONST_N_BOOL (CONST_N | TYPE_BOOL)
-
-#define VAR_I 0x30
-#define VAR_I_INT32 (VAR_I | TYPE_INT32)
-#define VAR_I_INT64 (VAR_I | TYPE_INT64)
-#define VAR_I_BOOL (VAR_I | TYPE_BOOL)
-#define VAR_I_FLOAT (VAR_I | TYPE_FLOAT)
-#define VAR_I_DOUBLE (VAR_I | TYPE_DOUBLE)
-#define VAR_I_DECIMAL (VAR_I | TYPE_DECIMAL)
-#define VAR_I_STRING (VAR_I | TYPE_STRING)
-
-#define POS 0x81
-#define NEG 0x82
-#define ADD 0x83
-#define SUB 0x84
-#define MUL 0x85
-#define DIV 0x86
-#define MOD 0x87
-
-#define EQ 0x91
-#define GE 0x92
-#define GT 0x93
-#define LE 0x94
-#define LT 0x95
-#define NE 0x96
-
-#define IS_NULL 0xA1
-#define IS_TRUE 0xA2
-#define IS_FALSE 0xA3
-
-#define NOT 0x51
-#define AND 0x52
-#define OR 0x53
+#include <stdexcept>
+#include <string_view>
 
-#define CAST 0xF0
+#include "codec.h"
+#include "instruction.h"
 
 using namespace dingodb::expr;
 
 void OperatorVector::Decode(const byte code[], size_t len) {
   m_vector.clear();
+  m_depth = 0;
+  m_max_depth = 0;
   for (const byte *p = code; p < code + len; ++p) {
     switch (*p) {
       case NULL_INT32:
-        Add(OperatorNull<CxxTraits<TYPE_INT32>::type>());
+        Add<OperatorNull<CxxTraits<TYPE_INT32>::type>>();
         break;
       case NULL_INT64:
-        Add(OperatorNull<CxxTraits<TYPE_INT64>::type>());
+        Add<OperatorNull<CxxTraits<TYPE_INT64>::type>>();
         break;
       case NULL_BOOL:
-        Add(OperatorNull<CxxTraits<TYPE_BOOL>::type>());
+        Add<OperatorNull<CxxTraits<TYPE_BOOL>::type>>();
         break;
       case NULL_FLOAT:
-        Add(OperatorNull<CxxTraits<TYPE_FLOAT>::type>());
+        Add<OperatorNull<CxxTraits<TYPE_FLOAT>::type>>();
         break;
       case NULL_DOUBLE:
-        Add(OperatorNull<CxxTraits<TYPE_DOUBLE>::type>());
+        Add<OperatorNull<CxxTraits<TYPE_DOUBLE>::type>>();
         break;
       case CONST_INT32: {
         CxxTraits<TYPE_INT32>::type v;
         p = DecodeVarint(v, ++p);
-        Add(OperatorConst<CxxTraits<TYPE_INT32>::type>(v));
+        AddConst<CxxTraits<TYPE_INT32>::type>(v);
         break;
       }
       case CONST_INT64: {
         CxxTraits<TYPE_INT64>::type v;
         p = DecodeVarint(v, ++p);
-        Add(OperatorConst<CxxTraits<TYPE_INT64>::type>(v));
+        AddConst<CxxTraits<TYPE_INT64>::type>(v);
         break;
       }
       case CONST_BOOL:
-        Add(OperatorConst<CxxTraits<TYPE_BOOL>::type>(true));
+        AddConst<CxxTraits<TYPE_BOOL>::type>(true);
         break;
       case CONST_FLOAT:
-        Add(OperatorConst<CxxTraits<TYPE_FLOAT>::type>(DecodeFloat(++p)));
+        AddConst<CxxTraits<TYPE_FLOAT>::type>(DecodeFloat(++p));
         p += 3;
         break;
       case CONST_DOUBLE:
-        Add(OperatorConst<CxxTraits<TYPE_DOUBLE>::type>(DecodeDouble(++p)));
+        AddConst<CxxTraits<TYPE_DOUBLE>::type>(DecodeDouble(++p));
         p += 7;
         break;
       case CONST_DECIMAL:
@@ -126,89 +75,89 @@ void OperatorVector::Decode(const byte code[], size_t len) {
       case CONST_N_INT32: {
         CxxTraits<TYPE_INT32>::type v;
         p = DecodeVarint(v, ++p);
-        Add(OperatorConst<CxxTraits<TYPE_INT32>::type>(-v));
+        AddConst<CxxTraits<TYPE_INT32>::type>(-v);
         break;
       }
       case CONST_N_INT64: {
         CxxTraits<TYPE_INT64>::type v;
         p = DecodeVarint(v, ++p);
-        Add(OperatorConst<CxxTraits<TYPE_INT64>::type>(-v));
+        AddConst<CxxTraits<TYPE_INT64>::type>(-v);
         break;
       }
       case CONST_N_BOOL:
-        Add(OperatorConst<CxxTraits<TYPE_BOOL>::type>(false));
+        AddConst<CxxTraits<TYPE_BOOL>::type>(false);
         break;
       case VAR_I_INT32: {
         uint32_t v;
         p = DecodeVarint(v, ++p);
-        Add(OperatorVarI<CxxTraits<TYPE_INT32>::type>(v));
+        Add<OperatorVarI<CxxTraits<TYPE_INT32>::type>>(v);
         break;
       }
       case VAR_I_INT64: {
         uint32_t v;
         p = DecodeVarint(v, ++p);
-        Add(OperatorVarI<CxxTraits<TYPE_INT64>::type>(v));
+        Add<OperatorVarI<CxxTraits<TYPE_INT64>::type>>(v);
         break;
       }
       case VAR_I_BOOL: {
         uint32_t v;
         p = DecodeVarint(v, ++p);
-        Add(OperatorVarI<CxxTraits<TYPE_BOOL>::type>(v));
+        Add<OperatorVarI<CxxTraits<TYPE_BOOL>::type>>(v);
         break;
       }
       case VAR_I_FLOAT: {
         uint32_t v;
         p = DecodeVarint(v, ++p);
-        Add(OperatorVarI<CxxTraits<TYPE_FLOAT>::type>(v));
+        Add<OperatorVarI<CxxTraits<TYPE_FLOAT>::type>>(v);
         break;
       }
       case VAR_I_DOUBLE: {
         uint32_t v;
         p = DecodeVarint(v, ++p);
-        Add(OperatorVarI<CxxTraits<TYPE_DOUBLE>::type>(v));
+        Add<OperatorVarI<CxxTraits<TYPE_DOUBLE>::type>>(v);
         break;
       }
       case VAR_I_DECIMAL: {
         uint32_t v;
         p = DecodeVarint(v, ++p);
         // TODO
-        // Add(OperatorVarI<CxxTraits<TYPE_DECIMAL>::type>(v));
+        // Add<OperatorVarI<CxxTraits<TYPE_DECIMAL>::type>>(v);
         break;
       }
       case VAR_I_STRING: {
         uint32_t v;
         p = DecodeVarint(v, ++p);
         // TODO
-        // Add(OperatorVarI<CxxTraits<TYPE_STRING>::type>(v));
+        // Add<OperatorVarI<CxxTraits<TYPE_STRING>::type>>(v);
         break;
       }
       case POS:
         ++p;
-        AddOperatorByType<OperatorPos>(*p);
+        AddArithmeticOperatorByType<OperatorPos>(*p);
         break;
       case NEG:
         ++p;
-        AddOperatorByType<OperatorNeg>(*p);
+        AddArithmeticOperatorByType<OperatorNeg>(*p);
         break;
       case ADD:
         ++p;
-        AddOperatorByType<OperatorAdd>(*p);
+        AddArithmeticOperatorByType<OperatorAdd>(*p);
         break;
       case SUB:
         ++p;
-        AddOperatorByType<OperatorSub>(*p);
+        AddArithmeticOperatorByType<OperatorSub>(*p);
         break;
       case MUL:
         ++p;
-        AddOperatorByType<OperatorMul>(*p);
+        AddArithmeticOperatorByType<OperatorMul>(*p);
         break;
       case DIV:
         ++p;
-        AddOperatorByType<OperatorDiv>(*p);
+        AddArithmeticOperatorByType<OperatorDiv>(*p);
         break;
       case MOD:
         ++p;
-        AddOperatorByType<OperatorMod>(*p);
+        AddArithmeticOperatorByType<OperatorMod>(*p);
         break;
       case EQ:
         ++p;
@@ -247,13 +196,13 @@ void OperatorVector::Decode(const byte code[], size_t len) {
         AddOperatorByType<OperatorIsFalse>(*p);
         break;
       case NOT:
-        Add(OperatorNot());
+        Add<OperatorNot>();
         break;
       case AND:
-        Add(OperatorAnd());
+        Add<OperatorAnd>();
         break;
       case OR:
-        Add(OperatorOr());
+        Add<OperatorOr>();
         break;
       case CAST:
         ++p;
@@ -265,29 +214,70 @@ void OperatorVector::Decode(const byte code[], size_t len) {
   }
 }
 
+template <typename OP>
+void OperatorVector::Add(uint32_t index, const StackValue &value) {
+  m_depth += OP::kDepth;
+  if (m_depth <= 0) {
+    throw std::runtime_error("Stack underflow.");
+  }
+  if (static_cast<size_t>(m_depth) > m_max_depth) {
+    m_max_depth = m_depth;
+  }
+  m_vector.push_back(Operator{OP::Run, index, value});
+}
+
+template <typename T>
+void OperatorVector::AddConst(T v) {
+  StackValue value;
+  value.Set<T>(v);
+  Add<OperatorConst>(0, value);
+}
+
 template <template <typename> class OP>
 void OperatorVector::AddOperatorByType(byte type) {
   switch (type) {
     case TYPE_INT32:
-      Add(OP<CxxTraits<TYPE_INT32>::type>());
+      Add<OP<CxxTraits<TYPE_INT32>::type>>();
       break;
     case TYPE_INT64:
-      Add(OP<CxxTraits<TYPE_INT64>::type>());
+      Add<OP<CxxTraits<TYPE_INT64>::type>>();
       break;
     case TYPE_BOOL:
-      Add(OP<CxxTraits<TYPE_BOOL>::type>());
+      Add<OP<CxxTraits<TYPE_BOOL>::type>>();
       break;
     case TYPE_FLOAT:
-      Add(OP<CxxTraits<TYPE_FLOAT>::type>());
+      Add<OP<CxxTraits<TYPE_FLOAT>::type>>();
       break;
     case TYPE_DOUBLE:
-      Add(OP<CxxTraits<TYPE_DOUBLE>::type>());
+      Add<OP<CxxTraits<TYPE_DOUBLE>::type>>();
       break;
     case TYPE_DECIMAL:
-      Add(OP<CxxTraits<TYPE_DECIMAL>::type>());
-      break;
     case TYPE_STRING:
-      Add(OP<CxxTraits<TYPE_STRING>::type>());
+      // Strings are referenced in stack, not copied.
+      Add<OP<std::string_view>>();
+      break;
+    default:
+      throw std::runtime_error("Unsupported type.");
+  }
+}
+
+template <template <typename> class OP>
+void OperatorVector::AddArithmeticOperatorByType(byte type) {
+  switch (type) {
+    case TYPE_INT32:
+      Add<OP<CxxTraits<TYPE_INT32>::type>>();
+      break;
+    case TYPE_INT64:
+      Add<OP<CxxTraits<TYPE_INT64>::type>>();
+      break;
+    case TYPE_BOOL:
+      Add<OP<CxxTraits<TYPE_BOOL>::type>>();
+      break;
+    case TYPE_FLOAT:
+      Add<OP<CxxTraits<TYPE_FLOAT>::type>>();
+      break;
+    case TYPE_DOUBLE:
+      Add<OP<CxxTraits<TYPE_DOUBLE>::type>>();
       break;
     default:
       throw std::runtime_error("Unsupported type.");
@@ -297,64 +287,64 @@ void OperatorVector::AddOperatorByType(byte type) {
 void OperatorVector::AddCastOperator(byte b) {
   switch (b) {
     case (TYPE_INT32 << 4) | TYPE_INT64:
-      Add(OperatorCast<CxxTraits<TYPE_INT32>::type, CxxTraits<TYPE_INT64>::type>());
+      Add<OperatorCast<CxxTraits<TYPE_INT32>::type, CxxTraits<TYPE_INT64>::type>>();
       break;
     case (TYPE_INT32 << 4) | TYPE_BOOL:
-      Add(OperatorCast<CxxTraits<TYPE_INT32>::type, CxxTraits<TYPE_BOOL>::type>());
+      Add<OperatorCast<CxxTraits<TYPE_INT32>::type, CxxTraits<TYPE_BOOL>::type>>();
       break;
     case (TYPE_INT32 << 4) | TYPE_FLOAT:
-      Add(OperatorCast<CxxTraits<TYPE_INT32>::type, CxxTraits<TYPE_FLOAT>::type>());
+      Add<OperatorCast<CxxTraits<TYPE_INT32>::type, CxxTraits<TYPE_FLOAT>::type>>();
       break;
     case (TYPE_INT32 << 4) | TYPE_DOUBLE:
-      Add(OperatorCast<CxxTraits<TYPE_INT32>::type, CxxTraits<TYPE_DOUBLE>::type>());
+      Add<OperatorCast<CxxTraits<TYPE_INT32>::type, CxxTraits<TYPE_DOUBLE>::type>>();
       break;
     case (TYPE_INT64 << 4) | TYPE_INT32:
-      Add(OperatorCast<CxxTraits<TYPE_INT64>::type, CxxTraits<TYPE_INT32>::type>());
+      Add<OperatorCast<CxxTraits<TYPE_INT64>::type, CxxTraits<TYPE_INT32>::type>>();
       break;
     case (TYPE_INT64 << 4) | TYPE_BOOL:
-      Add(OperatorCast<CxxTraits<TYPE_INT64>::type, CxxTraits<TYPE_BOOL>::type>());
+      Add<OperatorCast<CxxTraits<TYPE_INT64>::type, CxxTraits<TYPE_BOOL>::type>>();
       break;
     case (TYPE_INT64 << 4) | TYPE_FLOAT:
-      Add(OperatorCast<CxxTraits<TYPE_INT64>::type, CxxTraits<TYPE_FLOAT>::type>());
+      Add<OperatorCast<CxxTraits<TYPE_INT64>::type, CxxTraits<TYPE_FLOAT>::type>>();
       break;
     case (TYPE_INT64 << 4) | TYPE_DOUBLE:
-      Add(OperatorCast<CxxTraits<TYPE_INT64>::type, CxxTraits<TYPE_DOUBLE>::type>());
+      Add<OperatorCast<CxxTraits<TYPE_INT64>::type, CxxTraits<TYPE_DOUBLE>::type>>();
       break;
     case (TYPE_BOOL << 4) | TYPE_INT32:
-      Add(OperatorCast<CxxTraits<TYPE_BOOL>::type, CxxTraits<TYPE_INT32>::type>());
+      Add<OperatorCast<CxxTraits<TYPE_BOOL>::type, CxxTraits<TYPE_INT32>::type>>();
       break;
     case (TYPE_BOOL << 4) | TYPE_INT64:
-      Add(OperatorCast<CxxTraits<TYPE_BOOL>::type, CxxTraits<TYPE_INT64>::type>());
+      Add<OperatorCast<CxxTraits<TYPE_BOOL>::type, CxxTraits<TYPE_INT64>::type>>();
       break;
     case (TYPE_BOOL << 4) | TYPE_FLOAT:
-      Add(OperatorCast<CxxTraits<TYPE_BOOL>::type, CxxTraits<TYPE_FLOAT>::type>());
+      Add<OperatorCast<CxxTraits<TYPE_BOOL>::type, CxxTraits<TYPE_FLOAT>::type>>();
       break;
     case (TYPE_BOOL << 4) | TYPE_DOUBLE:
-      Add(OperatorCast<CxxTraits<TYPE_BOOL>::type, CxxTraits<TYPE_DOUBLE>::type>());
+      Add<OperatorCast<CxxTraits<TYPE_BOOL>::type, CxxTraits<TYPE_DOUBLE>::type>>();
       break;
     case (TYPE_FLOAT << 4) | TYPE_INT32:
-      Add(OperatorCast<CxxTraits<TYPE_FLOAT>::type, CxxTraits<TYPE_INT32>::type>());
+      Add<OperatorCast<CxxTraits<TYPE_FLOAT>::type, CxxTraits<TYPE_INT32>::type>>();
       break;
     case (TYPE_FLOAT << 4) | TYPE_INT64:
-      Add(OperatorCast<CxxTraits<TYPE_FLOAT>::type, CxxTraits<TYPE_INT64>::type>());
+      Add<OperatorCast<CxxTraits<TYPE_FLOAT>::type, CxxTraits<TYPE_INT64>::type>>();
       break;
     case (TYPE_FLOAT << 4) | TYPE_BOOL:
-      Add(OperatorCast<CxxTraits<TYPE_FLOAT>::type, CxxTraits<TYPE_BOOL>::type>());
+      Add<OperatorCast<CxxTraits<TYPE_FLOAT>::type, CxxTraits<TYPE_BOOL>::type>>();
       break;
     case (TYPE_FLOAT << 4) | TYPE_DOUBLE:
-      Add(OperatorCast<CxxTraits<TYPE_FLOAT>::type, CxxTraits<TYPE_DOUBLE>::type>());
+      Add<OperatorCast<CxxTraits<TYPE_FLOAT>::type, CxxTraits<TYPE_DOUBLE>::type>>();
       break;
     case (TYPE_DOUBLE << 4) | TYPE_INT32:
-      Add(OperatorCast<CxxTraits<TYPE_DOUBLE>::type, CxxTraits<TYPE_INT32>::type>());
+      Add<OperatorCast<CxxTraits<TYPE_DOUBLE>::type, CxxTraits<TYPE_INT32>::type>>();
       break;
     case (TYPE_DOUBLE << 4) | TYPE_INT64:
-      Add(OperatorCast<CxxTraits<TYPE_DOUBLE>::type, CxxTraits<TYPE_INT64>::type>());
+      Add<OperatorCast<CxxTraits<TYPE_DOUBLE>::type, CxxTraits<TYPE_INT64>::type>>();
       break;
     case (TYPE_DOUBLE << 4) | TYPE_BOOL:
-      Add(OperatorCast<CxxTraits<TYPE_DOUBLE>::type, CxxTraits<TYPE_BOOL>::type>());
+      Add<OperatorCast<CxxTraits<TYPE_DOUBLE>::type, CxxTraits<TYPE_BOOL>::type>>();
       break;
     case (TYPE_DOUBLE << 4) | TYPE_FLOAT:
-      Add(OperatorCast<CxxTraits<TYPE_DOUBLE>::type, CxxTraits<TYPE_FLOAT>::type>());
+      Add<OperatorCast<CxxTraits<TYPE_DOUBLE>::type, CxxTraits<TYPE_FLOAT>::type>>();
       break;
     case (TYPE_INT32 << 4) | TYPE_INT32:
     case (TYPE_INT64 << 4) | TYPE_INT64:
@@ -15,6 +15,7 @@
 #ifndef DINGODB_EXPR_OPERATORVECTOR_H_
 #define DINGODB_EXPR_OPERATORVECTOR_H_
 
+#include <cstdint>
 #include <vector>
 
 #include "operator.h"
@@ -24,23 +25,35 @@ namespace dingodb::expr {
 
 class OperatorVector {
  public:
-  OperatorVector() : m_vector() {}
+  OperatorVector() : m_vector(), m_depth(0), m_max_depth(0) {}
   virtual ~OperatorVector() {}
 
   void Decode(const byte code[], size_t len);
 
-  auto begin() { return m_vector.begin(); }
+  auto begin() const { return m_vector.begin(); }
 
-  auto end() { return m_vector.end(); }
+  auto end() const { return m_vector.end(); }
+
+  // Max stack depth while running.
+  size_t MaxDepth() const { return m_max_depth; }
 
  private:
   std::vector<Operator> m_vector;
+  int m_depth;
+  size_t m_max_depth;
+
+  template <typename OP>
+  void Add(uint32_t index = 0, const StackValue &value = StackValue());
 
-  void Add(const Operator &op) { m_vector.push_back(op); }
+  template <typename T>
+  void AddConst(T v);
 
   template <template <typename> class OP>
   void AddOperatorByType(byte b);
 
+  template <template <typename> class OP>
+  void AddArithmeticOperatorByType(byte b);
+
   void AddCastOperator(byte b);
 };
 
@@ -0,0 +1,278 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "range_analyzer.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "codec.h"
+#include "instruction.h"
+
+namespace dingodb::expr {
+
+namespace {
+
+// Symbolic value of a stack slot.
+struct Item {
+  enum Kind {
+    // Unknown value, or a bool which does not constrain the variable.
+    kOther,
+    // The analyzed variable.
+    kVar,
+    // Integral constant.
+    kConst,
+    // Bool which can be true only if the variable is in range.
+    kRange,
+  };
+
+  Kind kind = kOther;
+  byte type = 0;
+  int64_t value = 0;
+  VarRange range;
+};
+
+VarRange EmptyRange() {
+  VarRange range;
+  range.min = std::numeric_limits<int64_t>::max();
+  range.max = std::numeric_limits<int64_t>::min();
+  return range;
+}
+
+// A bool of kOther is unconstrained.
+VarRange RangeOf(const Item &item) { return item.kind == Item::kRange ? item.range : VarRange(); }
+
+Item MakeRange(const VarRange &range) {
+  Item item;
+  item.kind = Item::kRange;
+  item.type = TYPE_BOOL;
+  item.range = range;
+  return item;
+}
+
+Item MakeConst(byte type, int64_t value) {
+  Item item;
+  item.kind = Item::kConst;
+  item.type = type;
+  item.value = value;
+  return item;
+}
+
+// Range of `var op value`.
+VarRange CompareRange(byte op, int64_t value) {
+  VarRange range;
+  switch (op) {
+    case EQ:
+      range.min = value;
+      range.max = value;
+      break;
+    case GE:
+      range.min = value;
+      break;
+    case GT:
+      if (value == std::numeric_limits<int64_t>::max()) {
+        return EmptyRange();
+      }
+      range.min = value + 1;
+      break;
+    case LE:
+      range.max = value;
+      break;
+    case LT:
+      if (value == std::numeric_limits<int64_t>::min()) {
+        return EmptyRange();
+      }
+      range.max = value - 1;
+      break;
+    default:
+      break;
+  }
+  return range;
+}
+
+// `value op var` is `var MirrorCompare(op) value`.
+byte MirrorCompare(byte op) {
+  switch (op) {
+    case GE:
+      return LE;
+    case GT:
+      return LT;
+    case LE:
+      return GE;
+    case LT:
+      return GT;
+    default:
+      return op;
+  }
+}
+
+}  // namespace
+
+bool RangeAnalyzer::Analyze(const byte *code, size_t len, uint32_t index, VarRange &range) {
+  std::vector<Item> stack;
+  // Pop count items and push an unknown one.
+  auto replace_top = [&stack](size_t count) {
+    if (stack.size() < count) {
+      return false;
+    }
+    stack.resize(stack.size() - count);
+    stack.emplace_back();
+    return true;
+  };
+
+  for (const byte *p = code; p < code + len; ++p) {
+    byte op = *p;
+    switch (op) {
+      case NULL_INT32:
+      case NULL_INT64:
+      case NULL_BOOL:
+      case NULL_FLOAT:
+      case NULL_DOUBLE:
+      case CONST_BOOL:
+      case CONST_N_BOOL:
+        stack.emplace_back();
+        break;
+      case CONST_INT32:
+      case CONST_N_INT32: {
+        int32_t v;
+        p = DecodeVarint(v, ++p);
+        stack.push_back(MakeConst(TYPE_INT32, op == CONST_INT32 ? v : -static_cast<int64_t>(v)));
+        break;
+      }
+      case CONST_INT64:
+      case CONST_N_INT64: {
+        int64_t v;
+        p = DecodeVarint(v, ++p);
+        stack.push_back(MakeConst(TYPE_INT64, op == CONST_INT64 ? v : -v));
+        break;
+      }
+      case CONST_FLOAT:
+        p += 4;
+        stack.emplace_back();
+        break;
+      case CONST_DOUBLE:
+        p += 8;
+        stack.emplace_back();
+        break;
+      case VAR_I_INT32:
+      case VAR_I_INT64:
+      case VAR_I_BOOL:
+      case VAR_I_FLOAT:
+      case VAR_I_DOUBLE: {
+        uint32_t v;
+        p = DecodeVarint(v, ++p);
+        Item item;
+        if (v == index && (op == VAR_I_INT32 || op == VAR_I_INT64)) {
+          item.kind = Item::kVar;
+          item.type = op & 0x0F;
+        }
+        stack.push_back(item);
+        break;
+      }
+      case POS:
+      case NEG:
+      case IS_NULL:
+      case IS_FALSE:
+      case CAST:
+        ++p;
+        if (!replace_top(1)) {
+          return false;
+        }
+        break;
+      case NOT:
+        if (!replace_top(1)) {
+          return false;
+        }
+        break;
+      case IS_TRUE:
+        // Keep the range, is_true(a) is true only if a is true.
+        ++p;
+        if (stack.empty()) {
+          return false;
+        }
+        break;
+      case ADD:
+      case SUB:
+      case MUL:
+      case DIV:
+      case MOD:
+        ++p;
+        if (!replace_top(2)) {
+          return false;
+        }
+        break;
+      case EQ:
+      case GE:
+      case GT:
+      case LE:
+      case LT:
+      case NE: {
+        byte type = *++p;
+        if (stack.size() < 2) {
+          return false;
+        }
+        Item b = stack.back();
+        stack.pop_back();
+        Item a = stack.back();
+        stack.pop_back();
+        if (a.kind == Item::kVar && b.kind == Item::kConst && a.type == type && b.type == type) {
+          stack.push_back(MakeRange(CompareRange(op, b.value)));
+        } else if (a.kind == Item::kConst && b.kind == Item::kVar && a.type == type && b.type == type) {
+          stack.push_back(MakeRange(CompareRange(MirrorCompare(op), a.value)));
+        } else {
+          stack.emplace_back();
+        }
+        break;
+      }
+      case AND:
+      case OR: {
+        if (stack.size() < 2) {
+          return false;
+        }
+        VarRange b = RangeOf(stack.back());
+        stack.pop_back();
+        VarRange a = RangeOf(stack.back());
+        stack.pop_back();
+        VarRange r;
+        if (op == AND) {
+          r.min = std::max(a.min, b.min);
+          r.max = std::min(a.max, b.max);
+        } else if (a.IsEmpty()) {
+          r = b;
+        } else if (b.IsEmpty()) {
+          r = a;
+        } else {
+          r.min = std::min(a.min, b.min);
+          r.max = std::max(a.max, b.max);
+        }
+        stack.push_back(MakeRange(r));
+        break;
+      }
+      default:
+        // String, decimal and functions are not supported.
+        return false;
+    }
+  }
+
+  if (stack.size() != 1 || stack.back().kind != Item::kRange || stack.back().range.IsFull()) {
+    return false;
+  }
+  range = stack.back().range;
+  if (range.IsEmpty()) {
+    range = EmptyRange();
+  }
+  return true;
+}
+
+}  // namespace dingodb::expr
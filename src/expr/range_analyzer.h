@@ -0,0 +1,48 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DINGODB_EXPR_RANGE_ANALYZER_H_
+#define DINGODB_EXPR_RANGE_ANALYZER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "types.h"
+
+namespace dingodb::expr {
+
+// Closed interval of an integral variable, empty if min > max.
+struct VarRange {
+  int64_t min = std::numeric_limits<int64_t>::min();
+  int64_t max = std::numeric_limits<int64_t>::max();
+
+  bool IsEmpty() const { return min > max; }
+  bool IsFull() const {
+    return min == std::numeric_limits<int64_t>::min() && max == std::numeric_limits<int64_t>::max();
+  }
+};
+
+// Derive the range of an int32/int64 variable from a bool expression, the expression can be true only if the
+// variable is in the range. Only comparisons of the variable with constants combined by AND/OR are considered,
+// OR takes the hull of both sides, anything else leaves the variable unconstrained.
+class RangeAnalyzer {
+ public:
+  // Return false if the expression is not supported or the variable is unconstrained.
+  static bool Analyze(const byte *code, size_t len, uint32_t index, VarRange &range);
+};
+
+}  // namespace dingodb::expr
+
+#endif  // DINGODB_EXPR_RANGE_ANALYZER_H_
@@ -15,6 +15,8 @@
 #ifndef DINGODB_EXPR_RUNNER_H_
 #define DINGODB_EXPR_RUNNER_H_
 
+#include <stdexcept>
+
 #include "operand_stack.h"
 #include "operator_vector.h"
 
@@ -26,7 +28,10 @@ class Runner {
 
   virtual ~Runner() {}
 
-  void Decode(const byte *code, size_t len) { m_operatorVector.Decode(code, len); }
+  void Decode(const byte *code, size_t len) {
+    m_operatorVector.Decode(code, len);
+    m_operandStack.Resize(m_operatorVector.MaxDepth());
+  }
 
   Operand RunAny(const Tuple *tuple = nullptr) {
     RunInternal(tuple);
@@ -44,9 +49,14 @@ class Runner {
   OperatorVector m_operatorVector;
 
   void RunInternal(const Tuple *tuple) {
+    if (m_operatorVector.MaxDepth() == 0) {
+      throw std::runtime_error("Empty expression.");
+    }
+    // Nothing left by the last run if it throws.
+    m_operandStack.Reset();
     m_operandStack.BindTuple(tuple);
-    for (auto op : m_operatorVector) {
-      op(m_operandStack);
+    for (const auto &op : m_operatorVector) {
+      op.func(m_operandStack, op);
     }
   }
 };
@@ -0,0 +1,589 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "vector_runner.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+
+#include "calc/arithmetic.h"
+#include "codec.h"
+#include "instruction.h"
+
+namespace dingodb::expr {
+
+static bool IsFixedType(byte type) {
+  return type == TYPE_INT32 || type == TYPE_INT64 || type == TYPE_BOOL || type == TYPE_FLOAT || type == TYPE_DOUBLE;
+}
+
+static bool IsNumericType(byte type) {
+  return type == TYPE_INT32 || type == TYPE_INT64 || type == TYPE_FLOAT || type == TYPE_DOUBLE;
+}
+
+static bool IsIntegralType(byte type) { return type == TYPE_INT32 || type == TYPE_INT64; }
+
+static bool IsBinary(byte code) {
+  switch (code) {
+    case ADD:
+    case SUB:
+    case MUL:
+    case DIV:
+    case MOD:
+    case EQ:
+    case GE:
+    case GT:
+    case LE:
+    case LT:
+    case NE:
+    case AND:
+    case OR:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Call f with a value of the storage type, bool is stored as uint8_t.
+template <typename F>
+static void DispatchType(byte type, F &&f) {
+  switch (type) {
+    case TYPE_INT32:
+      f(int32_t());
+      break;
+    case TYPE_INT64:
+      f(int64_t());
+      break;
+    case TYPE_BOOL:
+      f(uint8_t());
+      break;
+    case TYPE_FLOAT:
+      f(float());
+      break;
+    case TYPE_DOUBLE:
+      f(double());
+      break;
+    default:
+      throw std::runtime_error("Unsupported type.");
+  }
+}
+
+void ColumnVector::Reset(byte type, size_t size) {
+  m_type = type;
+  m_size = size;
+  if (m_nulls.size() < size) {
+    m_nulls.resize(size);
+  }
+  if (type == TYPE_STRING) {
+    if (m_strings.size() < size) {
+      m_strings.resize(size);
+    }
+  } else if (m_values.size() < size) {
+    m_values.resize(size);
+  }
+}
+
+void ColumnVector::Set(size_t i, const Operand &v) {
+  switch (m_type) {
+    case TYPE_INT32:
+      SetValue<int32_t>(i, std::any_cast<const wrap<int32_t> &>(v));
+      break;
+    case TYPE_INT64:
+      SetValue<int64_t>(i, std::any_cast<const wrap<int64_t> &>(v));
+      break;
+    case TYPE_BOOL:
+      SetValue<bool>(i, std::any_cast<const wrap<bool> &>(v));
+      break;
+    case TYPE_FLOAT:
+      SetValue<float>(i, std::any_cast<const wrap<float> &>(v));
+      break;
+    case TYPE_DOUBLE:
+      SetValue<double>(i, std::any_cast<const wrap<double> &>(v));
+      break;
+    case TYPE_STRING:
+      SetValue<std::shared_ptr<std::string>>(i, std::any_cast<const wrap<std::shared_ptr<std::string>> &>(v));
+      break;
+    default:
+      throw std::runtime_error("Unsupported type.");
+  }
+}
+
+Operand ColumnVector::Get(size_t i) const {
+  switch (m_type) {
+    case TYPE_INT32:
+      return GetValue<int32_t>(i);
+    case TYPE_INT64:
+      return GetValue<int64_t>(i);
+    case TYPE_BOOL:
+      return GetValue<bool>(i);
+    case TYPE_FLOAT:
+      return GetValue<float>(i);
+    case TYPE_DOUBLE:
+      return GetValue<double>(i);
+    case TYPE_STRING:
+      return GetValue<std::shared_ptr<std::string>>(i);
+    default:
+      throw std::runtime_error("Unsupported type.");
+  }
+}
+
+bool VectorRunner::Decode(const byte *code, size_t len) {
+  m_instructions.clear();
+  m_columns.clear();
+  m_max_depth = 0;
+
+  // Type of the stack slots, check the operand types at compile time.
+  std::vector<byte> types;
+  auto check_top = [&types](size_t count, byte type) {
+    if (types.size() < count) {
+      return false;
+    }
+    return std::all_of(types.end() - count, types.end(), [type](byte t) { return t == type; });
+  };
+
+  for (const byte *p = code; p < code + len; ++p) {
+    Instruction inst{};
+    inst.code = *p;
+    inst.depth = types.size();
+    switch (*p) {
+      case NULL_INT32:
+      case NULL_INT64:
+      case NULL_BOOL:
+      case NULL_FLOAT:
+      case NULL_DOUBLE:
+        inst.type = *p & 0x0F;
+        inst.is_null = true;
+        types.push_back(inst.type);
+        break;
+      case CONST_INT32:
+      case CONST_N_INT32: {
+        int32_t v;
+        p = DecodeVarint(v, ++p);
+        inst.type = TYPE_INT32;
+        inst.value.i32 = (inst.code == CONST_INT32 ? v : -v);
+        types.push_back(inst.type);
+        break;
+      }
+      case CONST_INT64:
+      case CONST_N_INT64: {
+        int64_t v;
+        p = DecodeVarint(v, ++p);
+        inst.type = TYPE_INT64;
+        inst.value.i64 = (inst.code == CONST_INT64 ? v : -v);
+        types.push_back(inst.type);
+        break;
+      }
+      case CONST_BOOL:
+      case CONST_N_BOOL:
+        inst.type = TYPE_BOOL;
+        inst.value.b = (inst.code == CONST_BOOL ? 1 : 0);
+        types.push_back(inst.type);
+        break;
+      case CONST_FLOAT:
+        inst.type = TYPE_FLOAT;
+        inst.value.f = DecodeFloat(++p);
+        p += 3;
+        types.push_back(inst.type);
+        break;
+      case CONST_DOUBLE:
+        inst.type = TYPE_DOUBLE;
+        inst.value.d = DecodeDouble(++p);
+        p += 7;
+        types.push_back(inst.type);
+        break;
+      case VAR_I_INT32:
+      case VAR_I_INT64:
+      case VAR_I_BOOL:
+      case VAR_I_FLOAT:
+      case VAR_I_DOUBLE: {
+        uint32_t v;
+        p = DecodeVarint(v, ++p);
+        inst.type = inst.code & 0x0F;
+        inst.index = v;
+        auto it = std::find_if(m_columns.begin(), m_columns.end(), [v](const auto &c) { return c.first == v; });
+        if (it == m_columns.end()) {
+          m_columns.emplace_back(v, inst.type);
+        } else if (it->second != inst.type) {
+          return false;
+        }
+        types.push_back(inst.type);
+        break;
+      }
+      case POS:
+      case NEG:
+        inst.type = *++p;
+        if (!IsNumericType(inst.type) || !check_top(1, inst.type)) {
+          return false;
+        }
+        break;
+      case ADD:
+      case SUB:
+      case MUL:
+      case DIV:
+      case MOD:
+        inst.type = *++p;
+        if (!IsNumericType(inst.type) || !check_top(2, inst.type)) {
+          return false;
+        }
+        if (inst.code == MOD && !IsIntegralType(inst.type)) {
+          return false;
+        }
+        types.pop_back();
+        break;
+      case EQ:
+      case GE:
+      case GT:
+      case LE:
+      case LT:
+      case NE:
+        inst.type = *++p;
+        if (!IsFixedType(inst.type) || !check_top(2, inst.type)) {
+          return false;
+        }
+        types.pop_back();
+        types.back() = TYPE_BOOL;
+        break;
+      case IS_NULL:
+      case IS_TRUE:
+      case IS_FALSE:
+        inst.type = *++p;
+        if (!IsFixedType(inst.type) || !check_top(1, inst.type)) {
+          return false;
+        }
+        types.back() = TYPE_BOOL;
+        break;
+      case NOT:
+        inst.type = TYPE_BOOL;
+        if (!check_top(1, TYPE_BOOL)) {
+          return false;
+        }
+        break;
+      case AND:
+      case OR:
+        inst.type = TYPE_BOOL;
+        if (!check_top(2, TYPE_BOOL)) {
+          return false;
+        }
+        types.pop_back();
+        break;
+      case CAST:
+        ++p;
+        inst.cast_type = (*p >> 4);
+        inst.type = (*p & 0x0F);
+        if (!IsFixedType(inst.type) || !IsFixedType(inst.cast_type) || !check_top(1, inst.type)) {
+          return false;
+        }
+        types.back() = inst.cast_type;
+        break;
+      default:
+        return false;
+    }
+    m_instructions.push_back(inst);
+    m_max_depth = std::max(m_max_depth, types.size());
+  }
+
+  if (types.size() != 1) {
+    return false;
+  }
+  m_result_type = types.back();
+  return true;
+}
+
+template <typename T, typename R, typename F>
+static void UnaryKernel(const ColumnVector &in, ColumnVector &out, byte out_type, size_t size, F f) {
+  out.Reset(out_type, size);
+  const T *v = in.Values<T>();
+  const uint8_t *n = in.Nulls();
+  R *vo = out.Values<R>();
+  uint8_t *no = out.Nulls();
+  for (size_t i = 0; i < size; ++i) {
+    vo[i] = f(v[i], n[i]);
+    no[i] = n[i];
+  }
+}
+
+template <typename T, typename R, typename F>
+static void BinaryKernel(const ColumnVector &a, const ColumnVector &b, ColumnVector &out, byte out_type, size_t size,
+                         F f) {
+  out.Reset(out_type, size);
+  const T *va = a.Values<T>();
+  const T *vb = b.Values<T>();
+  const uint8_t *na = a.Nulls();
+  const uint8_t *nb = b.Nulls();
+  R *vo = out.Values<R>();
+  uint8_t *no = out.Nulls();
+  for (size_t i = 0; i < size; ++i) {
+    vo[i] = f(va[i], vb[i]);
+    no[i] = na[i] | nb[i];
+  }
+}
+
+// Integer divide by zero is null, instead of crash, same as OperatorDiv and OperatorMod.
+template <typename T>
+static void DivModKernel(const ColumnVector &a, const ColumnVector &b, ColumnVector &out, size_t size, bool is_mod) {
+  out.Reset(a.Type(), size);
+  const T *va = a.Values<T>();
+  const T *vb = b.Values<T>();
+  const uint8_t *na = a.Nulls();
+  const uint8_t *nb = b.Nulls();
+  T *vo = out.Values<T>();
+  uint8_t *no = out.Nulls();
+  for (size_t i = 0; i < size; ++i) {
+    T x = va[i];
+    T y = vb[i];
+    no[i] = na[i] | nb[i] | static_cast<uint8_t>(y == 0);
+    if (y == 0) {
+      vo[i] = T();
+    } else {
+      vo[i] = is_mod ? CalcMod(x, y) : CalcDiv(x, y);
+    }
+  }
+}
+
+template <typename T>
+static void CompareKernel(byte code, const ColumnVector &a, const ColumnVector &b, ColumnVector &out, size_t size) {
+  switch (code) {
+    case EQ:
+      BinaryKernel<T, uint8_t>(a, b, out, TYPE_BOOL, size, [](T x, T y) -> uint8_t { return x == y; });
+      break;
+    case GE:
+      BinaryKernel<T, uint8_t>(a, b, out, TYPE_BOOL, size, [](T x, T y) -> uint8_t { return x >= y; });
+      break;
+    case GT:
+      BinaryKernel<T, uint8_t>(a, b, out, TYPE_BOOL, size, [](T x, T y) -> uint8_t { return x > y; });
+      break;
+    case LE:
+      BinaryKernel<T, uint8_t>(a, b, out, TYPE_BOOL, size, [](T x, T y) -> uint8_t { return x <= y; });
+      break;
+    case LT:
+      BinaryKernel<T, uint8_t>(a, b, out, TYPE_BOOL, size, [](T x, T y) -> uint8_t { return x < y; });
+      break;
+    case NE:
+      BinaryKernel<T, uint8_t>(a, b, out, TYPE_BOOL, size, [](T x, T y) -> uint8_t { return x != y; });
+      break;
+    default:
+      throw std::runtime_error("Unknown instruction.");
+  }
+}
+
+template <typename T>
+static void ArithmeticKernel(byte code, const ColumnVector &a, const ColumnVector &b, ColumnVector &out, size_t size) {
+  switch (code) {
+    case ADD:
+      BinaryKernel<T, T>(a, b, out, a.Type(), size, [](T x, T y) -> T { return x + y; });
+      break;
+    case SUB:
+      BinaryKernel<T, T>(a, b, out, a.Type(), size, [](T x, T y) -> T { return x - y; });
+      break;
+    case MUL:
+      BinaryKernel<T, T>(a, b, out, a.Type(), size, [](T x, T y) -> T { return x * y; });
+      break;
+    case DIV:
+    case MOD:
+      if constexpr (std::is_integral_v<T>) {
+        DivModKernel<T>(a, b, out, size, code == MOD);
+      } else {
+        BinaryKernel<T, T>(a, b, out, a.Type(), size, [](T x, T y) -> T { return x / y; });
+      }
+      break;
+    default:
+      throw std::runtime_error("Unknown instruction.");
+  }
+}
+
+// Three-valued logic, same as OperatorAnd and OperatorOr.
+static void LogicKernel(byte code, const ColumnVector &a, const ColumnVector &b, ColumnVector &out, size_t size) {
+  out.Reset(TYPE_BOOL, size);
+  const uint8_t *va = a.Values<uint8_t>();
+  const uint8_t *vb = b.Values<uint8_t>();
+  const uint8_t *na = a.Nulls();
+  const uint8_t *nb = b.Nulls();
+  uint8_t *vo = out.Values<uint8_t>();
+  uint8_t *no = out.Nulls();
+  if (code == AND) {
+    for (size_t i = 0; i < size; ++i) {
+      uint8_t is_false = ((na[i] ^ 1) & (va[i] ^ 1)) | ((nb[i] ^ 1) & (vb[i] ^ 1));
+      vo[i] = (na[i] ^ 1) & va[i] & (nb[i] ^ 1) & vb[i];
+      no[i] = (is_false ^ 1) & (na[i] | nb[i]);
+    }
+  } else {
+    for (size_t i = 0; i < size; ++i) {
+      uint8_t is_true = ((na[i] ^ 1) & va[i]) | ((nb[i] ^ 1) & vb[i]);
+      vo[i] = is_true;
+      no[i] = (is_true ^ 1) & (na[i] | nb[i]);
+    }
+  }
+}
+
+// Same as CalcIsNull, CalcIsTrue and CalcIsFalse, the result is never null.
+template <typename T>
+static void SpecialKernel(byte code, byte type, const ColumnVector &in, ColumnVector &out, size_t size) {
+  out.Reset(TYPE_BOOL, size);
+  const T *v = in.Values<T>();
+  const uint8_t *n = in.Nulls();
+  uint8_t *vo = out.Values<uint8_t>();
+  uint8_t *no = out.Nulls();
+  for (size_t i = 0; i < size; ++i) {
+    uint8_t not_null = n[i] ^ 1;
+    if (code == IS_NULL) {
+      vo[i] = n[i];
+    } else if (type == TYPE_BOOL) {
+      vo[i] = not_null & (code == IS_TRUE ? v[i] != 0 : v[i] == 0);
+    } else if (IsIntegralType(type)) {
+      vo[i] = not_null & (v[i] != 0);
+    } else {
+      vo[i] = 0;
+    }
+    no[i] = 0;
+  }
+}
+
+void VectorRunner::RunInstruction(const Instruction &inst, const std::vector<ColumnVector> &columns, size_t size) {
+  switch (inst.code) {
+    case VAR_I_INT32:
+    case VAR_I_INT64:
+    case VAR_I_BOOL:
+    case VAR_I_FLOAT:
+    case VAR_I_DOUBLE: {
+      if (inst.index >= columns.size() || columns[inst.index].Type() != inst.type ||
+          columns[inst.index].Size() < size) {
+        throw std::runtime_error("Column type mismatch.");
+      }
+      const ColumnVector &in = columns[inst.index];
+      ColumnVector &out = m_stack[inst.depth];
+      out.Reset(inst.type, size);
+      DispatchType(inst.type, [&](auto tag) {
+        using T = decltype(tag);
+        std::copy_n(in.Values<T>(), size, out.Values<T>());
+      });
+      std::copy_n(in.Nulls(), size, out.Nulls());
+      return;
+    }
+    case POS:
+      return;
+    case NEG:
+      DispatchType(inst.type, [&](auto tag) {
+        using T = decltype(tag);
+        UnaryKernel<T, T>(m_stack[inst.depth - 1], m_temp, inst.type, size, [](T x, uint8_t) -> T { return -x; });
+      });
+      break;
+    case ADD:
+    case SUB:
+    case MUL:
+    case DIV:
+    case MOD:
+      DispatchType(inst.type, [&](auto tag) {
+        ArithmeticKernel<decltype(tag)>(inst.code, m_stack[inst.depth - 2], m_stack[inst.depth - 1], m_temp, size);
+      });
+      break;
+    case EQ:
+    case GE:
+    case GT:
+    case LE:
+    case LT:
+    case NE:
+      DispatchType(inst.type, [&](auto tag) {
+        CompareKernel<decltype(tag)>(inst.code, m_stack[inst.depth - 2], m_stack[inst.depth - 1], m_temp, size);
+      });
+      break;
+    case IS_NULL:
+    case IS_TRUE:
+    case IS_FALSE:
+      DispatchType(inst.type, [&](auto tag) {
+        SpecialKernel<decltype(tag)>(inst.code, inst.type, m_stack[inst.depth - 1], m_temp, size);
+      });
+      break;
+    case NOT:
+      UnaryKernel<uint8_t, uint8_t>(m_stack[inst.depth - 1], m_temp, TYPE_BOOL, size,
+                                    [](uint8_t x, uint8_t n) -> uint8_t { return (x ^ 1) & (n ^ 1); });
+      break;
+    case AND:
+    case OR:
+      LogicKernel(inst.code, m_stack[inst.depth - 2], m_stack[inst.depth - 1], m_temp, size);
+      break;
+    case CAST:
+      if (inst.type == inst.cast_type) {
+        return;
+      }
+      DispatchType(inst.type, [&](auto from) {
+        using T = decltype(from);
+        DispatchType(inst.cast_type, [&](auto to) {
+          using D = decltype(to);
+          if constexpr (std::is_same_v<D, uint8_t>) {
+            UnaryKernel<T, D>(m_stack[inst.depth - 1], m_temp, inst.cast_type, size,
+                              [](T x, uint8_t) -> D { return x != 0; });
+          } else {
+            UnaryKernel<T, D>(m_stack[inst.depth - 1], m_temp, inst.cast_type, size,
+                              [](T x, uint8_t n) -> D { return n ? D() : static_cast<D>(x); });
+          }
+        });
+      });
+      break;
+    default: {
+      // Null and const
+      ColumnVector &out = m_stack[inst.depth];
+      out.Reset(inst.type, size);
+      DispatchType(inst.type, [&](auto tag) {
+        using T = decltype(tag);
+        T v;
+        if constexpr (std::is_same_v<T, int32_t>) {
+          v = inst.value.i32;
+        } else if constexpr (std::is_same_v<T, int64_t>) {
+          v = inst.value.i64;
+        } else if constexpr (std::is_same_v<T, uint8_t>) {
+          v = inst.value.b;
+        } else if constexpr (std::is_same_v<T, float>) {
+          v = inst.value.f;
+        } else {
+          v = inst.value.d;
+        }
+        std::fill_n(out.Values<T>(), size, inst.is_null ? T() : v);
+      });
+      std::fill_n(out.Nulls(), size, static_cast<uint8_t>(inst.is_null));
+      return;
+    }
+  }
+
+  // Unary result replace the top, binary result replace the second one and pop the top.
+  std::swap(m_stack[inst.depth - (IsBinary(inst.code) ? 2 : 1)], m_temp);
+}
+
+const ColumnVector &VectorRunner::Run(const std::vector<ColumnVector> &columns, size_t size) {
+  if (m_stack.size() < m_max_depth) {
+    m_stack.resize(m_max_depth);
+  }
+  for (const auto &inst : m_instructions) {
+    RunInstruction(inst, columns, size);
+  }
+  return m_stack[0];
+}
+
+void VectorRunner::Select(const std::vector<ColumnVector> &columns, size_t size, std::vector<uint32_t> &selection) {
+  const ColumnVector &result = Run(columns, size);
+  if (result.Type() != TYPE_BOOL) {
+    throw std::runtime_error("Result is not bool.");
+  }
+
+  const uint8_t *v = result.Values<uint8_t>();
+  const uint8_t *n = result.Nulls();
+  size_t count = selection.size();
+  selection.resize(count + size);
+  for (size_t i = 0; i < size; ++i) {
+    selection[count] = i;
+    count += v[i] & (n[i] ^ 1);
+  }
+  selection.resize(count);
+}
+
+}  // namespace dingodb::expr
@@ -0,0 +1,182 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DINGODB_EXPR_VECTOR_RUNNER_H_
+#define DINGODB_EXPR_VECTOR_RUNNER_H_
+
+#include <any>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "calc/operand.h"
+#include "types.h"
+
+namespace dingodb::expr {
+
+// Values and null flags of one column over a batch of rows.
+// Bool values are stored as uint8_t 0/1, so the kernels can be vectorized.
+// String values are std::shared_ptr<std::string> as the decoded records, only for projection and aggregation.
+class ColumnVector {
+ public:
+  // Storage type of the value type T.
+  template <typename T>
+  using Storage = std::conditional_t<std::is_same_v<T, bool>, uint8_t, T>;
+
+  ColumnVector() : m_type(TYPE_BOOL), m_size(0) {}
+  virtual ~ColumnVector() {}
+
+  // Column type of the value type T.
+  template <typename T>
+  static constexpr byte TypeOf() {
+    if constexpr (std::is_same_v<T, int32_t>) {
+      return TYPE_INT32;
+    } else if constexpr (std::is_same_v<T, int64_t>) {
+      return TYPE_INT64;
+    } else if constexpr (std::is_same_v<T, bool>) {
+      return TYPE_BOOL;
+    } else if constexpr (std::is_same_v<T, float>) {
+      return TYPE_FLOAT;
+    } else if constexpr (std::is_same_v<T, double>) {
+      return TYPE_DOUBLE;
+    } else {
+      static_assert(std::is_same_v<T, std::shared_ptr<std::string>>, "ColumnVector : unsupported type");
+      return TYPE_STRING;
+    }
+  }
+
+  byte Type() const { return m_type; }
+  size_t Size() const { return m_size; }
+
+  // Set type and size, the content is undefined.
+  void Reset(byte type, size_t size);
+
+  template <typename T>
+  T *Values() {
+    return reinterpret_cast<T *>(m_values.data());
+  }
+
+  template <typename T>
+  const T *Values() const {
+    return reinterpret_cast<const T *>(m_values.data());
+  }
+
+  std::shared_ptr<std::string> *Strings() { return m_strings.data(); }
+  const std::shared_ptr<std::string> *Strings() const { return m_strings.data(); }
+
+  uint8_t *Nulls() { return m_nulls.data(); }
+  const uint8_t *Nulls() const { return m_nulls.data(); }
+
+  // Typed access of row i, throw std::bad_any_cast if type mismatch.
+  template <typename T>
+  void SetValue(size_t i, const wrap<T> &v) {
+    if (m_type != TypeOf<T>()) {
+      throw std::bad_any_cast();
+    }
+    m_nulls[i] = v.has_value() ? 0 : 1;
+    if constexpr (std::is_same_v<T, std::shared_ptr<std::string>>) {
+      m_strings[i] = v.has_value() ? *v : nullptr;
+    } else {
+      Values<Storage<T>>()[i] = v.has_value() ? static_cast<Storage<T>>(*v) : Storage<T>();
+    }
+  }
+
+  template <typename T>
+  wrap<T> GetValue(size_t i) const {
+    if (m_type != TypeOf<T>()) {
+      throw std::bad_any_cast();
+    }
+    if (m_nulls[i] != 0) {
+      return wrap<T>();
+    }
+    if constexpr (std::is_same_v<T, std::shared_ptr<std::string>>) {
+      return wrap<T>(m_strings[i]);
+    } else {
+      return wrap<T>(static_cast<T>(Values<Storage<T>>()[i]));
+    }
+  }
+
+  // Set row i from the operand of a tuple, throw std::bad_any_cast if type mismatch.
+  void Set(size_t i, const Operand &v);
+
+  Operand Get(size_t i) const;
+
+ private:
+  byte m_type;
+  size_t m_size;
+  // 8 bytes for each row, enough for all fixed width types.
+  std::vector<uint64_t> m_values;
+  std::vector<std::shared_ptr<std::string>> m_strings;
+  std::vector<uint8_t> m_nulls;
+};
+
+// Run expression on a batch of rows at a time, every instruction is a typed kernel over column vectors.
+// Support the fixed width types, Decode return false for others and the caller should use Runner.
+class VectorRunner {
+ public:
+  VectorRunner() : m_instructions(), m_columns(), m_result_type(TYPE_BOOL), m_max_depth(0), m_stack(), m_temp() {}
+  virtual ~VectorRunner() {}
+
+  // Compile the expression, return false if not support vectorized.
+  bool Decode(const byte *code, size_t len);
+
+  // Tuple index and type of the variables, the input columns of Run.
+  const std::vector<std::pair<uint32_t, byte>> &Columns() const { return m_columns; }
+
+  byte ResultType() const { return m_result_type; }
+
+  // Run on size rows, columns is indexed by tuple index.
+  const ColumnVector &Run(const std::vector<ColumnVector> &columns, size_t size);
+
+  // Run the bool expression, append the index of rows which result is true to selection.
+  void Select(const std::vector<ColumnVector> &columns, size_t size, std::vector<uint32_t> &selection);
+
+ private:
+  struct Instruction {
+    byte code;
+    // Operand type, source type for cast.
+    byte type;
+    // Result type for cast.
+    byte cast_type;
+    // Tuple index of variable.
+    uint32_t index;
+    // Stack depth before the instruction run.
+    uint32_t depth;
+    bool is_null;
+    union {
+      int32_t i32;
+      int64_t i64;
+      uint8_t b;
+      float f;
+      double d;
+    } value;
+  };
+
+  void RunInstruction(const Instruction &inst, const std::vector<ColumnVector> &columns, size_t size);
+
+  std::vector<Instruction> m_instructions;
+  std::vector<std::pair<uint32_t, byte>> m_columns;
+  byte m_result_type;
+  size_t m_max_depth;
+  // Every stack slot is a column vector.
+  std::vector<ColumnVector> m_stack;
+  ColumnVector m_temp;
+};
+
+}  // namespace dingodb::expr
+
+#endif  // DINGODB_EXPR_VECTOR_RUNNER_H_
@@ -35,6 +35,7 @@ enum class HandlerType {
   kSplit = pb::raft::SPLIT,
   kMetaWrite = pb::raft::META_WRITE,
   kCompareAndSet = pb::raft::COMPAREANDSET,
+  kHibernate = pb::raft::HIBERNATE,
 
   // Snapshot
   kSaveSnapshot = 1000,
@@ -28,6 +28,63 @@
 
 namespace dingodb {
 
+void InvalidateRowCache(std::shared_ptr<RawEngine> engine, const pb::raft::Request &req) {
+  switch (req.cmd_type()) {
+    case pb::raft::PUT: {
+      auto row_cache = engine->GetRowCache(req.put().cf_name());
+      if (row_cache == nullptr) {
+        break;
+      }
+      for (const auto &kv : req.put().kvs()) {
+        row_cache->Erase(kv.key());
+      }
+      break;
+    }
+    case pb::raft::PUTIFABSENT: {
+      auto row_cache = engine->GetRowCache(req.put_if_absent().cf_name());
+      if (row_cache == nullptr) {
+        break;
+      }
+      for (const auto &kv : req.put_if_absent().kvs()) {
+        row_cache->Erase(kv.key());
+      }
+      break;
+    }
+    case pb::raft::COMPAREANDSET: {
+      auto row_cache = engine->GetRowCache(req.compare_and_set().cf_name());
+      if (row_cache == nullptr) {
+        break;
+      }
+      for (const auto &kv : req.compare_and_set().kvs()) {
+        row_cache->Erase(kv.key());
+      }
+      break;
+    }
+    case pb::raft::DELETEBATCH: {
+      auto row_cache = engine->GetRowCache(req.delete_batch().cf_name());
+      if (row_cache == nullptr) {
+        break;
+      }
+      for (const auto &key : req.delete_batch().keys()) {
+        row_cache->Erase(key);
+      }
+      break;
+    }
+    case pb::raft::DELETERANGE: {
+      auto row_cache = engine->GetRowCache(req.delete_range().cf_name());
+      if (row_cache == nullptr) {
+        break;
+      }
+      for (const auto &range : req.delete_range().ranges()) {
+        row_cache->EraseRange(range.start_key(), range.end_key());
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
 void PutHandler::Handle(std::shared_ptr<Context> ctx, store::RegionPtr region, std::shared_ptr<RawEngine> engine,
                         const pb::raft::Request &req, store::RegionMetricsPtr region_metrics) {
   butil::Status status;
@@ -53,6 +110,18 @@ void PutHandler::Handle(std::shared_ptr<Context> ctx, store::RegionPtr region, s
     status = writer->KvBatchPut(Helper::PbRepeatedToVector(request.kvs()));
   }
 
+  // Row cache follow the applied index
+  if (status.ok()) {
+    auto row_cache = engine->GetRowCache(request.cf_name());
+    if (row_cache != nullptr) {
+      for (const auto &kv : request.kvs()) {
+        row_cache->Update(kv.key(), kv.value());
+      }
+    }
+  } else {
+    InvalidateRowCache(engine, req);
+  }
+
   if (ctx) {
     ctx->SetStatus(status);
   }
@@ -92,6 +161,8 @@ void PutIfAbsentHandler::Handle(std::shared_ptr<Context> ctx, store::RegionPtr r
     status = writer->KvBatchPutIfAbsent(Helper::PbRepeatedToVector(request.kvs()), key_states, request.is_atomic());
   }
 
+  InvalidateRowCache(engine, req);
+
   if (ctx) {
     ctx->SetStatus(status);
     if (is_write_batch) {
@@ -147,6 +218,8 @@ void CompareAndSetHandler::Handle(std::shared_ptr<Context> ctx, store::RegionPtr
                                         Helper::PbRepeatedToVector(request.expect_values()), key_states,
                                         request.is_atomic());
 
+  InvalidateRowCache(engine, req);
+
   if (ctx) {
     ctx->SetStatus(status);
     if (is_write_batch) {
@@ -217,7 +290,15 @@ void DeleteRangeHandler::Handle(std::shared_ptr<Context> ctx, store::RegionPtr r
   auto reader = engine->NewReader(request.cf_name());
   auto writer = engine->NewWriter(request.cf_name());
   uint64_t delete_count = 0;
-  if (1 == request.ranges().size()) {
+  if (request.delete_files_in_range()) {
+    // Count is not needed, skip the scan of the ranges
+    for (const auto &range : request.ranges()) {
+      status = writer->KvDeleteRange(range, true);
+      if (!status.ok()) {
+        break;
+      }
+    }
+  } else if (1 == request.ranges().size()) {
     uint64_t internal_delete_count = 0;
     const auto &range = request.ranges()[0];
     status = reader->KvCount(range.start_key(), range.end_key(), internal_delete_count);
@@ -242,6 +323,8 @@ void DeleteRangeHandler::Handle(std::shared_ptr<Context> ctx, store::RegionPtr r
     }
   }
 
+  InvalidateRowCache(engine, req);
+
   if (ctx && ctx->Response()) {
     auto *response = dynamic_cast<pb::store::KvDeleteRangeResponse *>(ctx->Response());
     if (response) {
@@ -295,6 +378,8 @@ void DeleteBatchHandler::Handle(std::shared_ptr<Context> ctx, store::RegionPtr r
     status = writer->KvBatchDelete(Helper::PbRepeatedToVector(request.keys()));
   }
 
+  InvalidateRowCache(engine, req);
+
   if (ctx && ctx->Response()) {
     auto *response = dynamic_cast<pb::store::KvBatchDeleteResponse *>(ctx->Response());
     ctx->SetStatus(status);
@@ -390,6 +475,11 @@ void SplitHandler::Handle(std::shared_ptr<Context>, store::RegionPtr from_region
   }
 }
 
+void HibernateHandler::Handle(std::shared_ptr<Context>, store::RegionPtr region, std::shared_ptr<RawEngine>,
+                              const pb::raft::Request &, store::RegionMetricsPtr) {
+  DINGO_LOG(DEBUG) << fmt::format("region {} apply hibernate", region->Id());
+}
+
 std::shared_ptr<HandlerCollection> RaftApplyHandlerFactory::Build() {
   auto handler_collection = std::make_shared<HandlerCollection>();
   handler_collection->Register(std::make_shared<PutHandler>());
@@ -398,6 +488,7 @@ std::shared_ptr<HandlerCollection> RaftApplyHandlerFactory::Build() {
   handler_collection->Register(std::make_shared<DeleteBatchHandler>());
   handler_collection->Register(std::make_shared<SplitHandler>());
   handler_collection->Register(std::make_shared<CompareAndSetHandler>());
+  handler_collection->Register(std::make_shared<HibernateHandler>());
 
   return handler_collection;
 }
@@ -23,6 +23,9 @@
 
 namespace dingodb {
 
+// Erase the rows written by the request from row cache of the engine.
+void InvalidateRowCache(std::shared_ptr<RawEngine> engine, const pb::raft::Request &req);
+
 // PutRequest
 class PutHandler : public BaseHandler {
  public:
@@ -83,6 +86,15 @@ class SplitHandler : public BaseHandler {
               const pb::raft::Request &req, store::RegionMetricsPtr region_metrics) override;
 };
 
+// HibernateHandler
+// Nothing to write, state machine notify raft node to stop election timer.
+class HibernateHandler : public BaseHandler {
+ public:
+  HandlerType GetType() override { return HandlerType::kHibernate; }
+  void Handle(std::shared_ptr<Context> ctx, store::RegionPtr region, std::shared_ptr<RawEngine> engine,
+              const pb::raft::Request &req, store::RegionMetricsPtr region_metrics) override;
+};
+
 class RaftApplyHandlerFactory : public HandlerFactory {
  public:
   std::shared_ptr<HandlerCollection> Build() override;
@@ -48,6 +48,7 @@ butil::Status RaftSnapshot::GenSnapshotFileByScan(const std::string& checkpoint_
   auto range = region->Range();
   // Build Iterator
   IteratorOptions options;
+  options.lower_bound = range.start_key();
   options.upper_bound = range.end_key();
 
   auto iter = raw_engine->NewIterator(Constant::kStoreDataCF, engine_snapshot_, options);
@@ -169,6 +170,11 @@ bool RaftSnapshot::LoadSnapshot(braft::SnapshotReader* reader, store::RegionPtr
   if (!status.ok()) {
     return false;
   }
+  // Not found is not cached, so rows ingested later need no invalidation
+  auto row_cache = engine_->GetRowCache(Constant::kStoreDataCF);
+  if (row_cache != nullptr) {
+    row_cache->EraseRange(region->Range().start_key(), region->Range().end_key());
+  }
 
   bool has_temp_file = false;
   // Ingest sst to region
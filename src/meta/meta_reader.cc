@@ -60,11 +60,19 @@ bool MetaReader::Scan(std::shared_ptr<Snapshot> snapshot, const std::string& pre
                       std::vector<pb::common::KeyValue>& kvs) {
   auto reader = engine_->NewReader(Constant::kStoreMetaCF);
   const std::string prefix_next = Helper::PrefixNext(prefix);
+  auto visitor = [&kvs](std::string_view key, std::string_view value) -> bool {
+    pb::common::KeyValue kv;
+    kv.set_key(key.data(), key.size());
+    kv.set_value(value.data(), value.size());
+    kvs.emplace_back(std::move(kv));
+    return true;
+  };
+
   butil::Status status;
   if (snapshot) {
-    status = reader->KvScan(snapshot, prefix, prefix_next, kvs);
+    status = reader->KvScan(snapshot, prefix, prefix_next, 0, 0, visitor);
   } else {
-    status = reader->KvScan(prefix, prefix_next, kvs);
+    status = reader->KvScan(prefix, prefix_next, 0, 0, visitor);
   }
   if (!status.ok()) {
     DINGO_LOG(ERROR) << "Meta scan failed, errcode: " << status.error_code() << " " << status.error_str();
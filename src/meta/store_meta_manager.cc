@@ -179,6 +179,8 @@ void StoreRegionMeta::AddRegion(store::RegionPtr region) {
   if (meta_writer_ != nullptr) {
     meta_writer_->Put(TransformToKv(&region));
   }
+
+  NotifyRanges();
 }
 
 void StoreRegionMeta::DeleteRegion(uint64_t region_id) {
@@ -187,6 +189,8 @@ void StoreRegionMeta::DeleteRegion(uint64_t region_id) {
   if (meta_writer_ != nullptr) {
     meta_writer_->Delete(GenKey(region_id));
   }
+
+  NotifyRanges();
 }
 
 void StoreRegionMeta::UpdateRegion(store::RegionPtr region) {
@@ -195,6 +199,8 @@ void StoreRegionMeta::UpdateRegion(store::RegionPtr region) {
   if (meta_writer_ != nullptr) {
     meta_writer_->Put(TransformToKv(&region));
   }
+
+  NotifyRanges();
 }
 
 void StoreRegionMeta::UpdateState(store::RegionPtr region, pb::common::StoreRegionState new_state) {
@@ -257,6 +263,10 @@ void StoreRegionMeta::UpdateState(store::RegionPtr region, pb::common::StoreRegi
                                         region->Id(), pb::common::StoreRegionState_Name(cur_state),
                                         pb::common::StoreRegionState_Name(new_state));
     }
+
+    if (new_state == pb::common::StoreRegionState::DELETED) {
+      NotifyRanges();
+    }
   }
 
   DINGO_LOG(DEBUG) << fmt::format("Update region state {} {} to {} {}", region->Id(),
@@ -292,6 +302,8 @@ void StoreRegionMeta::UpdateRange(store::RegionPtr region, const pb::common::Ran
   assert(region != nullptr);
   region->SetRange(range);
   meta_writer_->Put(TransformToKv(&region));
+
+  NotifyRanges();
 }
 
 void StoreRegionMeta::UpdateRange(uint64_t region_id, const pb::common::Range& range) {
@@ -352,6 +364,27 @@ std::vector<store::RegionPtr> StoreRegionMeta::GetAllMetricsRegion() {
   return regions;
 }
 
+void StoreRegionMeta::SetRangesListener(RangesListener listener) {
+  {
+    BAIDU_SCOPED_LOCK(ranges_mutex_);
+    ranges_listener_ = listener;
+  }
+  NotifyRanges();
+}
+
+void StoreRegionMeta::NotifyRanges() {
+  BAIDU_SCOPED_LOCK(ranges_mutex_);
+  if (ranges_listener_ == nullptr) {
+    return;
+  }
+
+  std::vector<pb::common::Range> ranges;
+  for (const auto& region : GetAllAliveRegion()) {
+    ranges.push_back(region->Range());
+  }
+  ranges_listener_(ranges);
+}
+
 std::shared_ptr<pb::common::KeyValue> StoreRegionMeta::TransformToKv(void* obj) {
   auto region = *static_cast<store::RegionPtr*>(obj);
   auto kv = std::make_shared<pb::common::KeyValue>();
@@ -18,6 +18,7 @@
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <shared_mutex>
 #include <string>
@@ -114,8 +115,9 @@ class StoreRegionMeta : public TransformKvAble {
   StoreRegionMeta(std::shared_ptr<MetaReader> meta_reader, std::shared_ptr<MetaWriter> meta_writer)
       : TransformKvAble(Constant::kStoreRegionMetaPrefix), meta_reader_(meta_reader), meta_writer_(meta_writer) {
     regions_.Init(Constant::kStoreRegionMetaInitCapacity);
+    bthread_mutex_init(&ranges_mutex_, nullptr);
   }
-  ~StoreRegionMeta() override = default;
+  ~StoreRegionMeta() override { bthread_mutex_destroy(&ranges_mutex_); }
 
   StoreRegionMeta(const StoreRegionMeta&) = delete;
   void operator=(const StoreRegionMeta&) = delete;
@@ -146,10 +148,16 @@ class StoreRegionMeta : public TransformKvAble {
   std::vector<store::RegionPtr> GetAllAliveRegion();
   std::vector<store::RegionPtr> GetAllMetricsRegion();
 
+  // Called with ranges of all alive regions, once set and after region add/delete or range/state change.
+  using RangesListener = std::function<void(const std::vector<pb::common::Range>&)>;
+  void SetRangesListener(RangesListener listener);
+
  private:
   std::shared_ptr<pb::common::KeyValue> TransformToKv(void* obj) override;
   void TransformFromKv(const std::vector<pb::common::KeyValue>& kvs) override;
 
+  void NotifyRanges();
+
   // Read meta data from persistence storage.
   std::shared_ptr<MetaReader> meta_reader_;
   // Write meta data to persistence storage.
@@ -158,6 +166,10 @@ class StoreRegionMeta : public TransformKvAble {
   // Store all region meta data in this server.
   using RegionMap = DingoSafeMap<uint64_t, store::RegionPtr>;
   RegionMap regions_;
+
+  // Serialize the notify, so the last notified ranges are the latest.
+  bthread_mutex_t ranges_mutex_;
+  RangesListener ranges_listener_;
 };
 
 class StoreRaftMeta : public TransformKvAble {
@@ -179,6 +191,8 @@ class StoreRaftMeta : public TransformKvAble {
 
   void AddRaftMeta(RaftMetaPtr raft_meta);
   void UpdateRaftMeta(RaftMetaPtr raft_meta);
+  // Raft meta kv, for writing raft meta together with data.
+  std::shared_ptr<pb::common::KeyValue> GenRaftMetaKv(RaftMetaPtr raft_meta) { return TransformToKv(&raft_meta); }
   void DeleteRaftMeta(uint64_t region_id);
   RaftMetaPtr GetRaftMeta(uint64_t region_id);
   std::vector<RaftMetaPtr> GetAllRaftMeta();
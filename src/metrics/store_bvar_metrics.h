@@ -18,6 +18,7 @@
 #include <string>
 
 #include "bvar/bvar.h"
+#include "bvar/latency_recorder.h"
 #include "bvar/multi_dimension.h"
 #include "bvar/reducer.h"
 #include "bvar/status.h"
@@ -32,7 +33,13 @@ class StoreBvarMetrics {
       : leader_switch_time_("dingo_metrics_store_raft_leader_switch_time", {"region"}),
         leader_switch_count_("dingo_metrics_store_raft_leader_switch_count", {"region"}),
         commit_count_per_second_("dingo_metrics_store_raft_commit_count_per_second", {"region"}),
-        apply_count_per_second_("dingo_metrics_store_raft_apply_count_per_second", {"region"}) {}
+        apply_count_per_second_("dingo_metrics_store_raft_apply_count_per_second", {"region"}),
+        lease_read_count_("dingo_metrics_store_raft_lease_read_count", {"region"}),
+        read_index_count_("dingo_metrics_store_raft_read_index_count", {"region"}),
+        follower_read_count_("dingo_metrics_store_raft_follower_read_count", {"region"}),
+        follower_read_latency_("dingo_metrics_store_raft_follower_read_latency", {"region"}),
+        stale_read_count_("dingo_metrics_store_raft_stale_read_count", {"region"}),
+        early_ack_count_("dingo_metrics_store_raft_early_ack_count", {"region"}) {}
   ~StoreBvarMetrics() = default;
 
   StoreBvarMetrics(const StoreBvarMetrics&) = delete;
@@ -68,11 +75,60 @@ class StoreBvarMetrics {
     }
   }
 
+  void IncLeaseReadCount(std::string region_id) {
+    auto* region_stat = lease_read_count_.get_stats({region_id});
+    if (region_stat != nullptr) {
+      *region_stat << 1;
+    }
+  }
+
+  void IncReadIndexCount(std::string region_id) {
+    auto* region_stat = read_index_count_.get_stats({region_id});
+    if (region_stat != nullptr) {
+      *region_stat << 1;
+    }
+  }
+
+  void IncFollowerReadCount(std::string region_id) {
+    auto* region_stat = follower_read_count_.get_stats({region_id});
+    if (region_stat != nullptr) {
+      *region_stat << 1;
+    }
+  }
+
+  void IncStaleReadCount(std::string region_id) {
+    auto* region_stat = stale_read_count_.get_stats({region_id});
+    if (region_stat != nullptr) {
+      *region_stat << 1;
+    }
+  }
+
+  void IncEarlyAckCount(std::string region_id) {
+    auto* region_stat = early_ack_count_.get_stats({region_id});
+    if (region_stat != nullptr) {
+      *region_stat << 1;
+    }
+  }
+
+  // Latency of get read index and wait applied, unit ms.
+  void UpdateFollowerReadLatency(std::string region_id, uint64_t value) {
+    auto* region_stat = follower_read_latency_.get_stats({region_id});
+    if (region_stat != nullptr) {
+      *region_stat << value;
+    }
+  }
+
  private:
   bvar::MultiDimension<bvar::Status<uint64_t>> leader_switch_time_;
   bvar::MultiDimension<bvar::Status<uint64_t>> leader_switch_count_;
   bvar::MultiDimension<bvar::PerSecondEx<bvar::Adder<uint64_t>>> commit_count_per_second_;
   bvar::MultiDimension<bvar::PerSecondEx<bvar::Adder<uint64_t>>> apply_count_per_second_;
+  bvar::MultiDimension<bvar::Adder<uint64_t>> lease_read_count_;
+  bvar::MultiDimension<bvar::Adder<uint64_t>> read_index_count_;
+  bvar::MultiDimension<bvar::Adder<uint64_t>> follower_read_count_;
+  bvar::MultiDimension<bvar::LatencyRecorder> follower_read_latency_;
+  bvar::MultiDimension<bvar::Adder<uint64_t>> stale_read_count_;
+  bvar::MultiDimension<bvar::Adder<uint64_t>> early_ack_count_;
 };
 
 }  // namespace dingodb
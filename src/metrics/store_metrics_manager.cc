@@ -24,6 +24,7 @@
 #include "common/helper.h"
 #include "common/logging.h"
 #include "config/config_manager.h"
+#include "engine/raft_kv_engine.h"
 #include "fmt/core.h"
 #include "proto/common.pb.h"
 #include "server/server.h"
@@ -112,6 +113,7 @@ std::string StoreRegionMetrics::GetRegionMinKey(store::RegionPtr region) {
                                  Helper::StringToHex(region->Range().start_key()),
                                  Helper::StringToHex(region->Range().end_key()));
   IteratorOptions options;
+  options.lower_bound = region->Range().start_key();
   options.upper_bound = region->Range().end_key();
   auto iter = raw_engine_->NewIterator(Constant::kStoreDataCF, options);
   iter->Seek(region->Range().start_key());
@@ -130,8 +132,9 @@ std::string StoreRegionMetrics::GetRegionMaxKey(store::RegionPtr region) {
                                  Helper::StringToHex(region->Range().end_key()));
   IteratorOptions options;
   options.lower_bound = region->Range().start_key();
+  options.upper_bound = region->Range().end_key();
   auto iter = raw_engine_->NewIterator(Constant::kStoreDataCF, options);
-  iter->SeekForPrev(region->Range().end_key());
+  iter->SeekToLast();
 
   if (!iter->Valid()) {
     return "";
@@ -164,9 +167,21 @@ bool StoreRegionMetrics::CollectMetrics() {
   auto store_region_meta = Server::GetInstance()->GetStoreMetaManager()->GetStoreRegionMeta();
   auto store_raft_meta = Server::GetInstance()->GetStoreMetaManager()->GetStoreRaftMeta();
   auto region_metricses = GetAllMetrics();
+  auto engine = Server::GetInstance()->GetEngine();
+  auto raft_kv_engine = (engine != nullptr && engine->GetID() == pb::common::ENG_RAFT_STORE)
+                            ? std::dynamic_pointer_cast<RaftKvEngine>(engine)
+                            : nullptr;
 
   std::vector<store::RegionPtr> need_collect_regions;
   for (const auto& region_metrics : region_metricses) {
+    // Hibernated region has no write, its metrics is unchanged.
+    if (raft_kv_engine != nullptr) {
+      auto raft_node = raft_kv_engine->GetNode(region_metrics->Id());
+      if (raft_node != nullptr && raft_node->IsHibernated()) {
+        continue;
+      }
+    }
+
     auto raft_meta = store_raft_meta->GetRaftMeta(region_metrics->Id());
     if (raft_meta == nullptr) {
       continue;
@@ -0,0 +1,408 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "raft/raft_log_storage.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "braft/configuration_manager.h"
+#include "common/logging.h"
+#include "fmt/core.h"
+#include "gflags/gflags.h"
+#include "rocksdb/iterator.h"
+#include "rocksdb/options.h"
+#include "rocksdb/table.h"
+#include "rocksdb/write_batch.h"
+
+namespace braft {
+DECLARE_bool(raft_sync);
+}  // namespace braft
+
+namespace dingodb {
+
+const std::string kRaftLogStorageProtocol = "dingo";
+
+// Key prefix of log engine
+const char kLogEntryPrefix = 'l';
+const char kConfEntryPrefix = 'c';
+const char kFirstLogIndexPrefix = 'm';
+
+static std::shared_ptr<rocksdb::DB> shared_log_db;
+
+static void EncodeInt64(std::string& buf, uint64_t value) {
+  for (int i = 7; i >= 0; --i) {
+    buf.push_back(static_cast<char>((value >> (i * 8)) & 0xFF));
+  }
+}
+
+static uint64_t DecodeInt64(const char* buf) {
+  uint64_t value = 0;
+  for (int i = 0; i < 8; ++i) {
+    value = (value << 8) | static_cast<uint8_t>(buf[i]);
+  }
+  return value;
+}
+
+static std::string GenKey(char prefix, uint64_t region_id, int64_t index) {
+  std::string key;
+  key.reserve(17);
+  key.push_back(prefix);
+  EncodeInt64(key, region_id);
+  EncodeInt64(key, static_cast<uint64_t>(index));
+  return key;
+}
+
+static std::string GenFirstLogIndexKey(uint64_t region_id) {
+  std::string key;
+  key.reserve(9);
+  key.push_back(kFirstLogIndexPrefix);
+  EncodeInt64(key, region_id);
+  return key;
+}
+
+static int64_t ParseIndex(const rocksdb::Slice& key) { return static_cast<int64_t>(DecodeInt64(key.data() + 9)); }
+
+static bool IsRegionKey(const rocksdb::Slice& key, char prefix, uint64_t region_id) {
+  return key.size() == 17 && key[0] == prefix && DecodeInt64(key.data() + 1) == region_id;
+}
+
+static bool ParseRegionId(const std::string& uri, uint64_t& region_id) {
+  char* end = nullptr;
+  region_id = std::strtoull(uri.c_str(), &end, 10);
+  return !uri.empty() && end != nullptr && *end == '\0';
+}
+
+// Log entry value: type(1 byte) + term(8 bytes) + data or configuration meta.
+static bool EncodeEntry(const braft::LogEntry* entry, std::string& value) {
+  value.reserve(9 + entry->data.size());
+  value.push_back(static_cast<char>(entry->type));
+  EncodeInt64(value, static_cast<uint64_t>(entry->id.term));
+
+  if (entry->type == braft::ENTRY_TYPE_CONFIGURATION) {
+    butil::IOBuf data;
+    auto status = braft::serialize_configuration_meta(entry, data);
+    if (!status.ok()) {
+      DINGO_LOG(ERROR) << fmt::format("Serialize configuration meta failed, index {} error {}", entry->id.index,
+                                      status.error_cstr());
+      return false;
+    }
+    data.append_to(&value);
+  } else {
+    entry->data.append_to(&value);
+  }
+
+  return true;
+}
+
+static braft::LogEntry* DecodeEntry(int64_t index, const std::string& value) {
+  if (value.size() < 9) {
+    return nullptr;
+  }
+
+  braft::LogEntry* entry = new braft::LogEntry();
+  entry->AddRef();
+  entry->type = static_cast<braft::EntryType>(value[0]);
+  entry->id = braft::LogId(index, static_cast<int64_t>(DecodeInt64(value.data() + 1)));
+
+  butil::IOBuf data;
+  data.append(value.data() + 9, value.size() - 9);
+  if (entry->type == braft::ENTRY_TYPE_CONFIGURATION) {
+    auto status = braft::parse_configuration_meta(data, entry);
+    if (!status.ok()) {
+      DINGO_LOG(ERROR) << fmt::format("Parse configuration meta failed, index {} error {}", index,
+                                      status.error_cstr());
+      entry->Release();
+      return nullptr;
+    }
+  } else {
+    entry->data.swap(data);
+  }
+
+  return entry;
+}
+
+RaftLogStorage::RaftLogStorage(std::shared_ptr<rocksdb::DB> db, uint64_t region_id)
+    : db_(db), region_id_(region_id), first_log_index_(1), last_log_index_(0) {}
+
+bool RaftLogStorage::Init(const std::string& path, std::shared_ptr<rocksdb::Cache> block_cache,
+                          std::shared_ptr<rocksdb::WriteBufferManager> write_buffer_manager) {
+  static std::once_flag once;
+  static bool is_success = false;
+  std::call_once(once, [&path, &block_cache, &write_buffer_manager]() {
+    std::error_code ec;
+    std::filesystem::create_directories(path, ec);
+
+    rocksdb::Options options;
+    options.create_if_missing = true;
+    // Concurrent appends of regions share one wal write and fsync.
+    options.enable_pipelined_write = true;
+    options.write_buffer_size = 64 * 1024 * 1024;
+    options.max_write_buffer_number = 4;
+    // Share the memory budget of data engine, else rocksdb create its own block cache.
+    if (block_cache != nullptr) {
+      rocksdb::BlockBasedTableOptions table_options;
+      table_options.block_cache = block_cache;
+      options.table_factory.reset(rocksdb::NewBlockBasedTableFactory(table_options));
+    }
+    options.write_buffer_manager = write_buffer_manager;
+
+    rocksdb::DB* db = nullptr;
+    auto status = rocksdb::DB::Open(options, path, &db);
+    if (!status.ok()) {
+      DINGO_LOG(ERROR) << fmt::format("Open raft log engine failed, path {} error {}", path, status.ToString());
+      return;
+    }
+    shared_log_db.reset(db);
+
+    // Prototype of log storage, braft create instance by new_instance.
+    static RaftLogStorage prototype(shared_log_db, 0);
+    braft::log_storage_extension()->RegisterOrDie(kRaftLogStorageProtocol.c_str(), &prototype);
+    is_success = true;
+
+    DINGO_LOG(INFO) << fmt::format("Init raft log engine, path {}", path);
+  });
+
+  return is_success;
+}
+
+bool RaftLogStorage::IsInited() { return shared_log_db != nullptr; }
+
+std::string RaftLogStorage::GenUri(uint64_t region_id) {
+  return fmt::format("{}://{}", kRaftLogStorageProtocol, region_id);
+}
+
+int RaftLogStorage::init(braft::ConfigurationManager* configuration_manager) {
+  std::string value;
+  auto status = db_->Get(rocksdb::ReadOptions(), GenFirstLogIndexKey(region_id_), &value);
+  if (status.ok() && value.size() == 8) {
+    first_log_index_.store(static_cast<int64_t>(DecodeInt64(value.data())));
+  } else if (!status.IsNotFound()) {
+    DINGO_LOG(ERROR) << fmt::format("Get first log index failed, region {} error {}", region_id_, status.ToString());
+    return -1;
+  }
+
+  std::unique_ptr<rocksdb::Iterator> iter(db_->NewIterator(rocksdb::ReadOptions()));
+  iter->SeekForPrev(GenKey(kLogEntryPrefix, region_id_, std::numeric_limits<int64_t>::max()));
+  if (iter->Valid() && IsRegionKey(iter->key(), kLogEntryPrefix, region_id_)) {
+    last_log_index_.store(ParseIndex(iter->key()));
+  } else {
+    last_log_index_.store(first_log_index_.load() - 1);
+  }
+
+  // Load configuration entries of the region.
+  for (iter->Seek(GenKey(kConfEntryPrefix, region_id_, first_log_index_.load()));
+       iter->Valid() && IsRegionKey(iter->key(), kConfEntryPrefix, region_id_); iter->Next()) {
+    int64_t const index = ParseIndex(iter->key());
+    if (index > last_log_index_.load()) {
+      break;
+    }
+
+    braft::LogEntry* entry = DecodeEntry(index, iter->value().ToString());
+    if (entry == nullptr) {
+      return -1;
+    }
+    braft::ConfigurationEntry conf_entry(*entry);
+    configuration_manager->add(conf_entry);
+    entry->Release();
+  }
+
+  DINGO_LOG(INFO) << fmt::format("Init raft log storage, region {} log index [{}, {}]", region_id_,
+                                 first_log_index_.load(), last_log_index_.load());
+  return 0;
+}
+
+bool RaftLogStorage::GetValue(int64_t index, std::string& value) {
+  if (index < first_log_index() || index > last_log_index()) {
+    return false;
+  }
+
+  auto status = db_->Get(rocksdb::ReadOptions(), GenKey(kLogEntryPrefix, region_id_, index), &value);
+  if (!status.ok()) {
+    if (!status.IsNotFound()) {
+      DINGO_LOG(ERROR) << fmt::format("Get log entry failed, region {} index {} error {}", region_id_, index,
+                                      status.ToString());
+    }
+    return false;
+  }
+
+  return true;
+}
+
+braft::LogEntry* RaftLogStorage::get_entry(const int64_t index) {
+  std::string value;
+  if (!GetValue(index, value)) {
+    return nullptr;
+  }
+
+  return DecodeEntry(index, value);
+}
+
+int64_t RaftLogStorage::get_term(const int64_t index) {
+  std::string value;
+  if (!GetValue(index, value) || value.size() < 9) {
+    return 0;
+  }
+
+  return static_cast<int64_t>(DecodeInt64(value.data() + 1));
+}
+
+int RaftLogStorage::append_entry(const braft::LogEntry* entry) {
+  std::vector<braft::LogEntry*> entries = {const_cast<braft::LogEntry*>(entry)};
+  return append_entries(entries, nullptr) == 1 ? 0 : -1;
+}
+
+int RaftLogStorage::append_entries(const std::vector<braft::LogEntry*>& entries, braft::IOMetric* /*metric*/) {
+  if (entries.empty()) {
+    return 0;
+  }
+  if (entries.front()->id.index != last_log_index() + 1) {
+    DINGO_LOG(ERROR) << fmt::format("Append log entry discontinuous, region {} last_log_index {} append index {}",
+                                    region_id_, last_log_index(), entries.front()->id.index);
+    return -1;
+  }
+
+  rocksdb::WriteBatch batch;
+  for (const auto* entry : entries) {
+    std::string value;
+    if (!EncodeEntry(entry, value)) {
+      return -1;
+    }
+    if (entry->type == braft::ENTRY_TYPE_CONFIGURATION) {
+      batch.Put(GenKey(kConfEntryPrefix, region_id_, entry->id.index), value);
+    }
+    batch.Put(GenKey(kLogEntryPrefix, region_id_, entry->id.index), value);
+  }
+
+  rocksdb::WriteOptions write_options;
+  write_options.sync = braft::FLAGS_raft_sync;
+  auto status = db_->Write(write_options, &batch);
+  if (!status.ok()) {
+    DINGO_LOG(ERROR) << fmt::format("Append log entry failed, region {} error {}", region_id_, status.ToString());
+    return -1;
+  }
+
+  last_log_index_.store(entries.back()->id.index, std::memory_order_release);
+  return static_cast<int>(entries.size());
+}
+
+bool RaftLogStorage::DeleteRange(int64_t start_index, int64_t end_index, int64_t first_log_index) {
+  rocksdb::WriteBatch batch;
+  if (start_index < end_index) {
+    batch.DeleteRange(GenKey(kLogEntryPrefix, region_id_, start_index), GenKey(kLogEntryPrefix, region_id_, end_index));
+    batch.DeleteRange(GenKey(kConfEntryPrefix, region_id_, start_index),
+                      GenKey(kConfEntryPrefix, region_id_, end_index));
+  }
+  std::string value;
+  EncodeInt64(value, static_cast<uint64_t>(first_log_index));
+  batch.Put(GenFirstLogIndexKey(region_id_), value);
+
+  rocksdb::WriteOptions write_options;
+  write_options.sync = braft::FLAGS_raft_sync;
+  auto status = db_->Write(write_options, &batch);
+  if (!status.ok()) {
+    DINGO_LOG(ERROR) << fmt::format("Delete log entry [{}, {}) failed, region {} error {}", start_index, end_index,
+                                    region_id_, status.ToString());
+    return false;
+  }
+
+  return true;
+}
+
+int RaftLogStorage::truncate_prefix(const int64_t first_index_kept) {
+  int64_t const first_index = first_log_index();
+  if (first_index_kept <= first_index) {
+    return 0;
+  }
+
+  if (!DeleteRange(first_index, first_index_kept, first_index_kept)) {
+    return -1;
+  }
+
+  first_log_index_.store(first_index_kept, std::memory_order_release);
+  if (last_log_index() < first_index_kept - 1) {
+    last_log_index_.store(first_index_kept - 1, std::memory_order_release);
+  }
+
+  return 0;
+}
+
+int RaftLogStorage::truncate_suffix(const int64_t last_index_kept) {
+  int64_t const last_index = last_log_index();
+  if (last_index_kept >= last_index) {
+    return 0;
+  }
+
+  if (!DeleteRange(last_index_kept + 1, last_index + 1, first_log_index())) {
+    return -1;
+  }
+
+  last_log_index_.store(last_index_kept, std::memory_order_release);
+  return 0;
+}
+
+int RaftLogStorage::reset(const int64_t next_log_index) {
+  if (next_log_index <= 0) {
+    DINGO_LOG(ERROR) << fmt::format("Reset log storage invalid next_log_index {}, region {}", next_log_index,
+                                    region_id_);
+    return -1;
+  }
+
+  if (!DeleteRange(0, std::numeric_limits<int64_t>::max(), next_log_index)) {
+    return -1;
+  }
+
+  first_log_index_.store(next_log_index, std::memory_order_release);
+  last_log_index_.store(next_log_index - 1, std::memory_order_release);
+  return 0;
+}
+
+braft::LogStorage* RaftLogStorage::new_instance(const std::string& uri) const {
+  uint64_t region_id = 0;
+  if (!ParseRegionId(uri, region_id)) {
+    DINGO_LOG(ERROR) << fmt::format("Invalid raft log storage uri {}", uri);
+    return nullptr;
+  }
+
+  return new RaftLogStorage(db_, region_id);
+}
+
+butil::Status RaftLogStorage::gc_instance(const std::string& uri) const {
+  uint64_t region_id = 0;
+  if (!ParseRegionId(uri, region_id)) {
+    return butil::Status(EINVAL, "Invalid raft log storage uri %s", uri.c_str());
+  }
+
+  rocksdb::WriteBatch batch;
+  batch.DeleteRange(GenKey(kLogEntryPrefix, region_id, 0),
+                    GenKey(kLogEntryPrefix, region_id, std::numeric_limits<int64_t>::max()));
+  batch.DeleteRange(GenKey(kConfEntryPrefix, region_id, 0),
+                    GenKey(kConfEntryPrefix, region_id, std::numeric_limits<int64_t>::max()));
+  batch.Delete(GenFirstLogIndexKey(region_id));
+  auto status = db_->Write(rocksdb::WriteOptions(), &batch);
+  if (!status.ok()) {
+    return butil::Status(EIO, "Delete raft log failed, %s", status.ToString().c_str());
+  }
+
+  DINGO_LOG(INFO) << fmt::format("Gc raft log storage, region {}", region_id);
+  return butil::Status();
+}
+
+}  // namespace dingodb
@@ -0,0 +1,84 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DINGODB_RAFT_LOG_STORAGE_H_
+#define DINGODB_RAFT_LOG_STORAGE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "braft/log_entry.h"
+#include "braft/storage.h"
+#include "butil/status.h"
+#include "rocksdb/cache.h"
+#include "rocksdb/db.h"
+#include "rocksdb/write_buffer_manager.h"
+
+namespace dingodb {
+
+// Multi raft log storage, all regions of the store share one log engine.
+// The log engine is a rocksdb without data column family, its wal is the append-only log
+// of all regions, so concurrent appends of regions are merged into one wal write and fsync.
+// Key is region_id + log_index, the memtable and sst is the per-region index.
+// Truncate prefix only delete the range of the region, compaction reclaim space.
+// Usage: raft log uri is dingo://{region_id}
+class RaftLogStorage : public braft::LogStorage {
+ public:
+  RaftLogStorage(std::shared_ptr<rocksdb::DB> db, uint64_t region_id);
+  ~RaftLogStorage() override = default;
+
+  // Open the shared log engine and register log storage extension, only once.
+  // The block cache and memtables are charged to the store memory budget of data engine when given.
+  static bool Init(const std::string& path, std::shared_ptr<rocksdb::Cache> block_cache = nullptr,
+                   std::shared_ptr<rocksdb::WriteBufferManager> write_buffer_manager = nullptr);
+  static bool IsInited();
+  static std::string GenUri(uint64_t region_id);
+
+  int init(braft::ConfigurationManager* configuration_manager) override;
+
+  int64_t first_log_index() override { return first_log_index_.load(std::memory_order_acquire); }
+  int64_t last_log_index() override { return last_log_index_.load(std::memory_order_acquire); }
+
+  braft::LogEntry* get_entry(const int64_t index) override;
+  int64_t get_term(const int64_t index) override;
+
+  int append_entry(const braft::LogEntry* entry) override;
+  int append_entries(const std::vector<braft::LogEntry*>& entries, braft::IOMetric* metric) override;
+
+  int truncate_prefix(const int64_t first_index_kept) override;
+  int truncate_suffix(const int64_t last_index_kept) override;
+  int reset(const int64_t next_log_index) override;
+
+  braft::LogStorage* new_instance(const std::string& uri) const override;
+  butil::Status gc_instance(const std::string& uri) const override;
+
+ private:
+  // Get log entry value, return false when not found.
+  bool GetValue(int64_t index, std::string& value);
+  // Delete log entries [start_index, end_index) and save first log index in one write.
+  bool DeleteRange(int64_t start_index, int64_t end_index, int64_t first_log_index);
+
+  std::shared_ptr<rocksdb::DB> db_;
+  uint64_t region_id_;
+
+  std::atomic<int64_t> first_log_index_;
+  std::atomic<int64_t> last_log_index_;
+};
+
+}  // namespace dingodb
+
+#endif  // DINGODB_RAFT_LOG_STORAGE_H_
@@ -14,21 +14,30 @@
 
 #include "raft/raft_node.h"
 
+#include <algorithm>
 #include <filesystem>
 #include <memory>
 #include <string>
 #include <utility>
 
+#include "butil/scoped_lock.h"
+#include "common/constant.h"
 #include "common/failpoint.h"
 #include "common/helper.h"
 #include "common/logging.h"
 #include "config/config_manager.h"
 #include "fmt/core.h"
+#include "gflags/gflags.h"
 #include "metrics/store_bvar_metrics.h"
 #include "proto/common.pb.h"
+#include "raft/raft_log_storage.h"
 #include "raft/store_state_machine.h"
 #include "server/server.h"
 
+namespace braft {
+DECLARE_int32(raft_election_heartbeat_factor);
+}  // namespace braft
+
 namespace dingodb {
 
 RaftNode::RaftNode(uint64_t node_id, const std::string& raft_group_name, braft::PeerId peer_id,
@@ -37,9 +46,25 @@ RaftNode::RaftNode(uint64_t node_id, const std::string& raft_group_name, braft::
       str_node_id_(std::to_string(node_id)),
       raft_group_name_(raft_group_name),
       node_(new braft::Node(raft_group_name, peer_id)),
-      fsm_(fsm) {}
+      fsm_(fsm),
+      election_timeout_ms_(0),
+      hibernate_idle_time_ms_(0),
+      hibernate_timeout_factor_(Constant::kRaftHibernateTimeoutFactor),
+      is_hibernated_(false),
+      is_leader_checked_(false),
+      last_active_time_ms_(Helper::TimestampMs()),
+      hibernate_propose_time_ms_(0),
+      hibernate_applied_time_ms_(0),
+      keep_alive_deadline_ms_(0),
+      keep_alive_tid_(INVALID_BTHREAD),
+      is_keep_alive_running_(false),
+      is_stopped_(false) {
+  bthread_mutex_init(&hibernate_mutex_, nullptr);
+}
 
 RaftNode::~RaftNode() {
+  StopKeepAlive();
+  bthread_mutex_destroy(&hibernate_mutex_);
   if (fsm_) {
     delete fsm_;
     fsm_ = nullptr;
@@ -61,21 +86,47 @@ int RaftNode::Init(const std::string& init_conf, std::shared_ptr<Config> config)
   node_options.snapshot_interval_s = config->GetInt("raft.snapshot_interval");
 
   path_ = fmt::format("{}/{}", config->GetString("raft.path"), node_id_);
-  node_options.log_uri = "local://" + path_ + "/log";
+  // All regions share one log engine when it is inited, else one segment log per region.
+  log_uri_ = RaftLogStorage::IsInited() ? RaftLogStorage::GenUri(node_id_) : "local://" + path_ + "/log";
+  node_options.log_uri = log_uri_;
   node_options.raft_meta_uri = "local://" + path_ + "/raft_meta";
   node_options.snapshot_uri = "local://" + path_ + "/snapshot";
   node_options.disable_cli = false;
 
+  election_timeout_ms_ = node_options.election_timeout_ms;
+  hibernate_idle_time_ms_ = std::max(config->GetInt("raft.hibernate_idle_time_ms"), 0);
+  int hibernate_timeout_factor = config->GetInt("raft.hibernate_timeout_factor");
+  if (hibernate_timeout_factor > 1) {
+    hibernate_timeout_factor_ = hibernate_timeout_factor;
+  }
+  auto* fsm = dynamic_cast<StoreStateMachine*>(fsm_);
+  if (hibernate_idle_time_ms_ > 0 && fsm != nullptr) {
+    fsm->SetHibernateListener([this](bool is_hibernate) { OnHibernateApplied(is_hibernate); });
+  }
+
   if (node_->init(node_options) != 0) {
     DINGO_LOG(ERROR) << "Fail to init raft node " << node_id_;
     return -1;
   }
 
+  RaftWriteBatcher::Options batcher_options;
+  int max_batch_count = config->GetInt("raft.group_commit_max_count");
+  int max_batch_bytes = config->GetInt("raft.group_commit_max_bytes");
+  batcher_options.max_batch_count = max_batch_count > 0 ? max_batch_count : Constant::kRaftGroupCommitMaxCount;
+  batcher_options.max_batch_bytes = max_batch_bytes > 0 ? max_batch_bytes : Constant::kRaftGroupCommitMaxBytes;
+  batcher_options.window_us = std::max(config->GetInt("raft.group_commit_window_us"), 0);
+  write_batcher_ = std::make_unique<RaftWriteBatcher>(
+      node_id_, batcher_options,
+      [this](std::vector<std::shared_ptr<Context>>& ctxs, std::shared_ptr<pb::raft::RaftCmdRequest> raft_cmd) {
+        return Commit(ctxs, raft_cmd);
+      });
+
   return 0;
 }
 
 void RaftNode::Stop() {
   DINGO_LOG(DEBUG) << fmt::format("Stop region {} raft node shutdown", node_id_);
+  StopKeepAlive();
   node_->shutdown(nullptr);
   node_->join();
   DINGO_LOG(DEBUG) << fmt::format("Stop region {} finish raft node shutdown", node_id_);
@@ -83,10 +134,19 @@ void RaftNode::Stop() {
 
 void RaftNode::Destroy() {
   DINGO_LOG(DEBUG) << fmt::format("Delete region {} raft node shutdown", node_id_);
+  StopKeepAlive();
   node_->shutdown(nullptr);
   node_->join();
   DINGO_LOG(DEBUG) << fmt::format("Delete region {} finish raft node shutdown", node_id_);
 
+  // Delete raft log of the region in shared log engine
+  if (log_uri_.rfind("local://", 0) != 0) {
+    auto status = braft::LogStorage::destroy(log_uri_);
+    if (!status.ok()) {
+      DINGO_LOG(ERROR) << fmt::format("Delete region {} raft log failed, {}", node_id_, status.error_cstr());
+    }
+  }
+
   // Delete file directory
   Helper::RemoveAllFileOrDirectory(path_);
   DINGO_LOG(DEBUG) << fmt::format("Delete region {} delete file directory", node_id_);
@@ -97,6 +157,36 @@ butil::Status RaftNode::Commit(std::shared_ptr<Context> ctx, std::shared_ptr<pb:
   if (!IsLeader()) {
     return butil::Status(pb::error::ERAFT_NOTLEADER, GetLeaderId().to_string());
   }
+
+  Touch();
+  return Apply(raft_cmd, new StoreClosure(ctx, raft_cmd));
+}
+
+butil::Status RaftNode::Commit(std::vector<std::shared_ptr<Context>> ctxs,
+                               std::shared_ptr<pb::raft::RaftCmdRequest> raft_cmd) {
+  if (!IsLeader()) {
+    return butil::Status(pb::error::ERAFT_NOTLEADER, GetLeaderId().to_string());
+  }
+
+  Touch();
+  return Apply(raft_cmd, new StoreClosure(std::move(ctxs), raft_cmd));
+}
+
+butil::Status RaftNode::GroupCommit(std::shared_ptr<Context> ctx,
+                                    std::shared_ptr<pb::raft::RaftCmdRequest> raft_cmd) {
+  if (write_batcher_ == nullptr) {
+    return Commit(ctx, raft_cmd);
+  }
+  if (!IsLeader()) {
+    return butil::Status(pb::error::ERAFT_NOTLEADER, GetLeaderId().to_string());
+  }
+
+  return write_batcher_->Commit(ctx, raft_cmd);
+}
+
+butil::Status RaftNode::Apply(std::shared_ptr<pb::raft::RaftCmdRequest> raft_cmd, braft::Closure* done) {
+  raft_cmd->mutable_header()->set_timestamp(Helper::TimestampMs());
+
   butil::IOBuf data;
   butil::IOBufAsZeroCopyOutputStream wrapper(&data);
   raft_cmd->SerializeToZeroCopyStream(&wrapper);
@@ -105,7 +195,7 @@ butil::Status RaftNode::Commit(std::shared_ptr<Context> ctx, std::shared_ptr<pb:
 
   braft::Task task;
   task.data = &data;
-  task.done = new StoreClosure(ctx, raft_cmd);
+  task.done = done;
   node_->apply(task);
 
   StoreBvarMetrics::GetInstance().IncCommitCountPerSecond(str_node_id_);
@@ -115,9 +205,85 @@ butil::Status RaftNode::Commit(std::shared_ptr<Context> ctx, std::shared_ptr<pb:
   return butil::Status();
 }
 
+butil::Status RaftNode::ReadIndex() {
+  if (!IsLeader()) {
+    return butil::Status(pb::error::ERAFT_NOTLEADER, GetLeaderId().to_string());
+  }
+
+  // Hibernated leader lease is stretched, wake up to check it with the normal election timeout.
+  Touch();
+
+  if (IsLeaderLeaseValid()) {
+    StoreBvarMetrics::GetInstance().IncLeaseReadCount(str_node_id_);
+    return WaitEarlyAcked();
+  }
+
+  // Lease is expired, the empty log entry is committed and applied means
+  // this node is still leader and all previous writes has been applied.
+  auto ctx = std::make_shared<Context>();
+  ctx->SetRegionId(node_id_);
+  ctx->EnableSyncMode();
+
+  auto raft_cmd = std::make_shared<pb::raft::RaftCmdRequest>();
+  raft_cmd->mutable_header()->set_region_id(node_id_);
+
+  auto status = Commit(ctx, raft_cmd);
+  if (!status.ok()) {
+    return status;
+  }
+  ctx->Cond()->IncreaseWait();
+
+  StoreBvarMetrics::GetInstance().IncReadIndexCount(str_node_id_);
+
+  return ctx->Status();
+}
+
+butil::Status RaftNode::GetReadIndex(uint64_t& read_index) {
+  auto status = ReadIndex();
+  if (!status.ok()) {
+    return status;
+  }
+
+  braft::NodeStatus node_status;
+  node_->get_status(&node_status);
+  read_index = node_status.committed_index;
+
+  return butil::Status();
+}
+
+butil::Status RaftNode::WaitEarlyAcked() {
+  // The early acked writes maybe not written to engine yet.
+  auto* fsm = dynamic_cast<StoreStateMachine*>(fsm_);
+  if (fsm != nullptr && fsm->GetEarlyAckIndex() > 0) {
+    return WaitApplied(fsm->GetEarlyAckIndex(), Constant::kFollowerReadTimeoutMs);
+  }
+  return butil::Status();
+}
+
+butil::Status RaftNode::WaitApplied(uint64_t read_index, int64_t timeout_ms) {
+  auto* fsm = dynamic_cast<StoreStateMachine*>(fsm_);
+  if (fsm == nullptr) {
+    return butil::Status(pb::error::ENOT_SUPPORT, "Not support wait applied");
+  }
+
+  if (!fsm->WaitApplied(static_cast<int64_t>(read_index), timeout_ms)) {
+    return butil::Status(pb::error::ERAFT_READ_INDEX,
+                         fmt::format("Wait applied index timeout, read_index {} applied_index {}", read_index,
+                                     fsm->GetAppliedIndex()));
+  }
+
+  return butil::Status();
+}
+
+int64_t RaftNode::GetAppliedTimestamp() {
+  auto* fsm = dynamic_cast<StoreStateMachine*>(fsm_);
+  return fsm != nullptr ? fsm->GetAppliedTimestamp() : 0;
+}
+
 bool RaftNode::IsLeader() { return node_->is_leader(); }
 
-bool RaftNode::IsLeaderLeaseValid() { return node_->is_leader_lease_valid(); }
+// Lease of hibernated leader is stretched with its election timeout, not safe for followers woken up.
+bool RaftNode::IsLeaderLeaseValid() { return !IsHibernated() && node_->is_leader_lease_valid(); }
 
 bool RaftNode::HasLeader() { return node_->leader_id().to_string() != "0.0.0.0:0:0"; }
 braft::PeerId RaftNode::GetLeaderId() { return node_->leader_id(); }
@@ -128,11 +294,18 @@ void RaftNode::Join() { node_->join(); }
 
 butil::Status RaftNode::ListPeers(std::vector<braft::PeerId>* peers) { return node_->list_peers(peers); }
 
-void RaftNode::AddPeer(const braft::PeerId& peer, braft::Closure* done) { node_->add_peer(peer, done); }
+void RaftNode::AddPeer(const braft::PeerId& peer, braft::Closure* done) {
+  Touch();
+  node_->add_peer(peer, done);
+}
 
-void RaftNode::RemovePeer(const braft::PeerId& peer, braft::Closure* done) { node_->remove_peer(peer, done); }
+void RaftNode::RemovePeer(const braft::PeerId& peer, braft::Closure* done) {
+  Touch();
+  node_->remove_peer(peer, done);
+}
 
 void RaftNode::ChangePeers(const std::vector<pb::common::Peer>& peers, braft::Closure* done) {
+  Touch();
   braft::Configuration config;
   for (const auto& peer : peers) {
     butil::EndPoint const endpoint = Helper::LocationToEndPoint(peer.raft_location());
@@ -144,7 +317,10 @@ void RaftNode::ChangePeers(const std::vector<pb::common::Peer>& peers, braft::Cl
 
 butil::Status RaftNode::ResetPeers(const braft::Configuration& new_peers) { return node_->reset_peers(new_peers); }
 
-int RaftNode::TransferLeadershipTo(const braft::PeerId& peer) { return node_->transfer_leadership_to(peer); }
+int RaftNode::TransferLeadershipTo(const braft::PeerId& peer) {
+  Touch();
+  return node_->transfer_leadership_to(peer);
+}
 
 void RaftNode::Snapshot(braft::Closure* done) { node_->snapshot(done); }
 
@@ -200,4 +376,171 @@ std::shared_ptr<pb::common::BRaftStatus> RaftNode::GetStatus() {
   return braft_status;
 }
 
+void RaftNode::Touch() {
+  last_active_time_ms_.store(Helper::TimestampMs(), std::memory_order_relaxed);
+  if (is_hibernated_.load()) {
+    WakeUp();
+  }
+}
+
+void RaftNode::Hibernate() {
+  BAIDU_SCOPED_LOCK(hibernate_mutex_);
+  if (is_hibernated_.load() || is_stopped_) {
+    return;
+  }
+  // Leader touched after the check
+  if (IsLeader() && Helper::TimestampMs() - last_active_time_ms_.load() < hibernate_idle_time_ms_) {
+    return;
+  }
+
+  node_->reset_election_timeout_ms(election_timeout_ms_ * hibernate_timeout_factor_);
+  is_hibernated_.store(true);
+  DINGO_LOG(INFO) << fmt::format("region {} hibernate, is_leader {}", node_id_, IsLeader());
+}
+
+void RaftNode::WakeUp() {
+  BAIDU_SCOPED_LOCK(hibernate_mutex_);
+  if (!is_hibernated_.load()) {
+    return;
+  }
+
+  // Lease is checked with the normal election timeout after it.
+  node_->reset_election_timeout_ms(election_timeout_ms_);
+  is_hibernated_.store(false);
+  if (IsLeader()) {
+    StartKeepAlive();
+  }
+  DINGO_LOG(INFO) << fmt::format("region {} wake up", node_id_);
+}
+
+void RaftNode::OnHibernateApplied(bool is_hibernate) {
+  if (!is_hibernate) {
+    hibernate_applied_time_ms_.store(0);
+    if (is_hibernated_.load()) {
+      WakeUp();
+    }
+    return;
+  }
+
+  hibernate_applied_time_ms_.store(Helper::TimestampMs());
+  // Followers stop election at once, the leader wait them applied the command.
+  if (!IsLeader()) {
+    Hibernate();
+  }
+}
+
+void RaftNode::CheckHibernate() {
+  if (hibernate_idle_time_ms_ <= 0) {
+    return;
+  }
+
+  bool const is_leader = IsLeader();
+  if (is_leader != is_leader_checked_) {
+    is_leader_checked_ = is_leader;
+    Touch();
+    return;
+  }
+  if (!is_leader || IsHibernated()) {
+    return;
+  }
+
+  int64_t const now = Helper::TimestampMs();
+  {
+    BAIDU_SCOPED_LOCK(hibernate_mutex_);
+    if (now < keep_alive_deadline_ms_) {
+      return;
+    }
+  }
+
+  // Followers learn the hibernate command committed by the next heartbeat, the leader stretch
+  // its heartbeat after followers stopped election, otherwise they miss the heartbeat.
+  int64_t const hibernate_applied_time = hibernate_applied_time_ms_.load();
+  if (hibernate_applied_time > 0) {
+    if (now - hibernate_applied_time >= election_timeout_ms_) {
+      Hibernate();
+    }
+    return;
+  }
+
+  if (now - last_active_time_ms_.load() >= hibernate_idle_time_ms_ &&
+      now - hibernate_propose_time_ms_.load() >= hibernate_idle_time_ms_) {
+    hibernate_propose_time_ms_.store(now);
+
+    auto raft_cmd = std::make_shared<pb::raft::RaftCmdRequest>();
+    raft_cmd->mutable_header()->set_region_id(node_id_);
+    auto* request = raft_cmd->add_requests();
+    request->set_cmd_type(pb::raft::HIBERNATE);
+    request->mutable_hibernate();
+
+    auto ctx = std::make_shared<Context>();
+    ctx->SetRegionId(node_id_);
+    Apply(raft_cmd, new StoreClosure(ctx, raft_cmd));
+    DINGO_LOG(DEBUG) << fmt::format("region {} idle, propose hibernate", node_id_);
+  }
+}
+
+// Run with hibernate_mutex_ locked.
+void RaftNode::StartKeepAlive() {
+  // The heartbeat timer scheduled in hibernation fire in one hibernated heartbeat interval.
+  int64_t const hibernate_heartbeat_interval_ms =
+      election_timeout_ms_ * hibernate_timeout_factor_ / std::max(braft::FLAGS_raft_election_heartbeat_factor, 1);
+  keep_alive_deadline_ms_ = Helper::TimestampMs() + hibernate_heartbeat_interval_ms + election_timeout_ms_;
+  if (is_keep_alive_running_ || is_stopped_) {
+    return;
+  }
+
+  const bthread_attr_t attr = BTHREAD_ATTR_NORMAL;
+  if (bthread_start_background(&keep_alive_tid_, &attr, KeepAlive, this) != 0) {
+    DINGO_LOG(ERROR) << fmt::format("region {} start keep alive failed", node_id_);
+    return;
+  }
+  is_keep_alive_running_ = true;
+}
+
+void RaftNode::StopKeepAlive() {
+  bthread_t tid = INVALID_BTHREAD;
+  {
+    BAIDU_SCOPED_LOCK(hibernate_mutex_);
+    is_stopped_ = true;
+    if (is_keep_alive_running_) {
+      tid = keep_alive_tid_;
+    }
+  }
+
+  if (tid != INVALID_BTHREAD) {
+    bthread_stop(tid);
+    bthread_join(tid, nullptr);
+  }
+}
+
+void* RaftNode::KeepAlive(void* arg) {
+  auto* raft_node = static_cast<RaftNode*>(arg);
+  for (;;) {
+    {
+      BAIDU_SCOPED_LOCK(raft_node->hibernate_mutex_);
+      if (raft_node->is_stopped_ || raft_node->is_hibernated_.load() || !raft_node->IsLeader() ||
+          Helper::TimestampMs() >= raft_node->keep_alive_deadline_ms_) {
+        raft_node->is_keep_alive_running_ = false;
+        break;
+      }
+    }
+
+    // Same as heartbeat, reset the election timer of followers and confirm the leader lease.
+    auto raft_cmd = std::make_shared<pb::raft::RaftCmdRequest>();
+    raft_cmd->mutable_header()->set_region_id(raft_node->node_id_);
+    auto ctx = std::make_shared<Context>();
+    ctx->SetRegionId(raft_node->node_id_);
+    raft_node->Apply(raft_cmd, new StoreClosure(ctx, raft_cmd));
+
+    if (bthread_usleep(raft_node->election_timeout_ms_ * 1000L / 2) != 0) {
+      // Stopped
+      BAIDU_SCOPED_LOCK(raft_node->hibernate_mutex_);
+      raft_node->is_keep_alive_running_ = false;
+      break;
+    }
+  }
+
+  return nullptr;
+}
+
 }  // namespace dingodb
@@ -18,14 +18,17 @@
 #include <braft/raft.h>
 #include <braft/util.h>
 
+#include <atomic>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "common/context.h"
 #include "config/config.h"
 #include "proto/common.pb.h"
 #include "proto/error.pb.h"
 #include "proto/raft.pb.h"
+#include "raft/raft_write_batcher.h"
 
 namespace dingodb {
 
@@ -43,6 +46,23 @@ class RaftNode {
   uint64_t GetNodeId() const { return node_id_; }
 
   butil::Status Commit(std::shared_ptr<Context> ctx, std::shared_ptr<pb::raft::RaftCmdRequest> raft_cmd);
+  // Commit one raft log entry for multiple writes, ctxs is aligned with raft_cmd->requests().
+  butil::Status Commit(std::vector<std::shared_ptr<Context>> ctxs,
+                       std::shared_ptr<pb::raft::RaftCmdRequest> raft_cmd);
+  // Commit through group commit batcher, concurrent writes share one raft log entry.
+  butil::Status GroupCommit(std::shared_ptr<Context> ctx, std::shared_ptr<pb::raft::RaftCmdRequest> raft_cmd);
+
+  // Make sure the local read is linearizable, serve read locally within leader lease,
+  // otherwise commit a empty log entry as read index and wait it applied.
+  butil::Status ReadIndex();
+  // Leader confirm leadership, then return committed index as read index of follower read.
+  butil::Status GetReadIndex(uint64_t& read_index);
+  // Local read within leader lease, wait the early acked writes visible.
+  butil::Status WaitEarlyAcked();
+  // Wait the state machine applied index catch up the read index.
+  butil::Status WaitApplied(uint64_t read_index, int64_t timeout_ms);
+  // Leader propose timestamp of the last applied log entry, 0 means unknown.
+  int64_t GetAppliedTimestamp();
 
   bool IsLeader();
   bool IsLeaderLeaseValid();
@@ -65,14 +85,59 @@ class RaftNode {
 
   std::shared_ptr<pb::common::BRaftStatus> GetStatus();
 
+  // Idle region hibernate, the leader propose a hibernate command, replicas stretch the election timeout
+  // by hibernate_timeout_factor after applied it, followers stop election and the leader heartbeat interval
+  // is stretched too. Any log entry or leader change wake up the replica.
+  bool IsHibernated() const { return is_hibernated_.load(); }
+  // Leader propose hibernate command when no write, read or peer request in idle time, hibernate after
+  // followers applied it. Run by crontab.
+  void CheckHibernate();
+  // Record region activity, wake up hibernated region.
+  void Touch();
+  // Wake up hibernated replica, also called by the store liveness check when the leader is lost.
+  void WakeUp();
+
  private:
+  void Hibernate();
+  void OnHibernateApplied(bool is_hibernate);
+  // braft can't reschedule the stretched heartbeat timer, woken leader keep followers alive by
+  // empty log entries until the hibernated heartbeat fired.
+  void StartKeepAlive();
+  void StopKeepAlive();
+  static void* KeepAlive(void* arg);
+
+  butil::Status Apply(std::shared_ptr<pb::raft::RaftCmdRequest> raft_cmd, braft::Closure* done);
+
   std::string path_;
+  std::string log_uri_;
   uint64_t node_id_;
   std::string str_node_id_;
   std::string raft_group_name_;
 
   std::unique_ptr<braft::Node> node_;
   braft::StateMachine* fsm_;
+
+  std::unique_ptr<RaftWriteBatcher> write_batcher_;
+
+  // For hibernate
+  int election_timeout_ms_;
+  // 0 means disable hibernate
+  int64_t hibernate_idle_time_ms_;
+  int hibernate_timeout_factor_;
+  // Protect hibernate state change, keep it consistent with the election timeout.
+  bthread_mutex_t hibernate_mutex_;
+  std::atomic<bool> is_hibernated_;
+  // Leader seen by the last check, new leader start from active.
+  bool is_leader_checked_;
+  std::atomic<int64_t> last_active_time_ms_;
+  std::atomic<int64_t> hibernate_propose_time_ms_;
+  // Apply time of the hibernate command when it is the last applied log entry, otherwise 0.
+  std::atomic<int64_t> hibernate_applied_time_ms_;
+  // Woken leader propose empty log entries until the deadline.
+  int64_t keep_alive_deadline_ms_;
+  bthread_t keep_alive_tid_;
+  bool is_keep_alive_running_;
+  bool is_stopped_;
 };
 
 }  // namespace dingodb
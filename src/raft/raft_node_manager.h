@@ -19,6 +19,7 @@
 #include <map>
 #include <memory>
 #include <shared_mutex>
+#include <vector>
 
 #include "raft/raft_node.h"
 
@@ -35,6 +36,7 @@ class RaftNodeManager {
 
   bool IsExist(uint64_t node_id);
   std::shared_ptr<RaftNode> GetNode(uint64_t node_id);
+  std::vector<std::shared_ptr<RaftNode> > GetAllNode();
   void AddNode(uint64_t node_id, std::shared_ptr<RaftNode> node);
   void DeleteNode(uint64_t node_id);
 
@@ -0,0 +1,139 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "raft/raft_write_batcher.h"
+
+#include <mutex>
+#include <utility>
+
+#include "common/logging.h"
+#include "fmt/core.h"
+#include "proto/error.pb.h"
+#include "raft/store_state_machine.h"
+
+namespace dingodb {
+
+RaftWriteBatcher::RaftWriteBatcher(uint64_t node_id, const Options& options, CommitFunc commit_func)
+    : node_id_(node_id),
+      options_(options),
+      commit_func_(commit_func),
+      pending_count_(0),
+      pending_bytes_(0),
+      queued_seq_(0),
+      taken_seq_(0),
+      is_flushing_(false) {}
+
+bool RaftWriteBatcher::IsFull() const {
+  return pending_count_ >= options_.max_batch_count || pending_bytes_ >= options_.max_batch_bytes;
+}
+
+std::vector<RaftWriteBatcher::Task> RaftWriteBatcher::TakeTasks() {
+  std::vector<Task> tasks;
+  tasks.swap(pending_tasks_);
+  pending_count_ = 0;
+  pending_bytes_ = 0;
+  taken_seq_ = queued_seq_;
+  taken_cond_.notify_all();
+  return tasks;
+}
+
+butil::Status RaftWriteBatcher::Commit(std::shared_ptr<Context> ctx,
+                                       std::shared_ptr<pb::raft::RaftCmdRequest> raft_cmd) {
+  std::unique_lock<bthread::Mutex> lock(mutex_);
+  uint64_t const bytes = raft_cmd->ByteSizeLong();
+  pending_count_ += raft_cmd->requests_size();
+  pending_bytes_ += bytes;
+  pending_tasks_.push_back({ctx, raft_cmd, bytes});
+  uint64_t const seq = ++queued_seq_;
+
+  // Other writer is flushing, wait it take this write, or become flusher when it quit.
+  if (is_flushing_ && IsFull()) {
+    cond_.notify_one();
+  }
+  while (is_flushing_ && taken_seq_ < seq) {
+    taken_cond_.wait(lock);
+  }
+  if (taken_seq_ >= seq) {
+    return butil::Status();
+  }
+
+  // Become flusher, the first round wait window, then take the writes queued while
+  // committing once without waiting, the rest is left to the next flusher.
+  is_flushing_ = true;
+  if (options_.window_us > 0 && !IsFull()) {
+    cond_.wait_for(lock, options_.window_us);
+  }
+  for (int round = 0; round < 2 && !pending_tasks_.empty(); ++round) {
+    auto tasks = TakeTasks();
+    lock.unlock();
+    Flush(tasks);
+    lock.lock();
+  }
+  is_flushing_ = false;
+  taken_cond_.notify_all();
+
+  return butil::Status();
+}
+
+void RaftWriteBatcher::Flush(std::vector<Task>& tasks) {
+  std::shared_ptr<pb::raft::RaftCmdRequest> raft_cmd;
+  std::vector<std::shared_ptr<Context>> ctxs;
+  uint64_t bytes = 0;
+  for (auto& task : tasks) {
+    // Current batch is full, commit it and start a new one.
+    if (raft_cmd != nullptr && (ctxs.size() + task.raft_cmd->requests_size() > options_.max_batch_count ||
+                                bytes + task.bytes > options_.max_batch_bytes)) {
+      CommitBatch(ctxs, raft_cmd);
+      raft_cmd = nullptr;
+      ctxs.clear();
+      bytes = 0;
+    }
+
+    if (raft_cmd == nullptr) {
+      raft_cmd = std::make_shared<pb::raft::RaftCmdRequest>();
+      *raft_cmd->mutable_header() = task.raft_cmd->header();
+    }
+
+    for (auto& request : *task.raft_cmd->mutable_requests()) {
+      raft_cmd->add_requests()->Swap(&request);
+      ctxs.push_back(task.ctx);
+    }
+    bytes += task.bytes;
+  }
+
+  if (raft_cmd != nullptr) {
+    CommitBatch(ctxs, raft_cmd);
+  }
+}
+
+void RaftWriteBatcher::CommitBatch(std::vector<std::shared_ptr<Context>>& ctxs,
+                                   std::shared_ptr<pb::raft::RaftCmdRequest> raft_cmd) {
+  auto status = commit_func_(ctxs, raft_cmd);
+  if (status.ok()) {
+    return;
+  }
+
+  DINGO_LOG(ERROR) << fmt::format("group commit failed, region[{}] requests[{}] {}:{}", node_id_,
+                                  raft_cmd->requests_size(), status.error_code(), status.error_str());
+  // The writes have been accepted, so notify every write the failure.
+  std::shared_ptr<Context> prev_ctx;
+  for (auto& ctx : ctxs) {
+    if (ctx != prev_ctx) {
+      StoreClosure::Finish(ctx, status);
+      prev_ctx = ctx;
+    }
+  }
+}
+
+}  // namespace dingodb
@@ -0,0 +1,97 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DINGODB_RAFT_WRITE_BATCHER_H_
+#define DINGODB_RAFT_WRITE_BATCHER_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "bthread/condition_variable.h"
+#include "bthread/mutex.h"
+#include "butil/status.h"
+#include "common/context.h"
+#include "proto/raft.pb.h"
+
+namespace dingodb {
+
+// Group commit for one region.
+// Concurrent writes are queued, the first writer which find no flusher become flusher,
+// it wait up to window_us or until the batch is full, then merge all queued writes into
+// one raft log entry. Every raft request keep its owner context, so the result of the
+// entry can fan out to each write by StoreClosure.
+// The flusher take at most one extra round of the writes queued while it is committing,
+// then hand over to a queued writer, so a writer never commit for others without bound.
+class RaftWriteBatcher {
+ public:
+  // Commit one raft log entry, ctxs is aligned with raft_cmd->requests().
+  using CommitFunc = std::function<butil::Status(std::vector<std::shared_ptr<Context>>&,
+                                                 std::shared_ptr<pb::raft::RaftCmdRequest>)>;
+
+  struct Options {
+    // Max raft requests of one raft log entry.
+    uint32_t max_batch_count;
+    // Max serialized bytes of one raft log entry.
+    uint64_t max_batch_bytes;
+    // Max time of flusher waiting for more writes, 0 means not wait.
+    int64_t window_us;
+  };
+
+  RaftWriteBatcher(uint64_t node_id, const Options& options, CommitFunc commit_func);
+  ~RaftWriteBatcher() = default;
+
+  RaftWriteBatcher(const RaftWriteBatcher&) = delete;
+  const RaftWriteBatcher& operator=(const RaftWriteBatcher&) = delete;
+
+  // Queue write, return when the write is taken by a flusher,
+  // the write result is notified by ctx write callback.
+  butil::Status Commit(std::shared_ptr<Context> ctx, std::shared_ptr<pb::raft::RaftCmdRequest> raft_cmd);
+
+ private:
+  struct Task {
+    std::shared_ptr<Context> ctx;
+    std::shared_ptr<pb::raft::RaftCmdRequest> raft_cmd;
+    uint64_t bytes;
+  };
+
+  bool IsFull() const;
+  // Take all queued tasks, wake up the writers of them.
+  std::vector<Task> TakeTasks();
+  // Merge tasks into raft log entries and commit them.
+  void Flush(std::vector<Task>& tasks);
+  void CommitBatch(std::vector<std::shared_ptr<Context>>& ctxs, std::shared_ptr<pb::raft::RaftCmdRequest> raft_cmd);
+
+  uint64_t node_id_;
+  Options options_;
+  CommitFunc commit_func_;
+
+  bthread::Mutex mutex_;
+  // Wake up flusher when batch is full.
+  bthread::ConditionVariable cond_;
+  // Wake up writers when their tasks are taken or flusher quit.
+  bthread::ConditionVariable taken_cond_;
+  std::vector<Task> pending_tasks_;
+  uint32_t pending_count_;
+  uint64_t pending_bytes_;
+  // Sequence of the last queued task and the last taken task.
+  uint64_t queued_seq_;
+  uint64_t taken_seq_;
+  bool is_flushing_;
+};
+
+}  // namespace dingodb
+
+#endif  // DINGODB_RAFT_WRITE_BATCHER_H_
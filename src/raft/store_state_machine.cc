@@ -14,15 +14,20 @@
 
 #include "raft/store_state_machine.h"
 
+#include <algorithm>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include "braft/util.h"
 #include "butil/status.h"
+#include "butil/time.h"
 #include "common/helper.h"
 #include "common/logging.h"
 #include "event/store_state_machine_event.h"
 #include "fmt/core.h"
+#include "handler/raft_handler.h"
 #include "meta/meta_writer.h"
 #include "meta/store_meta_manager.h"
 #include "metrics/store_bvar_metrics.h"
@@ -37,21 +42,55 @@ namespace dingodb {
 void StoreClosure::Run() {
   // Delete self after run
   std::unique_ptr<StoreClosure> self_guard(this);
-  brpc::ClosureGuard const done_guard(ctx_->IsSyncMode() ? nullptr : ctx_->Done());
-  if (!status().ok()) {
-    DINGO_LOG(ERROR) << fmt::format("raft log commit failed, region[{}] {}:{}", ctx_->RegionId(), status().error_code(),
-                                    status().error_str());
+  butil::Status status;
+  if (!this->status().ok()) {
+    DINGO_LOG(ERROR) << fmt::format("raft log commit failed, region[{}] {}:{}", ctx_->RegionId(),
+                                    this->status().error_code(), this->status().error_str());
 
-    ctx_->SetStatus(butil::Status(pb::error::ERAFT_COMMITLOG, status().error_str()));
+    status = butil::Status(pb::error::ERAFT_COMMITLOG, this->status().error_str());
   }
 
-  if (ctx_->IsSyncMode()) {
-    ctx_->Cond()->DecreaseSignal();
+  if (ctxs_.empty()) {
+    Finish(ctx_, status);
+    return;
+  }
+
+  // Fan out to every write of the group, requests of one write are adjacent.
+  std::shared_ptr<Context> prev_ctx;
+  for (auto& ctx : ctxs_) {
+    if (ctx != prev_ctx) {
+      Finish(ctx, status);
+      prev_ctx = ctx;
+    }
+  }
+}
+
+void StoreClosure::Finish(std::shared_ptr<Context> ctx, const butil::Status& status) {
+  brpc::ClosureGuard const done_guard(ctx->IsSyncMode() ? nullptr : ctx->Done());
+  if (!status.ok()) {
+    ctx->SetStatus(status);
+  }
+
+  if (ctx->IsSyncMode()) {
+    ctx->Cond()->DecreaseSignal();
   } else {
-    if (ctx_->WriteCb()) {
-      ctx_->WriteCb()(ctx_, ctx_->Status());
+    if (ctx->WriteCb()) {
+      ctx->WriteCb()(ctx, ctx->Status());
+    }
+  }
+}
+
+bool StoreClosure::IsBlindWrite() {
+  if (ctxs_.empty()) {
+    return ctx_ != nullptr && ctx_->BlindWrite();
+  }
+
+  for (auto& ctx : ctxs_) {
+    if (!ctx->BlindWrite()) {
+      return false;
     }
   }
+  return true;
 }
 
 StoreStateMachine::StoreStateMachine(std::shared_ptr<RawEngine> engine, store::RegionPtr region,
@@ -66,10 +105,47 @@ StoreStateMachine::StoreStateMachine(std::shared_ptr<RawEngine> engine, store::R
       listeners_(listeners),
       applied_term_(raft_meta->term()),
       applied_index_(raft_meta->applied_index()),
-      is_restart_for_load_snapshot_(is_restart) {}
+      visible_index_(raft_meta->applied_index()),
+      applied_timestamp_(0),
+      is_restart_for_load_snapshot_(is_restart),
+      apply_batch_max_bytes_(0),
+      disable_data_wal_(false),
+      early_ack_(false),
+      early_ack_index_(0),
+      flushed_applied_index_(raft_meta->applied_index()),
+      latest_commit_(0, 0),
+      oldest_unflushed_commit_(0, 0),
+      apply_waiter_count_(0) {}
 
 bool StoreStateMachine::Init() { return true; }
 
+bool StoreStateMachine::WaitApplied(int64_t index, int64_t timeout_ms) {
+  if (visible_index_.load() >= index) {
+    return true;
+  }
+
+  int64_t const deadline_us = butil::gettimeofday_us() + timeout_ms * 1000;
+  std::unique_lock<bthread::Mutex> lock(apply_mutex_);
+  apply_waiter_count_.fetch_add(1);
+  while (visible_index_.load() < index) {
+    int64_t const remain_us = deadline_us - butil::gettimeofday_us();
+    if (remain_us <= 0) {
+      break;
+    }
+    apply_cond_.wait_for(lock, remain_us);
+  }
+  apply_waiter_count_.fetch_sub(1);
+
+  return visible_index_.load() >= index;
+}
+
+void StoreStateMachine::NotifyApplied() {
+  if (apply_waiter_count_.load() > 0) {
+    std::unique_lock<bthread::Mutex> lock(apply_mutex_);
+    apply_cond_.notify_all();
+  }
+}
+
 void StoreStateMachine::DispatchEvent(dingodb::EventType event_type, std::shared_ptr<dingodb::Event> event) {
   if (listeners_ == nullptr) return;
 
@@ -78,52 +154,288 @@ void StoreStateMachine::DispatchEvent(dingodb::EventType event_type, std::shared
   }
 }
 
+void StoreStateMachine::NotifyHibernate(bool is_hibernate) {
+  if (hibernate_listener_ != nullptr) {
+    hibernate_listener_(is_hibernate);
+  }
+}
+
+// Raw engine of one apply batch, readers and writers go through the write batch,
+// others go to the underlying engine.
+class ApplyBatchEngine : public RawEngine {
+ public:
+  ApplyBatchEngine(std::shared_ptr<RawEngine> engine, std::shared_ptr<RawEngine::WriteBatch> write_batch)
+      : engine_(engine), write_batch_(write_batch) {}
+  ~ApplyBatchEngine() override = default;
+
+  bool Init(std::shared_ptr<Config> config) override { return engine_->Init(config); }
+  std::string GetName() override { return engine_->GetName(); }
+  pb::common::RawEngine GetID() override { return engine_->GetID(); }
+
+  std::shared_ptr<Snapshot> GetSnapshot() override { return engine_->GetSnapshot(); }
+  void Flush(const std::string& cf_name) override { engine_->Flush(cf_name); }
+
+  std::shared_ptr<Snapshot> NewSnapshot() override { return engine_->NewSnapshot(); }
+  std::shared_ptr<Reader> NewReader(const std::string& cf_name) override { return write_batch_->NewReader(cf_name); }
+  std::shared_ptr<Writer> NewWriter(const std::string& cf_name) override { return write_batch_->NewWriter(cf_name); }
+  std::shared_ptr<Iterator> NewIterator(const std::string& cf_name, IteratorOptions options) override {
+    return engine_->NewIterator(cf_name, options);
+  }
+
+  std::vector<uint64_t> GetApproximateSizes(const std::string& cf_name,
+                                            std::vector<pb::common::Range>& ranges) override {
+    return engine_->GetApproximateSizes(cf_name, ranges);
+  }
+
+  // Mutations are invisible until commit, the row cache is invalidated after commit.
+  std::shared_ptr<RowCache> GetRowCache(const std::string& /*cf_name*/) override { return nullptr; }
+
+ private:
+  std::shared_ptr<RawEngine> engine_;
+  std::shared_ptr<RawEngine::WriteBatch> write_batch_;
+};
+
+// Only the data write command can be applied by write batch,
+// others like split depend on the data has been written to engine.
+// Delete range commit the batch first, so only batch it when data wal is disabled.
+static bool IsBatchable(const pb::raft::RaftCmdRequest& raft_cmd, bool disable_data_wal) {
+  for (const auto& req : raft_cmd.requests()) {
+    switch (req.cmd_type()) {
+      case pb::raft::PUT:
+      case pb::raft::PUTIFABSENT:
+      case pb::raft::COMPAREANDSET:
+      case pb::raft::DELETEBATCH:
+      case pb::raft::HIBERNATE:
+        break;
+      case pb::raft::DELETERANGE:
+        if (!disable_data_wal) {
+          return false;
+        }
+        break;
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
+// Result of the blind write is determined once committed, except the region is
+// splitting, write out of range will be rejected.
+static bool IsEarlyAckable(const pb::raft::RaftCmdRequest& raft_cmd, pb::common::StoreRegionState region_state) {
+  if (region_state != pb::common::StoreRegionState::NORMAL || raft_cmd.requests().empty()) {
+    return false;
+  }
+
+  for (const auto& req : raft_cmd.requests()) {
+    switch (req.cmd_type()) {
+      case pb::raft::PUT:
+      case pb::raft::DELETEBATCH:
+      case pb::raft::DELETERANGE:
+        break;
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
+// Commit write batch, then run the closures of the committed log entries.
+static void CommitApplyBatch(uint64_t region_id, std::shared_ptr<RawEngine> engine,
+                             std::shared_ptr<RawEngine::WriteBatch> write_batch,
+                             std::vector<std::shared_ptr<pb::raft::RaftCmdRequest>>& raft_cmds,
+                             std::vector<braft::Closure*>& dones) {
+  if (write_batch == nullptr) {
+    return;
+  }
+
+  auto status = write_batch->Commit();
+  if (!status.ok()) {
+    DINGO_LOG(ERROR) << fmt::format("commit apply batch failed, region[{}] {}:{}", region_id, status.error_code(),
+                                    status.error_str());
+  }
+
+  // Before the closures, so reads after the response never hit the old rows.
+  for (const auto& raft_cmd : raft_cmds) {
+    for (const auto& req : raft_cmd->requests()) {
+      InvalidateRowCache(engine, req);
+    }
+  }
+  raft_cmds.clear();
+
+  for (auto* done : dones) {
+    if (!status.ok()) {
+      done->status().set_error(EIO, status.error_str());
+    }
+    braft::run_closure_in_bthread(done);
+  }
+  dones.clear();
+}
+
 void StoreStateMachine::on_apply(braft::Iterator& iter) {
+  // Apply the data write of log entries by one write batch, commit when the batch is large
+  // or meet the command which is not batchable, the closures run after commit.
+  // Without data wal every batchable entry goes through the batch to carry the applied index,
+  // apply_batch_max_bytes_ 0 means the batch only hold one entry.
+  bool const enable_batch = (apply_batch_max_bytes_ > 0 || disable_data_wal_) && engine_ != nullptr;
+  std::shared_ptr<RawEngine::WriteBatch> write_batch;
+  std::shared_ptr<ApplyBatchEngine> apply_batch_engine;
+  std::shared_ptr<StoreRaftMeta> store_raft_meta;
+  if (disable_data_wal_) {
+    store_raft_meta = Server::GetInstance()->GetStoreMetaManager()->GetStoreRaftMeta();
+  }
+  std::vector<braft::Closure*> batch_dones;
+  std::vector<std::shared_ptr<pb::raft::RaftCmdRequest>> batch_cmds;
+  bool is_applied = false;
+  bool is_hibernate = false;
+
+  // Commit the batch which carry data and raft meta up to the applied index.
+  auto commit_batch = [&]() {
+    if (write_batch == nullptr || batch_cmds.empty()) {
+      return;
+    }
+    CommitApplyBatch(region_->Id(), engine_, write_batch, batch_cmds, batch_dones);
+    visible_index_.store(applied_index_.load());
+    if (disable_data_wal_) {
+      TrackCommit(write_batch->CommittedSequence(), applied_index_.load());
+    }
+  };
+
   for (; iter.valid(); iter.next()) {
-    braft::AsyncClosureGuard done_guard(iter.done());
     if (iter.index() <= applied_index_) {
+      braft::AsyncClosureGuard done_guard(iter.done());
       continue;
     }
 
     auto raft_cmd = std::make_shared<pb::raft::RaftCmdRequest>();
-    if (iter.done()) {
-      StoreClosure* store_closure = dynamic_cast<StoreClosure*>(iter.done());
+    braft::Closure* done = iter.done();
+    if (done) {
+      StoreClosure* store_closure = dynamic_cast<StoreClosure*>(done);
       raft_cmd = store_closure->GetRequest();
+      // Respond blind write now, the reads wait early ack index visible.
+      if (early_ack_ && store_closure->IsBlindWrite() && IsEarlyAckable(*raft_cmd, region_->State())) {
+        early_ack_index_.store(iter.index());
+        braft::run_closure_in_bthread(done);
+        done = nullptr;
+        StoreBvarMetrics::GetInstance().IncEarlyAckCount(str_node_id_);
+      }
     } else {
       butil::IOBufAsZeroCopyInputStream wrapper(iter.data());
       CHECK(raft_cmd->ParseFromZeroCopyStream(&wrapper));
     }
 
+    bool const is_batch_apply = enable_batch && IsBatchable(*raft_cmd, disable_data_wal_);
+    if (!is_batch_apply) {
+      commit_batch();
+      // The command like split write engine with wal, its applied index is persisted with wal too,
+      // the data of previous log entries without wal must be durable before it.
+      if (disable_data_wal_ && engine_ != nullptr && GetFlushedAppliedIndex() < applied_index_.load()) {
+        engine_->Flush(Constant::kStoreDataCF);
+        MarkFlushed(applied_index_.load());
+      }
+    } else if (write_batch == nullptr) {
+      write_batch = engine_->NewWriteBatch();
+      apply_batch_engine = std::make_shared<ApplyBatchEngine>(engine_, write_batch);
+    }
+
     // DINGO_LOG(DEBUG) << fmt::format("raft apply log on region[{}-term:{}-index:{}] applied_index[{}] cmd:[{}]",
     //                                 raft_cmd->header().region_id(), iter.term(), iter.index(), applied_index_,
     //                                 raft_cmd->ShortDebugString());
     // Build event
     auto event = std::make_shared<SmApplyEvent>();
     event->region = region_;
-    event->engine = engine_;
-    event->done = iter.done();
+    event->engine = is_batch_apply ? apply_batch_engine : engine_;
+    event->done = done;
     event->raft_cmd = raft_cmd;
     event->region_metrics = region_metrics_;
 
     DispatchEvent(EventType::kSmApply, event);
     applied_term_ = iter.term();
     applied_index_ = iter.index();
+    if (raft_cmd->header().timestamp() > 0) {
+      applied_timestamp_.store(raft_cmd->header().timestamp());
+    }
+    is_applied = true;
+    is_hibernate = raft_cmd->requests_size() == 1 && raft_cmd->requests(0).cmd_type() == pb::raft::HIBERNATE;
 
     raft_meta_->set_term(applied_term_);
     raft_meta_->set_applied_index(applied_index_);
 
+    if (is_batch_apply) {
+      if (disable_data_wal_) {
+        write_batch->NewWriter(Constant::kStoreMetaCF)->KvPut(*store_raft_meta->GenRaftMetaKv(raft_meta_));
+      }
+      batch_cmds.push_back(raft_cmd);
+      if (done) {
+        batch_dones.push_back(done);
+      }
+      if (write_batch->DataSize() >= apply_batch_max_bytes_) {
+        commit_batch();
+      }
+    } else {
+      visible_index_.store(iter.index());
+      if (disable_data_wal_) {
+        store_raft_meta->UpdateRaftMeta(raft_meta_);
+        MarkFlushed(iter.index());
+      }
+      braft::AsyncClosureGuard done_guard(done);
+    }
+
     // bvar metrics
     StoreBvarMetrics::GetInstance().IncApplyCountPerSecond(str_node_id_);
   }
 
+  commit_batch();
+  visible_index_.store(applied_index_.load());
+  NotifyApplied();
+  if (is_applied) {
+    NotifyHibernate(is_hibernate);
+  }
+
   // Persistence applied index
   // If operation is idempotent, it's ok.
   // If not, must be stored with the data.
-  if (applied_index_ % kSaveAppliedIndexStep == 0) {
+  // Without data wal, applied index is stored with the data, persist it with wal
+  // separately may be ahead of the flushed data.
+  if (!disable_data_wal_ && applied_index_ % kSaveAppliedIndexStep == 0) {
     Server::GetInstance()->GetStoreMetaManager()->GetStoreRaftMeta()->UpdateRaftMeta(raft_meta_);
   }
 }
 
+void StoreStateMachine::TrackCommit(uint64_t sequence, int64_t applied_index) {
+  if (sequence == 0) {
+    return;
+  }
+  latest_commit_ = {sequence, applied_index};
+  if (oldest_unflushed_commit_.second == 0) {
+    oldest_unflushed_commit_ = latest_commit_;
+  }
+}
+
+void StoreStateMachine::MarkFlushed(int64_t applied_index) {
+  flushed_applied_index_ = std::max(flushed_applied_index_, applied_index);
+  if (latest_commit_.second <= flushed_applied_index_) {
+    latest_commit_ = {0, 0};
+    oldest_unflushed_commit_ = {0, 0};
+  }
+}
+
+int64_t StoreStateMachine::GetFlushedAppliedIndex() {
+  if (engine_ == nullptr || oldest_unflushed_commit_.second == 0) {
+    return flushed_applied_index_;
+  }
+
+  uint64_t const flushed_sequence = engine_->GetFlushedSequence();
+  if (flushed_sequence >= latest_commit_.first) {
+    MarkFlushed(latest_commit_.second);
+  } else if (flushed_sequence >= oldest_unflushed_commit_.first) {
+    // The commits between are not tracked, the latest one is the next to wait.
+    flushed_applied_index_ = std::max(flushed_applied_index_, oldest_unflushed_commit_.second);
+    oldest_unflushed_commit_ = latest_commit_;
+  }
+
+  return flushed_applied_index_;
+}
+
 void StoreStateMachine::on_shutdown() {
   DINGO_LOG(INFO) << "on_shutdown, region: " << region_->Id();
   auto event = std::make_shared<SmShutdownEvent>();
@@ -132,6 +444,12 @@ void StoreStateMachine::on_shutdown() {
 
 void StoreStateMachine::on_snapshot_save(braft::SnapshotWriter* writer, braft::Closure* done) {
   DINGO_LOG(INFO) << "on_snapshot_save, region: " << region_->Id();
+  // Raft log will be truncated after snapshot, make sure the applied data is durable.
+  if (disable_data_wal_ && GetFlushedAppliedIndex() < applied_index_.load()) {
+    engine_->Flush(Constant::kStoreDataCF);
+    MarkFlushed(applied_index_.load());
+  }
+
   auto event = std::make_shared<SmSnapshotSaveEvent>();
   event->engine = engine_;
   event->writer = writer;
@@ -184,7 +502,7 @@ int StoreStateMachine::on_snapshot_load(braft::SnapshotReader* reader) {
   braft::SnapshotMeta meta;
   reader->load_meta(&meta);
   DINGO_LOG(INFO) << fmt::format("load snapshot({}-{}) applied_index({})", meta.last_included_term(),
-                                 meta.last_included_index(), applied_index_);
+                                 meta.last_included_index(), applied_index_.load());
 
   // Todo: 1. When loading snapshot panic, need handle the corner case.
   //       2. When restart server, maybe meta.last_included_index() > applied_index_.
@@ -206,12 +524,14 @@ int StoreStateMachine::on_snapshot_load(braft::SnapshotReader* reader) {
     // Update applied term and index
     applied_term_ = meta.last_included_term();
     applied_index_ = meta.last_included_index();
+    visible_index_.store(applied_index_.load());
 
     if (raft_meta_ != nullptr) {
       raft_meta_->set_term(applied_term_);
       raft_meta_->set_applied_index(applied_index_);
       Server::GetInstance()->GetStoreMetaManager()->GetStoreRaftMeta()->UpdateRaftMeta(raft_meta_);
     }
+    NotifyApplied();
   }
 
   if (is_restart_for_load_snapshot_.load()) {
@@ -229,6 +549,7 @@ void StoreStateMachine::on_leader_start(int64_t term) {
   event->node_id = region_->Id();
 
   DispatchEvent(EventType::kSmLeaderStart, event);
+  NotifyHibernate(false);
 
   // bvar metrics
   StoreBvarMetrics::GetInstance().UpdateLeaderSwitchCount(str_node_id_, term);
@@ -242,6 +563,7 @@ void StoreStateMachine::on_leader_stop(const butil::Status& status) {
   event->status = status;
 
   DispatchEvent(EventType::kSmLeaderStop, event);
+  NotifyHibernate(false);
 }
 
 void StoreStateMachine::on_error(const braft::Error& e) {
@@ -262,6 +584,7 @@ void StoreStateMachine::on_configuration_committed(const braft::Configuration& c
   event->conf = conf;
 
   DispatchEvent(EventType::kSmConfigurationCommited, event);
+  NotifyHibernate(false);
 }
 
 void StoreStateMachine::on_start_following(const braft::LeaderChangeContext& ctx) {
@@ -271,6 +594,7 @@ void StoreStateMachine::on_start_following(const braft::LeaderChangeContext& ctx
   event->node_id = region_->Id();
 
   DispatchEvent(EventType::kSmStartFollowing, event);
+  NotifyHibernate(false);
 
   // bvar metrics
   StoreBvarMetrics::GetInstance().UpdateLeaderSwitchCount(str_node_id_, ctx.term());
@@ -284,6 +608,7 @@ void StoreStateMachine::on_stop_following(const braft::LeaderChangeContext& ctx)
   event->node_id = region_->Id();
 
   DispatchEvent(EventType::kSmStopFollowing, event);
+  NotifyHibernate(false);
 }
 
 }  // namespace dingodb
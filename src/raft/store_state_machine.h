@@ -17,10 +17,15 @@
 
 #include <atomic>
 #include <cstdint>
+#include <functional>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "braft/raft.h"
 #include "brpc/controller.h"
+#include "bthread/condition_variable.h"
+#include "bthread/mutex.h"
 #include "common/context.h"
 #include "engine/raw_engine.h"
 #include "event/event.h"
@@ -35,15 +40,28 @@ class StoreClosure : public braft::Closure {
  public:
   StoreClosure(std::shared_ptr<Context> ctx, std::shared_ptr<pb::raft::RaftCmdRequest> request)
       : ctx_(ctx), request_(request) {}
+  // Group commit, ctxs is aligned with request->requests(), every raft request has its owner context.
+  StoreClosure(std::vector<std::shared_ptr<Context>> ctxs, std::shared_ptr<pb::raft::RaftCmdRequest> request)
+      : ctx_(ctxs.empty() ? nullptr : ctxs[0]), ctxs_(std::move(ctxs)), request_(request) {}
   ~StoreClosure() override = default;
 
   void Run() override;
 
   std::shared_ptr<Context> GetCtx() { return ctx_; }
+  // Get the owner context of the raft request.
+  std::shared_ptr<Context> GetCtx(int request_index) {
+    return ctxs_.empty() ? ctx_ : ctxs_[request_index];
+  }
   std::shared_ptr<pb::raft::RaftCmdRequest> GetRequest() { return request_; }
+  // All owner contexts are blind write.
+  bool IsBlindWrite();
+
+  // Notify write finished, wake up sync waiter or call write callback.
+  static void Finish(std::shared_ptr<Context> ctx, const butil::Status& status);
 
  private:
   std::shared_ptr<Context> ctx_;
+  std::vector<std::shared_ptr<Context>> ctxs_;
   std::shared_ptr<pb::raft::RaftCmdRequest> request_;
 };
 
@@ -61,6 +79,27 @@ class StoreStateMachine : public braft::StateMachine {
 
   static bool Init();
 
+  // Apply data write of many log entries by one write batch, 0 means disable.
+  void SetApplyBatchMaxBytes(uint64_t max_bytes) { apply_batch_max_bytes_ = max_bytes; }
+  // Data is written without wal, persist applied index in the same write batch with data.
+  void SetDisableDataWal(bool disable_data_wal) { disable_data_wal_ = disable_data_wal; }
+  // Without data wal, the applied index whose data has been flushed, lag behind the real one.
+  // Only called in the state machine callbacks.
+  int64_t GetFlushedAppliedIndex();
+  // Respond blind write once the log entry committed, before write to engine.
+  void SetEarlyAck(bool early_ack) { early_ack_ = early_ack; }
+  // Called with true when the hibernate command is the last applied log entry,
+  // with false on any other log entry or leader change after it.
+  void SetHibernateListener(std::function<void(bool)> listener) { hibernate_listener_ = listener; }
+
+  int64_t GetAppliedIndex() const { return applied_index_.load(); }
+  // Leader propose timestamp of the last applied log entry, unit ms.
+  int64_t GetAppliedTimestamp() const { return applied_timestamp_.load(); }
+  // Log index of the last early acked write, read must wait it visible.
+  int64_t GetEarlyAckIndex() const { return early_ack_index_.load(); }
+  // Wait until the data of log entries up to the index is visible, used by follower read.
+  bool WaitApplied(int64_t index, int64_t timeout_ms);
+
   void on_apply(braft::Iterator& iter) override;
   void on_shutdown() override;
   void on_snapshot_save(braft::SnapshotWriter* writer, braft::Closure* done) override;
@@ -74,6 +113,13 @@ class StoreStateMachine : public braft::StateMachine {
 
  private:
   void DispatchEvent(dingodb::EventType, std::shared_ptr<dingodb::Event> event);
+  void NotifyHibernate(bool is_hibernate);
+  // Wake up the waiters of applied index.
+  void NotifyApplied();
+  // Track the oldest unflushed and the latest commit of apply batch, the applied index of a commit
+  // is durable when the flushed sequence pass its sequence.
+  void TrackCommit(uint64_t sequence, int64_t applied_index);
+  void MarkFlushed(int64_t applied_index);
 
   store::RegionPtr region_;
   std::string str_node_id_;
@@ -81,12 +127,32 @@ class StoreStateMachine : public braft::StateMachine {
   std::shared_ptr<EventListenerCollection> listeners_;
 
   int64_t applied_term_;
-  int64_t applied_index_;
+  std::atomic<int64_t> applied_index_;
+  // Data of log entries up to it is visible in engine, lag behind applied index in batch apply.
+  std::atomic<int64_t> visible_index_;
+  std::atomic<int64_t> applied_timestamp_;
   std::shared_ptr<pb::store_internal::RaftMeta> raft_meta_;
 
   store::RegionMetricsPtr region_metrics_;
 
   std::atomic<bool> is_restart_for_load_snapshot_;
+
+  uint64_t apply_batch_max_bytes_;
+  bool disable_data_wal_;
+  bool early_ack_;
+  std::atomic<int64_t> early_ack_index_;
+
+  std::function<void(bool)> hibernate_listener_;
+
+  // For durable applied index without data wal, pair of sequence and applied index.
+  int64_t flushed_applied_index_;
+  std::pair<uint64_t, int64_t> latest_commit_;
+  std::pair<uint64_t, int64_t> oldest_unflushed_commit_;
+
+  // For waiting applied index
+  std::atomic<int32_t> apply_waiter_count_;
+  bthread::Mutex apply_mutex_;
+  bthread::ConditionVariable apply_cond_;
 };
 
 }  // namespace dingodb
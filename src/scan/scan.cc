@@ -30,11 +30,14 @@
 #include "coprocessor/utils.h"
 #include "engine/write_data.h"
 #include "fmt/core.h"
+#include "gflags/gflags.h"
 #include "proto/common.pb.h"
 #include "proto/error.pb.h"
 
 namespace dingodb {
 
+DEFINE_uint64(scan_bulk_min_fetch_cnt, 10000, "scan fetch at least this count per request read as bulk scan, 0 disable");
+
 // timeout millisecond to destroy
 uint64_t ScanContext::timeout_ms_ = 0;
 
@@ -144,31 +147,16 @@ butil::Status ScanContext::GetKeyValue(std::vector<pb::common::KeyValue>& kvs) {
 
   ScanFilter scan_filter = ScanFilter(key_only_, std::min(max_fetch_cnt_, max_fetch_cnt_by_server_), max_bytes_rpc_);
 
-  while (iter_->HasNext()) {
+  iter_->Visit([this, &kvs, &scan_filter](std::string_view key, std::string_view value) -> bool {
     pb::common::KeyValue kv;
-    std::string key;
-    std::string value;
-    if (key_only_) {
-      iter_->GetKey(key);
-
-    } else {
-      iter_->GetKV(key, value);
-    }
-
-    kv.set_key(std::move(key));
+    kv.set_key(key.data(), key.size());
     if (!key_only_) {
-      kv.set_value(std::move(value));
+      kv.set_value(value.data(), value.size());
     }
 
-    kvs.emplace_back(kv);
-    if (scan_filter.UptoLimit(kv)) {
-      iter_->Next();
-      break;
-    }
-    kv.Clear();
-
-    iter_->Next();
-  }
+    kvs.emplace_back(std::move(kv));
+    return !scan_filter.UptoLimit(kvs.back());
+  });
 
   return butil::Status();
 }
@@ -216,6 +204,12 @@ void ScanContext::WaitForReady() {
     }
   }
 }
+
+ReadProfile ScanContext::GetReadProfile() {
+  BAIDU_SCOPED_LOCK(mutex_);
+  return iter_ ? iter_->GetReadProfile() : ReadProfile::kDefault;
+}
+
 butil::Status ScanContext::SeekCheck() {
   if (ScanContext::SeekState::kInitted != seek_state_) {
     state_ = ScanState::kError;
@@ -253,6 +247,23 @@ bool ScanContext::IsRecyclable() {
   return ret;
 }
 
+// Aggregation and top-n read the whole range before return, large fetch count means the caller drain the range.
+static ReadProfile ChooseReadProfile(uint64_t max_fetch_cnt, bool has_coprocessor,
+                                     const pb::store::Coprocessor& coprocessor) {
+  if (has_coprocessor) {
+    if (!coprocessor.aggregation_operators().empty() || !coprocessor.group_by_columns().empty()) {
+      return ReadProfile::kBulkScan;
+    }
+    if (!coprocessor.sort_columns().empty() && coprocessor.limit() > 0) {
+      return ReadProfile::kBulkScan;
+    }
+  }
+  if (FLAGS_scan_bulk_min_fetch_cnt > 0 && max_fetch_cnt >= FLAGS_scan_bulk_min_fetch_cnt) {
+    return ReadProfile::kBulkScan;
+  }
+  return ReadProfile::kDefault;
+}
+
 butil::Status ScanHandler::ScanBegin(std::shared_ptr<ScanContext> context, uint64_t region_id,
                                      const pb::common::Range& range, uint64_t max_fetch_cnt, bool key_only,
                                      bool disable_auto_release, bool disable_coprocessor,
@@ -300,9 +311,16 @@ butil::Status ScanHandler::ScanBegin(std::shared_ptr<ScanContext> context, uint6
     }
   }
 
+  // Skip the keys out of the key range derived from expression
+  if (context->coprocessor_) {
+    context->coprocessor_->NarrowRange(&context->range_);
+  }
+
   std::shared_ptr<RawEngine::Reader> reader = context->engine_->NewReader(context->cf_name_);
 
-  context->iter_ = reader->NewIterator(context->range_.start_key(), context->range_.end_key());
+  // The iterator is kept by ScanContinue, so is the read profile.
+  ReadProfile profile = ChooseReadProfile(max_fetch_cnt, context->coprocessor_ != nullptr, coprocessor);
+  context->iter_ = reader->NewIterator(context->range_.start_key(), context->range_.end_key(), profile);
 
   if (!context->iter_) {
     context->state_ = ScanState::kError;
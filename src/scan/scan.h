@@ -70,6 +70,9 @@ class ScanContext {
   // Is it possible to delete this object
   bool IsRecyclable();
 
+  // Read profile of the iterator, ScanContinue keep reading with it.
+  ReadProfile GetReadProfile();
+
  protected:
   friend class ScanHandler;
 
@@ -48,27 +48,41 @@ Buf::Buf(const std::string& buf, bool le) {
   this->le_ = le;
 }
 
+Buf::Buf(std::string_view buf, bool le) {
+  Init(buf);
+  this->le_ = le;
+}
+
 Buf::~Buf() {
   this->buf_.clear();
 }
 
 void Buf::Init(int size) {
   this->buf_.resize(size);
+  this->view_ = this->buf_;
   this->reverse_pos_ = size - 1;
 }
 
 void Buf::Init(std::string* buf) {
   this->buf_.resize(buf->size());
   this->buf_.assign(buf->begin(), buf->end());
+  this->view_ = this->buf_;
   this->reverse_pos_ = this->buf_.size() - 1;
 }
 
 void Buf::Init(const std::string& buf) {
   this->buf_.resize(buf.size());
   this->buf_.assign(buf.begin(), buf.end());
+  this->view_ = this->buf_;
   this->reverse_pos_ = this->buf_.size() - 1;
 }
 
+void Buf::Init(std::string_view buf) {
+  this->buf_.clear();
+  this->view_ = buf;
+  this->reverse_pos_ = this->view_.size() - 1;
+}
+
 void Buf::SetForwardPos(int fp) { this->forward_pos_ = fp; }
 
 void Buf::SetReversePos(int rp) { this->reverse_pos_ = rp; }
@@ -136,7 +150,7 @@ void Buf::ReverseWriteInt(int32_t i) {
   }
 }
 
-uint8_t Buf::Read() { return buf_.at(forward_pos_++); }
+uint8_t Buf::Read() { return view_.at(forward_pos_++); }
 
 int32_t Buf::ReadInt() {
   if (this->le_) {
@@ -161,7 +175,7 @@ int64_t Buf::ReadLong() {
   return l;
 }
 
-uint8_t Buf::ReverseRead() { return buf_.at(reverse_pos_--); }
+uint8_t Buf::ReverseRead() { return view_.at(reverse_pos_--); }
 
 int32_t Buf::ReverseReadInt() {
   if (this->le_) {
@@ -200,6 +214,7 @@ void Buf::EnsureRemainder(int length) {
     }
     reverse_pos_ = new_size - reverse_size - 1;
     buf_ = new_buf;
+    view_ = buf_;
   }
 }
 
@@ -17,6 +17,7 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace dingodb {
@@ -24,6 +25,8 @@ namespace dingodb {
 class Buf {
  private:
   std::string buf_;
+  // read view, refer to buf_ or external data which must outlive this Buf
+  std::string_view view_;
   int forward_pos_ = 0;
   int reverse_pos_ = 0;
   int count_ = 0;
@@ -36,10 +39,13 @@ class Buf {
   Buf(std::string* buf);
   Buf(const std::string& buf, bool le);
   Buf(const std::string& buf);
+  // read only and not copy buf
+  Buf(std::string_view buf, bool le);
   ~Buf();
   void Init(int size);
   void Init(std::string* buf);
   void Init(const std::string& buf);
+  void Init(std::string_view buf);
   void SetForwardPos(int fp);
   void SetReversePos(int rp);
   void Write(uint8_t b);
@@ -215,6 +215,11 @@ int RecordDecoder::Decode(const pb::common::KeyValue& key_value, std::vector<std
 
 int RecordDecoder::Decode(const std::string& key, const std::string& value, const std::vector<int>& column_indexes,
                           std::vector<std::any>& record) {
+  return Decode(std::string_view(key), std::string_view(value), column_indexes, record);
+}
+
+int RecordDecoder::Decode(std::string_view key, std::string_view value, const std::vector<int>& column_indexes,
+                          std::vector<std::any>& record) {
   Buf* key_buf = new Buf(key, this->le_);
   Buf* value_buf = new Buf(value, this->le_);
   if (key_buf->ReadLong() != common_id_) {
@@ -16,6 +16,8 @@
 #define DINGO_SERIAL_RECORD_DECODER_H_
 
 #include <memory>
+#include <string_view>
+#include <vector>
 
 #include "any"
 #include "functional"
@@ -58,8 +60,60 @@ class RecordDecoder {
              std::vector<std::any>& record /*output*/);
   int Decode(const std::string& key, const std::string& value, const std::vector<int>& column_indexes,
              std::vector<std::any>& record /*output*/);
+  // not copy key and value, such as decode from iterator.
+  int Decode(std::string_view key, std::string_view value, const std::vector<int>& column_indexes,
+             std::vector<std::any>& record /*output*/);
+
+  // Not box the columns to std::any, such as decode a batch of rows to typed columns.
+  // handler(index, std::optional<T>&& column) is called for the columns in column_indexes, others are skipped.
+  template <typename Handler>
+  int DecodeColumns(std::string_view key, std::string_view value, const std::vector<int>& column_indexes,
+                    Handler&& handler);
 };
 
+template <typename Handler>
+int RecordDecoder::DecodeColumns(std::string_view key, std::string_view value, const std::vector<int>& column_indexes,
+                                 Handler&& handler) {
+  Buf key_buf(key, this->le_);
+  Buf value_buf(value, this->le_);
+  if (key_buf.ReadLong() != common_id_) {
+    //"Wrong Common Id"
+    return -1;
+  }
+
+  if (key_buf.ReverseReadInt() != codec_version_) {
+    //"Wrong Codec Version"
+    return -1;
+  }
+
+  if (value_buf.ReadInt() != schema_version_) {
+    //"Wrong Schema Version"
+    return -1;
+  }
+
+  for (const auto& bs : *schemas_) {
+    if (!bs) {
+      continue;
+    }
+    VisitSchema(bs.get(), [&](auto* schema) {
+      if (!VectorFind(column_indexes, schema->GetIndex())) {
+        if (schema->IsKey()) {
+          schema->SkipKey(&key_buf);
+        } else {
+          schema->SkipValue(&value_buf);
+        }
+        return;
+      }
+      if (schema->IsKey()) {
+        handler(schema->GetIndex(), schema->DecodeKey(&key_buf));
+      } else {
+        handler(schema->GetIndex(), schema->DecodeValue(&value_buf));
+      }
+    });
+  }
+  return 0;
+}
+
 }  // namespace dingodb
 
 #endif
\ No newline at end of file
@@ -16,6 +16,9 @@
 #define DINGO_SERIAL_RECORD_ENCODER_H_
 
 #include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "any"
 #include "functional"
@@ -57,11 +60,75 @@ class RecordEncoder {
 
   int EncodeKeyPrefix(const std::vector<std::any>& record, int column_count, std::string& output);
 
+  // Not box the columns to std::any, getter(index, std::optional<T>& column) set the column of schema index,
+  // such as encode the rows of a batch of typed columns.
+  template <typename Getter>
+  int EncodeColumns(Getter&& getter, pb::common::KeyValue& key_value /*output*/);
+
+  template <typename Getter>
+  int EncodeKeyColumns(Getter&& getter, std::string& output);
+
+  template <typename Getter>
+  int EncodeValueColumns(Getter&& getter, std::string& output);
+
   int EncodeMaxKeyPrefix(std::string& output) const;
 
   int EncodeMinKeyPrefix(std::string& output) const;
 };
 
+template <typename Getter>
+int RecordEncoder::EncodeColumns(Getter&& getter, pb::common::KeyValue& key_value) {
+  int ret = EncodeKeyColumns(getter, *key_value.mutable_key());
+  if (ret < 0) {
+    return ret;
+  }
+  ret = EncodeValueColumns(getter, *key_value.mutable_value());
+  if (ret < 0) {
+    return ret;
+  }
+  return 0;
+}
+
+template <typename Getter>
+int RecordEncoder::EncodeKeyColumns(Getter&& getter, std::string& output) {
+  Buf key_buf(key_buf_size_, this->le_);
+  key_buf.EnsureRemainder(12);
+  key_buf.WriteLong(common_id_);
+  key_buf.ReverseWriteInt(codec_version_);
+  for (const auto& bs : *schemas_) {
+    if (!bs || !bs->IsKey()) {
+      continue;
+    }
+    VisitSchema(bs.get(), [&](auto* schema) {
+      decltype(schema->DecodeKey(nullptr)) column;
+      getter(schema->GetIndex(), column);
+      schema->EncodeKey(&key_buf, std::move(column));
+    });
+  }
+
+  key_buf.GetBytes(output);
+  return 0;
+}
+
+template <typename Getter>
+int RecordEncoder::EncodeValueColumns(Getter&& getter, std::string& output) {
+  Buf value_buf(value_buf_size_, this->le_);
+  value_buf.EnsureRemainder(4);
+  value_buf.WriteInt(schema_version_);
+  for (const auto& bs : *schemas_) {
+    if (!bs || bs->IsKey()) {
+      continue;
+    }
+    VisitSchema(bs.get(), [&](auto* schema) {
+      decltype(schema->DecodeValue(nullptr)) column;
+      getter(schema->GetIndex(), column);
+      schema->EncodeValue(&value_buf, std::move(column));
+    });
+  }
+
+  return value_buf.GetBytes(output);
+}
+
 }  // namespace dingodb
 
 #endif
\ No newline at end of file
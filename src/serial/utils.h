@@ -24,6 +24,7 @@
 #include "schema/base_schema.h"
 #include "schema/boolean_schema.h"
 #include "schema/double_schema.h"
+#include "schema/float_schema.h"
 #include "schema/integer_schema.h"
 #include "schema/long_schema.h"
 #include "schema/string_schema.h"
@@ -48,6 +49,33 @@ int SqlToElement(const pb::meta::TableDefinition& td, const std::vector<std::any
 
 bool IsLE();
 
+// Call f with the typed schema, such as DingoSchema<std::optional<int32_t>>*, no dynamic cast for every row.
+template <typename F>
+void VisitSchema(BaseSchema* schema, F&& f) {
+  switch (schema->GetType()) {
+    case BaseSchema::kBool:
+      f(static_cast<DingoSchema<std::optional<bool>>*>(schema));
+      break;
+    case BaseSchema::kInteger:
+      f(static_cast<DingoSchema<std::optional<int32_t>>*>(schema));
+      break;
+    case BaseSchema::kFloat:
+      f(static_cast<DingoSchema<std::optional<float>>*>(schema));
+      break;
+    case BaseSchema::kLong:
+      f(static_cast<DingoSchema<std::optional<int64_t>>*>(schema));
+      break;
+    case BaseSchema::kDouble:
+      f(static_cast<DingoSchema<std::optional<double>>*>(schema));
+      break;
+    case BaseSchema::kString:
+      f(static_cast<DingoSchema<std::optional<std::shared_ptr<std::string>>>*>(schema));
+      break;
+    default:
+      break;
+  }
+}
+
 }  // namespace dingodb
 
 #endif
\ No newline at end of file
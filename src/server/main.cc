@@ -337,6 +337,39 @@ bool SetGflagVariable() {
     }
   }
 
+  // Open braft leader lease, leader serve read locally within the lease.
+  if (google::SetCommandLineOption("raft_enable_leader_lease", "true").empty()) {
+    DINGO_LOG(ERROR) << "Fail to set raft_enable_leader_lease";
+    return false;
+  }
+
+  return true;
+}
+
+// Modify braft gflag variable by config
+bool SetRaftGflagVariable(std::shared_ptr<dingodb::Config> config) {
+  // Leader send heartbeat every election_timeout / election_heartbeat_factor to each follower,
+  // lower factor means less heartbeat rpc of all regions between store pair.
+  int heartbeat_factor = config->GetInt("raft.election_heartbeat_factor");
+  if (heartbeat_factor <= 0) {
+    heartbeat_factor = dingodb::Constant::kRaftElectionHeartbeatFactor;
+  }
+  if (google::SetCommandLineOption("raft_election_heartbeat_factor", std::to_string(heartbeat_factor).c_str())
+          .empty()) {
+    DINGO_LOG(ERROR) << "Fail to set raft_election_heartbeat_factor";
+    return false;
+  }
+
+  // Max log entries of one append entries rpc.
+  int max_entries_size = config->GetInt("raft.max_append_entries_size");
+  if (max_entries_size <= 0) {
+    max_entries_size = dingodb::Constant::kRaftMaxAppendEntriesSize;
+  }
+  if (google::SetCommandLineOption("raft_max_entries_size", std::to_string(max_entries_size).c_str()).empty()) {
+    DINGO_LOG(ERROR) << "Fail to set raft_max_entries_size";
+    return false;
+  }
+
   return true;
 }
 
@@ -418,6 +451,11 @@ int main(int argc, char *argv[]) {
     return -1;
   }
 
+  if (!SetRaftGflagVariable(config)) {
+    DINGO_LOG(ERROR) << "SetRaftGflagVariable failed!";
+    return -1;
+  }
+
   dingo_server->SetServerEndpoint(GetServerEndPoint(config));
   dingo_server->SetRaftEndpoint(GetRaftEndPoint(config));
 
@@ -29,6 +29,7 @@
 #include "common/logging.h"
 #include "config/config.h"
 #include "config/config_manager.h"
+#include "coprocessor/aggregation_manager.h"
 #include "coordinator/coordinator_control.h"
 #include "engine/engine.h"
 #include "engine/mem_engine.h"
@@ -118,6 +119,21 @@ bool Server::InitDirectory() {
     }
   }
 
+  if (role_ == pb::common::ClusterRole::STORE) {
+    // Coprocessor aggregation spill to the data disk instead of /tmp.
+    std::string spill_path = config->GetString(Constant::kSpillPath);
+    if (spill_path.empty()) {
+      spill_path = fmt::format("{}/spill", db_path.parent_path().string());
+    }
+    if (!std::filesystem::exists(spill_path)) {
+      if (!std::filesystem::create_directories(spill_path)) {
+        DINGO_LOG(ERROR) << "Create spill directory failed: " << spill_path;
+        return false;
+      }
+    }
+    AggregationSpillFile::SetDirectory(spill_path);
+  }
+
   return true;
 }
 
@@ -234,7 +250,17 @@ bool Server::InitStorage() {
 bool Server::InitStoreMetaManager() {
   store_meta_manager_ = std::make_shared<StoreMetaManager>(std::make_shared<MetaReader>(raw_engine_),
                                                            std::make_shared<MetaWriter>(raw_engine_));
-  return store_meta_manager_->Init();
+  if (!store_meta_manager_->Init()) {
+    return false;
+  }
+
+  // Compaction drop the data out of the regions
+  auto raw_rocks_engine = std::dynamic_pointer_cast<RawRocksEngine>(raw_engine_);
+  if (raw_rocks_engine != nullptr) {
+    store_meta_manager_->GetStoreRegionMeta()->SetRangesListener(
+        [raw_rocks_engine](const std::vector<pb::common::Range>& ranges) { raw_rocks_engine->SetLiveRanges(ranges); });
+  }
+  return true;
 }
 
 bool Server::InitCrontabManager() {
@@ -282,6 +308,50 @@ bool Server::InitCrontabManager() {
       crontab_manager_->AddAndRunCrontab(metrics_crontab);
     }
 
+    // Add region hibernate crontab, also check the leader of hibernated followers
+    int hibernate_idle_time_ms = config->GetInt("raft.hibernate_idle_time_ms");
+    if (hibernate_idle_time_ms > 0) {
+      std::shared_ptr<Crontab> hibernate_crontab = std::make_shared<Crontab>();
+      hibernate_crontab->name = "HIBERNATE";
+      hibernate_crontab->interval = std::max(config->GetInt("raft.election_timeout"), 1000);
+      hibernate_crontab->func = [](void*) {
+        // Rpc to the leader stores, not block the timer thread.
+        bthread_t tid;
+        const bthread_attr_t attr = BTHREAD_ATTR_NORMAL;
+        bthread_start_background(
+            &tid, &attr,
+            [](void*) -> void* {
+              auto raft_kv_engine = std::dynamic_pointer_cast<RaftKvEngine>(Server::GetInstance()->GetEngine());
+              if (raft_kv_engine != nullptr) {
+                raft_kv_engine->CheckHibernate();
+              }
+              return nullptr;
+            },
+            nullptr);
+      };
+      hibernate_crontab->arg = nullptr;
+
+      crontab_manager_->AddAndRunCrontab(hibernate_crontab);
+    }
+
+    // Add orphan data compaction crontab
+    int orphan_compact_interval_s = config->GetInt(Constant::kOrphanCompactIntervalS);
+    if (orphan_compact_interval_s > 0) {
+      std::shared_ptr<Crontab> orphan_compact_crontab = std::make_shared<Crontab>();
+      orphan_compact_crontab->name = "ORPHAN_COMPACT";
+      orphan_compact_crontab->interval = orphan_compact_interval_s * 1000;
+      orphan_compact_crontab->func = [](void*) {
+        // Only queue the task, the compaction run on the compactor thread of engine.
+        auto raw_rocks_engine = std::dynamic_pointer_cast<RawRocksEngine>(Server::GetInstance()->GetRawEngine());
+        if (raw_rocks_engine != nullptr) {
+          raw_rocks_engine->CompactOrphanRanges();
+        }
+      };
+      orphan_compact_crontab->arg = nullptr;
+
+      crontab_manager_->AddAndRunCrontab(orphan_compact_crontab);
+    }
+
     // Add scan crontab
     ScanManager::GetInstance()->Init(config);
     uint64_t scan_interval = config->GetInt(Constant::kStoreScan + "." + Constant::kStoreScanScanIntervalMs);
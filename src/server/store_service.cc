@@ -156,6 +156,51 @@ void StoreServiceImpl::TransferLeader(google::protobuf::RpcController* controlle
   }
 }
 
+void StoreServiceImpl::CheckHibernate(google::protobuf::RpcController* controller,
+                                      const pb::store::CheckHibernateRequest* request,
+                                      pb::store::CheckHibernateResponse* response, google::protobuf::Closure* done) {
+  brpc::ClosureGuard done_guard(done);
+
+  auto engine = Server::GetInstance()->GetEngine();
+  if (engine->GetID() != pb::common::ENG_RAFT_STORE) {
+    auto* mut_err = response->mutable_error();
+    mut_err->set_errcode(pb::error::ENOT_SUPPORT);
+    mut_err->set_errmsg("Not raft store");
+    return;
+  }
+
+  auto raft_kv_engine = std::dynamic_pointer_cast<RaftKvEngine>(engine);
+  for (auto region_id : request->region_ids()) {
+    auto node = raft_kv_engine->GetNode(region_id);
+    if (node != nullptr && node->IsLeader()) {
+      response->add_leader_region_ids(region_id);
+    }
+  }
+}
+
+void StoreServiceImpl::ReadIndex(google::protobuf::RpcController* controller,
+                                 const pb::store::ReadIndexRequest* request, pb::store::ReadIndexResponse* response,
+                                 google::protobuf::Closure* done) {
+  brpc::Controller* cntl = (brpc::Controller*)controller;
+  brpc::ClosureGuard done_guard(done);
+
+  std::shared_ptr<Context> ctx = std::make_shared<Context>(cntl, done);
+  ctx->SetRegionId(request->region_id());
+
+  uint64_t read_index = 0;
+  auto status = storage_->ReadIndex(ctx, read_index);
+  if (!status.ok()) {
+    auto* err = response->mutable_error();
+    err->set_errcode(static_cast<Errno>(status.error_code()));
+    err->set_errmsg(status.error_str());
+    DINGO_LOG(WARNING) << fmt::format("ReadIndex request: {} response: {}", request->ShortDebugString(),
+                                      response->ShortDebugString());
+    return;
+  }
+
+  response->set_read_index(read_index);
+}
+
 butil::Status ValidateKvGetRequest(const dingodb::pb::store::KvGetRequest* request) {
   if (request->key().empty()) {
     return butil::Status(pb::error::EKEY_EMPTY, "Key is empty");
@@ -188,6 +233,8 @@ void StoreServiceImpl::KvGet(google::protobuf::RpcController* controller,
 
   std::shared_ptr<Context> ctx = std::make_shared<Context>(cntl, done);
   ctx->SetRegionId(request->region_id()).SetCfName(Constant::kStoreDataCF);
+  ctx->SetFollowerRead(request->follower_read());
+  ctx->SetMaxStalenessMs(request->max_staleness_ms());
   std::vector<std::string> keys;
   auto* mut_request = const_cast<dingodb::pb::store::KvGetRequest*>(request);
   keys.emplace_back(std::move(*mut_request->release_key()));
@@ -254,6 +301,8 @@ void StoreServiceImpl::KvBatchGet(google::protobuf::RpcController* controller,
 
   std::shared_ptr<Context> ctx = std::make_shared<Context>(cntl, done);
   ctx->SetRegionId(request->region_id()).SetCfName(Constant::kStoreDataCF);
+  ctx->SetFollowerRead(request->follower_read());
+  ctx->SetMaxStalenessMs(request->max_staleness_ms());
 
   std::vector<pb::common::KeyValue> kvs;
   auto* mut_request = const_cast<dingodb::pb::store::KvBatchGetRequest*>(request);
@@ -309,6 +358,7 @@ void StoreServiceImpl::KvPut(google::protobuf::RpcController* controller,
 
   std::shared_ptr<Context> ctx = std::make_shared<Context>(cntl, done_guard.release(), request, response);
   ctx->SetRegionId(request->region_id()).SetCfName(Constant::kStoreDataCF);
+  ctx->SetBlindWrite(true);
 
   auto* mut_request = const_cast<dingodb::pb::store::KvPutRequest*>(request);
   std::vector<pb::common::KeyValue> kvs;
@@ -367,6 +417,7 @@ void StoreServiceImpl::KvBatchPut(google::protobuf::RpcController* controller,
 
   std::shared_ptr<Context> ctx = std::make_shared<Context>(cntl, done_guard.release(), request, response);
   ctx->SetRegionId(request->region_id()).SetCfName(Constant::kStoreDataCF);
+  ctx->SetBlindWrite(true);
   auto* mut_request = const_cast<dingodb::pb::store::KvBatchPutRequest*>(request);
   status = storage_->KvPut(ctx, Helper::PbRepeatedToVector(mut_request->mutable_kvs()));
   if (!status.ok()) {
@@ -534,6 +585,7 @@ void StoreServiceImpl::KvBatchDelete(google::protobuf::RpcController* controller
 
   std::shared_ptr<Context> const ctx = std::make_shared<Context>(cntl, done_guard.release(), request, response);
   ctx->SetRegionId(request->region_id()).SetCfName(Constant::kStoreDataCF);
+  ctx->SetBlindWrite(request->blind_write());
   auto* mut_request = const_cast<dingodb::pb::store::KvBatchDeleteRequest*>(request);
   status = storage_->KvDelete(ctx, Helper::PbRepeatedToVector(mut_request->mutable_keys()));
   if (!status.ok()) {
@@ -602,6 +654,7 @@ void StoreServiceImpl::KvDeleteRange(google::protobuf::RpcController* controller
 
   std::shared_ptr<Context> const ctx = std::make_shared<Context>(cntl, done_guard.release(), request, response);
   ctx->SetRegionId(request->region_id()).SetCfName(Constant::kStoreDataCF);
+  ctx->SetBlindWrite(request->blind_write());
   auto* mut_request = const_cast<dingodb::pb::store::KvDeleteRangeRequest*>(request);
   status = storage_->KvDeleteRange(ctx, correction_range);
   if (!status.ok()) {
@@ -786,6 +839,8 @@ void StoreServiceImpl::KvScanBegin(google::protobuf::RpcController* controller,
 
   std::shared_ptr<Context> ctx = std::make_shared<Context>(cntl, done);
   ctx->SetRegionId(request->region_id()).SetCfName(Constant::kStoreDataCF);
+  ctx->SetFollowerRead(request->follower_read());
+  ctx->SetMaxStalenessMs(request->max_staleness_ms());
 
   std::vector<pb::common::KeyValue> kvs;  // NOLINT
   std::string scan_id;                    // NOLINT
@@ -41,6 +41,12 @@ class StoreServiceImpl : public pb::store::StoreService {
   void TransferLeader(google::protobuf::RpcController* controller, const pb::store::TransferLeaderRequest* request,
                       pb::store::TransferLeaderResponse* response, google::protobuf::Closure* done) override;
 
+  void CheckHibernate(google::protobuf::RpcController* controller, const pb::store::CheckHibernateRequest* request,
+                      pb::store::CheckHibernateResponse* response, google::protobuf::Closure* done) override;
+
+  void ReadIndex(google::protobuf::RpcController* controller, const pb::store::ReadIndexRequest* request,
+                 pb::store::ReadIndexResponse* response, google::protobuf::Closure* done) override;
+
   void KvGet(google::protobuf::RpcController* controller, const pb::store::KvGetRequest* request,
              pb::store::KvGetResponse* response, google::protobuf::Closure* done) override;
 
@@ -80,7 +80,25 @@ void HeartbeatTask::SendStoreHeartbeat(std::shared_ptr<CoordinatorInteraction> c
     }
   }
   for (const auto& region_meta : region_metas) {
+    std::shared_ptr<RaftNode> raft_node = nullptr;
+    if ((region_meta->State() == pb::common::StoreRegionState::NORMAL ||
+         region_meta->State() == pb::common::StoreRegionState::STANDBY ||
+         region_meta->State() == pb::common::StoreRegionState::SPLITTING ||
+         region_meta->State() == pb::common::StoreRegionState::MERGING) &&
+        raft_kv_engine != nullptr) {
+      raft_node = raft_kv_engine->GetNode(region_meta->Id());
+    }
+
     pb::common::RegionMetrics tmp_region_metrics;
+    tmp_region_metrics.set_id(region_meta->Id());
+    if (raft_node != nullptr && raft_node->IsHibernated()) {
+      // Hibernated region is unchanged, the coordinator keep its last metrics.
+      tmp_region_metrics.mutable_region_definition()->set_epoch(region_meta->InnerRegion().definition().epoch());
+      tmp_region_metrics.set_is_hibernated(true);
+      mut_region_metrics_map->insert({region_meta->Id(), tmp_region_metrics});
+      continue;
+    }
+
     auto metrics = region_metrics->GetMetrics(region_meta->Id());
     if (metrics != nullptr) {
       tmp_region_metrics.CopyFrom(metrics->InnerRegionMetrics());
@@ -90,16 +108,8 @@ void HeartbeatTask::SendStoreHeartbeat(std::shared_ptr<CoordinatorInteraction> c
     tmp_region_metrics.set_leader_store_id(region_meta->LeaderId());
     tmp_region_metrics.set_store_region_state(region_meta->State());
     tmp_region_metrics.mutable_region_definition()->CopyFrom(region_meta->InnerRegion().definition());
-
-    if ((region_meta->State() == pb::common::StoreRegionState::NORMAL ||
-         region_meta->State() == pb::common::StoreRegionState::STANDBY ||
-         region_meta->State() == pb::common::StoreRegionState::SPLITTING ||
-         region_meta->State() == pb::common::StoreRegionState::MERGING) &&
-        raft_kv_engine != nullptr) {
-      auto raft_node = raft_kv_engine->GetNode(region_meta->Id());
-      if (raft_node != nullptr) {
-        tmp_region_metrics.mutable_braft_status()->CopyFrom(*raft_node->GetStatus());
-      }
+    if (raft_node != nullptr) {
+      tmp_region_metrics.mutable_braft_status()->CopyFrom(*raft_node->GetStatus());
     }
 
     mut_region_metrics_map->insert({region_meta->Id(), tmp_region_metrics});
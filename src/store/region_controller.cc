@@ -163,7 +163,11 @@ butil::Status DeleteRegionTask::DeleteRegion(std::shared_ptr<Context> ctx, uint6
   // Delete data
   DINGO_LOG(DEBUG) << fmt::format("Delete region {} delete data", region_id);
   auto writer = engine->GetRawEngine()->NewWriter(Constant::kStoreDataCF);
-  writer->KvDeleteRange(region->Range());
+  writer->KvDeleteRange(region->Range(), true);
+  auto row_cache = engine->GetRawEngine()->GetRowCache(Constant::kStoreDataCF);
+  if (row_cache != nullptr) {
+    row_cache->EraseRange(region->Range().start_key(), region->Range().end_key());
+  }
 
   // Raft kv engine
   if (engine->GetID() == pb::common::ENG_RAFT_STORE) {
@@ -17,6 +17,10 @@
 
 #include <gtest/gtest.h>
 
+#include <string>
+#include <vector>
+
+#include "codec.h"
 #include "operand_stack.h"
 #include "types.h"
 
@@ -63,6 +67,13 @@ testing::AssertionResult EqualsByType(int type, const Operand &actual, const Ope
   }
 }
 
+// Bytecode of hex string.
+inline std::vector<byte> Code(const std::string &hex) {
+  std::vector<byte> code(hex.size() / 2);
+  HexToBytes(code.data(), hex.data(), hex.size());
+  return code;
+}
+
 }  // namespace dingodb::expr
 
 #endif  // DINGODB_EXPR_ASSERTIONS_H_
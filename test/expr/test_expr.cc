@@ -12,7 +12,9 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <string>
 #include <tuple>
+#include <vector>
 
 #include "assertions.h"
 #include "codec.h"
@@ -109,3 +111,35 @@ INSTANTIATE_TEST_SUITE_P(  // Test cases with vars
         std::make_tuple("3501128080808008f0529505", &tuple3,  // t1 < 2147483648
                         TYPE_BOOL, wrap<bool>(true))          // true
         ));
+
+TEST(RunnerTest, Reuse) {
+  auto code = Code("310031018301");  // t0 + t1
+  Runner runner;
+  runner.Decode(code.data(), code.size());
+  EXPECT_EQ(runner.Run<int32_t>(&tuple1), wrap<int32_t>(3));
+
+  Tuple tuple{wrap<int32_t>(), wrap<int32_t>(2)};
+  EXPECT_EQ(runner.Run<int32_t>(&tuple), wrap<int32_t>());
+
+  // The copy has its own stack.
+  Runner copy = runner;
+  EXPECT_EQ(copy.Run<int32_t>(&tuple1), wrap<int32_t>(3));
+}
+
+TEST(RunnerTest, TypeMismatch) {
+  Runner runner;
+  auto code = Code("3100");  // t0
+  runner.Decode(code.data(), code.size());
+  EXPECT_THROW(runner.Run<int32_t>(&tuple2), std::bad_any_cast);
+  EXPECT_THROW(runner.Run<int64_t>(&tuple1), std::bad_any_cast);
+  // Still usable after throw.
+  EXPECT_EQ(runner.Run<int32_t>(&tuple1), wrap<int32_t>(1));
+}
+
+TEST(RunnerTest, BadCode) {
+  Runner runner;
+  auto code = Code("31008301");  // t0 +
+  EXPECT_THROW(runner.Decode(code.data(), code.size()), std::runtime_error);
+  code = Code("11011101830B");  // 1 + 1 of unknown type
+  EXPECT_THROW(runner.Decode(code.data(), code.size()), std::runtime_error);
+}
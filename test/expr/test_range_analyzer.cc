@@ -0,0 +1,74 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "assertions.h"
+#include "codec.h"
+#include "range_analyzer.h"
+
+using namespace dingodb::expr;
+
+static constexpr int64_t kMin = std::numeric_limits<int64_t>::min();
+static constexpr int64_t kMax = std::numeric_limits<int64_t>::max();
+
+class RangeAnalyzerTest : public testing::TestWithParam<std::tuple<std::string, int64_t, int64_t>> {};
+
+TEST_P(RangeAnalyzerTest, Analyze) {
+  auto &para = GetParam();
+  auto code = Code(std::get<0>(para));
+  VarRange range;
+  ASSERT_TRUE(RangeAnalyzer::Analyze(code.data(), code.size(), 0, range));
+  EXPECT_EQ(std::get<1>(para), range.min);
+  EXPECT_EQ(std::get<2>(para), range.max);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    RangeExpr, RangeAnalyzerTest,
+    testing::Values(                                                        //
+        std::make_tuple("310011059301", 6, kMax),                           // t0 > 5
+        std::make_tuple("110531009501", 6, kMax),                           // 5 < t0
+        std::make_tuple("310011079101", 7, 7),                              // t0 == 7
+        std::make_tuple("310021039201", -3, kMax),                          // t0 >= -3
+        std::make_tuple("3200120A9302", 11, kMax),                          // int64 t0 > 10L
+        std::make_tuple("3100110593013100110A950152", 6, 9),                // t0 > 5 && t0 < 10
+        std::make_tuple("3100110593013101110A950152", 6, kMax),             // t0 > 5 && t1 < 10
+        std::make_tuple("31001101910131001103910153", 1, 3),                // t0 == 1 || t0 == 3
+        std::make_tuple("31001105930131001103950152", kMax, kMin)           // t0 > 5 && t0 < 3
+        ));
+
+TEST(RangeAnalyzerTest, NotSupport) {
+  VarRange range;
+  // t0 > 5 || t0 < 10
+  auto code = Code("3100110593013100110A950153");
+  EXPECT_FALSE(RangeAnalyzer::Analyze(code.data(), code.size(), 0, range));
+  // !(t0 > 5)
+  code = Code("31001105930151");
+  EXPECT_FALSE(RangeAnalyzer::Analyze(code.data(), code.size(), 0, range));
+  // t1 < 10
+  code = Code("3101110A9501");
+  EXPECT_FALSE(RangeAnalyzer::Analyze(code.data(), code.size(), 0, range));
+  // int64(t0) > 5L
+  code = Code("3100F02112059302");
+  EXPECT_FALSE(RangeAnalyzer::Analyze(code.data(), code.size(), 0, range));
+  // string variable
+  code = Code("3700");
+  EXPECT_FALSE(RangeAnalyzer::Analyze(code.data(), code.size(), 0, range));
+}
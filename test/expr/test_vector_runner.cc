@@ -0,0 +1,170 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <limits>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "assertions.h"
+#include "codec.h"
+#include "runner.h"
+#include "vector_runner.h"
+
+using namespace dingodb::expr;
+
+// Columns: t0 int32, t1 int32, t2 double
+static std::vector<Tuple> batch_tuples{
+    {wrap<int32_t>(1), wrap<int32_t>(2), wrap<double>(3.5)},
+    {wrap<int32_t>(6), wrap<int32_t>(9), wrap<double>(8.0)},
+    {wrap<int32_t>(), wrap<int32_t>(3), wrap<double>(7.9)},
+    {wrap<int32_t>(10), wrap<int32_t>(), wrap<double>()},
+    {wrap<int32_t>(7), wrap<int32_t>(12), wrap<double>(1.0)},
+    {wrap<int32_t>(-3), wrap<int32_t>(-4), wrap<double>(7.8)},
+};
+
+static std::vector<ColumnVector> ToColumns(const VectorRunner &runner, const std::vector<Tuple> &tuples) {
+  std::vector<ColumnVector> columns(tuples[0].size());
+  for (const auto &[index, type] : runner.Columns()) {
+    columns[index].Reset(type, tuples.size());
+    for (size_t i = 0; i < tuples.size(); ++i) {
+      columns[index].Set(i, tuples[i][index]);
+    }
+  }
+  return columns;
+}
+
+class VectorRunnerTest : public testing::TestWithParam<std::tuple<std::string, int>> {};
+
+// Result of every row is same as Runner.
+TEST_P(VectorRunnerTest, Run) {
+  auto &para = GetParam();
+  auto code = Code(std::get<0>(para));
+
+  VectorRunner vector_runner;
+  ASSERT_TRUE(vector_runner.Decode(code.data(), code.size()));
+  EXPECT_EQ(std::get<1>(para), vector_runner.ResultType());
+  auto columns = ToColumns(vector_runner, batch_tuples);
+  const auto &result = vector_runner.Run(columns, batch_tuples.size());
+  ASSERT_EQ(batch_tuples.size(), result.Size());
+
+  Runner runner;
+  runner.Decode(code.data(), code.size());
+  for (size_t i = 0; i < batch_tuples.size(); ++i) {
+    EXPECT_TRUE(EqualsByType(std::get<1>(para), result.Get(i), runner.RunAny(&batch_tuples[i]))) << "row " << i;
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(  // Test cases compare with Runner
+    BatchExpr, VectorRunnerTest,
+    testing::Values(                                                     //
+        std::make_tuple("310011059301", TYPE_BOOL),                      // t0 > 5
+        std::make_tuple("3100110593013101110A950152", TYPE_BOOL),        // t0 > 5 && t1 < 10
+        std::make_tuple("3100110593013101110A950153", TYPE_BOOL),        // t0 > 5 || t1 < 10
+        std::make_tuple("31001105930151", TYPE_BOOL),                    // !(t0 > 5)
+        std::make_tuple("3100A101", TYPE_BOOL),                          // is_null(t0)
+        std::make_tuple("3100A201", TYPE_BOOL),                          // is_true(t0)
+        std::make_tuple("310031018301", TYPE_INT32),                     // t0 + t1
+        std::make_tuple("310031018501", TYPE_INT32),                     // t0 * t1
+        std::make_tuple("310031018601", TYPE_INT32),                     // t0 / t1
+        std::make_tuple("310031018701", TYPE_INT32),                     // t0 % t1
+        std::make_tuple("31008201", TYPE_INT32),                         // -t0
+        std::make_tuple("3100F02112059302", TYPE_BOOL),                  // int64(t0) > 5L
+        std::make_tuple("350215401F3333333333339305", TYPE_BOOL),        // t2 > 7.8
+        std::make_tuple("3100F05135028305", TYPE_DOUBLE),                // double(t0) + t2
+        std::make_tuple("310011059301350215401F333333333333950552", TYPE_BOOL)  // t0 > 5 && t2 < 7.8
+        ));
+
+TEST(VectorRunnerTest, Select) {
+  auto code = Code("3100110593013101110A950152");  // t0 > 5 && t1 < 10
+  VectorRunner vector_runner;
+  ASSERT_TRUE(vector_runner.Decode(code.data(), code.size()));
+  auto columns = ToColumns(vector_runner, batch_tuples);
+
+  std::vector<uint32_t> selection;
+  vector_runner.Select(columns, batch_tuples.size(), selection);
+  EXPECT_EQ(std::vector<uint32_t>({1}), selection);
+
+  // Select append to the selection.
+  code = Code("3100A101");  // is_null(t0)
+  ASSERT_TRUE(vector_runner.Decode(code.data(), code.size()));
+  vector_runner.Select(columns, batch_tuples.size(), selection);
+  EXPECT_EQ(std::vector<uint32_t>({1, 2}), selection);
+}
+
+// Integer divide by zero is null and min / -1 not overflow, same as Runner.
+TEST(VectorRunnerTest, DivideByZero) {
+  static constexpr int32_t kMin = std::numeric_limits<int32_t>::min();
+  std::vector<Tuple> tuples{
+      {wrap<int32_t>(5), wrap<int32_t>(0)},
+      {wrap<int32_t>(5), wrap<int32_t>(2)},
+      {wrap<int32_t>(kMin), wrap<int32_t>(-1)},
+  };
+  std::vector<std::vector<wrap<int32_t>>> expected{
+      {wrap<int32_t>(), wrap<int32_t>(2), wrap<int32_t>(kMin)},  // t0 / t1
+      {wrap<int32_t>(), wrap<int32_t>(1), wrap<int32_t>(0)},     // t0 % t1
+  };
+  std::vector<std::string> codes{"310031018601", "310031018701"};
+
+  for (size_t c = 0; c < codes.size(); ++c) {
+    auto code = Code(codes[c]);
+    VectorRunner vector_runner;
+    ASSERT_TRUE(vector_runner.Decode(code.data(), code.size()));
+    Runner runner;
+    runner.Decode(code.data(), code.size());
+
+    auto columns = ToColumns(vector_runner, tuples);
+    const auto &result = vector_runner.Run(columns, tuples.size());
+    for (size_t i = 0; i < tuples.size(); ++i) {
+      EXPECT_TRUE(EqualsByType(TYPE_INT32, result.Get(i), expected[c][i]));
+      EXPECT_TRUE(EqualsByType(TYPE_INT32, runner.RunAny(&tuples[i]), expected[c][i]));
+    }
+  }
+}
+
+TEST(VectorRunnerTest, NotSupport) {
+  VectorRunner vector_runner;
+  // string variable
+  auto code = Code("3700");
+  EXPECT_FALSE(vector_runner.Decode(code.data(), code.size()));
+  // operand type mismatch, t0 > 5L
+  code = Code("310012059301");
+  EXPECT_FALSE(vector_runner.Decode(code.data(), code.size()));
+  // stack underflow
+  code = Code("31009301");
+  EXPECT_FALSE(vector_runner.Decode(code.data(), code.size()));
+}
+
+// Typed access is the same as the operand of tuple, string column is only stored.
+TEST(VectorRunnerTest, ColumnVectorValue) {
+  ColumnVector column;
+  column.Reset(TYPE_BOOL, 2);
+  column.SetValue<bool>(0, wrap<bool>(true));
+  column.SetValue<bool>(1, wrap<bool>());
+  EXPECT_EQ(1, column.Values<uint8_t>()[0]);
+  EXPECT_EQ(wrap<bool>(true), column.GetValue<bool>(0));
+  EXPECT_EQ(wrap<bool>(), column.GetValue<bool>(1));
+  EXPECT_TRUE(EqualsByType(TYPE_BOOL, column.Get(0), wrap<bool>(true)));
+  EXPECT_THROW(column.SetValue<int32_t>(0, wrap<int32_t>(1)), std::bad_any_cast);
+
+  column.Reset(TYPE_STRING, 2);
+  column.Set(0, wrap<std::shared_ptr<std::string>>(std::make_shared<std::string>("abc")));
+  column.SetValue<std::shared_ptr<std::string>>(1, wrap<std::shared_ptr<std::string>>());
+  EXPECT_EQ("abc", *column.Strings()[0]);
+  EXPECT_EQ(0, column.Nulls()[0]);
+  EXPECT_EQ(1, column.Nulls()[1]);
+  auto value = std::any_cast<wrap<std::shared_ptr<std::string>>>(column.Get(0));
+  EXPECT_EQ("abc", *value.value());
+  EXPECT_FALSE(column.GetValue<std::shared_ptr<std::string>>(1).has_value());
+}
@@ -25,11 +25,13 @@
 #include <filesystem>
 #include <iostream>
 #include <iterator>
+#include <limits>
 #include <memory>
 #include <numeric>
 #include <optional>
 #include <random>
 #include <string>
+#include <tuple>
 #include <vector>
 
 #include "butil/status.h"
@@ -38,15 +40,20 @@
 #include "config/config.h"
 #include "config/yaml_config.h"
 #include "coprocessor/coprocessor.h"
+#include "coprocessor/coprocessor_plan.h"
+#include "coprocessor/utils.h"
 #include "engine/raw_rocks_engine.h"
 #include "proto/common.pb.h"
 #include "proto/error.pb.h"
 #include "proto/store_internal.pb.h"
+#include "serial/record_decoder.h"
 #include "serial/record_encoder.h"
 #include "server/server.h"
 
 namespace dingodb {  // NOLINT
 
+DECLARE_int32(coprocessor_batch_size);
+
 static const std::string kDefaultCf = "default";
 // static const std::string &kDefaultCf = "meta";
 
@@ -1481,6 +1488,384 @@ TEST_F(CoprocessorTest, ExecuteSelection) {
   std::cout << "key_values selection cnt : " << cnt << std::endl;
 }
 
+// selection all columns of the prepared rows
+static pb::store::Coprocessor BuildSelectionCoprocessor() {
+  pb::store::Coprocessor pb_coprocessor;
+  pb_coprocessor.set_schema_version(1);
+
+  const std::vector<::dingodb::pb::store::Schema_Type> types = {
+      ::dingodb::pb::store::Schema_Type::Schema_Type_BOOL,  ::dingodb::pb::store::Schema_Type::Schema_Type_INTEGER,
+      ::dingodb::pb::store::Schema_Type::Schema_Type_FLOAT, ::dingodb::pb::store::Schema_Type::Schema_Type_LONG,
+      ::dingodb::pb::store::Schema_Type::Schema_Type_DOUBLE, ::dingodb::pb::store::Schema_Type::Schema_Type_STRING};
+  const std::vector<bool> is_keys = {true, false, false, false, true, true};
+
+  auto *original_schema = pb_coprocessor.mutable_original_schema();
+  original_schema->set_common_id(1);
+  auto *result_schema = pb_coprocessor.mutable_result_schema();
+  result_schema->set_common_id(1);
+  for (size_t i = 0; i < types.size(); i++) {
+    for (auto *schema : {original_schema->add_schema(), result_schema->add_schema()}) {
+      schema->set_type(types[i]);
+      schema->set_is_key(is_keys[i]);
+      schema->set_is_nullable(true);
+      schema->set_index(i);
+    }
+  }
+
+  return pb_coprocessor;
+}
+
+// filter by expression, vectorized and row by row get the same rows
+TEST_F(CoprocessorTest, OpenAndExecuteSelectionExpr) {
+  butil::Status ok;
+
+  pb::store::Coprocessor pb_coprocessor = BuildSelectionCoprocessor();
+
+  // index 1 int32 > 1
+  std::string expression = Helper::HexToString("310111019301");
+  pb_coprocessor.set_expression(expression);
+
+  std::string my_min_key(min_key.c_str(), 8);
+  std::string my_max_key(max_key.c_str(), 8);
+
+  int32_t old_batch_size = FLAGS_coprocessor_batch_size;
+  // 0 is row by row, 3 rows batch the selected rows exceed the limit
+  for (int32_t batch_size : {0, 3, 1024}) {
+    FLAGS_coprocessor_batch_size = batch_size;
+
+    coprocessor->Close();
+    ok = coprocessor->Open(pb_coprocessor);
+    EXPECT_EQ(ok.error_code(), pb::error::OK);
+
+    std::shared_ptr<EngineIterator> iter =
+        engine->NewReader(kDefaultCf)->NewIterator(my_min_key, Helper::PrefixNext(my_max_key));
+    bool key_only = false;
+    size_t max_fetch_cnt = 2;
+    uint64_t max_bytes_rpc = 1000000000000000;
+    std::vector<pb::common::KeyValue> kvs;
+
+    iter->Start();
+
+    size_t cnt = 0;
+    while (true) {
+      ok = coprocessor->Execute(iter, key_only, max_fetch_cnt, max_bytes_rpc, &kvs);
+      EXPECT_EQ(ok.error_code(), pb::error::OK);
+      cnt += kvs.size();
+      if (kvs.empty()) {
+        break;
+      }
+      kvs.clear();
+    }
+
+    // 2, 4, 6, 7
+    EXPECT_EQ(cnt, 4) << "batch size : " << batch_size;
+  }
+
+  FLAGS_coprocessor_batch_size = old_batch_size;
+  coprocessor->Close();
+}
+
+// aggregation of the filtered rows, column-wise and row by row get the same groups
+TEST_F(CoprocessorTest, OpenAndExecuteAggregationExpr) {
+  butil::Status ok;
+
+  std::string my_min_key(min_key.c_str(), 8);
+  std::string my_max_key(max_key.c_str(), 8);
+
+  int32_t old_batch_size = FLAGS_coprocessor_batch_size;
+  // group by the first key column is stream aggregation, group by the value column is hash aggregation
+  for (int32_t group_by_column : {0, 1}) {
+    pb::store::Coprocessor pb_coprocessor = BuildSelectionCoprocessor();
+    // index 1 int32 > 1
+    pb_coprocessor.set_expression(Helper::HexToString("310111019301"));
+    pb_coprocessor.add_group_by_columns(group_by_column);
+
+    auto *result_schema = pb_coprocessor.mutable_result_schema();
+    auto group_by_type = result_schema->schema(group_by_column).type();
+    result_schema->clear_schema();
+    const std::vector<std::tuple<::dingodb::pb::store::AggregationType, int32_t, ::dingodb::pb::store::Schema_Type>>
+        aggregations = {
+            {::dingodb::pb::store::AggregationType::COUNT, -1, ::dingodb::pb::store::Schema_Type::Schema_Type_LONG},
+            {::dingodb::pb::store::AggregationType::SUM, 3, ::dingodb::pb::store::Schema_Type::Schema_Type_LONG},
+            {::dingodb::pb::store::AggregationType::MAX, 5, ::dingodb::pb::store::Schema_Type::Schema_Type_STRING},
+            {::dingodb::pb::store::AggregationType::MIN, 4, ::dingodb::pb::store::Schema_Type::Schema_Type_DOUBLE}};
+    auto *group_by_schema = result_schema->add_schema();
+    group_by_schema->set_type(group_by_type);
+    group_by_schema->set_is_key(true);
+    group_by_schema->set_is_nullable(true);
+    group_by_schema->set_index(0);
+    for (size_t i = 0; i < aggregations.size(); i++) {
+      auto *aggregation_operator = pb_coprocessor.add_aggregation_operators();
+      aggregation_operator->set_oper(std::get<0>(aggregations[i]));
+      aggregation_operator->set_index_of_column(std::get<1>(aggregations[i]));
+      auto *schema = result_schema->add_schema();
+      schema->set_type(std::get<2>(aggregations[i]));
+      schema->set_is_key(false);
+      schema->set_is_nullable(true);
+      schema->set_index(i + 1);
+    }
+
+    std::vector<std::string> expected_kvs;
+    for (int32_t batch_size : {0, 3, 1024}) {
+      FLAGS_coprocessor_batch_size = batch_size;
+
+      Coprocessor aggregation_coprocessor;
+      ok = aggregation_coprocessor.Open(pb_coprocessor);
+      EXPECT_EQ(ok.error_code(), pb::error::OK);
+
+      std::shared_ptr<EngineIterator> iter =
+          engine->NewReader(kDefaultCf)->NewIterator(my_min_key, Helper::PrefixNext(my_max_key));
+      iter->Start();
+
+      std::vector<std::string> result_kvs;
+      while (true) {
+        std::vector<pb::common::KeyValue> kvs;
+        ok = aggregation_coprocessor.Execute(iter, false, 1, 1000000000000000, &kvs);
+        EXPECT_EQ(ok.error_code(), pb::error::OK);
+        if (kvs.empty()) {
+          break;
+        }
+        for (const auto &kv : kvs) {
+          result_kvs.push_back(kv.key() + kv.value());
+        }
+      }
+
+      if (batch_size == 0) {
+        EXPECT_FALSE(result_kvs.empty());
+        expected_kvs = result_kvs;
+      } else {
+        EXPECT_EQ(result_kvs, expected_kvs) << "group by : " << group_by_column << " batch size : " << batch_size;
+      }
+    }
+  }
+
+  FLAGS_coprocessor_batch_size = old_batch_size;
+}
+
+// the same coprocessor share one plan
+TEST_F(CoprocessorTest, PlanCache) {
+  butil::Status ok;
+  CoprocessorPlanCache::GetInstance()->Clear();
+
+  pb::store::Coprocessor pb_coprocessor = BuildSelectionCoprocessor();
+  pb_coprocessor.set_expression(Helper::HexToString("310111019301"));
+
+  Coprocessor coprocessor1;
+  ok = coprocessor1.Open(pb_coprocessor);
+  EXPECT_EQ(ok.error_code(), pb::error::OK);
+  EXPECT_EQ(CoprocessorPlanCache::GetInstance()->Size(), 1);
+
+  Coprocessor coprocessor2;
+  ok = coprocessor2.Open(pb_coprocessor);
+  EXPECT_EQ(ok.error_code(), pb::error::OK);
+  EXPECT_EQ(CoprocessorPlanCache::GetInstance()->Size(), 1);
+
+  // close not affect the other scans
+  coprocessor1.Close();
+  Coprocessor coprocessor3;
+  ok = coprocessor3.Open(pb_coprocessor);
+  EXPECT_EQ(ok.error_code(), pb::error::OK);
+
+  pb_coprocessor.set_schema_version(2);
+  Coprocessor coprocessor4;
+  ok = coprocessor4.Open(pb_coprocessor);
+  EXPECT_EQ(ok.error_code(), pb::error::OK);
+  EXPECT_EQ(CoprocessorPlanCache::GetInstance()->Size(), 2);
+
+  // bad expression is not cached
+  pb_coprocessor.set_expression(Helper::HexToString("FF"));
+  Coprocessor coprocessor5;
+  ok = coprocessor5.Open(pb_coprocessor);
+  EXPECT_EQ(ok.error_code(), pb::error::EILLEGAL_PARAMTETERS);
+  EXPECT_EQ(CoprocessorPlanCache::GetInstance()->Size(), 2);
+}
+
+// order by limit, the first rows are returned at the end of scan
+TEST_F(CoprocessorTest, TopN) {
+  butil::Status ok;
+
+  pb::store::Coprocessor pb_coprocessor = BuildSelectionCoprocessor();
+  auto *sort_column = pb_coprocessor.add_sort_columns();
+  sort_column->set_index_of_column(1);
+  sort_column->set_is_desc(true);
+  pb_coprocessor.set_limit(3);
+
+  std::string my_min_key(min_key.c_str(), 8);
+  std::string my_max_key(max_key.c_str(), 8);
+
+  Coprocessor top_n_coprocessor;
+  ok = top_n_coprocessor.Open(pb_coprocessor);
+  EXPECT_EQ(ok.error_code(), pb::error::OK);
+
+  std::shared_ptr<EngineIterator> iter =
+      engine->NewReader(kDefaultCf)->NewIterator(my_min_key, Helper::PrefixNext(my_max_key));
+  std::vector<pb::common::KeyValue> kvs;
+  iter->Start();
+
+  size_t cnt = 0;
+  while (true) {
+    ok = top_n_coprocessor.Execute(iter, false, 2, 1000000000000000, &kvs);
+    EXPECT_EQ(ok.error_code(), pb::error::OK);
+    if (kvs.empty()) {
+      break;
+    }
+    cnt += kvs.size();
+    kvs.clear();
+  }
+  EXPECT_EQ(cnt, 3);
+
+  // limit exceed the max
+  pb_coprocessor.set_limit(std::numeric_limits<int64_t>::max());
+  Coprocessor huge_limit_coprocessor;
+  ok = huge_limit_coprocessor.Open(pb_coprocessor);
+  EXPECT_EQ(ok.error_code(), pb::error::EILLEGAL_PARAMTETERS);
+  pb_coprocessor.set_limit(3);
+
+  // not support with group by
+  pb_coprocessor.add_group_by_columns(0);
+  Coprocessor group_by_coprocessor;
+  ok = group_by_coprocessor.Open(pb_coprocessor);
+  EXPECT_NE(ok.error_code(), pb::error::OK);
+}
+
+// the scan range is narrowed by the predicates on the first key column
+TEST_F(CoprocessorTest, NarrowRange) {
+  butil::Status ok;
+
+  // int32 index 1 is the first key column
+  pb::store::Coprocessor pb_coprocessor = BuildSelectionCoprocessor();
+  for (auto *schema : {pb_coprocessor.mutable_original_schema(), pb_coprocessor.mutable_result_schema()}) {
+    schema->mutable_schema(0)->set_is_key(false);
+    schema->mutable_schema(1)->set_is_key(true);
+  }
+
+  // index 1 int32 > 5 && index 1 int32 < 10
+  pb_coprocessor.set_expression(Helper::HexToString("3101110593013101110A950152"));
+
+  auto serial_schemas = std::make_shared<std::vector<std::shared_ptr<BaseSchema>>>();
+  ok = Utils::TransToSerialSchema(pb_coprocessor.original_schema().schema(), &serial_schemas);
+  EXPECT_EQ(ok.error_code(), pb::error::OK);
+  RecordEncoder record_encoder(1, serial_schemas, 1);
+  auto encode_key = [&record_encoder](int32_t value) {
+    std::vector<std::any> record;
+    record.emplace_back(std::optional<bool>(true));
+    record.emplace_back(std::optional<int32_t>(value));
+    record.emplace_back(std::optional<float>(std::nullopt));
+    record.emplace_back(std::optional<int64_t>(std::nullopt));
+    record.emplace_back(std::optional<double>(1.0));
+    record.emplace_back(std::optional<std::shared_ptr<std::string>>(std::make_shared<std::string>("abc")));
+    pb::common::KeyValue key_value;
+    EXPECT_EQ(record_encoder.Encode(record, key_value), 0);
+    return key_value.key();
+  };
+
+  std::string my_min_key(min_key.c_str(), 8);
+  std::string my_max_key(max_key.c_str(), 8);
+  pb::common::Range scan_range;
+  scan_range.set_start_key(my_min_key);
+  scan_range.set_end_key(Helper::PrefixNext(my_max_key));
+
+  Coprocessor range_coprocessor;
+  ok = range_coprocessor.Open(pb_coprocessor);
+  EXPECT_EQ(ok.error_code(), pb::error::OK);
+
+  pb::common::Range range = scan_range;
+  range_coprocessor.NarrowRange(&range);
+  for (int32_t value : {6, 9}) {
+    std::string key = encode_key(value);
+    EXPECT_TRUE(key >= range.start_key() && key < range.end_key()) << value;
+  }
+  for (int32_t value : {5, 10}) {
+    std::string key = encode_key(value);
+    EXPECT_FALSE(key >= range.start_key() && key < range.end_key()) << value;
+  }
+
+  // index 1 int32 > 5 && index 1 int32 < 3, nothing to scan
+  pb_coprocessor.set_expression(Helper::HexToString("31011105930131011103950152"));
+  Coprocessor empty_coprocessor;
+  ok = empty_coprocessor.Open(pb_coprocessor);
+  EXPECT_EQ(ok.error_code(), pb::error::OK);
+  range = scan_range;
+  empty_coprocessor.NarrowRange(&range);
+  EXPECT_EQ(range.start_key(), range.end_key());
+
+  // !(index 1 int32 > 5), not narrowed
+  pb_coprocessor.set_expression(Helper::HexToString("31011105930151"));
+  Coprocessor not_coprocessor;
+  ok = not_coprocessor.Open(pb_coprocessor);
+  EXPECT_EQ(ok.error_code(), pb::error::OK);
+  range = scan_range;
+  not_coprocessor.NarrowRange(&range);
+  EXPECT_EQ(range.start_key(), scan_range.start_key());
+  EXPECT_EQ(range.end_key(), scan_range.end_key());
+}
+
+// group by the first key column, the finished groups are returned before the scan end
+TEST_F(CoprocessorTest, StreamAggregation) {
+  butil::Status ok;
+
+  pb::store::Coprocessor pb_coprocessor = BuildSelectionCoprocessor();
+  auto *result_schema = pb_coprocessor.mutable_result_schema();
+  result_schema->clear_schema();
+  auto *schema1 = result_schema->add_schema();
+  schema1->set_type(::dingodb::pb::store::Schema_Type::Schema_Type_BOOL);
+  schema1->set_is_key(true);
+  schema1->set_is_nullable(true);
+  schema1->set_index(0);
+  auto *schema2 = result_schema->add_schema();
+  schema2->set_type(::dingodb::pb::store::Schema_Type::Schema_Type_LONG);
+  schema2->set_is_key(false);
+  schema2->set_is_nullable(true);
+  schema2->set_index(1);
+
+  pb_coprocessor.add_group_by_columns(0);
+  auto *aggregation_operator = pb_coprocessor.add_aggregation_operators();
+  aggregation_operator->set_oper(::dingodb::pb::store::AggregationType::COUNT);
+  aggregation_operator->set_index_of_column(-1);
+
+  auto result_serial_schemas = std::make_shared<std::vector<std::shared_ptr<BaseSchema>>>();
+  ok = Utils::TransToSerialSchema(result_schema->schema(), &result_serial_schemas);
+  EXPECT_EQ(ok.error_code(), pb::error::OK);
+  RecordDecoder result_record_decoder(1, result_serial_schemas, 1);
+
+  std::string my_min_key(min_key.c_str(), 8);
+  std::string my_max_key(max_key.c_str(), 8);
+
+  Coprocessor stream_coprocessor;
+  ok = stream_coprocessor.Open(pb_coprocessor);
+  EXPECT_EQ(ok.error_code(), pb::error::OK);
+
+  std::shared_ptr<EngineIterator> iter =
+      engine->NewReader(kDefaultCf)->NewIterator(my_min_key, Helper::PrefixNext(my_max_key));
+  std::vector<pb::common::KeyValue> kvs;
+  iter->Start();
+
+  // null, false and true
+  size_t cnt = 0;
+  int64_t row_cnt = 0;
+  while (true) {
+    ok = stream_coprocessor.Execute(iter, false, 1, 1000000000000000, &kvs);
+    EXPECT_EQ(ok.error_code(), pb::error::OK);
+    if (kvs.empty()) {
+      break;
+    }
+    // the first group is returned when the second group begin
+    if (cnt == 0) {
+      EXPECT_TRUE(iter->HasNext());
+    }
+    for (const auto &kv : kvs) {
+      std::vector<std::any> record;
+      EXPECT_EQ(result_record_decoder.Decode(kv, record), 0);
+      row_cnt += std::any_cast<std::optional<int64_t>>(record[1]).value();
+    }
+    cnt += kvs.size();
+    kvs.clear();
+  }
+
+  EXPECT_EQ(cnt, 3);
+  EXPECT_EQ(row_cnt, 8);
+}
+
 // without Aggregation Key
 TEST_F(CoprocessorTest, OpenNoAggregationKey) {
   butil::Status ok;
@@ -15,18 +15,25 @@
 #include <gtest/gtest.h>
 
 #include <cstdint>
+#include <filesystem>
 #include <memory>
 #include <optional>
+#include <string>
 #include <vector>
 
 #include "butil/status.h"
 #include "coprocessor/aggregation_manager.h"
 #include "coprocessor/utils.h"
+#include "gflags/gflags.h"
 #include "proto/common.pb.h"
 #include "proto/store.pb.h"
+#include "serial/schema/long_schema.h"
+#include "serial/schema/string_schema.h"
 
 namespace dingodb {  // NOLINT
 
+DECLARE_int64(coprocessor_aggregation_memory_limit);
+
 class CoprocessorAggregationManagerTest : public testing::Test {
  protected:
   static void SetUpTestSuite() {}
@@ -2737,4 +2744,136 @@ TEST_F(CoprocessorAggregationManagerTest, CreateIterator) {
 
 TEST_F(CoprocessorAggregationManagerTest, Close) { aggregation_manager->Close(); }
 
+// Groups exceed memory limit are spilled, the result is merged and ordered by key.
+TEST_F(CoprocessorAggregationManagerTest, Spill) {
+  auto group_by_operator_serial_schemas = std::make_shared<std::vector<std::shared_ptr<BaseSchema>>>();
+  group_by_operator_serial_schemas->emplace_back(std::make_shared<DingoSchema<std::optional<int64_t>>>());
+  group_by_operator_serial_schemas->emplace_back(std::make_shared<DingoSchema<std::optional<int64_t>>>());
+  group_by_operator_serial_schemas->emplace_back(
+      std::make_shared<DingoSchema<std::optional<std::shared_ptr<std::string>>>>());
+  auto result_serial_schemas = std::make_shared<std::vector<std::shared_ptr<BaseSchema>>>();
+  result_serial_schemas->emplace_back(std::make_shared<DingoSchema<std::optional<int64_t>>>());
+  result_serial_schemas->emplace_back(std::make_shared<DingoSchema<std::optional<int64_t>>>());
+  result_serial_schemas->emplace_back(std::make_shared<DingoSchema<std::optional<std::shared_ptr<std::string>>>>());
+
+  ::google::protobuf::RepeatedPtrField<pb::store::AggregationOperator> aggregation_operators;
+  for (auto oper : {pb::store::AggregationType::SUM, pb::store::AggregationType::COUNT,
+                    pb::store::AggregationType::MAX}) {
+    pb::store::AggregationOperator aggregation_operator;
+    aggregation_operator.set_index_of_column(aggregation_operators.size());
+    aggregation_operator.set_oper(oper);
+    aggregation_operators.Add(std::move(aggregation_operator));
+  }
+
+  int64_t old_memory_limit = FLAGS_coprocessor_aggregation_memory_limit;
+  FLAGS_coprocessor_aggregation_memory_limit = 16 * 1024;
+
+  AggregationManager manager;
+  butil::Status ok = manager.Open(group_by_operator_serial_schemas, aggregation_operators, result_serial_schemas);
+  EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+
+  const int group_count = 2000;
+  for (int round = 0; round < 3; round++) {
+    for (int i = group_count - 1; i >= 0; i--) {
+      char key[16];
+      snprintf(key, sizeof(key), "key_%05d", i);
+      std::vector<std::any> record;
+      record.emplace_back(std::optional<int64_t>(i));
+      record.emplace_back(round == 1 ? std::optional<int64_t>(std::nullopt) : std::optional<int64_t>(round));
+      record.emplace_back(std::optional<std::shared_ptr<std::string>>(
+          std::make_shared<std::string>("value_" + std::to_string((round + i) % 3))));
+      ok = manager.Execute(key, record);
+      EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+    }
+  }
+  EXPECT_GT(manager.SpillFileCount(), 0);
+
+  int i = 0;
+  auto iter = manager.CreateIterator();
+  EXPECT_TRUE(iter->Status().ok());
+  while (iter->HasNext()) {
+    char key[16];
+    snprintf(key, sizeof(key), "key_%05d", i);
+    EXPECT_EQ(key, iter->GetKey());
+    const auto &value = iter->GetValue();
+    EXPECT_EQ(3 * i, std::any_cast<std::optional<int64_t>>((*value)[0]).value());
+    EXPECT_EQ(2, std::any_cast<std::optional<int64_t>>((*value)[1]).value());
+    EXPECT_EQ("value_2", *std::any_cast<std::optional<std::shared_ptr<std::string>>>((*value)[2]).value());
+    EXPECT_TRUE(iter->Next().ok());
+    i++;
+  }
+  EXPECT_EQ(group_count, i);
+
+  manager.Close();
+  FLAGS_coprocessor_aggregation_memory_limit = old_memory_limit;
+}
+
+TEST_F(CoprocessorAggregationManagerTest, SpillFile) {
+  const std::string spill_path = "./aggregation_spill_test";
+  std::filesystem::remove_all(spill_path);
+  std::filesystem::create_directories(spill_path);
+  AggregationSpillFile::SetDirectory(spill_path);
+
+  AggregationSpillFile spill_file;
+  EXPECT_TRUE(spill_file.Open().ok());
+  // Unlinked at once, nothing left in the directory.
+  EXPECT_TRUE(std::filesystem::is_empty(spill_path));
+  EXPECT_TRUE(spill_file.Write("key1", "states1").ok());
+  EXPECT_TRUE(spill_file.Write("key2", "").ok());
+  EXPECT_TRUE(spill_file.Rewind().ok());
+
+  std::string key;
+  std::string states;
+  bool eof = false;
+  EXPECT_TRUE(spill_file.Read(&key, &states, &eof).ok());
+  EXPECT_FALSE(eof);
+  EXPECT_EQ("key1", key);
+  EXPECT_EQ("states1", states);
+  EXPECT_TRUE(spill_file.Read(&key, &states, &eof).ok());
+  EXPECT_FALSE(eof);
+  EXPECT_EQ("key2", key);
+  EXPECT_EQ("", states);
+  EXPECT_TRUE(spill_file.Read(&key, &states, &eof).ok());
+  EXPECT_TRUE(eof);
+
+  // Directory not exist.
+  std::filesystem::remove_all(spill_path);
+  AggregationSpillFile missing_spill_file;
+  EXPECT_FALSE(missing_spill_file.Open().ok());
+
+  AggregationSpillFile::SetDirectory("");
+}
+
+// MAX of string replace the value in place, the memory usage follow it.
+TEST_F(CoprocessorAggregationManagerTest, StringMemoryUsage) {
+  auto group_by_operator_serial_schemas = std::make_shared<std::vector<std::shared_ptr<BaseSchema>>>();
+  group_by_operator_serial_schemas->emplace_back(
+      std::make_shared<DingoSchema<std::optional<std::shared_ptr<std::string>>>>());
+  auto result_serial_schemas = std::make_shared<std::vector<std::shared_ptr<BaseSchema>>>();
+  result_serial_schemas->emplace_back(std::make_shared<DingoSchema<std::optional<std::shared_ptr<std::string>>>>());
+
+  ::google::protobuf::RepeatedPtrField<pb::store::AggregationOperator> aggregation_operators;
+  pb::store::AggregationOperator aggregation_operator;
+  aggregation_operator.set_index_of_column(0);
+  aggregation_operator.set_oper(pb::store::AggregationType::MAX);
+  aggregation_operators.Add(std::move(aggregation_operator));
+
+  AggregationManager manager;
+  butil::Status ok = manager.Open(group_by_operator_serial_schemas, aggregation_operators, result_serial_schemas);
+  EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+
+  std::vector<std::any> record;
+  record.emplace_back(std::optional<std::shared_ptr<std::string>>(std::make_shared<std::string>("a")));
+  ok = manager.Execute("key", record);
+  EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+  size_t memory_usage = manager.MemoryUsage();
+
+  record[0] = std::optional<std::shared_ptr<std::string>>(std::make_shared<std::string>(64 * 1024, 'b'));
+  ok = manager.Execute("key", record);
+  EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+  EXPECT_GE(manager.MemoryUsage(), memory_usage + 64 * 1024);
+
+  manager.Close();
+}
+
 }  // namespace dingodb
@@ -0,0 +1,88 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <any>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "coprocessor/top_n.h"
+#include "proto/common.pb.h"
+
+namespace dingodb {  // NOLINT
+
+class CoprocessorTopNTest : public testing::Test {
+ protected:
+  static std::vector<std::any> MakeRecord(std::optional<int32_t> a, std::optional<std::string> b) {
+    std::vector<std::any> record;
+    record.emplace_back(a);
+    record.emplace_back(b.has_value() ? std::optional<std::shared_ptr<std::string>>(
+                                            std::make_shared<std::string>(b.value()))
+                                      : std::optional<std::shared_ptr<std::string>>(std::nullopt));
+    return record;
+  }
+
+  static std::vector<std::string> Run(TopN &top_n, const std::vector<std::vector<std::any>> &records) {
+    for (size_t i = 0; i < records.size(); i++) {
+      if (top_n.Accept(records[i])) {
+        pb::common::KeyValue key_value;
+        key_value.set_key(std::to_string(i));
+        top_n.Push(records[i], std::move(key_value));
+      }
+    }
+
+    std::vector<std::string> keys;
+    for (const auto &key_value : top_n.Finish()) {
+      keys.push_back(key_value.key());
+    }
+    return keys;
+  }
+};
+
+TEST_F(CoprocessorTopNTest, Asc) {
+  std::vector<std::vector<std::any>> records = {MakeRecord(5, "a"), MakeRecord(3, "b"),          MakeRecord(9, "c"),
+                                                MakeRecord(1, "d"), MakeRecord(std::nullopt, "e"), MakeRecord(7, "f")};
+
+  TopN top_n({SortKey{0, BaseSchema::kInteger, false}}, 3);
+  EXPECT_EQ(Run(top_n, records), std::vector<std::string>({"4", "3", "1"}));
+  EXPECT_EQ(top_n.Size(), 0);
+
+  // limit exceed the rows
+  TopN top_all({SortKey{0, BaseSchema::kInteger, false}}, 100);
+  EXPECT_EQ(Run(top_all, records), std::vector<std::string>({"4", "3", "1", "0", "5", "2"}));
+}
+
+TEST_F(CoprocessorTopNTest, DescMultiColumns) {
+  std::vector<std::vector<std::any>> records = {MakeRecord(5, "a"), MakeRecord(9, "b"), MakeRecord(9, "c"),
+                                                MakeRecord(1, "d"), MakeRecord(7, std::nullopt)};
+
+  // order by a desc, b asc
+  TopN top_n({SortKey{0, BaseSchema::kInteger, true}, SortKey{1, BaseSchema::kString, false}}, 3);
+  EXPECT_EQ(Run(top_n, records), std::vector<std::string>({"1", "2", "4"}));
+
+  // order by b desc, null is the last
+  TopN top_string({SortKey{1, BaseSchema::kString, true}}, 5);
+  EXPECT_EQ(Run(top_string, records), std::vector<std::string>({"3", "2", "1", "0", "4"}));
+}
+
+TEST_F(CoprocessorTopNTest, TypeMismatch) {
+  TopN top_n({SortKey{0, BaseSchema::kLong, false}}, 3);
+  EXPECT_THROW(top_n.Accept(MakeRecord(1, "a")), std::bad_any_cast);
+}
+
+}  // namespace dingodb
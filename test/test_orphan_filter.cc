@@ -0,0 +1,106 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "engine/orphan_filter.h"
+#include "proto/common.pb.h"
+
+static dingodb::pb::common::Range GenRange(const std::string &start_key, const std::string &end_key) {
+  dingodb::pb::common::Range range;
+  range.set_start_key(start_key);
+  range.set_end_key(end_key);
+  return range;
+}
+
+class OrphanFilterTest : public testing::Test {
+ protected:
+  void SetUp() override {}
+  void TearDown() override {}
+};
+
+TEST_F(OrphanFilterTest, LiveRanges) {
+  // Unsorted, [b, d) and [c, e) overlap while splitting, [e, f) is adjacent
+  dingodb::LiveRanges live_ranges({GenRange("m", "p"), GenRange("c", "e"), GenRange("b", "d"), GenRange("e", "f")});
+  ASSERT_EQ(2, live_ranges.Ranges().size());
+  EXPECT_EQ("b", live_ranges.Ranges()[0].start_key());
+  EXPECT_EQ("f", live_ranges.Ranges()[0].end_key());
+
+  size_t hint = 0;
+  EXPECT_FALSE(live_ranges.Contains("a", hint));
+  EXPECT_TRUE(live_ranges.Contains("b", hint));
+  EXPECT_TRUE(live_ranges.Contains("e1", hint));
+  EXPECT_FALSE(live_ranges.Contains("f", hint));
+  EXPECT_TRUE(live_ranges.Contains("m", hint));
+  EXPECT_EQ(1, hint);
+  EXPECT_FALSE(live_ranges.Contains("p", hint));
+  EXPECT_FALSE(live_ranges.Contains("z", hint));
+  // Hint of other range
+  EXPECT_TRUE(live_ranges.Contains("c", hint));
+  EXPECT_EQ(0, hint);
+
+  auto gaps = live_ranges.Gaps();
+  ASSERT_EQ(3, gaps.size());
+  EXPECT_EQ("", gaps[0].start_key());
+  EXPECT_EQ("b", gaps[0].end_key());
+  EXPECT_EQ("f", gaps[1].start_key());
+  EXPECT_EQ("m", gaps[1].end_key());
+  EXPECT_EQ("p", gaps[2].start_key());
+  EXPECT_EQ("", gaps[2].end_key());
+}
+
+TEST_F(OrphanFilterTest, Filter) {
+  auto live_ranges = std::make_shared<dingodb::LiveRanges>(
+      std::vector<dingodb::pb::common::Range>{GenRange("b", "d"), GenRange("m", "p")});
+  dingodb::OrphanFilter filter(live_ranges);
+
+  std::string new_value;
+  bool value_changed = false;
+  EXPECT_TRUE(filter.Filter(0, "a", "value", &new_value, &value_changed));
+  EXPECT_FALSE(filter.Filter(0, "b", "value", &new_value, &value_changed));
+  EXPECT_FALSE(filter.Filter(0, "c", "value", &new_value, &value_changed));
+  EXPECT_TRUE(filter.Filter(0, "d", "value", &new_value, &value_changed));
+  EXPECT_FALSE(filter.Filter(0, "n", "value", &new_value, &value_changed));
+  EXPECT_TRUE(filter.Filter(0, "q", "value", &new_value, &value_changed));
+  EXPECT_FALSE(value_changed);
+}
+
+TEST_F(OrphanFilterTest, Factory) {
+  dingodb::OrphanFilterFactory factory;
+  rocksdb::CompactionFilter::Context context;
+
+  // Not published
+  EXPECT_EQ(nullptr, factory.CreateCompactionFilter(context));
+
+  // No region
+  factory.SetLiveRanges(std::make_shared<dingodb::LiveRanges>(std::vector<dingodb::pb::common::Range>{}));
+  EXPECT_EQ(nullptr, factory.CreateCompactionFilter(context));
+
+  factory.SetLiveRanges(
+      std::make_shared<dingodb::LiveRanges>(std::vector<dingodb::pb::common::Range>{GenRange("b", "d")}));
+  auto filter = factory.CreateCompactionFilter(context);
+  ASSERT_NE(nullptr, filter);
+
+  // The created filter keep its ranges
+  factory.SetLiveRanges(
+      std::make_shared<dingodb::LiveRanges>(std::vector<dingodb::pb::common::Range>{GenRange("x", "z")}));
+  std::string new_value;
+  bool value_changed = false;
+  EXPECT_FALSE(filter->Filter(0, "c", "value", &new_value, &value_changed));
+  EXPECT_TRUE(filter->Filter(0, "y", "value", &new_value, &value_changed));
+}
@@ -0,0 +1,153 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "braft/configuration_manager.h"
+#include "braft/log_entry.h"
+#include "braft/storage.h"
+#include "raft/raft_log_storage.h"
+#include "rocksdb/cache.h"
+#include "rocksdb/write_buffer_manager.h"
+
+const std::string kLogStoragePath = "./raft_log_storage_test";
+
+class RaftLogStorageTest : public testing::Test {
+ protected:
+  static void SetUpTestSuite() {
+    std::filesystem::remove_all(kLogStoragePath);
+    // Memory budget shared with data engine.
+    block_cache = rocksdb::NewLRUCache(64 * 1024 * 1024);
+    write_buffer_manager = std::make_shared<rocksdb::WriteBufferManager>(32 * 1024 * 1024, block_cache);
+    ASSERT_TRUE(dingodb::RaftLogStorage::Init(kLogStoragePath, block_cache, write_buffer_manager));
+  }
+
+  static void TearDownTestSuite() {}
+
+  static std::unique_ptr<braft::LogStorage> NewLogStorage(uint64_t region_id) {
+    std::unique_ptr<braft::LogStorage> log_storage(
+        braft::LogStorage::create(dingodb::RaftLogStorage::GenUri(region_id)));
+    return log_storage;
+  }
+
+  static std::vector<braft::LogEntry*> GenEntries(int64_t start_index, int count, int64_t term) {
+    std::vector<braft::LogEntry*> entries;
+    for (int i = 0; i < count; ++i) {
+      auto* entry = new braft::LogEntry();
+      entry->AddRef();
+      entry->type = braft::ENTRY_TYPE_DATA;
+      entry->id = braft::LogId(start_index + i, term);
+      entry->data.append("data_" + std::to_string(start_index + i));
+      entries.push_back(entry);
+    }
+    return entries;
+  }
+
+  static void ReleaseEntries(std::vector<braft::LogEntry*>& entries) {
+    for (auto* entry : entries) {
+      entry->Release();
+    }
+    entries.clear();
+  }
+
+  inline static std::shared_ptr<rocksdb::Cache> block_cache;
+  inline static std::shared_ptr<rocksdb::WriteBufferManager> write_buffer_manager;
+};
+
+TEST_F(RaftLogStorageTest, AppendAndGet) {
+  auto log_storage = NewLogStorage(1001);
+  ASSERT_NE(nullptr, log_storage);
+  braft::ConfigurationManager conf_manager;
+  ASSERT_EQ(0, log_storage->init(&conf_manager));
+  EXPECT_EQ(1, log_storage->first_log_index());
+  EXPECT_EQ(0, log_storage->last_log_index());
+
+  auto entries = GenEntries(1, 10, 2);
+  EXPECT_EQ(10, log_storage->append_entries(entries, nullptr));
+  ReleaseEntries(entries);
+  EXPECT_EQ(10, log_storage->last_log_index());
+
+  // Discontinuous append is rejected.
+  entries = GenEntries(20, 1, 2);
+  EXPECT_EQ(-1, log_storage->append_entries(entries, nullptr));
+  ReleaseEntries(entries);
+
+  auto* entry = log_storage->get_entry(5);
+  ASSERT_NE(nullptr, entry);
+  EXPECT_EQ(2, entry->id.term);
+  EXPECT_EQ("data_5", entry->data.to_string());
+  entry->Release();
+  EXPECT_EQ(2, log_storage->get_term(10));
+  EXPECT_EQ(nullptr, log_storage->get_entry(11));
+
+  // Other region is isolated.
+  auto other_log_storage = NewLogStorage(1002);
+  ASSERT_EQ(0, other_log_storage->init(&conf_manager));
+  EXPECT_EQ(0, other_log_storage->last_log_index());
+}
+
+TEST_F(RaftLogStorageTest, Truncate) {
+  auto log_storage = NewLogStorage(1003);
+  braft::ConfigurationManager conf_manager;
+  ASSERT_EQ(0, log_storage->init(&conf_manager));
+
+  auto entries = GenEntries(1, 20, 1);
+  EXPECT_EQ(20, log_storage->append_entries(entries, nullptr));
+  ReleaseEntries(entries);
+
+  EXPECT_EQ(0, log_storage->truncate_prefix(6));
+  EXPECT_EQ(6, log_storage->first_log_index());
+  EXPECT_EQ(nullptr, log_storage->get_entry(5));
+
+  EXPECT_EQ(0, log_storage->truncate_suffix(15));
+  EXPECT_EQ(15, log_storage->last_log_index());
+  EXPECT_EQ(nullptr, log_storage->get_entry(16));
+
+  // Reload log index from log engine.
+  auto reload_log_storage = NewLogStorage(1003);
+  ASSERT_EQ(0, reload_log_storage->init(&conf_manager));
+  EXPECT_EQ(6, reload_log_storage->first_log_index());
+  EXPECT_EQ(15, reload_log_storage->last_log_index());
+
+  EXPECT_EQ(0, reload_log_storage->reset(100));
+  EXPECT_EQ(100, reload_log_storage->first_log_index());
+  EXPECT_EQ(99, reload_log_storage->last_log_index());
+  EXPECT_EQ(nullptr, reload_log_storage->get_entry(10));
+
+  EXPECT_TRUE(braft::LogStorage::destroy(dingodb::RaftLogStorage::GenUri(1003)).ok());
+  auto destroyed_log_storage = NewLogStorage(1003);
+  ASSERT_EQ(0, destroyed_log_storage->init(&conf_manager));
+  EXPECT_EQ(1, destroyed_log_storage->first_log_index());
+  EXPECT_EQ(0, destroyed_log_storage->last_log_index());
+}
+
+TEST_F(RaftLogStorageTest, MemoryBudget) {
+  auto log_storage = NewLogStorage(1004);
+  braft::ConfigurationManager conf_manager;
+  ASSERT_EQ(0, log_storage->init(&conf_manager));
+
+  auto entries = GenEntries(1, 100, 1);
+  EXPECT_EQ(100, log_storage->append_entries(entries, nullptr));
+  ReleaseEntries(entries);
+
+  // Memtables of log engine are charged to the shared write buffer manager and block cache.
+  EXPECT_GT(write_buffer_manager->memory_usage(), 0);
+  EXPECT_GT(block_cache->GetUsage(), 0);
+}
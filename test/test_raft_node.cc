@@ -19,6 +19,7 @@
 #include <filesystem>
 #include <iostream>
 #include <iterator>
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -27,14 +28,20 @@
 #include "butil/endpoint.h"
 #include "butil/strings/string_split.h"
 #include "butil/strings/stringprintf.h"
+#include "common/constant.h"
 #include "common/helper.h"
 #include "config/yaml_config.h"
 #include "event/store_state_machine_event.h"
+#include "gflags/gflags.h"
 #include "meta/store_meta_manager.h"
 #include "proto/common.pb.h"
 #include "raft/raft_node.h"
 #include "raft/store_state_machine.h"
 
+namespace braft {
+DECLARE_int32(raft_election_heartbeat_factor);
+}  // namespace braft
+
 const std::string kYamlConfigContent =
     "cluster:\n"
     "  name: dingodb\n"
@@ -168,6 +175,83 @@ std::vector<std::shared_ptr<dingodb::RaftNode>> LaunchRaftGroup(std::shared_ptr<
   return nodes;
 }
 
+// Region hibernate after idle 50ms, election timeout and heartbeat interval of hibernated region * 50,
+// so heartbeat interval is 20ms and 1s in hibernation.
+std::shared_ptr<dingodb::Config> LoadHibernateConfig() {
+  std::string content = kYamlConfigContent;
+  std::string const election_timeout = "  election_timeout: 1000 # ms\n";
+  content.replace(content.find(election_timeout), election_timeout.size(),
+                  "  election_timeout: 200 # ms\n  hibernate_idle_time_ms: 50 # ms\n  hibernate_timeout_factor: 50\n");
+
+  auto config = std::make_shared<dingodb::YamlConfig>();
+  if (config->Load(content) != 0) {
+    return nullptr;
+  }
+  return config;
+}
+
+std::shared_ptr<dingodb::RaftNode> WaitLeader(const std::vector<std::shared_ptr<dingodb::RaftNode>>& nodes,
+                                              int64_t timeout_ms) {
+  int64_t const deadline = dingodb::Helper::TimestampMs() + timeout_ms;
+  while (dingodb::Helper::TimestampMs() < deadline) {
+    for (const auto& node : nodes) {
+      if (node->IsLeader()) {
+        return node;
+      }
+    }
+    bthread_usleep(10 * 1000L);
+  }
+  return nullptr;
+}
+
+// Run the hibernate check like crontab, until all replicas hibernated.
+bool WaitHibernate(const std::vector<std::shared_ptr<dingodb::RaftNode>>& nodes, int64_t timeout_ms) {
+  int64_t const deadline = dingodb::Helper::TimestampMs() + timeout_ms;
+  while (dingodb::Helper::TimestampMs() < deadline) {
+    bool all_hibernated = true;
+    for (const auto& node : nodes) {
+      node->CheckHibernate();
+      all_hibernated = all_hibernated && node->IsHibernated();
+    }
+    if (all_hibernated) {
+      return true;
+    }
+    bthread_usleep(10 * 1000L);
+  }
+  return false;
+}
+
+bool WaitWakeUp(const std::vector<std::shared_ptr<dingodb::RaftNode>>& nodes, int64_t timeout_ms) {
+  int64_t const deadline = dingodb::Helper::TimestampMs() + timeout_ms;
+  while (dingodb::Helper::TimestampMs() < deadline) {
+    if (std::none_of(nodes.begin(), nodes.end(), [](const auto& node) { return node->IsHibernated(); })) {
+      return true;
+    }
+    bthread_usleep(10 * 1000L);
+  }
+  return false;
+}
+
+// Count the heartbeat and append entries rpc of leader in the duration, by the change of follower
+// last rpc send timestamp.
+int CountLeaderRpc(std::shared_ptr<dingodb::RaftNode> leader, int64_t duration_ms) {
+  int count = 0;
+  int64_t last_rpc_timestamp = 0;
+  int64_t const deadline = dingodb::Helper::TimestampMs() + duration_ms;
+  while (dingodb::Helper::TimestampMs() < deadline) {
+    int64_t rpc_timestamp = 0;
+    for (const auto& [_, follower] : leader->GetStatus()->stable_followers()) {
+      rpc_timestamp = std::max(rpc_timestamp, follower.last_rpc_send_timestamp());
+    }
+    if (last_rpc_timestamp > 0 && rpc_timestamp != last_rpc_timestamp) {
+      ++count;
+    }
+    last_rpc_timestamp = rpc_timestamp;
+    bthread_usleep(5 * 1000L);
+  }
+  return count;
+}
+
 class RaftNodeTest : public testing::Test {
  protected:
   static void SetUpTestSuite() {
@@ -371,4 +455,237 @@ TEST_F(RaftNodeTest, DeleteOnePeer) {
   }
 
   inner_nodes.clear();
-}
\ No newline at end of file
+}
+TEST_F(RaftNodeTest, GroupCommitClosureFanOut) {
+  auto raft_cmd = std::make_shared<dingodb::pb::raft::RaftCmdRequest>();
+  raft_cmd->mutable_header()->set_region_id(1000);
+
+  std::map<uint64_t, int> notify_counts;
+  auto write_cb = [&notify_counts](std::shared_ptr<dingodb::Context> ctx, butil::Status status) {
+    EXPECT_EQ(dingodb::pb::error::ERAFT_COMMITLOG, status.error_code());
+    ++notify_counts[ctx->RegionId()];
+  };
+
+  auto ctx1 = std::make_shared<dingodb::Context>();
+  ctx1->SetRegionId(1);
+  ctx1->SetWriteCb(write_cb);
+  auto ctx2 = std::make_shared<dingodb::Context>();
+  ctx2->SetRegionId(2);
+  ctx2->SetWriteCb(write_cb);
+
+  // ctx1 own two raft requests, ctx2 own one.
+  std::vector<std::shared_ptr<dingodb::Context>> ctxs = {ctx1, ctx1, ctx2};
+  auto* closure = new dingodb::StoreClosure(ctxs, raft_cmd);
+  EXPECT_EQ(ctx1, closure->GetCtx(1));
+  EXPECT_EQ(ctx2, closure->GetCtx(2));
+
+  closure->status().set_error(EINVAL, "commit failed");
+  closure->Run();
+
+  EXPECT_EQ(1, notify_counts[1]);
+  EXPECT_EQ(1, notify_counts[2]);
+  EXPECT_EQ(dingodb::pb::error::ERAFT_COMMITLOG, ctx1->Status().error_code());
+}
+
+TEST_F(RaftNodeTest, Hibernate) {
+  auto hibernate_config = LoadHibernateConfig();
+  ASSERT_NE(nullptr, hibernate_config);
+  int const election_timeout = hibernate_config->GetInt("raft.election_timeout");
+  int const hibernate_timeout_factor = hibernate_config->GetInt("raft.hibernate_timeout_factor");
+  // Heartbeat interval is election timeout / 10
+  int const hibernate_heartbeat_interval = election_timeout * hibernate_timeout_factor / 10;
+
+  std::vector<std::string> raft_addrs = {"127.0.0.1:17001:11", "127.0.0.1:17001:12", "127.0.0.1:17001:13"};
+  auto region = BuildRegion(2000, "hibernate_test", raft_addrs);
+  auto nodes = LaunchRaftGroup(hibernate_config, region);
+  ASSERT_EQ(3, nodes.size());
+  auto leader = WaitLeader(nodes, 10 * election_timeout);
+  ASSERT_NE(nullptr, leader);
+
+  // New leader start from active
+  for (auto& node : nodes) {
+    node->CheckHibernate();
+  }
+  EXPECT_FALSE(leader->IsHibernated());
+
+  // Followers hibernate after applied the hibernate command, then the leader
+  ASSERT_TRUE(WaitHibernate(nodes, 10 * election_timeout));
+  // The stretched lease is never used
+  EXPECT_FALSE(leader->IsLeaderLeaseValid());
+
+  // Followers stop election and the leader nearly stop heartbeat
+  int64_t const term = leader->GetStatus()->term();
+  EXPECT_LE(CountLeaderRpc(leader, 4 * election_timeout), 1);
+  EXPECT_TRUE(leader->IsLeader());
+  EXPECT_EQ(term, leader->GetStatus()->term());
+  for (auto& node : nodes) {
+    EXPECT_TRUE(node->IsHibernated());
+  }
+
+  // Read wake up the leader, followers wake up by the log entries of leader
+  EXPECT_TRUE(leader->ReadIndex().ok());
+  EXPECT_FALSE(leader->IsHibernated());
+  ASSERT_TRUE(WaitWakeUp(nodes, 2 * election_timeout));
+
+  // Keep alive until the heartbeat scheduled in hibernation fired, then heartbeat as normal, no election
+  bthread_usleep((hibernate_heartbeat_interval + election_timeout) * 1000L);
+  EXPECT_TRUE(leader->IsLeader());
+  EXPECT_EQ(term, leader->GetStatus()->term());
+  EXPECT_GT(CountLeaderRpc(leader, election_timeout), 5);
+
+  // Write wake up
+  ASSERT_TRUE(WaitHibernate(nodes, 10 * election_timeout));
+  auto ctx = std::make_shared<dingodb::Context>();
+  ctx->SetRegionId(region->Id());
+  ctx->EnableSyncMode();
+  auto raft_cmd = std::make_shared<dingodb::pb::raft::RaftCmdRequest>();
+  raft_cmd->mutable_header()->set_region_id(region->Id());
+  ASSERT_TRUE(leader->Commit(ctx, raft_cmd).ok());
+  ctx->Cond()->IncreaseWait();
+  EXPECT_TRUE(ctx->Status().ok());
+  EXPECT_FALSE(leader->IsHibernated());
+  ASSERT_TRUE(WaitWakeUp(nodes, 2 * election_timeout));
+
+  // Not hibernate before idle again
+  for (auto& node : nodes) {
+    node->CheckHibernate();
+  }
+  EXPECT_FALSE(leader->IsHibernated());
+
+  for (auto& node : nodes) {
+    node->Destroy();
+  }
+}
+
+TEST_F(RaftNodeTest, HibernateFailover) {
+  auto hibernate_config = LoadHibernateConfig();
+  ASSERT_NE(nullptr, hibernate_config);
+  int const election_timeout = hibernate_config->GetInt("raft.election_timeout");
+  int const hibernate_timeout_factor = hibernate_config->GetInt("raft.hibernate_timeout_factor");
+
+  std::vector<std::string> raft_addrs = {"127.0.0.1:17001:21", "127.0.0.1:17001:22", "127.0.0.1:17001:23"};
+  auto region = BuildRegion(3000, "hibernate_failover_test", raft_addrs);
+  auto nodes = LaunchRaftGroup(hibernate_config, region);
+  ASSERT_EQ(3, nodes.size());
+  auto leader = WaitLeader(nodes, 10 * election_timeout);
+  ASSERT_NE(nullptr, leader);
+
+  for (auto& node : nodes) {
+    node->CheckHibernate();
+  }
+  ASSERT_TRUE(WaitHibernate(nodes, 10 * election_timeout));
+
+  // Cut the leader off by reset the followers peers, they lost the leader and wake up,
+  // like the store liveness check found the leader store is down.
+  std::vector<std::shared_ptr<dingodb::RaftNode>> followers;
+  braft::Configuration follower_conf;
+  for (auto& node : nodes) {
+    if (node != leader) {
+      followers.push_back(node);
+      follower_conf.add_peer(node->GetPeerId());
+    }
+  }
+
+  int64_t const start_time = dingodb::Helper::TimestampMs();
+  for (auto& follower : followers) {
+    ASSERT_TRUE(follower->ResetPeers(follower_conf).ok());
+    follower->WakeUp();
+  }
+  // Elect with the normal election timeout, not the hibernated one
+  auto new_leader = WaitLeader(followers, hibernate_timeout_factor * election_timeout);
+  ASSERT_NE(nullptr, new_leader);
+  EXPECT_LT(dingodb::Helper::TimestampMs() - start_time, 5 * election_timeout);
+  for (auto& follower : followers) {
+    EXPECT_FALSE(follower->IsHibernated());
+  }
+
+  for (auto& node : nodes) {
+    node->Destroy();
+  }
+}
+
+TEST_F(RaftNodeTest, EarlyAckAndWaitApplied) {
+  std::vector<std::string> raft_addrs = {"127.0.0.1:17001:31"};
+  auto region = BuildRegion(4000, "early_ack_test", raft_addrs);
+  region->SetState(dingodb::pb::common::StoreRegionState::NORMAL);
+
+  auto raft_meta = dingodb::StoreRaftMeta::NewRaftMeta(region->Id());
+  auto* state_machine = new dingodb::StoreStateMachine(nullptr, region, raft_meta, nullptr, nullptr, false);
+  state_machine->SetEarlyAck(true);
+  auto node = std::make_shared<dingodb::RaftNode>(
+      region->Id() + 1, region->Name(), braft::PeerId(FormatLocation(region->Peers()[0].raft_location())),
+      state_machine);
+  ASSERT_EQ(0, node->Init(FormatPeers(region->Peers()), config));
+  ASSERT_NE(nullptr, WaitLeader({node}, 10 * config->GetInt("raft.election_timeout")));
+
+  // Wait the configuration entry applied.
+  EXPECT_TRUE(node->ReadIndex().ok());
+  int64_t const applied_index = state_machine->GetAppliedIndex();
+  EXPECT_TRUE(state_machine->WaitApplied(applied_index, 0));
+  EXPECT_FALSE(state_machine->WaitApplied(applied_index + 1, 100));
+  EXPECT_FALSE(node->WaitApplied(applied_index + 1, 100).ok());
+  EXPECT_EQ(0, state_machine->GetEarlyAckIndex());
+
+  // Blind write is acked once committed.
+  auto ctx = std::make_shared<dingodb::Context>();
+  ctx->SetRegionId(region->Id());
+  ctx->SetBlindWrite(true);
+  ctx->EnableSyncMode();
+  auto raft_cmd = std::make_shared<dingodb::pb::raft::RaftCmdRequest>();
+  raft_cmd->mutable_header()->set_region_id(region->Id());
+  auto* request = raft_cmd->add_requests();
+  request->set_cmd_type(dingodb::pb::raft::CmdType::PUT);
+  auto* kv = request->mutable_put()->add_kvs();
+  kv->set_key("key1");
+  kv->set_value("value1");
+  ASSERT_TRUE(node->Commit(ctx, raft_cmd).ok());
+  ctx->Cond()->IncreaseWait();
+  EXPECT_TRUE(ctx->Status().ok());
+  EXPECT_EQ(applied_index + 1, state_machine->GetEarlyAckIndex());
+
+  // Read wait the early acked write visible.
+  EXPECT_TRUE(node->WaitEarlyAcked().ok());
+  EXPECT_TRUE(node->ReadIndex().ok());
+  EXPECT_TRUE(state_machine->WaitApplied(applied_index + 1, 0));
+  EXPECT_TRUE(node->WaitApplied(applied_index + 1, 0).ok());
+
+  node->Destroy();
+}
+
+// All peers are on one store, so every rpc of the leader is between the same store pair.
+TEST_F(RaftNodeTest, HeartbeatFactor) {
+  int const election_timeout = config->GetInt("raft.election_timeout");
+  int32_t const braft_heartbeat_factor = braft::FLAGS_raft_election_heartbeat_factor;
+
+  auto count_idle_rpc = [&](uint64_t region_id, const std::string& name, int heartbeat_factor,
+                            std::vector<std::string> raft_addrs) {
+    // braft read the factor when node init
+    braft::FLAGS_raft_election_heartbeat_factor = heartbeat_factor;
+    auto region = BuildRegion(region_id, name, raft_addrs);
+    auto nodes = LaunchRaftGroup(config, region);
+    int count = -1;
+    auto leader = WaitLeader(nodes, 10 * election_timeout);
+    if (nodes.size() == 3 && leader != nullptr) {
+      // Wait the followers stable
+      bthread_usleep(election_timeout * 1000L);
+      count = CountLeaderRpc(leader, 2 * election_timeout);
+    }
+    for (auto& node : nodes) {
+      node->Destroy();
+    }
+    return count;
+  };
+
+  int const braft_count = count_idle_rpc(5000, "heartbeat_factor_braft_test", 10,
+                                         {"127.0.0.1:17001:41", "127.0.0.1:17001:42", "127.0.0.1:17001:43"});
+  int const tuned_count = count_idle_rpc(6000, "heartbeat_factor_tuned_test",
+                                         dingodb::Constant::kRaftElectionHeartbeatFactor,
+                                         {"127.0.0.1:17001:51", "127.0.0.1:17001:52", "127.0.0.1:17001:53"});
+  braft::FLAGS_raft_election_heartbeat_factor = braft_heartbeat_factor;
+
+  ASSERT_GT(braft_count, 0);
+  ASSERT_GT(tuned_count, 0);
+  // Heartbeat interval 100ms vs 250ms, idle rpc nearly drop to 10 / kRaftElectionHeartbeatFactor
+  EXPECT_LT(tuned_count, braft_count);
+  EXPECT_LE(tuned_count * 10, braft_count * dingodb::Constant::kRaftElectionHeartbeatFactor * 3 / 2);
+}
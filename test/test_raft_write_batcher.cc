@@ -0,0 +1,222 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bthread/bthread.h"
+#include "bthread/countdown_event.h"
+#include "common/context.h"
+#include "common/helper.h"
+#include "proto/raft.pb.h"
+#include "raft/raft_write_batcher.h"
+
+static std::shared_ptr<dingodb::pb::raft::RaftCmdRequest> GenRaftCmd(int request_count) {
+  auto raft_cmd = std::make_shared<dingodb::pb::raft::RaftCmdRequest>();
+  raft_cmd->mutable_header()->set_region_id(1000);
+  for (int i = 0; i < request_count; ++i) {
+    auto* request = raft_cmd->add_requests();
+    request->set_cmd_type(dingodb::pb::raft::CmdType::PUT);
+    auto* kv = request->mutable_put()->add_kvs();
+    kv->set_key("key" + std::to_string(i));
+    kv->set_value(std::string(100, 'v'));
+  }
+  return raft_cmd;
+}
+
+// Record the committed batches, the commit of the given calls is blocked until released.
+class MockRaftNode {
+ public:
+  explicit MockRaftNode(std::vector<int> block_calls) : block_calls_(block_calls) {}
+
+  butil::Status Commit(std::vector<std::shared_ptr<dingodb::Context>>& ctxs,
+                       std::shared_ptr<dingodb::pb::raft::RaftCmdRequest> raft_cmd) {
+    EXPECT_EQ(ctxs.size(), raft_cmd->requests_size());
+    int call = 0;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      batch_sizes_.push_back(raft_cmd->requests_size());
+      call = ++call_count_;
+    }
+
+    for (int block_call : block_calls_) {
+      if (block_call == call) {
+        blocked_.store(call);
+        release_.wait();
+        release_.reset(1);
+      }
+    }
+    return butil::Status();
+  }
+
+  // Wait the commit of the call is blocked.
+  void WaitBlocked(int call) {
+    while (blocked_.load() != call) {
+      bthread_usleep(1000);
+    }
+  }
+  void Release() { release_.signal(); }
+
+  std::vector<int> BatchSizes() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return batch_sizes_;
+  }
+
+ private:
+  std::vector<int> block_calls_;
+  std::mutex mutex_;
+  std::vector<int> batch_sizes_;
+  int call_count_{0};
+  std::atomic<int> blocked_{0};
+  bthread::CountdownEvent release_{1};
+};
+
+static dingodb::RaftWriteBatcher::Options GenOptions(uint32_t max_batch_count, uint64_t max_batch_bytes,
+                                                     int64_t window_us) {
+  dingodb::RaftWriteBatcher::Options options;
+  options.max_batch_count = max_batch_count;
+  options.max_batch_bytes = max_batch_bytes;
+  options.window_us = window_us;
+  return options;
+}
+
+static dingodb::RaftWriteBatcher::CommitFunc GenCommitFunc(MockRaftNode& node) {
+  return [&node](std::vector<std::shared_ptr<dingodb::Context>>& ctxs,
+                 std::shared_ptr<dingodb::pb::raft::RaftCmdRequest> raft_cmd) { return node.Commit(ctxs, raft_cmd); };
+}
+
+// Start writers, every writer commit one request.
+static void StartWriters(dingodb::RaftWriteBatcher& batcher, int count, std::vector<std::thread>& threads) {
+  for (int i = 0; i < count; ++i) {
+    threads.emplace_back([&batcher]() {
+      auto ctx = std::make_shared<dingodb::Context>();
+      EXPECT_TRUE(batcher.Commit(ctx, GenRaftCmd(1)).ok());
+    });
+  }
+}
+
+static void JoinWriters(std::vector<std::thread>& threads) {
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  threads.clear();
+}
+
+class RaftWriteBatcherTest : public testing::Test {
+ protected:
+  void SetUp() override {}
+  void TearDown() override {}
+};
+
+TEST_F(RaftWriteBatcherTest, Batching) {
+  MockRaftNode node({});
+  dingodb::RaftWriteBatcher batcher(1000, GenOptions(1024, 4 * 1024 * 1024, 50 * 1000), GenCommitFunc(node));
+
+  std::vector<std::thread> threads;
+  StartWriters(batcher, 16, threads);
+  JoinWriters(threads);
+
+  auto batch_sizes = node.BatchSizes();
+  int total = 0;
+  for (int size : batch_sizes) {
+    total += size;
+  }
+  EXPECT_EQ(16, total);
+  EXPECT_LT(batch_sizes.size(), 16);
+}
+
+TEST_F(RaftWriteBatcherTest, WindowEndWhenFull) {
+  MockRaftNode node({});
+  int64_t const window_us = 5 * 1000 * 1000;
+  dingodb::RaftWriteBatcher batcher(1000, GenOptions(4, 4 * 1024 * 1024, window_us), GenCommitFunc(node));
+
+  int64_t const start_time = dingodb::Helper::TimestampMs();
+  std::vector<std::thread> threads;
+  StartWriters(batcher, 4, threads);
+  JoinWriters(threads);
+
+  // Full batch not wait the whole window.
+  EXPECT_LT(dingodb::Helper::TimestampMs() - start_time, window_us / 1000);
+  EXPECT_EQ(std::vector<int>({4}), node.BatchSizes());
+}
+
+TEST_F(RaftWriteBatcherTest, SplitByCount) {
+  MockRaftNode node({1});
+  dingodb::RaftWriteBatcher batcher(1000, GenOptions(2, 4 * 1024 * 1024, 0), GenCommitFunc(node));
+
+  std::vector<std::thread> threads;
+  StartWriters(batcher, 1, threads);
+  node.WaitBlocked(1);
+
+  // Queued while the flusher is committing.
+  StartWriters(batcher, 5, threads);
+  bthread_usleep(100 * 1000);
+  node.Release();
+  JoinWriters(threads);
+
+  EXPECT_EQ(std::vector<int>({1, 2, 2, 1}), node.BatchSizes());
+}
+
+TEST_F(RaftWriteBatcherTest, SplitByBytes) {
+  MockRaftNode node({1});
+  uint64_t const bytes = GenRaftCmd(1)->ByteSizeLong();
+  dingodb::RaftWriteBatcher batcher(1000, GenOptions(1024, 3 * bytes, 0), GenCommitFunc(node));
+
+  std::vector<std::thread> threads;
+  StartWriters(batcher, 1, threads);
+  node.WaitBlocked(1);
+
+  StartWriters(batcher, 7, threads);
+  bthread_usleep(100 * 1000);
+  node.Release();
+  JoinWriters(threads);
+
+  EXPECT_EQ(std::vector<int>({1, 3, 3, 1}), node.BatchSizes());
+}
+
+TEST_F(RaftWriteBatcherTest, FlusherHandOver) {
+  // Block the first round and the extra round of the first flusher.
+  MockRaftNode node({1, 2});
+  dingodb::RaftWriteBatcher batcher(1000, GenOptions(1024, 4 * 1024 * 1024, 0), GenCommitFunc(node));
+
+  std::vector<std::thread> first_threads;
+  StartWriters(batcher, 1, first_threads);
+  node.WaitBlocked(1);
+
+  std::vector<std::thread> second_threads;
+  StartWriters(batcher, 2, second_threads);
+  bthread_usleep(100 * 1000);
+  node.Release();
+  node.WaitBlocked(2);
+
+  // Queued while the extra round is committing, the first flusher not take them.
+  std::vector<std::thread> third_threads;
+  StartWriters(batcher, 3, third_threads);
+  bthread_usleep(100 * 1000);
+  node.Release();
+
+  JoinWriters(first_threads);
+  JoinWriters(second_threads);
+  JoinWriters(third_threads);
+
+  // Taken by the next flusher.
+  EXPECT_EQ(std::vector<int>({1, 2, 3}), node.BatchSizes());
+}
@@ -32,6 +32,7 @@
 #include <vector>
 
 #include "butil/status.h"
+#include "bvar/variable.h"
 #include "common/context.h"
 #include "common/helper.h"
 #include "config/config.h"
@@ -84,9 +85,9 @@ const std::string kYamlConfigContent =
     "  path: /tmp/dingo-store/log\n"
     "store:\n"
     "  path: ./rocks_example\n"
+    "  memory_budget_mb: 256\n"
     "  base:\n"
     "    block_size: 131072\n"
-    "    block_cache: 67108864\n"
     "    arena_block_size: 67108864\n"
     "    min_write_buffer_number_to_merge: 4\n"
     "    max_write_buffer_number: 4\n"
@@ -98,6 +99,7 @@ const std::string kYamlConfigContent =
     "  default:\n"
     "  instruction:\n"
     "    max_write_buffer_number: 3\n"
+    "    block_cache_ratio: 0.25\n"
     "  column_families:\n"
     "    - default\n"
     "    - meta\n"
@@ -144,6 +146,13 @@ TEST_F(RawRocksEngineTest, GetID) {
   EXPECT_EQ(id, pb::common::RawEngine::RAW_ENG_ROCKSDB);
 }
 
+TEST_F(RawRocksEngineTest, MemoryBudget) {
+  // shared cache and the dedicated cache of instruction make up the budget
+  EXPECT_EQ(bvar::Variable::describe_exposed("dingo_rocksdb_block_cache_capacity"), std::to_string(256 * 1024 * 1024));
+  EXPECT_FALSE(bvar::Variable::describe_exposed("dingo_rocksdb_block_cache_usage").empty());
+  EXPECT_FALSE(bvar::Variable::describe_exposed("dingo_rocksdb_write_buffer_usage").empty());
+}
+
 TEST_F(RawRocksEngineTest, GetSnapshot$ReleaseSnapshot) {
   std::shared_ptr<Snapshot> snapshot = RawRocksEngineTest::engine->GetSnapshot();
   EXPECT_NE(snapshot.get(), nullptr);
@@ -1049,9 +1058,7 @@ TEST_F(RawRocksEngineTest, KvBatchCompareAndSet) {
   }
 }
 
-#if 0
 TEST_F(RawRocksEngineTest, KvBatchGet) {
-
   const std::string &cf_name = kDefaultCf;
   std::shared_ptr<RawEngine::Reader> reader = RawRocksEngineTest::engine->NewReader(cf_name);
 
@@ -1073,25 +1080,56 @@ TEST_F(RawRocksEngineTest, KvBatchGet) {
     EXPECT_EQ(ok.error_code(), pb::error::Errno::EKEY_EMPTY);
   }
 
-  // some key not exist
+  std::shared_ptr<RawEngine::Writer> writer = RawRocksEngineTest::engine->NewWriter(cf_name);
+  std::vector<pb::common::KeyValue> put_kvs;
+  for (int i = 0; i < 4; ++i) {
+    pb::common::KeyValue kv;
+    kv.set_key("KeyBatchGet" + std::to_string(i));
+    kv.set_value("ValueBatchGet" + std::to_string(i));
+    put_kvs.emplace_back(std::move(kv));
+  }
+  butil::Status ok = writer->KvBatchPut(put_kvs);
+  EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+
+  // some key not exist, skip them
   {
-    std::vector<std::string> keys{"key1", "key2", "key", "key4"};
+    std::vector<std::string> keys{"KeyBatchGet0", "KeyBatchGetNotExist1", "KeyBatchGet2", "KeyBatchGetNotExist2"};
     std::vector<pb::common::KeyValue> kvs;
 
-    butil::Status ok = reader->KvBatchGet(keys, kvs);
-    EXPECT_EQ(ok.error_code(), pb::error::Errno::EINTERNAL);
+    ok = reader->KvBatchGet(keys, kvs);
+    EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+    EXPECT_EQ(kvs.size(), 2);
+    EXPECT_EQ(kvs[0].key(), "KeyBatchGet0");
+    EXPECT_EQ(kvs[0].value(), "ValueBatchGet0");
+    EXPECT_EQ(kvs[1].key(), "KeyBatchGet2");
+    EXPECT_EQ(kvs[1].value(), "ValueBatchGet2");
   }
 
-  // normal
+  // normal, same as KvGet
   {
-    std::vector<std::string> keys{"key1", "key"};
+    std::vector<std::string> keys{"KeyBatchGet3", "KeyBatchGet1", "KeyBatchGet0", "KeyBatchGet2"};
     std::vector<pb::common::KeyValue> kvs;
 
-    butil::Status ok = reader->KvBatchGet(keys, kvs);
+    ok = reader->KvBatchGet(keys, kvs);
     EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+    EXPECT_EQ(kvs.size(), keys.size());
+
+    for (size_t i = 0; i < kvs.size(); ++i) {
+      EXPECT_EQ(kvs[i].key(), keys[i]);
+
+      std::string value;
+      ok = reader->KvGet(kvs[i].key(), value);
+      EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+      EXPECT_EQ(kvs[i].value(), value);
+    }
   }
+
+  pb::common::Range range;
+  range.set_start_key("KeyBatchGet");
+  range.set_end_key("KeyBatchGeu");
+  ok = writer->KvDeleteRange(range);
+  EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
 }
-#endif
 
 TEST_F(RawRocksEngineTest, KvPutIfAbsent) {
   const std::string &cf_name = kDefaultCf;
@@ -1566,6 +1604,144 @@ TEST_F(RawRocksEngineTest, KvScan) {
   }
 }
 
+TEST_F(RawRocksEngineTest, KvScanVisitor) {
+  const std::string &cf_name = kDefaultCf;
+  std::shared_ptr<RawEngine::Reader> reader = RawRocksEngineTest::engine->NewReader(cf_name);
+  std::shared_ptr<RawEngine::Writer> writer = RawRocksEngineTest::engine->NewWriter(cf_name);
+
+  std::vector<pb::common::KeyValue> put_kvs;
+  for (int i = 0; i < 10; ++i) {
+    pb::common::KeyValue kv;
+    kv.set_key("KeyScanVisitor" + std::to_string(i));
+    kv.set_value("ValueScanVisitor" + std::to_string(i));
+    put_kvs.emplace_back(std::move(kv));
+  }
+  butil::Status ok = writer->KvBatchPut(put_kvs);
+  EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+
+  // start_key empty error
+  {
+    ok = reader->KvScan("", "KeyScanVisitos", 0, 0, [](std::string_view, std::string_view) { return true; });
+    EXPECT_EQ(ok.error_code(), pb::error::Errno::EKEY_EMPTY);
+  }
+
+  // no limit
+  {
+    std::vector<std::string> keys;
+    ok = reader->KvScan("KeyScanVisitor", "KeyScanVisitos", 0, 0,
+                        [&keys](std::string_view key, std::string_view value) {
+                          keys.emplace_back(key);
+                          EXPECT_EQ(value.substr(0, 16), "ValueScanVisitor");
+                          return true;
+                        });
+    EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+    EXPECT_EQ(keys.size(), 10);
+  }
+
+  // count limit
+  {
+    uint64_t count = 0;
+    ok = reader->KvScan("KeyScanVisitor", "KeyScanVisitos", 3, 0, [&count](std::string_view, std::string_view) {
+      ++count;
+      return true;
+    });
+    EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+    EXPECT_EQ(count, 3);
+  }
+
+  // bytes limit, every key value is 15 + 17 bytes
+  {
+    uint64_t count = 0;
+    ok = reader->KvScan("KeyScanVisitor", "KeyScanVisitos", 0, 64, [&count](std::string_view, std::string_view) {
+      ++count;
+      return true;
+    });
+    EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+    EXPECT_EQ(count, 2);
+  }
+
+  // visitor stop
+  {
+    uint64_t count = 0;
+    ok = reader->KvScan("KeyScanVisitor", "KeyScanVisitos", 0, 0,
+                        [&count](std::string_view key, std::string_view) {
+                          ++count;
+                          return key != "KeyScanVisitor4";
+                        });
+    EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+    EXPECT_EQ(count, 5);
+  }
+
+  pb::common::Range range;
+  range.set_start_key("KeyScanVisitor");
+  range.set_end_key("KeyScanVisitos");
+  ok = writer->KvDeleteRange(range);
+  EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+}
+
+TEST_F(RawRocksEngineTest, WriteBatch) {
+  const std::string &cf_name = kDefaultCf;
+  std::shared_ptr<RawEngine::Reader> reader = RawRocksEngineTest::engine->NewReader(cf_name);
+
+  auto write_batch = RawRocksEngineTest::engine->NewWriteBatch();
+  EXPECT_NE(write_batch, nullptr);
+  auto batch_reader = write_batch->NewReader(cf_name);
+  auto batch_writer = write_batch->NewWriter(cf_name);
+
+  pb::common::KeyValue kv;
+  kv.set_key("KeyWriteBatch0");
+  kv.set_value("ValueWriteBatch0");
+  butil::Status ok = batch_writer->KvPut(kv);
+  EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+  EXPECT_EQ(write_batch->Count(), 1);
+
+  // Uncommitted mutation only visible through batch
+  std::string value;
+  ok = reader->KvGet("KeyWriteBatch0", value);
+  EXPECT_EQ(ok.error_code(), pb::error::Errno::EKEY_NOT_FOUND);
+  ok = batch_reader->KvGet("KeyWriteBatch0", value);
+  EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+  EXPECT_EQ(value, "ValueWriteBatch0");
+
+  // Put if absent see the uncommitted key
+  bool key_state = true;
+  ok = batch_writer->KvPutIfAbsent(kv, key_state);
+  EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+  EXPECT_FALSE(key_state);
+
+  std::vector<pb::common::KeyValue> kvs;
+  for (int i = 1; i < 3; ++i) {
+    pb::common::KeyValue kv;
+    kv.set_key("KeyWriteBatch" + std::to_string(i));
+    kv.set_value("ValueWriteBatch" + std::to_string(i));
+    kvs.emplace_back(std::move(kv));
+  }
+  ok = batch_writer->KvBatchPut(kvs);
+  EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+
+  uint64_t count = 0;
+  ok = batch_reader->KvCount("KeyWriteBatch", "KeyWriteBatcH", count);
+  EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+  EXPECT_EQ(count, 0);
+  ok = batch_reader->KvCount("KeyWriteBatch", "KeyWriteBatci", count);
+  EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+  EXPECT_EQ(count, 3);
+
+  ok = write_batch->Commit();
+  EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+  EXPECT_EQ(write_batch->Count(), 0);
+
+  ok = reader->KvGet("KeyWriteBatch2", value);
+  EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+  EXPECT_EQ(value, "ValueWriteBatch2");
+
+  pb::common::Range range;
+  range.set_start_key("KeyWriteBatch");
+  range.set_end_key("KeyWriteBatci");
+  ok = RawRocksEngineTest::engine->NewWriter(cf_name)->KvDeleteRange(range);
+  EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+}
+
 TEST_F(RawRocksEngineTest, KvCount) {
   const std::string &cf_name = kDefaultCf;
   std::shared_ptr<RawEngine::Reader> reader = RawRocksEngineTest::engine->NewReader(cf_name);
@@ -2535,6 +2711,64 @@ TEST_F(RawRocksEngineTest, KvDeleteRangeWithRangeWithOptions) {
   }
 }
 
+TEST_F(RawRocksEngineTest, KvDeleteRangeDeleteFiles) {
+  const std::string &cf_name = kDefaultCf;
+  std::shared_ptr<RawEngine::Writer> writer = RawRocksEngineTest::engine->NewWriter(cf_name);
+  // Greater than the keys of other cases, no other file overlap with them.
+  const std::string prefix = std::string(1, static_cast<char>(0xFE)) + "DFKEY";
+
+  // Every batch is one sst file, move it out of level 0 which is not dropped by DeleteFilesInRange.
+  for (int i = 0; i < 3; i++) {
+    std::vector<pb::common::KeyValue> kvs;
+    for (int j = 0; j < 10; j++) {
+      pb::common::KeyValue kv;
+      kv.set_key(prefix + std::to_string(i) + std::to_string(j));
+      kv.set_value("VALUE" + std::to_string(j));
+      kvs.push_back(kv);
+    }
+    butil::Status ok = writer->KvBatchPut(kvs);
+    EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+    RawRocksEngineTest::engine->Flush(cf_name);
+
+    pb::common::Range batch_range;
+    batch_range.set_start_key(prefix + std::to_string(i));
+    batch_range.set_end_key(prefix + std::to_string(i + 1));
+    ok = RawRocksEngineTest::engine->CompactRange(cf_name, batch_range);
+    EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+  }
+
+  pb::common::Range range;
+  range.set_start_key(prefix + "0");
+  range.set_end_key(prefix + "2");
+  std::vector<pb::common::Range> ranges = {range};
+  EXPECT_GT(RawRocksEngineTest::engine->GetApproximateSizes(cf_name, ranges)[0], 0);
+
+  butil::Status ok = writer->KvDeleteRange(range, true);
+  EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+
+  // The files in range are dropped, not wait the compaction.
+  EXPECT_EQ(0, RawRocksEngineTest::engine->GetApproximateSizes(cf_name, ranges)[0]);
+
+  std::shared_ptr<RawEngine::Reader> reader = RawRocksEngineTest::engine->NewReader(cf_name);
+  uint64_t count = 0;
+  ok = reader->KvCount(prefix + "0", prefix + "2", count);
+  EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+  EXPECT_EQ(0, count);
+
+  ok = reader->KvCount(prefix + "2", prefix + "3", count);
+  EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+  EXPECT_EQ(10, count);
+
+  ranges[0].set_start_key(prefix + "2");
+  ranges[0].set_end_key(prefix + "3");
+  EXPECT_GT(RawRocksEngineTest::engine->GetApproximateSizes(cf_name, ranges)[0], 0);
+
+  range.set_start_key(prefix);
+  range.set_end_key(std::string(1, static_cast<char>(0xFE)) + "DFKEZ");
+  ok = writer->KvDeleteRange(range, true);
+  EXPECT_EQ(ok.error_code(), pb::error::Errno::OK);
+}
+
 TEST_F(RawRocksEngineTest, KvBatchDeleteRange) {
   const std::string &cf_name = kDefaultCf;
   std::shared_ptr<RawEngine::Writer> writer = RawRocksEngineTest::engine->NewWriter(cf_name);
@@ -2742,7 +2976,8 @@ TEST_F(RawRocksEngineTest, KvBatchDeleteRange) {
       std::cout << kv.key() << ":" << kv.value() << std::endl;
     }
 
-    EXPECT_EQ(20, kvs.size());
+    // KEY0 -> KEY9 are deleted
+    EXPECT_EQ(10, kvs.size());
   }
 
   {
@@ -2777,6 +3012,43 @@ TEST_F(RawRocksEngineTest, Iterator) {
   EXPECT_GE(count, 1);
 }
 
+TEST_F(RawRocksEngineTest, IteratorBounds) {
+  auto writer = RawRocksEngineTest::engine->NewWriter(kDefaultCf);
+  pb::common::KeyValue kv;
+  for (const auto *key : {"bounds_a", "bounds_b", "bounds_c"}) {
+    kv.set_key(key);
+    kv.set_value(GenRandomString(16));
+    writer->KvPut(kv);
+  }
+
+  // [bounds_b, bounds_c)
+  IteratorOptions options;
+  options.lower_bound = "bounds_b";
+  options.upper_bound = "bounds_c";
+  auto iter = RawRocksEngineTest::engine->NewIterator(kDefaultCf, options);
+
+  std::vector<std::string> keys;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    keys.emplace_back(iter->Key());
+  }
+  EXPECT_EQ(keys, std::vector<std::string>({"bounds_b"}));
+
+  iter->SeekToLast();
+  ASSERT_TRUE(iter->Valid());
+  EXPECT_EQ(iter->Key(), "bounds_b");
+
+  // Engine iterator of reader
+  auto reader = RawRocksEngineTest::engine->NewReader(kDefaultCf);
+  auto engine_iter = reader->NewIterator("bounds_a", "bounds_c");
+  engine_iter->Start();
+  size_t count = 0;
+  while (engine_iter->HasNext()) {
+    ++count;
+    engine_iter->Next();
+  }
+  EXPECT_EQ(count, 2);
+}
+
 // TEST_F(RawRocksEngineTest, Checkpoint) {
 //   auto writer = RawRocksEngineTest::engine->NewWriter(kDefaultCf);
 
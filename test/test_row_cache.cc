@@ -0,0 +1,119 @@
+// Copyright (c) 2023 dingodb.com, Inc. All Rights Reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "engine/row_cache.h"
+
+class RowCacheTest : public testing::Test {
+ protected:
+  void SetUp() override {}
+  void TearDown() override {}
+};
+
+TEST_F(RowCacheTest, FillAndLookup) {
+  dingodb::RowCache cache(1024 * 1024);
+  std::string value;
+  EXPECT_FALSE(cache.Lookup("key1", value));
+
+  cache.Fill("key1", "value1", cache.Version("key1"));
+  EXPECT_TRUE(cache.Lookup("key1", value));
+  EXPECT_EQ("value1", value);
+  EXPECT_EQ(1, cache.Size());
+  EXPECT_GT(cache.Usage(), 0);
+}
+
+TEST_F(RowCacheTest, StaleFill) {
+  dingodb::RowCache cache(1024 * 1024);
+  std::string value;
+
+  // Written between version and fill, the value read may be old.
+  uint64_t version = cache.Version("key1");
+  cache.Erase("key1");
+  cache.Fill("key1", "old", version);
+  EXPECT_FALSE(cache.Lookup("key1", value));
+
+  version = cache.Version("key1");
+  cache.Update("key1", "new");
+  cache.Fill("key1", "old", version);
+  EXPECT_FALSE(cache.Lookup("key1", value));
+}
+
+TEST_F(RowCacheTest, Update) {
+  dingodb::RowCache cache(1024 * 1024);
+  std::string value;
+
+  // Cold key is not admitted.
+  cache.Update("key1", "value1");
+  EXPECT_FALSE(cache.Lookup("key1", value));
+
+  cache.Fill("key1", "value1", cache.Version("key1"));
+  cache.Update("key1", "value2");
+  EXPECT_TRUE(cache.Lookup("key1", value));
+  EXPECT_EQ("value2", value);
+
+  cache.Erase("key1");
+  EXPECT_FALSE(cache.Lookup("key1", value));
+  EXPECT_EQ(0, cache.Usage());
+}
+
+TEST_F(RowCacheTest, EraseRange) {
+  dingodb::RowCache cache(1024 * 1024);
+  for (char c = 'a'; c <= 'e'; ++c) {
+    std::string key(1, c);
+    cache.Fill(key, key, cache.Version(key));
+  }
+  EXPECT_EQ(5, cache.Size());
+
+  cache.EraseRange("b", "d");
+  std::string value;
+  EXPECT_TRUE(cache.Lookup("a", value));
+  EXPECT_FALSE(cache.Lookup("b", value));
+  EXPECT_FALSE(cache.Lookup("c", value));
+  EXPECT_TRUE(cache.Lookup("d", value));
+
+  cache.EraseRange("d", "");
+  EXPECT_FALSE(cache.Lookup("e", value));
+  EXPECT_EQ(1, cache.Size());
+
+  cache.Clear();
+  EXPECT_EQ(0, cache.Size());
+  EXPECT_EQ(0, cache.Usage());
+}
+
+TEST_F(RowCacheTest, Evict) {
+  // One shard, hold about 4 entries.
+  dingodb::RowCache cache(4 * 128, 0);
+  std::string value(60, 'v');
+  for (int i = 0; i < 4; ++i) {
+    std::string key = "key" + std::to_string(i);
+    cache.Fill(key, value, cache.Version(key));
+  }
+  EXPECT_EQ(4, cache.Size());
+
+  // Touch key0, key1 is the least recently used.
+  std::string out;
+  EXPECT_TRUE(cache.Lookup("key0", out));
+  cache.Fill("key4", value, cache.Version("key4"));
+  EXPECT_TRUE(cache.Lookup("key0", out));
+  EXPECT_FALSE(cache.Lookup("key1", out));
+  EXPECT_TRUE(cache.Lookup("key4", out));
+  EXPECT_LE(cache.Usage(), cache.Capacity());
+
+  // Larger than the capacity.
+  cache.Fill("big", std::string(1024, 'v'), cache.Version("big"));
+  EXPECT_FALSE(cache.Lookup("big", out));
+}
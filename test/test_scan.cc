@@ -36,6 +36,7 @@
 #include "engine/engine.h"
 #include "engine/raw_rocks_engine.h"
 #include "engine/rocks_engine.h"
+#include "gflags/gflags.h"
 #include "proto/common.pb.h"
 #include "scan/scan.h"
 #include "scan/scan_manager.h"
@@ -43,6 +44,8 @@
 
 namespace dingodb {
 
+DECLARE_uint64(scan_bulk_min_fetch_cnt);
+
 static const std::string &kDefaultCf = Constant::kStoreDataCF;  // NOLINT
 
 class ScanTest : public testing::Test {
@@ -911,6 +914,52 @@ TEST_F(ScanTest, max_times) {
   crontab_manager.Destroy();
 }
 
+TEST_F(ScanTest, ReadProfile) {
+  auto raw_rocks_engine = this->GetRawRocksEngine();
+  auto *manager = this->GetManager();
+  butil::Status ok;
+
+  pb::common::Range range;
+  range.set_start_key("keyAA");
+  range.set_end_key("keyZZ");
+  std::vector<pb::common::KeyValue> kvs;
+
+  // Small fetch count read through block cache.
+  {
+    std::string scan_id;
+    std::shared_ptr<ScanContext> scan = manager->CreateScan(&scan_id);
+    ok = scan->Open(scan_id, raw_rocks_engine, kDefaultCf);
+    EXPECT_EQ(ok.error_code(), dingodb::pb::error::Errno::OK);
+
+    ok = ScanHandler::ScanBegin(scan, 1, range, 10, false, true, true, {}, &kvs);
+    EXPECT_EQ(ok.error_code(), dingodb::pb::error::Errno::OK);
+    EXPECT_EQ(scan->GetReadProfile(), ReadProfile::kDefault);
+
+    manager->DeleteScan(scan_id);
+  }
+
+  // Large fetch count is bulk scan, ScanContinue keep the iterator of ScanBegin.
+  {
+    std::string scan_id;
+    std::shared_ptr<ScanContext> scan = manager->CreateScan(&scan_id);
+    ok = scan->Open(scan_id, raw_rocks_engine, kDefaultCf);
+    EXPECT_EQ(ok.error_code(), dingodb::pb::error::Errno::OK);
+
+    ok = ScanHandler::ScanBegin(scan, 1, range, FLAGS_scan_bulk_min_fetch_cnt, false, true, true, {}, &kvs);
+    EXPECT_EQ(ok.error_code(), dingodb::pb::error::Errno::OK);
+    EXPECT_EQ(scan->GetReadProfile(), ReadProfile::kBulkScan);
+
+    kvs.clear();
+    ok = ScanHandler::ScanContinue(scan, scan_id, 1, &kvs);
+    EXPECT_EQ(ok.error_code(), dingodb::pb::error::Errno::OK);
+    EXPECT_EQ(scan->GetReadProfile(), ReadProfile::kBulkScan);
+
+    ok = ScanHandler::ScanRelease(scan, scan_id);
+    EXPECT_EQ(ok.error_code(), dingodb::pb::error::Errno::OK);
+    manager->DeleteScan(scan_id);
+  }
+}
+
 TEST_F(ScanTest, KvDeleteRange) {
   auto raw_rocks_engine = this->GetRawRocksEngine();
   const std::string &cf_name = kDefaultCf;
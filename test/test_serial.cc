@@ -1649,6 +1649,48 @@ TEST_F(DingoSerialTest, recordTest) {
   delete rd;
 }
 
+TEST_F(DingoSerialTest, recordColumnsTest) {
+  InitVector();
+  auto schemas = GetSchemas();
+  RecordEncoder re(0, schemas, 0L, this->le);
+  InitRecord();
+
+  vector<any>* record1 = GetRecord();
+  pb::common::KeyValue kv;
+  EXPECT_EQ(0, re.Encode(*record1, kv));
+
+  RecordDecoder rd(0, schemas, 0L, this->le);
+  vector<int> index{0, 1, 3, 5};
+  vector<any> record2(schemas->size());
+  EXPECT_EQ(0, rd.DecodeColumns(kv.key(), kv.value(), index,
+                                [&](int i, auto&& column) { record2.at(i) = std::move(column); }));
+  vector<any> record3;
+  (void)rd.Decode(kv, index, record3);
+  for (int i : index) {
+    EXPECT_EQ(record3.at(i).type(), record2.at(i).type());
+  }
+  EXPECT_EQ(0, any_cast<optional<int32_t>>(record2.at(0)).value_or(-1));
+  EXPECT_FALSE(record2.at(2).has_value());
+
+  // All columns decoded by visitor and encoded back by getter must give the same key value.
+  vector<int> all_index;
+  for (const auto& bs : *schemas) {
+    all_index.push_back(bs->GetIndex());
+  }
+  vector<any> record4(schemas->size());
+  EXPECT_EQ(0, rd.DecodeColumns(kv.key(), kv.value(), all_index,
+                                [&](int i, auto&& column) { record4.at(i) = std::move(column); }));
+  pb::common::KeyValue kv2;
+  EXPECT_EQ(0, re.EncodeColumns(
+                   [&](int i, auto& column) { column = any_cast<std::decay_t<decltype(column)>>(record4.at(i)); },
+                   kv2));
+  EXPECT_EQ(kv.key(), kv2.key());
+  EXPECT_EQ(kv.value(), kv2.value());
+
+  DeleteSchemas();
+  DeleteRecords();
+}
+
 TEST_F(DingoSerialTest, tabledefinitionTest) {
   auto td = std::make_shared<pb::meta::TableDefinition>();
   td->set_name("test");